@@ -0,0 +1,116 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark of the per-flush lookup overhead of the fuse cache and the codegen cache.
+ * The instruction list and the kernel are found in the caches thus the elapsed time per lookup
+ * is the overhead of hashing and verifying the instruction list and the kernel.
+ * Exits with a non-zero status when a lookup misses or returns something else than what was inserted.
+ *
+ * Usage: bhxx_bench_cache_lookup [instructions] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+#include <bohrium/bh_config_parser.hpp>
+#include <bohrium/jitk/statistics.hpp>
+#include <bohrium/jitk/fuser_cache.hpp>
+#include <bohrium/jitk/codegen_cache.hpp>
+#include <bohrium/jitk/symbol_table.hpp>
+
+using namespace bohrium;
+
+// Returns true when all lookups hit and return the inserted entries
+bool compute(uint64_t num_instrs, uint64_t iterations) {
+    const int64_t nelem = 1000;
+    const uint64_t num_bases = 100;
+    const bh_opcode opcodes[] = {BH_ADD, BH_MULTIPLY, BH_SUBTRACT, BH_MAXIMUM};
+
+    std::vector<std::unique_ptr<bh_base> > bases;
+    for (uint64_t i = 0; i < num_bases; ++i) {
+        bases.emplace_back(new bh_base(nelem, bh_type::FLOAT64));
+    }
+
+    // A list of element-wise instructions that reads a base and a constant and writes another base
+    std::vector<bh_instruction> instrs;
+    for (uint64_t i = 0; i < num_instrs; ++i) {
+        bh_view out(bases[i % num_bases].get());
+        bh_view in(bases[(i * 7 + 1) % num_bases].get());
+        bh_view constant;
+        bh_instruction instr(opcodes[i % 4], {out, in, constant});
+        instr.constant = bh_constant(1.0 + i);
+        instr.origin_id = static_cast<int64_t>(i);
+        instrs.push_back(std::move(instr));
+    }
+    std::vector<bh_instruction *> instr_list;
+    for (bh_instruction &instr: instrs) {
+        instr_list.push_back(&instr);
+    }
+
+    // The kernel is a single loop of all instructions
+    jitk::LoopB loop{0, nelem};
+    for (const bh_instruction &instr: instrs) {
+        loop._block_list.emplace_back(instr, 1);
+    }
+    loop.metadataUpdate();
+    std::vector<jitk::Block> block_list = {jitk::Block(loop)};
+    jitk::LoopB kernel{-1, 1, block_list};
+    kernel.metadataUpdate();
+    const jitk::SymbolTable symbols(kernel, false, true, true, true);
+
+    ConfigParser config(-1);
+    jitk::Statistics stat(false, config);
+    jitk::FuseCache fcache(stat);
+    jitk::CodegenCache codegen_cache(stat);
+    fcache.insert(instr_list, block_list);
+    codegen_cache.insert("kernel", codegen_cache.lookup(kernel, symbols).second);
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const std::pair<std::vector<jitk::Block>, bool> cached = fcache.get(instr_list);
+        hits += cached.second and cached.first.size() == block_list.size() ? 1 : 0;
+    }
+    const std::chrono::duration<double> fuse_elapsed = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const jitk::CodegenCache::Source *source = codegen_cache.lookup(kernel, symbols).first;
+        hits += source != nullptr and source->code == "kernel" ? 1 : 0;
+    }
+    const std::chrono::duration<double> codegen_elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "bhxx_bench_cache_lookup - instructions: " << num_instrs << ", iterations: " << iterations
+              << ", hits: " << hits << "/" << 2 * iterations << ", fuse cache: "
+              << fuse_elapsed.count() / iterations * 1e3 << "ms, codegen cache: "
+              << codegen_elapsed.count() / iterations * 1e3 << "ms per lookup" << std::endl;
+    if (hits != 2 * iterations) {
+        std::cerr << "bhxx_bench_cache_lookup - a lookup missed or returned a wrong entry" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t num_instrs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    const uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100;
+    return compute(num_instrs, iterations) ? 0 : 1;
+}
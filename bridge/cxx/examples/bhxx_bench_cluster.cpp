@@ -0,0 +1,150 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Scaling benchmark of the cluster VEM on an elementwise, a stencil, and a reduction workload of a 2-D grid.
+ * Run it with BH_STACK=cluster_openmp and compare the elapsed times of BH_CLUSTER_WORKERS=1,2,4,... The stencil
+ * exchanges a halo row between neighbouring shards and the reduction along the rows combines a partial result of
+ * each shard. The checksums are independent of the number of workers. Exits with a non-zero status when the sums
+ * differ from the sums of the same computation on the host.
+ *
+ * Usage: bhxx_bench_cluster [rows] [cols] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+namespace {
+// A `nrows` x `ncols` view of `grid` (of `cols` columns) that starts at row `row` and column `col`
+BhArray<double> block(const BhArray<double> &grid, uint64_t cols, uint64_t row, uint64_t col,
+                      uint64_t nrows, uint64_t ncols) {
+    return BhArray<double>(grid.base(), {nrows, ncols}, {static_cast<int64_t>(cols), 1}, row * cols + col);
+}
+
+// Run `func` `iterations` times and print the elapsed time per iteration. Notice, the workers execute
+// asynchronously thus the measurement ends by reading the sum of `grid`, which waits for all of them.
+template<typename F>
+void timeit(const char *name, uint64_t iterations, const BhArray<double> &grid, F func) {
+    BhArray<double> sum({1});
+    BhArray<double> flat(grid.base(), {static_cast<uint64_t>(grid.base()->nelem())}, {1});
+    auto barrier = [&]() {
+        add_reduce(sum, flat, 0);
+        sum.vec();
+    };
+    func(); // Warm up, which compiles the kernels of the workers
+    barrier();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    barrier();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << name << ": " << elapsed.count() / iterations * 1e3 << "ms" << std::endl;
+}
+
+// Returns the column sums of the grid after the computation of `compute()` on the host
+std::vector<double> host_sums(uint64_t rows, uint64_t cols, uint64_t iterations) {
+    std::vector<double> grid(rows * cols, 1.0);
+    for (uint64_t i = 0; i <= iterations; ++i) {
+        for (double &v: grid) {
+            v = v * 0.5 + 1.0;
+        }
+    }
+    std::vector<double> tmp((rows - 2) * (cols - 2));
+    for (uint64_t i = 0; i <= iterations; ++i) {
+        for (uint64_t r = 1; r < rows - 1; ++r) {
+            for (uint64_t c = 1; c < cols - 1; ++c) {
+                const double *g = &grid[r * cols + c];
+                tmp[(r - 1) * (cols - 2) + c - 1] = g[-static_cast<int64_t>(cols)] + g[cols] + g[-1] + g[1] + g[0];
+            }
+        }
+        for (uint64_t r = 1; r < rows - 1; ++r) {
+            for (uint64_t c = 1; c < cols - 1; ++c) {
+                grid[r * cols + c] = tmp[(r - 1) * (cols - 2) + c - 1] * 0.2;
+            }
+        }
+    }
+    std::vector<double> ret(cols, 0.0);
+    for (uint64_t r = 0; r < rows; ++r) {
+        for (uint64_t c = 0; c < cols; ++c) {
+            ret[c] += grid[r * cols + c];
+        }
+    }
+    return ret;
+}
+}
+
+// Returns true when the sums are correct
+bool compute(uint64_t rows, uint64_t cols, uint64_t iterations) {
+    BhArray<double> grid = full<double>({rows, cols}, 1.0);
+    BhArray<double> tmp({rows - 2, cols - 2});
+    BhArray<double> sums({cols});
+    BhArray<double> total({1});
+    Runtime::instance().flush();
+
+    std::cout << "bhxx_bench_cluster - rows: " << rows << ", cols: " << cols
+              << ", iterations: " << iterations << std::endl;
+    timeit("elementwise", iterations, grid, [&]() {
+        multiply(grid, grid, 0.5);
+        add(grid, grid, 1.0);
+    });
+    timeit("stencil", iterations, grid, [&]() {
+        add(tmp, block(grid, cols, 0, 1, rows - 2, cols - 2), block(grid, cols, 2, 1, rows - 2, cols - 2));
+        add(tmp, tmp, block(grid, cols, 1, 0, rows - 2, cols - 2));
+        add(tmp, tmp, block(grid, cols, 1, 2, rows - 2, cols - 2));
+        add(tmp, tmp, block(grid, cols, 1, 1, rows - 2, cols - 2));
+        BhArray<double> center = block(grid, cols, 1, 1, rows - 2, cols - 2);
+        multiply(center, tmp, 0.2);
+    });
+    timeit("reduction", iterations, grid, [&]() {
+        add_reduce(sums, grid, 0);
+        add_reduce(total, sums, 0);
+    });
+    std::cout << "checksum(grid): " << total << std::endl;
+
+    // The order of the additions differs between the host and the workers
+    const std::vector<double> expected = host_sums(rows, cols, iterations);
+    double expected_total = 0;
+    for (double v: expected) {
+        expected_total += v;
+    }
+    const std::vector<double> got = sums.vec();
+    bool correct = std::fabs(total.vec()[0] - expected_total) <= 1e-9 * expected_total;
+    for (uint64_t c = 0; c < cols; ++c) {
+        correct = correct and std::fabs(got[c] - expected[c]) <= 1e-9 * expected[c];
+    }
+    if (not correct) {
+        std::cerr << "bhxx_bench_cluster - wrong sums, expected a total of " << expected_total << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000;
+    const uint64_t cols = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000;
+    const uint64_t iterations = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10;
+    return compute(rows, cols, iterations) ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark of BLAS extension methods interleaved with element-wise code.
+ * The element-wise updates of `x` and `y` are independent of the matrix multiplications
+ * thus they should fuse into one kernel across the extension method calls.
+ * Exits with a non-zero status when `y` or `d` differs from the values that the host computes.
+ *
+ * Usage: bhxx_bench_extmethod [matrix size] [vector size] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+// Returns true when the results are correct
+bool compute(uint64_t n, uint64_t m, uint64_t iterations) {
+    BhArray<double> a = full<double>({n, n}, 0.5);
+    BhArray<double> b = full<double>({n, n}, 0.25);
+    BhArray<double> c = zeros<double>({n, n});
+    BhArray<double> d = zeros<double>({n, n});
+    BhArray<double> x = ones<double>({m});
+    BhArray<double> y = zeros<double>({m});
+    Runtime::instance().flush();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        Runtime::instance().enqueueExtmethod("blas_gemm", c, a, b);
+        multiply(x, x, 0.999);
+        add(x, x, 0.001);
+        add(y, y, x);
+        add(d, d, c);
+        multiply(x, x, 1.001);
+        subtract(y, y, 0.5);
+    }
+    BhArray<double> checksum({1});
+    add_reduce(checksum, y, 0);
+    std::cout << "checksum(y): " << checksum << std::endl;
+    Runtime::instance().flush();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "bhxx_bench_extmethod - matrix: " << n << "x" << n << ", vector: " << m
+              << ", iterations: " << iterations << ", elapsed: " << elapsed.count() << "s" << std::endl;
+
+    // All elements of `x` and `y` are equal and `d` is the sum of the products, which are all `n * 0.5 * 0.25`
+    double x_elem = 1, y_elem = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        x_elem = x_elem * 0.999 + 0.001;
+        y_elem += x_elem;
+        x_elem *= 1.001;
+        y_elem -= 0.5;
+    }
+    const double expected_y = m * y_elem;
+    const double expected_d = n * n * (iterations * (n * 0.125));
+    BhArray<double> d_sum({1});
+    BhArray<double> d_flat(d.base(), {n * n});
+    add_reduce(d_sum, d_flat, 0);
+    const double got_y = checksum.vec()[0];
+    const double got_d = d_sum.vec()[0];
+    if (std::fabs(got_y - expected_y) > 1e-9 * std::fabs(expected_y) or
+        std::fabs(got_d - expected_d) > 1e-9 * std::fabs(expected_d)) {
+        std::cerr << "bhxx_bench_extmethod - wrong results, sum(y): " << got_y << " (expected " << expected_y
+                  << "), sum(d): " << got_d << " (expected " << expected_d << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+    const uint64_t m = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    const uint64_t iterations = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20;
+    return compute(n, m, iterations) ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Micro-benchmark of the per-kernel launch overhead.
+ * Each iteration flushes a single tiny kernel, which is found in all caches after the first iteration,
+ * thus the elapsed time per iteration is dominated by the overhead of launching a kernel.
+ * Exits with a non-zero status when the checksum is wrong.
+ *
+ * Usage: bhxx_bench_launch [array size] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+// Returns true when the checksum is correct
+bool compute(uint64_t size, uint64_t iterations) {
+    BhArray<double> a = ones<double>({size});
+    BhArray<double> b = ones<double>({size});
+    Runtime::instance().flush();
+
+    // Warm up the caches
+    add(a, a, b);
+    Runtime::instance().flush();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        add(a, a, b);
+        Runtime::instance().flush();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    BhArray<double> checksum({1});
+    add_reduce(checksum, a, 0);
+    std::cout << "checksum(a): " << checksum << std::endl;
+    std::cout << "bhxx_bench_launch - size: " << size << ", iterations: " << iterations
+              << ", elapsed: " << elapsed.count() << "s, per kernel: "
+              << elapsed.count() / iterations * 1e6 << "us" << std::endl;
+
+    // Every element is one plus the ones added by the warm up and the iterations
+    const double expected = static_cast<double>(size) * (iterations + 2);
+    if (checksum.vec()[0] != expected) {
+        std::cerr << "bhxx_bench_launch - wrong checksum, expected " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10;
+    const uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    return compute(size, iterations) ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Accuracy and throughput of the transcendental functions per opcode and type.
+ * The accuracy is the maximum error in ulp compared to the `long double` libm functions and the
+ * throughput is the best of the iterations. Compare `BH_OPENMP_MATH_PRECISION=fast` with the default,
+ * which is `exact`. Exits with a non-zero status when an error exceeds the 4 ulp that both precisions promise
+ * for these input ranges.
+ *
+ * Usage: bhxx_bench_math [elements] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+// The maximum error in ulp of both math precisions
+constexpr long double MAX_ULP = 4;
+
+template<typename T>
+struct MathOp {
+    const char *name;
+    // The range of the first and second input
+    double lo1, hi1, lo2, hi2;
+    void (*run)(BhArray<T> &out, const BhArray<T> &in1, const BhArray<T> &in2);
+    long double (*ref)(long double in1, long double in2);
+};
+
+// Return the unit in the last place of `ref` in the type `T`
+template<typename T>
+long double ulp(long double ref) {
+    const int exp = std::max(std::ilogb(ref), std::numeric_limits<T>::min_exponent - 1);
+    return std::ldexp(1.0L, exp - std::numeric_limits<T>::digits + 1);
+}
+
+// Return an array of `n` elements that covers [lo; hi] where `stride` permutes the order of the elements
+template<typename T>
+BhArray<T> input(uint64_t n, double lo, double hi, uint64_t stride) {
+    BhArray<T> ret = zeros<T>({n});
+    T *data = ret.data();
+    for (uint64_t i = 0; i < n; ++i) {
+        data[i] = static_cast<T>(lo + (hi - lo) * static_cast<double>((i * stride) % n) / n);
+    }
+    return ret;
+}
+
+// Returns true when the max error is within `MAX_ULP`
+template<typename T>
+bool bench(const char *type_name, const MathOp<T> &op, uint64_t n, uint64_t iterations) {
+    const BhArray<T> in1 = input<T>(n, op.lo1, op.hi1, 1);
+    const BhArray<T> in2 = input<T>(n, op.lo2, op.hi2, 7919);
+    BhArray<T> out({n});
+    op.run(out, in1, in2); // Compiles the kernel
+    Runtime::instance().flush();
+
+    std::chrono::duration<double> best(1e9);
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        op.run(out, in1, in2);
+        Runtime::instance().flush();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    const T *a = in1.data();
+    const T *b = in2.data();
+    const T *res = out.data();
+    long double max_error = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        const long double ref = op.ref(a[i], b[i]);
+        if (not std::isfinite(ref) or std::fabs(ref) > std::numeric_limits<T>::max()) {
+            continue;
+        }
+        // NB: a NaN result is an infinite error
+        const long double error = std::fabs(res[i] - ref) / ulp<T>(ref);
+        max_error = std::isnan(error) ? INFINITY : std::max(max_error, error);
+    }
+    std::cout << "bhxx_bench_math - " << type_name << " " << op.name << ": max error " << max_error
+              << " ulp, throughput " << n / best.count() / 1e6 << " Melem/s" << std::endl;
+    if (max_error > MAX_ULP) {
+        std::cerr << "bhxx_bench_math - " << type_name << " " << op.name << " exceeds " << MAX_ULP << " ulp"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Returns true when all max errors are within `MAX_ULP`
+template<typename T>
+bool bench_all(const char *type_name, uint64_t n, uint64_t iterations) {
+    typedef BhArray<T> A;
+    const MathOp<T> ops[] = {
+        {"exp", -80, 80, 0, 0, [](A &o, const A &x, const A &) { exp(o, x); },
+         [](long double x, long double) { return std::exp(x); }},
+        {"exp2", -120, 120, 0, 0, [](A &o, const A &x, const A &) { exp2(o, x); },
+         [](long double x, long double) { return std::exp2(x); }},
+        {"expm1", -5, 5, 0, 0, [](A &o, const A &x, const A &) { expm1(o, x); },
+         [](long double x, long double) { return std::expm1(x); }},
+        {"log", 1e-30, 1e30, 0, 0, [](A &o, const A &x, const A &) { log(o, x); },
+         [](long double x, long double) { return std::log(x); }},
+        {"log2", 0, 4, 0, 0, [](A &o, const A &x, const A &) { log2(o, x); },
+         [](long double x, long double) { return std::log2(x); }},
+        {"log10", 0, 4, 0, 0, [](A &o, const A &x, const A &) { log10(o, x); },
+         [](long double x, long double) { return std::log10(x); }},
+        {"log1p", -0.9, 4, 0, 0, [](A &o, const A &x, const A &) { log1p(o, x); },
+         [](long double x, long double) { return std::log1p(x); }},
+        {"sin", -100, 100, 0, 0, [](A &o, const A &x, const A &) { sin(o, x); },
+         [](long double x, long double) { return std::sin(x); }},
+        {"cos", -100, 100, 0, 0, [](A &o, const A &x, const A &) { cos(o, x); },
+         [](long double x, long double) { return std::cos(x); }},
+        {"tan", -100, 100, 0, 0, [](A &o, const A &x, const A &) { tan(o, x); },
+         [](long double x, long double) { return std::tan(x); }},
+        {"tanh", -10, 10, 0, 0, [](A &o, const A &x, const A &) { tanh(o, x); },
+         [](long double x, long double) { return std::tanh(x); }},
+        {"power", 0, 100, -15, 15, [](A &o, const A &x, const A &y) { power(o, x, y); },
+         [](long double x, long double y) { return std::pow(x, y); }},
+    };
+    bool ret = true;
+    for (const MathOp<T> &op: ops) {
+        ret = bench<T>(type_name, op, n, iterations) and ret;
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+    const bool float64_ok = bench_all<double>("float64", n, iterations);
+    const bool float32_ok = bench_all<float>("float32", n, iterations);
+    return float64_ok and float32_ok ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark of the per-flush overhead of flushes that repeat the same structure.
+ * Each flush consists of a chain of element-wise operations and two reductions, which results in
+ * several kernels. After the first iteration, the flush is found in the plan cache (`plan_cache = true`)
+ * thus the elapsed time per flush is dominated by binding the arguments and launching the kernels.
+ * Set `BH_OPENMP_PLAN_CACHE=false` to compare against the fuse and codegen caches alone and
+ * `BH_OPENMP_PROF=true` to see the share spent in the engine ("Total Execution").
+ * Exits with a non-zero status when the total differs from the total computed on the host.
+ *
+ * Usage: bhxx_bench_plan [array size] [operations] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+// Returns true when the total is correct
+bool compute(uint64_t size, uint64_t operations, uint64_t iterations) {
+    BhArray<double> a = ones<double>({size, size});
+    BhArray<double> b = ones<double>({size, size});
+    BhArray<double> rows = zeros<double>({size});
+    BhArray<double> total = zeros<double>({1});
+    Runtime::instance().flush();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        for (uint64_t j = 0; j < operations; ++j) {
+            if (j % 2 == 0) {
+                multiply(a, a, 0.999);
+            } else {
+                add(a, a, b);
+            }
+        }
+        add_reduce(rows, a, 1);
+        add_reduce(total, rows, 0);
+        Runtime::instance().flush();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "checksum(total): " << total << std::endl;
+    std::cout << "bhxx_bench_plan - size: " << size << ", operations: " << operations
+              << ", iterations: " << iterations << ", elapsed: " << elapsed.count() << "s, per flush: "
+              << elapsed.count() / iterations * 1e6 << "us" << std::endl;
+
+    // Every element of `a` has the same value, thus the host only needs to follow one of them
+    double value = 1.0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        for (uint64_t j = 0; j < operations; ++j) {
+            value = j % 2 == 0 ? value * 0.999 : value + 1.0;
+        }
+    }
+    const double expected = iterations > 0 ? value * size * size : 0.0;
+    if (std::fabs(total.vec()[0] - expected) > 1e-9 * expected) {
+        std::cerr << "bhxx_bench_plan - wrong total, expected " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10;
+    const uint64_t operations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20;
+    const uint64_t iterations = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10000;
+    return compute(size, operations, iterations) ? 0 : 1;
+}
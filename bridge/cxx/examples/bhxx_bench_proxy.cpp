@@ -0,0 +1,128 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark of the proxy VEM on three workloads, which stress the link in different ways:
+ *   latency   - a time-stepping loop that reads back a scalar every step (one round trip per step)
+ *   download  - reads back a large, smooth array every iteration (bandwidth and compression bound)
+ *   batches   - many small flushes of the same structure (serialization and batch cache bound)
+ * Run it with BH_STACK=proxy_openmp against a backend on the same host, which is started with the same stack and
+ * options as the benchmark since it compresses the replies using its own `compress_param`. Simulate the link of
+ * a deployment through the proxy options, e.g.
+ *
+ *   export BH_STACK=proxy_openmp BH_PROXY_TRANSPORT=tcp BH_PROXY_COMPRESS_PARAM=zlib,1,shuffle
+ *   bh_proxy_backend -a localhost -p 4200 &
+ *   BH_PROXY_SIM_BANDWIDTH=125000000 BH_PROXY_SIM_RTT=0.5 BH_PROXY_REPORT=costs.csv bhxx_bench_proxy
+ *
+ * which writes the serialization, compression, transfer, and backend execution time of each message to
+ * `costs.csv`. Repeat with other `compress_param` and `batch_cache` settings to compare them.
+ *
+ * Exits with a non-zero status when a read-back value differs from the value computed on the host by more than
+ * the relative `tolerance` (default 1e-9); use the bound of a lossy `compress_param` as the tolerance.
+ *
+ * Usage: bhxx_bench_proxy [elements] [iterations] [tolerance]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+namespace {
+// Read element `i` of `ary` back from the backend like the Python bridge does (through `getMemoryPointer()`)
+double readBack(BhArray<double> &ary, uint64_t i) {
+    Runtime::instance().flush();
+    const void *data = Runtime::instance().getMemoryPointer(ary.base(), true, false, false);
+    return static_cast<const double *>(data)[ary.offset() + i];
+}
+
+// Run `func` `iterations` times and print the elapsed time per iteration
+template<typename F>
+void timeit(const char *name, uint64_t iterations, F func) {
+    func(); // Warm up, which compiles the kernels of the backend
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << name << ": " << elapsed.count() / iterations * 1e3 << "ms" << std::endl;
+}
+
+// Returns true when `got` is within the relative `tolerance` of `expected`, otherwise reports the mismatch
+bool check(const char *name, double got, double expected, double tolerance) {
+    if (std::fabs(got - expected) <= tolerance * std::fabs(expected)) {
+        return true;
+    }
+    std::cerr << "bhxx_bench_proxy - wrong " << name << ": " << got << ", expected " << expected << std::endl;
+    return false;
+}
+}
+
+// Returns true when every read-back value is within the relative `tolerance` of the value computed on the host
+bool compute(uint64_t n, uint64_t iterations, double tolerance) {
+    std::cout << "bhxx_bench_proxy - elements: " << n << ", iterations: " << iterations << std::endl;
+    double checksum = 0;
+    bool correct = true;
+
+    BhArray<double> state = full<double>({n}, 1.0);
+    double expected_state = 1.0;
+    timeit("latency", iterations, [&]() {
+        multiply(state, state, 0.5);
+        add(state, state, 1.0);
+        BhArray<double> residual({1});
+        add_reduce(residual, state, 0);
+        const double value = readBack(residual, 0);
+        expected_state = expected_state * 0.5 + 1.0;
+        correct = check("residual", value, n * expected_state, tolerance) and correct;
+        checksum += value;
+    });
+
+    BhArray<double> field = arange<double>(n);
+    double expected_field = static_cast<double>(n / 2);
+    timeit("download", iterations, [&]() {
+        multiply(field, field, 1.0001);
+        const double value = readBack(field, n / 2);
+        expected_field *= 1.0001;
+        correct = check("field", value, expected_field, tolerance) and correct;
+        checksum += value;
+    });
+
+    BhArray<double> small = full<double>({1000}, 1.0);
+    timeit("batches", iterations, [&]() {
+        for (int i = 0; i < 100; ++i) {
+            add(small, small, 1.0);
+            Runtime::instance().flush();
+        }
+    });
+    const double value = readBack(small, 0);
+    correct = check("batches", value, 1.0 + 100.0 * (iterations + 1), tolerance) and correct;
+    checksum += value;
+    std::cout << "checksum: " << checksum << std::endl;
+    return correct;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    const uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+    const double tolerance = argc > 3 ? std::strtod(argv[3], nullptr) : 1e-9;
+    return compute(n, iterations, tolerance) ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark of the BhIR serialization of the proxy VEM: serializing a flush of element-wise instructions
+ * and de-serializing it again. The same flush is sent repeatedly as an iterative program would, thus its views
+ * are in the view dictionary after the first flush. Exits with a non-zero status when a de-serialized flush
+ * differs from the serialized one.
+ *
+ * Usage: bhxx_bench_serialize [instructions per flush] [flushes]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+#include <bohrium/bh_ir.hpp>
+
+using namespace std;
+
+// Returns true when `received` is `instrs` with the base arrays translated through `remote2local`
+bool equal(const BhIR &received, const std::vector<bh_instruction> &instrs,
+           const std::map<const bh_base *, bh_base> &remote2local) {
+    if (received.instr_list.size() != instrs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < instrs.size(); ++i) {
+        const bh_instruction &got = received.instr_list[i];
+        const bh_instruction &sent = instrs[i];
+        if (got.opcode != sent.opcode or got.operand.size() != sent.operand.size() or
+            got.constant != sent.constant) {
+            return false;
+        }
+        for (size_t j = 0; j < sent.operand.size(); ++j) {
+            const bh_view &v = got.operand[j];
+            const bh_view &w = sent.operand[j];
+            if (v.isConstant() != w.isConstant()) {
+                return false;
+            }
+            if (not w.isConstant()) {
+                auto it = remote2local.find(w.base);
+                if (it == remote2local.end() or v.base != &it->second or v.start != w.start or v.ndim != w.ndim or
+                    v.shape != w.shape or v.stride != w.stride) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Returns true when all flushes are de-serialized correctly
+bool compute(uint64_t num_instrs, uint64_t flushes) {
+    const int64_t rows = 100;
+    const int64_t cols = 100;
+    const uint64_t num_bases = 32;
+    const bh_opcode opcodes[] = {BH_ADD, BH_MULTIPLY, BH_SUBTRACT, BH_MAXIMUM};
+
+    std::vector<std::unique_ptr<bh_base> > bases;
+    for (uint64_t i = 0; i < num_bases; ++i) {
+        bases.emplace_back(new bh_base(rows * cols, bh_type::FLOAT64));
+    }
+
+    // Element-wise instructions on 2D views where every other input is shifted by a row
+    std::vector<bh_instruction> instrs;
+    for (uint64_t i = 0; i < num_instrs; ++i) {
+        bh_view out(bases[i % num_bases].get(), 0, 2, {rows - 1, cols}, {cols, 1});
+        bh_view in(bases[(i * 3 + 1) % num_bases].get(), (i % 2) * cols, 2, {rows - 1, cols}, {cols, 1});
+        bh_view constant;
+        bh_instruction instr(opcodes[i % 4], {out, in, constant});
+        instr.constant = bh_constant(1.0 + i);
+        instrs.push_back(std::move(instr));
+    }
+
+    // The state of the serializing and the de-serializing end
+    std::set<bh_base *> known_base_arrays;
+    BhIRViewDict write_dict;
+    std::map<const bh_base *, bh_base> remote2local;
+    BhIRViewDict read_dict;
+
+    std::chrono::duration<double> write_time{0};
+    std::chrono::duration<double> read_time{0};
+    uint64_t nbytes = 0;
+    uint64_t first_nbytes = 0;
+    uint64_t checksum = 0;
+    for (uint64_t i = 0; i < flushes; ++i) {
+        BhIR bhir(instrs, {});
+        std::vector<bh_base *> new_data;
+        const auto t1 = std::chrono::steady_clock::now();
+        const std::vector<char> buffer = bhir.writeSerialized(known_base_arrays, write_dict, new_data);
+        const auto t2 = std::chrono::steady_clock::now();
+        std::vector<bh_base *> data_recv;
+        std::set<bh_base *> frees;
+        const BhIR received(buffer, remote2local, read_dict, data_recv, frees);
+        const auto t3 = std::chrono::steady_clock::now();
+        write_time += t2 - t1;
+        read_time += t3 - t2;
+
+        nbytes += buffer.size();
+        if (i == 0) {
+            first_nbytes = buffer.size();
+        }
+        for (const bh_instruction &instr: received.instr_list) {
+            checksum += instr.opcode + instr.operand[1].start + instr.operand[0].shape[0];
+        }
+        if (not equal(received, instrs, remote2local)) {
+            std::cerr << "bhxx_bench_serialize - flush " << i << " is not de-serialized correctly" << std::endl;
+            return false;
+        }
+    }
+
+    const double total_instrs = static_cast<double>(num_instrs * flushes);
+    std::cout << "checksum: " << checksum << std::endl;
+    std::cout << "bhxx_bench_serialize - instructions: " << num_instrs << ", flushes: " << flushes
+              << ", bytes per flush: " << first_nbytes << " (first), " << nbytes / flushes << " (average)"
+              << ", write: " << total_instrs / write_time.count() / 1e6 << " Minstr/s ("
+              << nbytes / write_time.count() / 1024 / 1024 << " MB/s)"
+              << ", read: " << total_instrs / read_time.count() / 1e6 << " Minstr/s" << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t num_instrs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    const uint64_t flushes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+    return compute(num_instrs, flushes) ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The STREAM triad `a = b + scalar * c` on arrays much larger than the caches.
+ * The output `a` is only written thus the OpenMP backend writes it with non-temporal stores when it is
+ * larger than `nontemporal_threshold`. Compare with BH_OPENMP_NONTEMPORAL_THRESHOLD=0, which disables them.
+ * The bandwidth counts the bytes of the three arrays like the original STREAM benchmark.
+ * Exits with a non-zero status when the sum of `a` is wrong.
+ *
+ * Usage: bhxx_bench_stream_triad [elements] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include <bhxx/bhxx.hpp>
+
+using namespace bhxx;
+
+// Returns true when the checksum is correct
+bool compute(uint64_t n, uint64_t iterations) {
+    BhArray<double> b = full<double>({n}, 2.0);
+    BhArray<double> c = full<double>({n}, 0.5);
+    Runtime::instance().flush();
+
+    std::chrono::duration<double> best(1e9);
+    BhArray<double> checksum({1});
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        BhArray<double> a({n});
+        BhArray<double> tmp({n});
+        multiply(tmp, c, 3.0);
+        add(a, b, tmp);
+        tmp.reset();
+        Runtime::instance().flush();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+        add_reduce(checksum, a, 0);
+    }
+    std::cout << "checksum(a): " << checksum << std::endl;
+
+    const double gbytes = 3.0 * n * sizeof(double) / 1e9;
+    std::cout << "bhxx_bench_stream_triad - elements: " << n << ", iterations: " << iterations
+              << ", best: " << best.count() << "s, bandwidth: " << gbytes / best.count() << " GB/s" << std::endl;
+
+    // Every element of `a` is 2 + 3 * 0.5, which sums exactly
+    const double expected = 3.5 * n;
+    if (iterations > 0 and checksum.vec()[0] != expected) {
+        std::cerr << "bhxx_bench_stream_triad - wrong checksum, expected " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    const uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+    return compute(n, iterations) ? 0 : 1;
+}
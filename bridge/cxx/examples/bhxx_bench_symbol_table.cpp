@@ -0,0 +1,141 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark of the per-kernel metadata overhead: building the symbol table of a small kernel and
+ * the scope lookups done while generating its source.
+ * Exits with a non-zero status when the IDs of the symbol table do not tell the arrays, views, and constants
+ * apart or differ between the iterations.
+ *
+ * Usage: bhxx_bench_symbol_table [instructions per kernel] [iterations]
+ */
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <map>
+#include <set>
+
+#include <bohrium/jitk/symbol_table.hpp>
+#include <bohrium/jitk/scope.hpp>
+
+using namespace bohrium;
+
+// Build the symbol table of `kernel` and look up the IDs of `instrs` like the code generation does. Returns the sum
+// of the IDs.
+uint64_t use_symbol_table(const jitk::LoopB &kernel, const std::vector<bh_instruction> &instrs) {
+    uint64_t ret = 0;
+    const jitk::SymbolTable symbols(kernel, false, true, true, true);
+    jitk::Scope scope(symbols, nullptr);
+    for (const bh_instruction &instr: instrs) {
+        const bh_view &out = instr.operand[0];
+        if (not scope.isScalarReplaced(out)) {
+            scope.insertScalarReplaced(out);
+        }
+        for (const bh_view &view: instr.getViews()) {
+            ret += symbols.baseID(view.base) + symbols.viewID(view) + symbols.idxID(view) +
+                   symbols.offsetStridesID(view);
+            ret += scope.isArray(view) ? 1 : 0;
+        }
+        ret += symbols.constID(instr);
+    }
+    return ret;
+}
+
+// Returns true when the IDs are correct
+bool compute(uint64_t num_instrs, uint64_t iterations) {
+    const int64_t rows = 100;
+    const int64_t cols = 100;
+    const uint64_t num_bases = 8;
+    const bh_opcode opcodes[] = {BH_ADD, BH_MULTIPLY, BH_SUBTRACT, BH_MAXIMUM};
+
+    std::vector<std::unique_ptr<bh_base> > bases;
+    for (uint64_t i = 0; i < num_bases; ++i) {
+        bases.emplace_back(new bh_base(rows * cols, bh_type::FLOAT64));
+    }
+
+    // Element-wise instructions on 2D views where every other input is shifted by a row
+    std::vector<bh_instruction> instrs;
+    for (uint64_t i = 0; i < num_instrs; ++i) {
+        bh_view out(bases[i % num_bases].get(), 0, 2, {rows - 1, cols}, {cols, 1});
+        bh_view in(bases[(i * 3 + 1) % num_bases].get(), (i % 2) * cols, 2, {rows - 1, cols}, {cols, 1});
+        bh_view constant;
+        bh_instruction instr(opcodes[i % 4], {out, in, constant});
+        instr.constant = bh_constant(1.0 + i);
+        instr.origin_id = static_cast<int64_t>(i);
+        instrs.push_back(std::move(instr));
+    }
+
+    jitk::LoopB inner{1, cols};
+    for (const bh_instruction &instr: instrs) {
+        inner._block_list.emplace_back(instr, 2);
+    }
+    inner.metadataUpdate();
+    jitk::LoopB outer{0, rows - 1, {jitk::Block(inner)}};
+    outer.metadataUpdate();
+    jitk::LoopB kernel{-1, 1, {jitk::Block(outer)}};
+    kernel.metadataUpdate();
+
+    uint64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        checksum += use_symbol_table(kernel, instrs);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "checksum: " << checksum << std::endl;
+    std::cout << "bhxx_bench_symbol_table - instructions: " << num_instrs << ", iterations: " << iterations
+              << ", elapsed: " << elapsed.count() << "s, per kernel: "
+              << elapsed.count() / iterations * 1e6 << "us" << std::endl;
+
+    // Equal arrays and views must have equal IDs and different ones different IDs, every constant has its own ID,
+    // and all iterations must find the same IDs
+    const jitk::SymbolTable symbols(kernel, false, true, true, true);
+    std::map<const bh_base *, size_t> base_ids;
+    std::set<size_t> distinct_base_ids;
+    std::map<std::pair<const bh_base *, int64_t>, size_t> view_ids;
+    std::set<size_t> distinct_view_ids;
+    std::set<int64_t> const_ids;
+    bool correct = checksum == iterations * use_symbol_table(kernel, instrs);
+    for (const bh_instruction &instr: instrs) {
+        for (const bh_view &view: instr.getViews()) {
+            const size_t base_id = symbols.baseID(view.base);
+            correct = correct and base_ids.emplace(view.base, base_id).first->second == base_id;
+            distinct_base_ids.insert(base_id);
+            const size_t view_id = symbols.viewID(view);
+            correct = correct and view_ids.emplace(std::make_pair(view.base, view.start), view_id).first->second ==
+                                  view_id;
+            distinct_view_ids.insert(view_id);
+        }
+        const_ids.insert(symbols.constID(instr));
+    }
+    correct = correct and distinct_base_ids.size() == base_ids.size() and
+              distinct_view_ids.size() == view_ids.size() and const_ids.size() == instrs.size();
+    if (not correct) {
+        std::cerr << "bhxx_bench_symbol_table - wrong IDs" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const uint64_t num_instrs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16;
+    const uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    return compute(num_instrs, iterations) ? 0 : 1;
+}
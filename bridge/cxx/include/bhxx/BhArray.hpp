@@ -194,7 +194,7 @@ public:
      * @param shape   Shape of the new array
      * @param stride  Stride of the new array
      */
-    explicit BhArray(Shape shape, Stride stride) : BhArrayUnTypedCore{0, std::move(shape), std::move(stride),
+    explicit BhArray(Shape shape, Stride stride) : BhArrayUnTypedCore{0, shape, std::move(stride),
                                                                       make_base_ptr(T(0), shape.prod())} {}
 
     /** Create a new array (contiguous stride, row-major) */
@@ -210,8 +210,8 @@ public:
      */
     explicit BhArray(std::shared_ptr<BhBase> base, Shape shape, Stride stride, uint64_t offset = 0) :
             BhArrayUnTypedCore{offset, std::move(shape), std::move(stride), std::move(base)} {
-        assert(shape.size() == stride.size());
-        assert(shape.prod() > 0);
+        assert(this->shape().size() == this->stride().size());
+        assert(this->shape().prod() > 0);
     }
 
     /** Create a view that points to the given base (contiguous stride, row-major)
@@ -222,9 +222,9 @@ public:
      *        construct a BhBase object, use the make_base_ptr
      *        helper function.
      */
-    explicit BhArray(std::shared_ptr<BhBase> base, Shape shape) : BhArray(std::move(base), std::move(shape),
+    explicit BhArray(std::shared_ptr<BhBase> base, Shape shape) : BhArray(std::move(base), shape,
                                                                           contiguous_stride(shape), 0) {
-        assert(static_cast<uint64_t>(base->nelem()) == shape.prod());
+        assert(static_cast<uint64_t>(this->base()->nelem()) == this->shape().prod());
     }
 
     /** Create a copy of `ary` using a Bohrium `identity` operation, which copies the underlying array data.
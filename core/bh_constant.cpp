@@ -50,15 +50,15 @@ bh_constant bh_constant::get_min(bh_type type) {
         case bh_type::UINT64:
             return bh_constant(bh_uint64{0});
         case bh_type::FLOAT32:
-            return bh_constant(std::numeric_limits<float>::min());
+            return bh_constant(std::numeric_limits<float>::lowest());
         case bh_type::FLOAT64:
-            return bh_constant(std::numeric_limits<double>::min());
+            return bh_constant(std::numeric_limits<double>::lowest());
         case bh_type::COMPLEX64:
-            return bh_constant(std::complex<float>(std::numeric_limits<float>::min(),
-                                                   std::numeric_limits<float>::min()));
+            return bh_constant(std::complex<float>(std::numeric_limits<float>::lowest(),
+                                                   std::numeric_limits<float>::lowest()));
         case bh_type::COMPLEX128:
-            return bh_constant(std::complex<double>(std::numeric_limits<double>::min(),
-                                                    std::numeric_limits<double>::min()));
+            return bh_constant(std::complex<double>(std::numeric_limits<double>::lowest(),
+                                                    std::numeric_limits<double>::lowest()));
         case bh_type::R123:
             return bh_constant(bh_r123{0, 0});
         default:
@@ -18,53 +18,192 @@ GNU Lesser General Public License along with Bohrium.
 If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <boost/archive/binary_oarchive.hpp>
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/iostreams/stream_buffer.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/back_inserter.hpp>
-#include <boost/serialization/vector.hpp>
-#include <boost/serialization/set.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
 
 #include <bohrium/bh_ir.hpp>
 #include <bohrium/bh_util.hpp>
 
 using namespace std;
-using namespace boost;
-namespace io = boost::iostreams;
 
+/* The flat binary format of a serialized BhIR (version 1). All values are in the byte order of the host and the
+ * sections follow each other in the order below, each aligned to 8 bytes:
+ *
+ *   WireHeader                 the number of elements in each section
+ *   WireInstr[ninstr]          the instructions
+ *   uint32_t[noperands]        the view index of each operand (`constant_operand` for the constant)
+ *   WireView[nviews]           the views that are new to the view dictionary
+ *   WireBase[nbases]           the base arrays that are new to the de-serializing end
+ *   uint64_t[nsyncs]           the sync'ed base arrays
+ *   int64_t[npool]             the shapes, strides, and slides of the new views
+ *
+ * Base arrays are identified by their pointer on the serializing end.
+ */
+namespace {
+constexpr uint32_t wire_magic = 0x52496842; // "BhIR"
+constexpr uint32_t wire_version = 1;
+constexpr uint32_t constant_operand = 0xFFFFFFFF;
+// Flag of `WireHeader::flags`: the view dictionary is cleared before the new views are added
+constexpr uint32_t flag_reset_views = 1;
 
-BhIR::BhIR(const std::vector<char> &serialized_archive, std::map<const bh_base*, bh_base> &remote2local,
-           vector<bh_base*> &data_recv, set<bh_base*> &frees) {
+struct WireHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t nrepeats;
+    uint64_t repeat_condition;
+    uint32_t ninstr;
+    uint32_t noperands;
+    uint32_t nviews;
+    uint32_t nbases;
+    uint32_t nsyncs;
+    uint32_t npool;
+    uint32_t flags;
+    uint32_t padding;
+};
 
-    // Wrap 'serialized_archive' in an input stream
-    iostreams::basic_array_source<char> source(&serialized_archive[0], serialized_archive.size());
-    iostreams::stream<iostreams::basic_array_source<char> > input_stream(source);
-    archive::binary_iarchive ia(input_stream);
+struct WireInstr {
+    bh_opcode opcode;
+    // The operands are `noperands` indexes starting at `first_operand` in the operand section
+    uint32_t first_operand;
+    uint32_t noperands;
+    bh_constant constant;
+};
+static_assert(std::is_trivially_copyable<bh_constant>::value, "bh_constant must be copyable as bytes");
 
-    // Load number of repeats and the repeat condition
-    ia >> _nrepeats;
-    {
-        size_t t;
-        ia >> t;
-        _repeat_condition = reinterpret_cast<bh_base*>(t);
+struct WireView {
+    uint64_t base;
+    int64_t start;
+    int64_t ndim;
+    // The shape and stride (`ndim` each) followed by the slide dimensions (6 values each) and the slide resets
+    // (3 values each) start at `pool` in the pool section
+    uint32_t pool;
+    uint32_t nslide_dims;
+    uint32_t nslide_resets;
+    uint32_t padding;
+    int64_t iteration_counter;
+};
+
+struct WireBase {
+    uint64_t id;
+    // Non-zero when the array has data, which is transferred after the BhIR
+    uint64_t data;
+    int64_t nelem;
+    int64_t type;
+};
+
+constexpr size_t align8(size_t nbytes) {
+    return (nbytes + 7) / 8 * 8;
+}
+
+// The byte offsets of the sections of a serialized BhIR
+struct WireLayout {
+    size_t instrs, operands, views, bases, syncs, pool, total;
+
+    explicit WireLayout(const WireHeader &head) {
+        instrs = align8(sizeof(WireHeader));
+        operands = instrs + head.ninstr * sizeof(WireInstr);
+        views = operands + align8(head.noperands * sizeof(uint32_t));
+        bases = views + head.nviews * sizeof(WireView);
+        syncs = bases + head.nbases * sizeof(WireBase);
+        pool = syncs + head.nsyncs * sizeof(uint64_t);
+        total = pool + head.npool * sizeof(int64_t);
     }
+};
 
-    // Load the instruction list
-    ia >> instr_list;
+// Number of values a view takes up in the pool section
+size_t pool_size(const bh_view &view) {
+    return 2 * view.ndim + 6 * view.slides.dims.size() + 3 * view.slides.resets.size();
+}
+}
 
-    // Load the set of syncs
-    {
-        vector<size_t> base_as_int;
-        ia >> base_as_int;
-        for(size_t base: base_as_int) {
-            _syncs.insert(reinterpret_cast<bh_base*>(base));
+constexpr uint32_t BhIRViewDict::max_size;
+
+size_t BhIRViewDict::ViewHash::operator()(const bh_view &view) const {
+    size_t ret = std::hash<const bh_base *>()(view.base) ^ (std::hash<int64_t>()(view.start) * 31);
+    for (int64_t i = 0; i < view.ndim; ++i) {
+        ret = ret * 1000003 ^ static_cast<size_t>(view.shape[i]);
+        ret = ret * 1000003 ^ static_cast<size_t>(view.stride[i]);
+    }
+    return ret;
+}
+
+BhIR::BhIR(const std::vector<char> &serialized, std::map<const bh_base *, bh_base> &remote2local,
+           BhIRViewDict &view_dict, vector<bh_base *> &data_recv, set<bh_base *> &frees) {
+
+    if (serialized.size() < sizeof(WireHeader)) {
+        throw runtime_error("BhIR: the serialized BhIR is truncated");
+    }
+    const WireHeader &head = *reinterpret_cast<const WireHeader *>(serialized.data());
+    if (head.magic != wire_magic or head.version != wire_version) {
+        throw runtime_error("BhIR: unknown format of the serialized BhIR");
+    }
+    const WireLayout layout(head);
+    if (serialized.size() < layout.total) {
+        throw runtime_error("BhIR: the serialized BhIR is truncated");
+    }
+    const char *buf = serialized.data();
+    const auto *instrs = reinterpret_cast<const WireInstr *>(buf + layout.instrs);
+    const auto *operands = reinterpret_cast<const uint32_t *>(buf + layout.operands);
+    const auto *views = reinterpret_cast<const WireView *>(buf + layout.views);
+    const auto *bases = reinterpret_cast<const WireBase *>(buf + layout.bases);
+    const auto *syncs = reinterpret_cast<const uint64_t *>(buf + layout.syncs);
+    const auto *pool = reinterpret_cast<const int64_t *>(buf + layout.pool);
+
+    _nrepeats = head.nrepeats;
+    _repeat_condition = reinterpret_cast<bh_base *>(head.repeat_condition);
+
+    // Add the new views to the view dictionary
+    if (head.flags & flag_reset_views) {
+        view_dict.views.clear();
+    }
+    for (uint32_t i = 0; i < head.nviews; ++i) {
+        const WireView &w = views[i];
+        if (w.ndim < 0 or w.ndim > BH_MAXDIM or w.pool + 2 * w.ndim + 6 * w.nslide_dims + 3 * w.nslide_resets >
+                                                      head.npool) {
+            throw runtime_error("BhIR: corrupt view in the serialized BhIR");
+        }
+        const int64_t *values = pool + w.pool;
+        bh_view view;
+        view.base = reinterpret_cast<bh_base *>(w.base);
+        view.start = w.start;
+        view.ndim = w.ndim;
+        view.shape.assign(values, values + w.ndim);
+        view.stride.assign(values + w.ndim, values + 2 * w.ndim);
+        values += 2 * w.ndim;
+        for (uint32_t j = 0; j < w.nslide_dims; ++j, values += 6) {
+            view.slides.dims.push_back(bh_slide_dim{values[0], values[1], values[2], values[3], values[4], values[5]});
+        }
+        for (uint32_t j = 0; j < w.nslide_resets; ++j, values += 3) {
+            view.slides.resets[values[0]] = std::make_pair(values[1], values[2]);
         }
+        view.slides.iteration_counter = w.iteration_counter;
+        view_dict.views.push_back(std::move(view));
     }
 
-    // Load the new base arrays
-    std::vector<bh_base> news;
-    ia >> news;
+    // Load the instruction list
+    instr_list.resize(head.ninstr);
+    for (uint32_t i = 0; i < head.ninstr; ++i) {
+        const WireInstr &w = instrs[i];
+        if (w.first_operand + w.noperands > head.noperands) {
+            throw runtime_error("BhIR: corrupt instruction in the serialized BhIR");
+        }
+        bh_instruction &instr = instr_list[i];
+        instr.opcode = w.opcode;
+        instr.constant = w.constant;
+        instr.operand.resize(w.noperands);
+        for (uint32_t j = 0; j < w.noperands; ++j) {
+            const uint32_t idx = operands[w.first_operand + j];
+            if (idx != constant_operand) {
+                instr.operand[j] = view_dict.views.at(idx);
+            }
+        }
+    }
+
+    // Load the set of syncs
+    for (uint32_t i = 0; i < head.nsyncs; ++i) {
+        _syncs.insert(reinterpret_cast<bh_base *>(syncs[i]));
+    }
 
     // Find all freed base arrays (remote base pointers)
     for (const bh_instruction &instr: instr_list) {
@@ -74,18 +213,14 @@ BhIR::BhIR(const std::vector<char> &serialized_archive, std::map<const bh_base*,
     }
 
     // Add the new base array to 'remote2local' and to 'data_recv'
-    size_t new_base_count = 0;
-    for (const bh_instruction &instr: instr_list) {
-        for (const bh_view &v: instr.getViews()) {
-            if (not util::exist(remote2local, v.base)) {
-                assert(new_base_count < news.size());
-                remote2local.emplace(v.base, news.at(new_base_count++));
-                if (remote2local.at(v.base).getDataPtr() != nullptr)
-                    data_recv.push_back(&remote2local.at(v.base));
-            }
+    for (uint32_t i = 0; i < head.nbases; ++i) {
+        const WireBase &w = bases[i];
+        bh_base base(w.nelem, static_cast<bh_type>(w.type), reinterpret_cast<void *>(w.data));
+        auto it = remote2local.emplace(reinterpret_cast<const bh_base *>(w.id), base).first;
+        if (w.data != 0) {
+            data_recv.push_back(&it->second);
         }
     }
-    assert(new_base_count == news.size());
 
     // Update all base pointers to point to the local bases
     for (bh_instruction &instr: instr_list) {
@@ -95,7 +230,7 @@ BhIR::BhIR(const std::vector<char> &serialized_archive, std::map<const bh_base*,
     }
     // Update all base pointers in the bhir's `_syncs` set
     {
-        set<bh_base*> syncs_as_local_ptr;
+        set<bh_base *> syncs_as_local_ptr;
         for (bh_base *base: _syncs) {
             if (util::exist(remote2local, base)) {
                 syncs_as_local_ptr.insert(&remote2local.at(base));
@@ -107,48 +242,132 @@ BhIR::BhIR(const std::vector<char> &serialized_archive, std::map<const bh_base*,
     if (_repeat_condition != nullptr) {
         _repeat_condition = &remote2local.at(_repeat_condition);
     }
-
 }
 
-std::vector<char> BhIR::writeSerializedArchive(set<bh_base *> &known_base_arrays, vector<bh_base *> &new_data) {
+std::vector<char> BhIR::writeSerialized(set<bh_base *> &known_base_arrays, BhIRViewDict &view_dict,
+                                        vector<bh_base *> &new_data) {
+    WireHeader head{};
+    head.magic = wire_magic;
+    head.version = wire_version;
+    head.nrepeats = _nrepeats;
 
-    // Find new base arrays in 'bhir', which the de-serializing component should know about, and their data (if any)
-    vector<bh_base> new_bases; // New base arrays in the order they appear in the instruction list
-    for (bh_instruction &instr: instr_list) {
-        for (const bh_view &v: instr.getViews()) {
+    // Start a new view dictionary if the views of this BhIR might not fit
+    size_t max_new_views = 0;
+    for (const bh_instruction &instr: instr_list) {
+        max_new_views += instr.operand.size();
+    }
+    if (view_dict.size + max_new_views > BhIRViewDict::max_size) {
+        view_dict.index.clear();
+        view_dict.size = 0;
+        head.flags |= flag_reset_views;
+    }
+
+    // Find the view index of each operand, the new views, and the new base arrays, which the de-serializing
+    // component should know about, and their data (if any)
+    vector<uint32_t> operands;
+    vector<const bh_view *> new_views;
+    vector<const bh_base *> new_bases; // New base arrays in the order they appear in the instruction list
+    size_t npool = 0;
+    for (const bh_instruction &instr: instr_list) {
+        for (const bh_view &v: instr.operand) {
+            if (v.isConstant()) {
+                operands.push_back(constant_operand);
+                continue;
+            }
             if (not util::exist(known_base_arrays, v.base)) {
-                new_bases.push_back(*v.base);
+                new_bases.push_back(v.base);
                 known_base_arrays.insert(v.base);
                 if (v.base->getDataPtr() != nullptr) {
                     new_data.push_back(v.base);
                 }
             }
+            if (not v.hasSlide()) {
+                auto it = view_dict.index.find(v);
+                if (it != view_dict.index.end()) {
+                    operands.push_back(it->second);
+                    continue;
+                }
+                view_dict.index.emplace(v, view_dict.size);
+            }
+            operands.push_back(view_dict.size++);
+            new_views.push_back(&v);
+            npool += pool_size(v);
         }
     }
+    if (_repeat_condition != nullptr and util::exist(known_base_arrays, _repeat_condition)) {
+        head.repeat_condition = reinterpret_cast<uint64_t>(_repeat_condition);
+    }
+    head.ninstr = static_cast<uint32_t>(instr_list.size());
+    head.noperands = static_cast<uint32_t>(operands.size());
+    head.nviews = static_cast<uint32_t>(new_views.size());
+    head.nbases = static_cast<uint32_t>(new_bases.size());
+    head.nsyncs = static_cast<uint32_t>(_syncs.size());
+    head.npool = static_cast<uint32_t>(npool);
 
-    // Wrap 'ret' in an output stream
-    std::vector<char> ret;
-    iostreams::stream<iostreams::back_insert_device<vector<char> > > output_stream(ret);
-    archive::binary_oarchive oa(output_stream);
+    // Write all sections directly into the returned buffer
+    const WireLayout layout(head);
+    std::vector<char> ret(layout.total);
+    char *buf = ret.data();
+    memcpy(buf, &head, sizeof(head));
 
-    // Write number of repeats and the repeat condition
-    oa << _nrepeats;
-    if (_repeat_condition != nullptr and util::exist(known_base_arrays, _repeat_condition)) {
-        size_t t = reinterpret_cast<size_t >(_repeat_condition);
-        oa << t;
-    } else {
-        size_t t = 0;
-        oa << t;
+    auto *instrs = reinterpret_cast<WireInstr *>(buf + layout.instrs);
+    uint32_t first_operand = 0;
+    for (const bh_instruction &instr: instr_list) {
+        WireInstr &w = *instrs++;
+        w.opcode = instr.opcode;
+        w.first_operand = first_operand;
+        w.noperands = static_cast<uint32_t>(instr.operand.size());
+        w.constant = instr.constant;
+        first_operand += w.noperands;
+    }
+    if (not operands.empty()) {
+        memcpy(buf + layout.operands, operands.data(), operands.size() * sizeof(uint32_t));
+    }
+
+    auto *views = reinterpret_cast<WireView *>(buf + layout.views);
+    auto *pool = reinterpret_cast<int64_t *>(buf + layout.pool);
+    uint32_t pool_offset = 0;
+    for (const bh_view *v: new_views) {
+        WireView &w = *views++;
+        w.base = reinterpret_cast<uint64_t>(v->base);
+        w.start = v->start;
+        w.ndim = v->ndim;
+        w.pool = pool_offset;
+        w.nslide_dims = static_cast<uint32_t>(v->slides.dims.size());
+        w.nslide_resets = static_cast<uint32_t>(v->slides.resets.size());
+        w.iteration_counter = v->slides.iteration_counter;
+        int64_t *values = pool + pool_offset;
+        std::copy(v->shape.begin(), v->shape.end(), values);
+        std::copy(v->stride.begin(), v->stride.end(), values + v->ndim);
+        values += 2 * v->ndim;
+        for (const bh_slide_dim &d: v->slides.dims) {
+            *values++ = d.rank;
+            *values++ = d.offset_change;
+            *values++ = d.shape_change;
+            *values++ = d.stride;
+            *values++ = d.shape;
+            *values++ = d.step_delay;
+        }
+        for (const auto &reset: v->slides.resets) {
+            *values++ = reset.first;
+            *values++ = reset.second.first;
+            *values++ = reset.second.second;
+        }
+        pool_offset += static_cast<uint32_t>(pool_size(*v));
     }
 
-    // Write the instruction list
-    oa << instr_list;
+    auto *bases = reinterpret_cast<WireBase *>(buf + layout.bases);
+    for (const bh_base *base: new_bases) {
+        WireBase &w = *bases++;
+        w.id = reinterpret_cast<uint64_t>(base);
+        w.data = reinterpret_cast<uint64_t>(base->getDataPtr());
+        w.nelem = base->nelem();
+        w.type = static_cast<int64_t>(base->dtype());
+    }
 
-    vector<size_t> base_as_int;
-    for(bh_base *base: _syncs) {
-        base_as_int.push_back(reinterpret_cast<size_t>(base));
+    auto *syncs = reinterpret_cast<uint64_t *>(buf + layout.syncs);
+    for (const bh_base *base: _syncs) {
+        *syncs++ = reinterpret_cast<uint64_t>(base);
     }
-    oa << base_as_int;
-    oa << new_bases;
     return ret;
 }
@@ -107,10 +107,18 @@ void main_mem_free(void *mem, uint64_t nbytes) {
 MallocCache malloc_cache(main_mem_malloc, main_mem_free, 0);
 }
 
-void bh_data_malloc(bh_base *base) {
-    if (base == nullptr) return;
-    if (base->getDataPtr() != nullptr) return;
-    base->resetDataPtr(malloc_cache.alloc(base->nbytes()));
+bool bh_data_malloc(bh_base *base) {
+    if (base == nullptr) return false;
+    if (base->getDataPtr() != nullptr) return false;
+    bool fresh;
+    base->resetDataPtr(malloc_cache.alloc(base->nbytes(), &fresh));
+    return fresh; // `main_mem_malloc()` uses anonymous mappings, which are zero-filled by the kernel
+}
+
+void bh_data_adopt(bh_base *base, void *mem) {
+    assert(base->getDataPtr() == nullptr);
+    malloc_cache.adopt(base->nbytes());
+    base->resetDataPtr(mem);
 }
 
 void bh_data_free(bh_base *base) {
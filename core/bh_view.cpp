@@ -69,6 +69,47 @@ void bh_view::transpose(int64_t axis1, int64_t axis2) {
     slides.transpose(axis1, axis2);
 }
 
+void bh_view::slide() {
+    // The relevant dimension in the view is updated by the given stride
+    for (const bh_slide_dim &dim: slides.dims) {
+        if (dim.step_delay == 1 || (slides.iteration_counter % dim.step_delay == dim.step_delay-1)) {
+            if (dim.stride) {
+                int64_t change = dim.offset_change*dim.stride;
+                int64_t max_rel_idx = dim.stride*dim.shape;
+                int64_t rel_idx = start % (dim.stride*dim.shape);
+                rel_idx += change;
+                if (rel_idx < 0) {
+                    change += max_rel_idx;
+                } else if (rel_idx >= max_rel_idx) {
+                    change -= max_rel_idx;
+                }
+                start += change;
+
+                // We may have to reset the iteration
+                auto it = slides.resets.find(dim.rank);
+                if (it != slides.resets.end()) {
+                    const int64_t reset_at = it->second.first;
+                    int64_t &changes_since_reset = it->second.second;
+                    changes_since_reset += change;
+                    if (slides.iteration_counter > 0) {
+                        if ((slides.iteration_counter / dim.step_delay) % reset_at == reset_at - 1) {
+                            start -= changes_since_reset;
+                            changes_since_reset = 0;
+                            shape[dim.rank] -= reset_at * dim.shape_change;
+                        }
+                    }
+                }
+            }
+            shape[dim.rank] += dim.shape_change;
+            // We allow the user to make the shape negative, but we set it to zero here to prevent confusion
+            if(shape[dim.rank] < 0) {
+                shape[dim.rank] = 0;
+            }
+        }
+    }
+    slides.iteration_counter += 1;
+}
+
 bool bh_view::isContiguous() const {
     if (isConstant()) {
         return false;
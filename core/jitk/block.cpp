@@ -683,6 +683,11 @@ bool mergeable(const Block &b1, const Block &b2, bool avoid_rank0_sweep) {
         return false;
     }
 
+    // Or if 'b2' sweeps into an array that 'b1' accesses, since the sweep writes all of it in every iteration
+    if (sweeps_accessed_by_block(l2._sweeps, l1)) {
+        return false;
+    }
+
     if (l1.size == l2.size or // Perfect match
         (l2._reshapable && l2.size % l1.size == 0) or // 'l2' is reshapable to match 'l1'
         (l1._reshapable && l1.size % l2.size == 0)) { // 'l1' is reshapable to match 'l2'
@@ -18,6 +18,8 @@ GNU Lesser General Public License along with Bohrium.
 If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstring>
+#include <list>
 #include <vector>
 #include <iostream>
 
@@ -30,105 +32,190 @@ namespace jitk {
 
 namespace {
 
+// Tags that separates the fields of the hash
+constexpr uint64_t TAG_LOOP = UINT64_MAX;
+constexpr uint64_t TAG_LOOP_END = UINT64_MAX - 1;
+constexpr uint64_t TAG_INSTR = UINT64_MAX - 2;
+constexpr uint64_t TAG_VIEW = UINT64_MAX - 3;
+constexpr uint64_t TAG_CONST_ID = UINT64_MAX - 4;
+constexpr uint64_t TAG_CONST_VALUE = UINT64_MAX - 5;
+
+// Returns the bits of `value`
+template<typename T>
+uint64_t bits(T value) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "the value must fit in 64 bits");
+    uint64_t ret = 0;
+    memcpy(&ret, &value, sizeof(T));
+    return ret;
+}
+
+/* The Constant hash consists of the value of the constant packed by its type
+ */
+void hash_stream(const bh_constant &constant, StructuralHasher &hasher) {
+    switch (constant.type) {
+        case bh_type::BOOL:
+            hasher.add(constant.value.bool8);
+            return;
+        case bh_type::INT8:
+            hasher.add_signed(constant.value.int8);
+            return;
+        case bh_type::INT16:
+            hasher.add_signed(constant.value.int16);
+            return;
+        case bh_type::INT32:
+            hasher.add_signed(constant.value.int32);
+            return;
+        case bh_type::INT64:
+            hasher.add_signed(constant.value.int64);
+            return;
+        case bh_type::UINT8:
+            hasher.add(constant.value.uint8);
+            return;
+        case bh_type::UINT16:
+            hasher.add(constant.value.uint16);
+            return;
+        case bh_type::UINT32:
+            hasher.add(constant.value.uint32);
+            return;
+        case bh_type::UINT64:
+            hasher.add(constant.value.uint64);
+            return;
+        case bh_type::FLOAT32:
+            hasher.add(bits(constant.value.float32));
+            return;
+        case bh_type::FLOAT64:
+            hasher.add(bits(constant.value.float64));
+            return;
+        case bh_type::COMPLEX64:
+            hasher.add(bits(constant.value.complex64.real));
+            hasher.add(bits(constant.value.complex64.imag));
+            return;
+        case bh_type::COMPLEX128:
+            hasher.add(bits(constant.value.complex128.real));
+            hasher.add(bits(constant.value.complex128.imag));
+            return;
+        case bh_type::R123:
+            hasher.add(constant.value.r123.start);
+            hasher.add(constant.value.r123.key);
+            return;
+        default:
+            throw runtime_error("hash_stream(): unknown constant type");
+    }
+}
+
 /* The View hash consists of the following fields:
- * <view_id><start><ndim>[<shape><stride><SEP_SHAPE>...]<SEP_OP>
+ * <TAG_VIEW><dtype><base_id><always_array>[<offset_strides_id> or <start><ndim>[<shape><stride>...]]
+ * [<index_id><is_scalar>]
  */
-void hash_stream(const bh_view &view, const SymbolTable &symbols, std::stringstream &ss) {
-    ss << "dtype: " << static_cast<uint32_t>(view.base->dtype());
-    ss << "baseid: " << symbols.baseID(view.base);
-    ss << "always array: " << (symbols.isAlwaysArray(view.base)?"true":"false");
+void hash_stream(const bh_view &view, const SymbolTable &symbols, StructuralHasher &hasher) {
+    hasher.add(TAG_VIEW);
+    hasher.add(static_cast<uint64_t>(view.base->dtype()));
+    hasher.add(symbols.baseID(view.base));
+    hasher.add(symbols.isAlwaysArray(view.base));
 
     if (symbols.strides_as_var) {
-        ss << "strideid: " << symbols.offsetStridesID(view);
+        hasher.add(symbols.offsetStridesID(view));
     } else {
-        ss << "vstart: " << view.start;
+        hasher.add_signed(view.start);
+        hasher.add_signed(view.ndim);
         for (int j = 0; j < view.ndim; ++j) {
-            ss << "dim: " << j;
-            ss << "shape: " << view.shape[j];
-            ss << "stride: " << view.stride[j];
+            hasher.add_signed(view.shape[j]);
+            hasher.add_signed(view.stride[j]);
         }
     }
     if (symbols.index_as_var) {
-        ss << "indexid: " << symbols.idxID(view);
-        if (view.is_scalar()) { // We optimize indexes into 1-sized arrays, which we need the hash to reflect
-            ss << "is-1-elem: " << endl;
-        }
+        hasher.add(symbols.idxID(view));
+        // We optimize indexes into 1-sized arrays, which we need the hash to reflect
+        hasher.add(view.is_scalar());
     }
 }
 
 /* The Instruction hash consists of the following fields:
- * <opcode[<hash_view>...]<sweep_axis()><SEP_INSTR>
+ * <TAG_INSTR><opcode><constructor>[<hash_view> or <TAG_CONST_ID><const_id><dtype>
+ * or <TAG_CONST_VALUE><value><dtype>...]<sweep_axis()>
  */
-void hash_stream(const bh_instruction &instr, const SymbolTable &symbols, std::stringstream &ss) {
-    ss << "opcode: " << instr.opcode;
-    ss << "constructor: " << (instr.constructor?"true":"false");
+void hash_stream(const bh_instruction &instr, const SymbolTable &symbols, StructuralHasher &hasher) {
+    hasher.add(TAG_INSTR);
+    hasher.add(instr.opcode);
+    hasher.add(instr.constructor);
     for (const bh_view &op: instr.operand) {
         if (op.isConstant()) {
-            int64_t id = symbols.constID(instr);
-            if (id >= 0 and symbols.const_as_var) {
-                ss << "const: " << symbols.constID(instr);
+            const int64_t id = symbols.const_as_var ? symbols.constID(instr) : -1;
+            if (id >= 0) {
+                hasher.add(TAG_CONST_ID);
+                hasher.add_signed(id);
             } else {
-                ss << "const: " << instr.constant;
+                hasher.add(TAG_CONST_VALUE);
+                hash_stream(instr.constant, hasher);
             }
-            ss << "const dtype: " << static_cast<uint32_t >(instr.constant.type);
+            hasher.add(static_cast<uint64_t>(instr.constant.type));
         } else {
-            hash_stream(op, symbols,  ss);
+            hash_stream(op, symbols, hasher);
         }
     }
-    ss << "sweep: " << instr.sweep_axis();
+    hasher.add_signed(instr.sweep_axis());
 }
 
 /* The Block hash consists of the following fields:
- * <block_rank><instr_hash><SEP_BLOCK>
+ * <TAG_LOOP><rank><size><number of freed>[<freed_base_id>...][<hash_instr> or <hash_block>...]<TAG_LOOP_END>
  */
-void hash_stream(const LoopB &block, const SymbolTable &symbols, std::stringstream &ss) {
-    ss << "rank: " << block.rank;
-    ss << "size: " << block.size;
+void hash_stream(const LoopB &block, const SymbolTable &symbols, StructuralHasher &hasher) {
+    hasher.add(TAG_LOOP);
+    hasher.add_signed(block.rank);
+    hasher.add_signed(block.size);
     {  // The order of BH_FREE within a block doesn't matter, thus we sort the freed base IDs here
-        ss << "freed: ";
-        set<uint64_t>sorted_freed_bases;
+        set<uint64_t> sorted_freed_bases;
         for (const bh_base *b: block._frees) {
             sorted_freed_bases.insert(symbols.baseID(b));
         }
-        for(uint64_t b_id: sorted_freed_bases) {
-            ss << b_id << ",";
+        hasher.add(sorted_freed_bases.size());
+        for (uint64_t b_id: sorted_freed_bases) {
+            hasher.add(b_id);
         }
     }
     for (const Block &b: block._block_list) {
         if (b.isInstr()) {
             if (b.getInstr()->opcode != BH_FREE) {
-                hash_stream(*b.getInstr(), symbols, ss);
+                hash_stream(*b.getInstr(), symbols, hasher);
             }
         } else {
-            hash_stream(b.getLoop(), symbols, ss);
+            hash_stream(b.getLoop(), symbols, hasher);
         }
     }
-}
-
-/* The Block hash from above as an uint64_t */
-uint64_t hash_stream(const LoopB &block, const SymbolTable &symbols) {
-    stringstream ss;
-    hash_stream(block, symbols, ss);
-    return util::hash(ss.str());
+    hasher.add(TAG_LOOP_END);
 }
 } // Anonymous Namespace
 
-std::pair<std::string, uint64_t> CodegenCache::lookup(const LoopB &kernel, const SymbolTable &symbols) {
+std::pair<const CodegenCache::Source *, StructuralKey> CodegenCache::lookup(const LoopB &kernel,
+                                                                          const SymbolTable &symbols) {
     ++stat.codegen_cache_lookups;
-    const uint64_t lookup_hash = hash_stream(kernel, symbols);
-    auto lookup = _cache.find(lookup_hash);
-    if (lookup != _cache.end()) { // Cache hit!
-        return make_pair(lookup->second, lookup_hash);
-    } else {
-        ++stat.codegen_cache_misses;
-        return make_pair("", lookup_hash);
+    _hasher.clear();
+    hash_stream(kernel, symbols, _hasher);
+    StructuralKey key;
+    key.hash = _hasher.digest();
+    auto lookup = _cache.find(key.hash);
+    if (lookup != _cache.end()) {
+        // NB: hash collisions are detected by comparing the hashed fields
+        for (Entry &entry: lookup->second) {
+            if (entry.fields == _hasher.fields()) { // Cache hit!
+                return make_pair(&entry.source, std::move(key));
+            }
+        }
     }
+    ++stat.codegen_cache_misses;
+    key.fields = _hasher.release();
+    return make_pair(nullptr, std::move(key));
 }
 
-void CodegenCache::insert(std::string source, const LoopB &kernel, const SymbolTable &symbols) {
-    const uint64_t lookup_hash = hash_stream(kernel, symbols);
-    assert(_cache.find(lookup_hash) == _cache.end()); // The source shouldn't exist in the cache already
-    _cache[lookup_hash] = std::move(source);
+const CodegenCache::Source &CodegenCache::insert(std::string source, StructuralKey key) {
+    // NB: on a hash collision, the existing entries stay valid since we only append to the list of the hash
+    list<Entry> &entries = _cache[key.hash];
+    entries.emplace_back();
+    Entry &ret = entries.back();
+    ret.fields = std::move(key.fields);
+    ret.source.hash = util::hash(source);
+    ret.source.code = std::move(source);
+    return ret.source;
 }
 
 } // jitk
@@ -102,7 +102,7 @@ std::vector<InstrPtr> order_sweep_set(const std::set<InstrPtr> &sweep_set, const
     ret.reserve(sweep_set.size());
     std::copy(sweep_set.begin(),  sweep_set.end(), std::back_inserter(ret));
     std::sort(ret.begin(), ret.end(),
-             [symbols](const InstrPtr & a, const InstrPtr & b) -> bool
+             [&symbols](const InstrPtr & a, const InstrPtr & b) -> bool
              {
                  return symbols.viewID(a->operand[0]) > symbols.viewID(b->operand[0]);
              });
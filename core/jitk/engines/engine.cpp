@@ -217,11 +217,34 @@ void Engine::writeBlock(const SymbolTable &symbols,
                 writeInstr(scope, *instr, 4 + b.rank() * 4, opencl, out);
             }
         } else {
+            // Declare the part of the indexes of the loop that depends on the outer loops before the loop header
+            // thus the index calculations inside the loop only involve the iterators of the loop and its inner loops
+            const LoopB &loop = b.getLoop();
+            if (symbols.index_as_var and loop.rank > 0) {
+                const set<bh_base *> &local_tmps = loop.getLocalTemps();
+                for (const InstrPtr &instr: iterator::allLocalInstr(loop)) {
+                    for (size_t i = 0; i < instr->operand.size(); ++i) {
+                        const bh_view &view = instr->operand[i];
+                        if (view.isConstant() or view.ndim < 2 or view.is_scalar() or
+                            (i == 0 and bh_opcode_is_reduction(instr->opcode))) {
+                            continue; // NB: the output of a reduction hides the sweep axis
+                        }
+                        if (symbols.existIdxID(view) and scope.isArray(view) and
+                            not util::exist(local_tmps, view.base) and not scope.isIdxDeclared(view) and
+                            scope.idxBaseRank(view) < loop.rank) {
+                            util::spaces(out, 4 + b.rank() * 4);
+                            scope.writeIdxBaseDeclaration(view, writeType(bh_type::UINT64), loop.rank, out);
+                            out << "\n";
+                        }
+                    }
+                }
+            }
             util::spaces(out, 4 + b.rank() * 4);
             loopHeadWriter(symbols, scope, b.getLoop(), thread_stack, out);
             writeBlock(symbols, &scope, b.getLoop(), thread_stack, opencl, out);
             util::spaces(out, 4 + b.rank() * 4);
             out << "}\n";
+            loopTailWriter(symbols, scope, b.getLoop(), out);
         }
     }
 
@@ -332,7 +355,7 @@ void Engine::writeInstr(Scope &scope, const bh_instruction &instr, int indent, b
             ops.push_back(ss.str());
         }
     }
-    write_operation(instr, ops, out, opencl);
+    write_operation(instr, ops, out, opencl, fast_math);
 }
 
 void Engine::setConstructorFlag(std::vector<bh_instruction *> &instr_list, std::set<bh_base *> &constructed_arrays) {
@@ -341,7 +364,8 @@ void Engine::setConstructorFlag(std::vector<bh_instruction *> &instr_list, std::
         for (size_t o = 0; o < instr->operand.size(); ++o) {
             const bh_view &v = instr->operand[o];
             if (not v.isConstant()) {
-                if (o == 0 and not util::exist_nconst(constructed_arrays, v.base)) {
+                // Notice, an array that has data already has been constructed by a previous flush
+                if (o == 0 and v.base->getDataPtr() == nullptr and not util::exist_nconst(constructed_arrays, v.base)) {
                     instr->constructor = true;
                 }
                 constructed_arrays.insert(v.base);
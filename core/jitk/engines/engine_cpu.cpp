@@ -19,12 +19,16 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 #include <vector>
 #include <set>
+#include <atomic>
+#include <thread>
+#include <tuple>
 
 #include <bohrium/jitk/engines/engine_cpu.hpp>
 
 #include <bohrium/bh_config_parser.hpp>
 #include <bohrium/jitk/statistics.hpp>
 #include <bohrium/jitk/apply_fusion.hpp>
+#include <bohrium/jitk/graph.hpp>
 
 #include <bohrium/bh_view.hpp>
 #include <bohrium/bh_component.hpp>
@@ -36,7 +40,328 @@ using namespace std;
 namespace bohrium {
 namespace jitk {
 
+namespace {
+
+// Returns the source of `kernel` and its codegen hash. The source is generated if not in the codegen cache.
+pair<const CodegenCache::Source *, uint64_t> get_source(EngineCPU &engine, CodegenCache &codegen_cache,
+                                                        Statistics &stat, const LoopB &kernel,
+                                                        const SymbolTable &symbols) {
+    auto lookup = codegen_cache.lookup(kernel, symbols);
+    const uint64_t codegen_hash = lookup.second.hash.lo;
+    if (lookup.first != nullptr) {
+        // In debug mode, we check that the cached source code is correct
+        #ifndef NDEBUG
+            stringstream ss;
+            engine.writeKernel(kernel, symbols, {}, codegen_hash, ss);
+            if (ss.str().compare(lookup.first->code) != 0) {
+                cout << "\nCached source code: \n" << lookup.first->code;
+                cout << "\nReal source code: \n" << ss.str();
+                assert(1 == 2);
+            }
+        #endif
+        return make_pair(lookup.first, codegen_hash);
+    }
+    const auto tcodegen = chrono::steady_clock::now();
+    stringstream ss;
+    engine.writeKernel(kernel, symbols, {}, codegen_hash, ss);
+    stat.time_codegen += chrono::steady_clock::now() - tcodegen;
+    return make_pair(&codegen_cache.insert(ss.str(), std::move(lookup.second)), codegen_hash);
+}
+
+// Writes the constants of the kernel of `symbols` into `constants`
+void get_constants(const SymbolTable &symbols, vector<const bh_instruction *> &constants) {
+    constants.clear();
+    for (const InstrPtr &instr: symbols.constIDs()) {
+        constants.push_back(&(*instr));
+    }
+}
+
+// Returns true when a kernel can slide `view` between the iterations of a repeat, which requires that the slides
+// never change the shape of the view
+bool slide_in_kernel_compatible(const bh_view &view) {
+    if (not view.slides.resets.empty()) {
+        return false;
+    }
+    for (const bh_slide_dim &dim: view.slides.dims) {
+        if (dim.shape_change != 0 or dim.step_delay < 1 or (dim.stride != 0 and dim.shape == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns true when `a` and `b` slide identically
+bool same_slides(const bh_view &a, const bh_view &b) {
+    if (a.slides.iteration_counter != b.slides.iteration_counter or a.slides.dims.size() != b.slides.dims.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.slides.dims.size(); ++i) {
+        const bh_slide_dim &x = a.slides.dims[i];
+        const bh_slide_dim &y = b.slides.dims[i];
+        if (x.rank != y.rank or x.offset_change != y.offset_change or x.shape_change != y.shape_change or
+            x.stride != y.stride or x.shape != y.shape or x.step_delay != y.step_delay) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the number of iterations after which the slides of `views` bring all starts back to where they were, which
+// is the least common multiple of `shape * step_delay` of the sliding dimensions, or `limit + 1` when that exceeds
+// `limit`. Notice, the slides wrap around thus a start that changes by less than its dimension returns after
+// `shape` changes.
+uint64_t slide_period(const vector<bh_view> &views, uint64_t limit) {
+    uint64_t period = 1;
+    for (const bh_view &view: views) {
+        for (const bh_slide_dim &dim: view.slides.dims) {
+            if (dim.stride == 0) {
+                continue;
+            }
+            const auto length = static_cast<uint64_t>(dim.shape * dim.step_delay);
+            uint64_t gcd = period;
+            for (uint64_t b = length; b != 0;) {
+                const uint64_t t = gcd % b;
+                gcd = b;
+                b = t;
+            }
+            const uint64_t factor = length / gcd;
+            if (factor > limit / period) {
+                return limit + 1;
+            }
+            period *= factor;
+        }
+    }
+    return period;
+}
+
+// Returns true when the kernel of the first iteration of a repeat of `instr_list` is valid for all `nrepeats`
+// iterations. The fusion and the symbol table only compare view starts for equality thus the kernel is valid
+// as long as the starts that are equal stay equal and the starts that differ stay different.
+// The slides are periodic thus only the iterations until the starts are back where they were need checking. When
+// that takes more than `max_simulated` iterations, we give up and let the caller execute iteration by iteration.
+bool kernel_is_repeat_invariant(const vector<bh_instruction *> &instr_list, uint64_t nrepeats) {
+    const uint64_t max_simulated = 100000;
+
+    // The unique views of `instr_list`
+    vector<bh_view> views;
+    for (const bh_instruction *instr: instr_list) {
+        for (const bh_view &view: instr->getViews()) {
+            bool found = false;
+            for (const bh_view &v: views) {
+                if (v == view and same_slides(v, view)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (not found) {
+                views.push_back(view);
+            }
+        }
+    }
+
+    // The pairs of views where the equality of their starts matters, which are views of the same base (fusion)
+    // and views with identical shapes and strides (IDs of the symbol table). Pairs that do not slide never change.
+    vector<tuple<size_t, size_t, bool> > pairs;
+    for (size_t i = 0; i < views.size(); ++i) {
+        for (size_t j = i + 1; j < views.size(); ++j) {
+            const bh_view &a = views[i];
+            const bh_view &b = views[j];
+            if ((a.hasSlide() or b.hasSlide()) and
+                (a.base == b.base or (a.ndim == b.ndim and a.shape == b.shape and a.stride == b.stride))) {
+                pairs.emplace_back(i, j, a.start == b.start);
+            }
+        }
+    }
+    if (pairs.empty()) {
+        return true;
+    }
+
+    const uint64_t period = slide_period(views, max_simulated);
+    const uint64_t nslides = std::min(nrepeats - 1, period);
+    if (nslides > max_simulated) {
+        return false;
+    }
+    vector<int64_t> starts;
+    for (const bh_view &view: views) {
+        starts.push_back(view.start);
+    }
+    for (uint64_t i = 1; i <= nslides; ++i) {
+        for (bh_view &view: views) {
+            if (view.hasSlide()) {
+                view.slide();
+            }
+        }
+        for (const auto &pair: pairs) {
+            if ((views[get<0>(pair)].start == views[get<1>(pair)].start) != get<2>(pair)) {
+                return false;
+            }
+        }
+    }
+    // A slide larger than its dimension wraps around only once thus such a start might not be back yet
+    if (nslides < nrepeats - 1) {
+        for (size_t i = 0; i < views.size(); ++i) {
+            if (views[i].start != starts[i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+void EngineCPU::execute(const jitk::SymbolTable &symbols,
+                        const CodegenCache::Source &source,
+                        uint64_t codegen_hash,
+                        const std::vector<const bh_instruction *> &constants) {
+    runLaunch(prepare(symbols, source, codegen_hash, constants));
+}
+
+void EngineCPU::runLaunch(const KernelLaunch &launch) {
+    auto start_exec = chrono::steady_clock::now();
+    launch.run(0);
+    auto texec = chrono::steady_clock::now() - start_exec;
+    stat.time_exec += texec;
+    stat.time_per_kernel[launch.filename].register_exec_time(texec);
+}
+
+TrivialKernel EngineCPU::getTrivialKernel(const LoopB &kernel) const {
+    return trivial_kernels ? classify_trivial_kernel(kernel) : TrivialKernel();
+}
+
+void EngineCPU::executeTrivial(const TrivialKernel &kernel, uint64_t max_threads) {
+    ++stat.num_trivial_kernels;
+    if (alloc_trivial_kernel(kernel)) {
+        ++stat.num_skipped_zero_fills;
+        return;
+    }
+    if (_pool == nullptr and std::thread::hardware_concurrency() > 1) {
+        _pool.reset(new ThreadPool(std::thread::hardware_concurrency() - 1));
+    }
+    const auto start_exec = chrono::steady_clock::now();
+    run_trivial_kernel(kernel, nontemporal_threshold, _pool.get(), max_threads);
+    stat.time_exec += chrono::steady_clock::now() - start_exec;
+}
+
+bool EngineCPU::executeConcurrently(const vector<LoopB> &kernel_list) {
+    // The dependencies between the kernels. Notice, the vertex IDs corresponds to the indexes in `kernel_list`.
+    const graph::DAG dag = graph::from_block_list(vector<Block>(kernel_list.begin(), kernel_list.end()));
+
+    // Nothing to gain when the kernels form a chain
+    bool is_chain = true;
+    for (uint64_t i = 1; i < kernel_list.size() and is_chain; ++i) {
+        is_chain = boost::edge(i - 1, i, dag).second;
+    }
+    if (is_chain) {
+        return false;
+    }
+
+    // Let's compile all kernels and prepare their arguments. Since this is not thread-safe, we do it up front.
+    vector<KernelLaunch> launches(kernel_list.size());
+    vector<const bh_instruction *> constants;
+    for (uint64_t i = 0; i < kernel_list.size(); ++i) {
+        const LoopB &kernel = kernel_list[i];
+        const SymbolTable symbols(kernel, use_volatile, strides_as_var, index_as_var, const_as_var);
+        stat.record(symbols);
+        if (kernel.isSystemOnly()) {
+            continue;
+        }
+        const TrivialKernel trivial = getTrivialKernel(kernel);
+        if (trivial.kind != TrivialKernel::NONE) {
+            // Trivial kernels run serially since they share the cores with the other kernels
+            ++stat.num_trivial_kernels;
+            if (alloc_trivial_kernel(trivial)) {
+                ++stat.num_skipped_zero_fills;
+            } else {
+                const uint64_t threshold = nontemporal_threshold;
+                launches[i].run = [trivial, threshold](int) { run_trivial_kernel(trivial, threshold, nullptr, 1); };
+            }
+        } else {
+            const bh_instruction *single = single_instr_of_kernel(kernel);
+            if (single != nullptr) {
+                launches[i] = prepareGeneric(*single);
+            }
+            if (launches[i].run) {
+                ++stat.num_generic_kernels;
+            } else {
+                const auto source = get_source(*this, codegen_cache, stat, kernel, symbols);
+                get_constants(symbols, constants);
+                launches[i] = prepare(symbols, *source.first, source.second, constants);
+            }
+        }
+    }
+
+    if (_kernel_pool == nullptr) {
+        _kernel_pool.reset(new ThreadPool(static_cast<uint64_t>(kernel_concurrency)));
+    }
+    // We cap the threads of each kernel such that the concurrent kernels share the cores
+    const uint64_t num_concurrent = std::min(_kernel_pool->size(), static_cast<uint64_t>(kernel_list.size()));
+    const int max_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency() / num_concurrent));
+
+    // The number of unfinished dependencies of each kernel
+    vector<atomic<uint64_t> > num_deps(kernel_list.size());
+    for (uint64_t i = 0; i < kernel_list.size(); ++i) {
+        num_deps[i] = boost::in_degree(i, dag);
+    }
+    vector<chrono::duration<double> > exec_times(kernel_list.size());
+    atomic<uint64_t> num_running{0};
+    atomic<uint64_t> max_running{0};
+
+    // Executes kernel `i` and then submits the kernels that become ready
+    std::function<void(graph::Vertex)> task = [&](graph::Vertex i) {
+        if (launches[i].run) {
+            uint64_t running = ++num_running;
+            uint64_t peak = max_running.load();
+            while (running > peak and not max_running.compare_exchange_weak(peak, running)) {}
+
+            const auto start_exec = chrono::steady_clock::now();
+            launches[i].run(max_threads);
+            exec_times[i] = chrono::steady_clock::now() - start_exec;
+            --num_running;
+        }
+        BOOST_FOREACH (const graph::Vertex v, boost::adjacent_vertices(i, dag)) {
+            if (--num_deps[v] == 0) {
+                _kernel_pool->submit([&task, v]() { task(v); });
+            }
+        }
+    };
+
+    const auto start_exec = chrono::steady_clock::now();
+    BOOST_FOREACH (const graph::Vertex v, boost::vertices(dag)) {
+        if (boost::in_degree(v, dag) == 0) {
+            _kernel_pool->submit([&task, v]() { task(v); });
+        }
+    }
+    _kernel_pool->wait();
+    const chrono::duration<double> texec = chrono::steady_clock::now() - start_exec;
+
+    // Finally, let's record the statistics and cleanup
+    chrono::duration<double> tbusy{0};
+    for (uint64_t i = 0; i < kernel_list.size(); ++i) {
+        if (launches[i].run) {
+            tbusy += exec_times[i];
+            if (not launches[i].filename.empty()) {
+                stat.time_per_kernel[launches[i].filename].register_exec_time(exec_times[i]);
+            }
+        }
+        for (bh_base *base: kernel_list[i].getAllFrees()) {
+            bh_data_free(base);
+        }
+    }
+    stat.time_exec += texec;
+    stat.record_concurrency(tbusy, texec, max_running);
+    if (verbose) {
+        cout << "Executed " << kernel_list.size() << " kernels concurrently (average concurrency: "
+             << tbusy.count() / texec.count() << ", max: " << max_running << ")" << endl;
+    }
+    return true;
+}
+
 void EngineCPU::handleExecution(BhIR *bhir) {
+    handleExecution(bhir, {});
+}
+
+void EngineCPU::handleExecution(BhIR *bhir, vector<LoopB> kernel_list) {
 
     const auto texecution = chrono::steady_clock::now();
 
@@ -52,18 +377,41 @@ void EngineCPU::handleExecution(BhIR *bhir) {
         bh_data_free(base);
     }
 
-    // Set the constructor flag
-    if (array_contraction) {
-        setConstructorFlag(instr_list);
-    } else {
-        for (bh_instruction *instr: instr_list) {
-            instr->constructor = false;
+    // Pre-fused kernels have their constructor flags set already (see `handleRepeat()`)
+    const bool pre_fused = not kernel_list.empty();
+    const bool record_plan = use_plan_cache and not pre_fused;
+    StructuralKey plan_key;
+    if (not pre_fused) {
+        // Set the constructor flag
+        if (array_contraction) {
+            setConstructorFlag(instr_list);
+        } else {
+            for (bh_instruction *instr: instr_list) {
+                instr->constructor = false;
+            }
+        }
+
+        // A repeated flush executes the plan of its previous execution
+        if (use_plan_cache) {
+            const PlanCache::Plan *plan = plan_cache.lookup(instr_list, plan_key);
+            if (plan != nullptr) {
+                executePlan(*plan, instr_list);
+                stat.time_total_execution += chrono::steady_clock::now() - texecution;
+                return;
+            }
         }
+
+        // Let's get the kernel list
+        kernel_list = get_kernel_list(instr_list, fusion_config, fcache, stat);
     }
 
-    // Let's get the kernel list
-    vector<LoopB> kernel_list = get_kernel_list(instr_list, fusion_config, fcache, stat);
+    // Independent kernels might execute concurrently
+    if (kernel_concurrency > 1 and kernel_list.size() > 1 and executeConcurrently(kernel_list)) {
+        stat.time_total_execution += chrono::steady_clock::now() - texecution;
+        return;
+    }
 
+    vector<const bh_instruction *> constants;
     for (const LoopB &kernel: kernel_list) {
         // Let's create the symbol table for the kernel
         const SymbolTable symbols(kernel,
@@ -73,37 +421,50 @@ void EngineCPU::handleExecution(BhIR *bhir) {
                                   const_as_var);
         stat.record(symbols);
 
-        if (not kernel.isSystemOnly()) { // We can skip this step if the kernel does no computation
-            // Create the constant vector
-            vector<const bh_instruction *> constants;
-            constants.reserve(symbols.constIDs().size());
-            for (const InstrPtr &instr: symbols.constIDs()) {
-                constants.push_back(&(*instr));
-            }
-
-            const auto lookup = codegen_cache.lookup(kernel, symbols);
-            if (not lookup.first.empty()) {
-                // In debug mode, we check that the cached source code is correct
-                #ifndef NDEBUG
-                    stringstream ss;
-                    writeKernel(kernel, symbols, {}, lookup.second, ss);
-                    if (ss.str().compare(lookup.first) != 0) {
-                        cout << "\nCached source code: \n" << lookup.first;
-                        cout << "\nReal source code: \n" << ss.str();
-                        assert(1 == 2);
-                    }
-                #endif
-                execute(symbols, lookup.first, lookup.second, constants);
+        // Trivial and shape-generic kernels skip codegen, but the plan executes the instruction that the kernel
+        // originates from thus it must be the same kind of kernel
+        const bh_instruction *single = kernel.isSystemOnly() ? nullptr : single_instr_of_kernel(kernel);
+        const bh_instruction *origin = nullptr;
+        if (single != nullptr and use_plan_cache) {
+            const int64_t id = single->origin_id;
+            if (id >= 0 and static_cast<uint64_t>(id) < instr_list.size()) {
+                origin = instr_list[id];
             } else {
-                const auto tcodegen = chrono::steady_clock::now();
-                stringstream ss;
-                writeKernel(kernel, symbols, {}, lookup.second, ss);
-                string source = ss.str();
-                stat.time_codegen += chrono::steady_clock::now() - tcodegen;
+                single = nullptr;
+            }
+        }
+        TrivialKernel trivial = single == nullptr ? TrivialKernel() : getTrivialKernel(kernel);
+        if (trivial.kind != TrivialKernel::NONE and origin != nullptr and
+            classify_trivial_instr(*origin).kind != trivial.kind) {
+            trivial = TrivialKernel();
+            single = nullptr;
+        }
+        KernelLaunch generic;
+        if (single != nullptr and trivial.kind == TrivialKernel::NONE) {
+            // The plan replays the origin thus it is the origin that must have a shape-generic kernel
+            generic = prepareGeneric(origin == nullptr ? *single : *origin);
+        }
 
-                execute(symbols, source, lookup.second, constants);
-                codegen_cache.insert(std::move(source), kernel, symbols);
+        if (trivial.kind != TrivialKernel::NONE) {
+            executeTrivial(trivial, 0);
+            if (record_plan) {
+                plan_cache.addKernel(kernel, symbols, nullptr, 0, origin);
+            }
+        } else if (generic.run) {
+            ++stat.num_generic_kernels;
+            runLaunch(generic);
+            if (record_plan) {
+                plan_cache.addKernel(kernel, symbols, nullptr, 0, origin);
+            }
+        } else if (not kernel.isSystemOnly()) { // We can skip this step if the kernel does no computation
+            const auto source = get_source(*this, codegen_cache, stat, kernel, symbols);
+            get_constants(symbols, constants);
+            execute(symbols, *source.first, source.second, constants);
+            if (record_plan) {
+                plan_cache.addKernel(kernel, symbols, source.first, source.second);
             }
+        } else if (record_plan) {
+            plan_cache.addKernel(kernel, symbols, nullptr, 0);
         }
 
         // Finally, let's cleanup
@@ -111,7 +472,146 @@ void EngineCPU::handleExecution(BhIR *bhir) {
             bh_data_free(base);
         }
     }
+    if (record_plan) {
+        plan_cache.insert(std::move(plan_key));
+    }
+    stat.time_total_execution += chrono::steady_clock::now() - texecution;
+}
+
+void EngineCPU::executePlan(const PlanCache::Plan &plan, const vector<bh_instruction *> &instr_list) {
+    const vector<bh_base *> &bases = plan_cache.bases();
+    for (const PlanCache::Kernel &kernel: plan.kernels) {
+        stat.num_base_arrays += kernel.num_base_arrays;
+        stat.num_temp_arrays += kernel.num_base_arrays - kernel.num_params;
+
+        if (kernel.source != nullptr) {
+            // Let's bind the arrays, starts, and constants of `instr_list` to the kernel arguments
+            _plan_args.data_list.clear();
+            for (uint64_t id: kernel.params) {
+                bh_data_malloc(bases[id]);
+                _plan_args.data_list.push_back(bases[id]->getDataPtr());
+            }
+            _plan_args.offset_strides = kernel.offset_strides;
+            for (const PlanCache::StartBinding &b: kernel.starts) {
+                const bh_view &view = instr_list[b.instr]->operand[b.operand];
+                _plan_args.offset_strides[b.slot] = static_cast<uint64_t>(view.start);
+            }
+            _plan_args.constants = kernel.constants;
+            for (const PlanCache::ConstBinding &b: kernel.const_bindings) {
+                _plan_args.constants[b.slot] = instr_list[b.instr]->constant.value;
+            }
+            execute(*kernel.source, kernel.codegen_hash, _plan_args);
+        } else if (kernel.single_instr >= 0) {
+            const bh_instruction &instr = *instr_list[kernel.single_instr];
+            const TrivialKernel trivial = trivial_kernels ? classify_trivial_instr(instr) : TrivialKernel();
+            if (trivial.kind != TrivialKernel::NONE) {
+                executeTrivial(trivial, 0);
+            } else {
+                // The instruction list matches the plan thus the shape-generic kernel still applies
+                const KernelLaunch generic = prepareGeneric(instr);
+                if (not generic.run) {
+                    throw runtime_error("executePlan(): the plan has no kernel for " + instr.pprint());
+                }
+                ++stat.num_generic_kernels;
+                runLaunch(generic);
+            }
+        }
+
+        // Finally, let's cleanup
+        for (uint64_t id: kernel.frees) {
+            bh_data_free(bases[id]);
+        }
+    }
+}
+
+bool EngineCPU::handleRepeat(BhIR *bhir, vector<LoopB> &kernel_list) {
+    const uint64_t nrepeats = bhir->getNRepeats();
+
+    // Without strides-as-var, the view starts are hardcoded in the kernel source
+    if (not repeat_in_kernel or not strides_as_var or nrepeats < 2) {
+        return false;
+    }
+    // Extension methods are executed by the host and changes to the shapes requires new loops
+    for (const bh_instruction &instr: bhir->instr_list) {
+        if (util::exist(comp.extmethods, instr.opcode)) {
+            return false;
+        }
+        for (const bh_view &view: instr.getViews()) {
+            if (view.hasSlide() and not slide_in_kernel_compatible(view)) {
+                return false;
+            }
+        }
+    }
+
+    const auto texecution = chrono::steady_clock::now();
+
+    // The structural checks go before the fusion, which thus happens once even when the repeat is rejected
+    set<bh_base *> frees;
+    vector<bh_instruction *> instr_list = jitk::remove_non_computed_system_instr(bhir->instr_list, frees);
+    if (std::all_of(instr_list.begin(), instr_list.end(),
+                    [](const bh_instruction *instr) { return bh_opcode_is_system(instr->opcode); })) {
+        return false;
+    }
+    if (not kernel_is_repeat_invariant(instr_list, nrepeats)) {
+        return false;
+    }
+
+    // Notice, the constructor flags of the first iteration are valid for all iterations. A constructor flag makes
+    // an array a kernel temporary, which is constructed anew each iteration, if the kernel also frees the array.
+    // Otherwise, the flag only saves the load of the output of the constructing instruction, which overwrites
+    // the output in every iteration.
+    if (array_contraction) {
+        setConstructorFlag(instr_list);
+    } else {
+        for (bh_instruction *instr: instr_list) {
+            instr->constructor = false;
+        }
+    }
+
+    // The kernels of an iteration execute one after another within a single kernel. However, merging the kernels
+    // must not turn arrays shared between the kernels into temporary arrays.
+    kernel_list = get_kernel_list(instr_list, fusion_config, fcache, stat);
+    LoopB kernel{-1, 1};
+    set<bh_base *> temps;
+    for (const LoopB &k: kernel_list) {
+        k.getAllTemps(temps);
+        for (const Block &b: k._block_list) {
+            kernel._block_list.push_back(b);
+        }
+    }
+    kernel.metadataUpdate();
+    if (kernel.getAllTemps() != temps) {
+        return false;
+    }
+    const SymbolTable symbols(kernel, use_volatile, strides_as_var, index_as_var, const_as_var);
+
+    // The kernel keeps its arrays between iterations thus only the kernel temporaries may be freed
+    for (bh_base *base: kernel.getAllFrees()) {
+        if (util::exist_linearly(symbols.getParams(), base)) {
+            return false;
+        }
+    }
+
+    kernel_list.clear();
+    for (bh_base *base: frees) {
+        bh_data_free(base);
+    }
+    stat.record(symbols);
+    const auto source = get_source(*this, codegen_cache, stat, kernel, symbols);
+    vector<const bh_instruction *> constants;
+    get_constants(symbols, constants);
+    const uint64_t iterations = executeRepeat(symbols, *source.first, source.second, constants, nrepeats,
+                                              bhir->getRepeatCondition());
+    for (bh_base *base: kernel.getAllFrees()) {
+        bh_data_free(base);
+    }
+
+    stat.record_repeat(*bhir, iterations);
+    if (verbose) {
+        cout << "Executed " << iterations << " iterations of a repeat within one kernel" << endl;
+    }
     stat.time_total_execution += chrono::steady_clock::now() - texecution;
+    return true;
 }
 
 void EngineCPU::handleExtmethod(BhIR *bhir){
@@ -120,10 +620,14 @@ void EngineCPU::handleExtmethod(BhIR *bhir){
     for (bh_instruction &instr: bhir->instr_list) {
         auto ext = comp.extmethods.find(instr.opcode);
 
-        if (ext != comp.extmethods.end()) { // Execute the instructions up until now
-            BhIR b(std::move(instr_list), bhir->getSyncs());
-            comp.execute(&b);
-            instr_list.clear(); // Notice, it is legal to clear a moved vector.
+        if (ext != comp.extmethods.end()) {
+            // Execute the instructions up until now that the extension method depends on. The rest of the
+            // instructions stays in `instr_list`, which makes them fusible with the instructions that follows.
+            std::vector<bh_instruction> dependencies = extract_extmethod_dependencies(instr_list, instr);
+            if (not dependencies.empty()) {
+                BhIR b(std::move(dependencies), bhir->getSyncs());
+                comp.execute(&b);
+            }
             const auto texecution = std::chrono::steady_clock::now();
             ext->second.execute(&instr, nullptr); // Execute the extension method
             stat.time_ext_method += std::chrono::steady_clock::now() - texecution;
@@ -54,68 +54,68 @@ public:
 };
 
 
-constexpr size_t SEP_INSTR = SIZE_MAX;
-constexpr size_t SEP_OP = SIZE_MAX - 1;
-constexpr size_t SEP_SHAPE = SIZE_MAX - 2;
-constexpr size_t SEP_CONSTANT = SIZE_MAX - 3;
-
-/* The Instruction hash consists of the following fields:
- * <view_id><start><ndim>[<shape><stride><SEP_SHAPE>...]<SEP_OP>
+// Tags that separates the fields of the hash
+constexpr uint64_t TAG_INSTR = UINT64_MAX;
+constexpr uint64_t TAG_VIEW = UINT64_MAX - 1;
+constexpr uint64_t TAG_CONSTANT = UINT64_MAX - 2;
+constexpr uint64_t TAG_SLIDE = UINT64_MAX - 3;
+
+/* The View hash consists of the following fields:
+ * <TAG_VIEW><view_id><start or TAG_SLIDE><ndim>[<shape><stride>...] or <TAG_CONSTANT>
  */
-void hash_view(const bh_view &view, ViewDB &views, std::stringstream &ss) {
+void hash_view(const bh_view &view, ViewDB &views, StructuralHasher &hasher) {
     if (not view.isConstant()) {
-        size_t view_id = views.insert(view).first;
-        ss << view_id;
+        hasher.add(TAG_VIEW);
+        hasher.add(views.insert(view).first);
         // Sliding views has identical hashes across iterations
-        if (not view.hasSlide()) {
-            ss << view.start;
-        } else {
+        bool include_start = true;
+        if (view.hasSlide()) {
             // Check whether the shape of the sliding view is a single value
-            bool single_index = true;
+            include_start = false;
             for (int i = 0; i < view.ndim; i++) {
                 if (view.shape[i] != 1) {
-                    single_index = false;
+                    include_start = true;
                     break;
                 }
             }
-            if (!single_index) {
-                ss << view.start;
-            }
         }
-
-        ss << view.ndim;
+        if (include_start) {
+            hasher.add_signed(view.start);
+        } else {
+            hasher.add(TAG_SLIDE);
+        }
+        hasher.add_signed(view.ndim);
         for (int j = 0; j < view.ndim; ++j) {
-            ss << view.shape[j];
-            ss << view.stride[j];
-            ss << SEP_SHAPE;
+            hasher.add_signed(view.shape[j]);
+            hasher.add_signed(view.stride[j]);
         }
-        ss << SEP_OP;
     } else {
         // Notice, we can ignore the value of the constant but we need to hash the location of the constant
-        ss << SEP_CONSTANT;
+        hasher.add(TAG_CONSTANT);
     }
 }
 
 /* The Instruction hash consists of the following fields:
- * <opcode[<hash_view>...]<sweep_axis()><SEP_INSTR>
+ * <TAG_INSTR><opcode><constructor>[<hash_view>...]<sweep_axis()>
  */
-void hash_instr(const bh_instruction &instr, ViewDB &views, std::stringstream &ss) {
-    ss << instr.opcode; // <opcode>
+void hash_instr(const bh_instruction &instr, ViewDB &views, StructuralHasher &hasher) {
+    hasher.add(TAG_INSTR);
+    hasher.add(instr.opcode);
+    hasher.add(instr.constructor);
     for(const bh_view &op: instr.operand) {
-        hash_view(op, views, ss);
+        hash_view(op, views, hasher);
     }
-    ss << instr.sweep_axis();
-    ss << SEP_INSTR;
+    hasher.add_signed(instr.sweep_axis());
 }
 
-// Hash of an instruction list
-size_t hash_instr_list(const vector<bh_instruction *> &instr_list) {
-    stringstream ss;
+// Write the hash fields of an instruction list into `hasher` and return the hash
+Hash128 hash_instr_list(const vector<bh_instruction *> &instr_list, StructuralHasher &hasher) {
+    hasher.clear();
     ViewDB views;
     for (const bh_instruction *instr: instr_list) {
-        hash_instr(*instr, views, ss);
+        hash_instr(*instr, views, hasher);
     }
-    return util::hash(ss.str());
+    return hasher.digest();
 }
 
 // Replace the cached values of constants and bases arrays in `instr` with their original values
@@ -180,10 +180,12 @@ std::vector<bh_base*> calc_base_ids(const vector<bh_instruction *> &instr_list)
 } // Anon namespace
 
 pair<vector<Block>, bool> FuseCache::get(const vector<bh_instruction *> &instr_list) {
-    const size_t lookup_hash = hash_instr_list(instr_list);
+    const Hash128 lookup_hash = hash_instr_list(instr_list, _hasher);
     ++stat.fuser_cache_lookups;
 
-    if (_cache.find(lookup_hash) != _cache.end()) { // Cache hit!
+    auto lookup = _cache.find(lookup_hash);
+    // NB: a hash collision is detected by comparing the hashed fields and is handled as a cache miss
+    if (lookup != _cache.end() and lookup->second.fields == _hasher.fields()) { // Cache hit!
         // Create a map: 'origin_id' => instruction for updating the constants
         map<int64_t, const bh_instruction *> origin_id_to_instr;
         for(const bh_instruction *instr: instr_list) {
@@ -192,7 +194,7 @@ pair<vector<Block>, bool> FuseCache::get(const vector<bh_instruction *> &instr_l
             origin_id_to_instr.insert(make_pair(instr->origin_id, instr));
         }
         // Create a map: 'cached bases' => 'new bases' for updating the base arrays
-        const CachePayload &cached = _cache.at(lookup_hash);
+        const CachePayload &cached = lookup->second;
         std::map<bh_base*, bh_base*> base_cached2new;
         {
             size_t id = 0;
@@ -214,9 +216,9 @@ pair<vector<Block>, bool> FuseCache::get(const vector<bh_instruction *> &instr_l
 }
 
 void FuseCache::insert(const vector<bh_instruction *> &instr_list, vector<Block> block_list) {
-    const size_t lookup_hash = hash_instr_list(instr_list);
-    CachePayload payload = {std::move(block_list), calc_base_ids(instr_list)};
-    _cache.insert(make_pair(lookup_hash, std::move(payload)));
+    const Hash128 lookup_hash = hash_instr_list(instr_list, _hasher);
+    // NB: on a hash collision, we replace the existing entry
+    _cache[lookup_hash] = CachePayload{_hasher.release(), std::move(block_list), calc_base_ids(instr_list)};
 }
 
 } // jitk
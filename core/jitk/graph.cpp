@@ -173,6 +173,31 @@ bool validate(DAG &dag) {
     return true;
 }
 
+namespace {
+/* Removes the vertex 'v' from the 'dag' and, like boost::remove_vertex(), decrements the vertices after 'v'.
+ * NB: we cannot use boost::remove_vertex() because, when the edge lists are sets, some versions of Boost
+ *     (e.g. 1.74) re-index the edge lists using erased iterators, which corrupts the heap.
+ *
+ * Complexity: O(E + V)
+ */
+void remove_vertex(Vertex v, DAG &dag) {
+    DAG ret(boost::num_vertices(dag) - 1);
+    BOOST_FOREACH(Vertex u, boost::vertices(dag)) {
+        if (u != v) {
+            ret[u > v ? u - 1 : u] = std::move(dag[u]);
+        }
+    }
+    BOOST_FOREACH(Edge e, boost::edges(dag)) {
+        const Vertex src = boost::source(e, dag);
+        const Vertex dst = boost::target(e, dag);
+        if (src != v and dst != v) {
+            boost::add_edge(src > v ? src - 1 : src, dst > v ? dst - 1 : dst, ret);
+        }
+    }
+    dag = std::move(ret);
+}
+} // Anonymous Namespace
+
 void merge_vertices(DAG &dag, Vertex a, Vertex b, const bool remove_b) {
     // Let's merge the two blocks and save it in vertex 'a'
     assert(not dag[a].isInstr());
@@ -194,7 +219,7 @@ void merge_vertices(DAG &dag, Vertex a, Vertex b, const bool remove_b) {
     // Finally, cleanup of 'b'
     boost::clear_vertex(b, dag);
     if (remove_b) {
-        boost::remove_vertex(b, dag);
+        remove_vertex(b, dag);
     }
     assert(validate(dag));
 }
@@ -236,7 +261,7 @@ void merge_system_pendants(DAG &dag) {
     // Remove the vertex leftover from the merge
     // NB: because of Vertex invalidation, we have to traverse in reverse
     BOOST_REVERSE_FOREACH(Edge &e, merges) {
-        boost::remove_vertex(boost::target(e, dag), dag);
+        remove_vertex(boost::target(e, dag), dag);
     }
     assert(validate(dag));
 }
@@ -19,6 +19,7 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <sstream>
+#include <cmath>
 
 #include <bohrium/bh_instruction.hpp>
 #include <bohrium/jitk/block.hpp>
@@ -52,10 +53,72 @@ void write_opcodes_with_special_opencl_complex(const bh_instruction &instr, cons
     }
     out << "\n";
 }
+
+// Write `instr` as a call to the vector math library in `kernel_dependencies/vmath.h`, which names the single
+// precision functions with a 'f' suffix. Returns false when the library doesn't implement `instr`.
+bool write_vmath_operation(const bh_instruction &instr, const vector <string> &ops, stringstream &out) {
+    const bh_type t0 = instr.operand_type(0);
+    if (t0 != bh_type::FLOAT32 and t0 != bh_type::FLOAT64) {
+        return false;
+    }
+    const char *fname;
+    switch (instr.opcode) {
+        case BH_EXP:
+            fname = "bh_vexp";
+            break;
+        case BH_EXP2:
+            fname = "bh_vexp2";
+            break;
+        case BH_EXPM1:
+            fname = "bh_vexpm1";
+            break;
+        case BH_LOG:
+            fname = "bh_vlog";
+            break;
+        case BH_LOG2:
+            fname = "bh_vlog2";
+            break;
+        case BH_LOG10:
+            fname = "bh_vlog10";
+            break;
+        case BH_LOG1P:
+            fname = "bh_vlog1p";
+            break;
+        case BH_SIN:
+            fname = "bh_vsin";
+            break;
+        case BH_COS:
+            fname = "bh_vcos";
+            break;
+        case BH_TAN:
+            fname = "bh_vtan";
+            break;
+        case BH_TANH:
+            fname = "bh_vtanh";
+            break;
+        case BH_POWER:
+            fname = "bh_vpow";
+            break;
+        default:
+            return false;
+    }
+    const char *suffix = t0 == bh_type::FLOAT32 ? "f" : "";
+    out << ops[0] << " = " << fname << suffix << "(" << ops[1];
+    if (instr.opcode == BH_POWER) {
+        out << ", " << ops[2];
+    }
+    out << ");";
+    return true;
+}
 } // Anon namespace
 
 // Write the 'instr' using the string in 'ops' as ops
-void write_operation(const bh_instruction &instr, const vector <string> &ops, stringstream &out, bool opencl) {
+void write_operation(const bh_instruction &instr, const vector <string> &ops, stringstream &out, bool opencl,
+                     bool fast_math) {
+    if (fast_math and not opencl and write_vmath_operation(instr, ops, out)) {
+        out << "\n";
+        return;
+    }
     switch (instr.opcode) {
         // Opcodes that are Complex/OpenCL agnostic
         case BH_BITWISE_AND:
@@ -543,6 +606,75 @@ void write_operation(const bh_instruction &instr, const vector <string> &ops, st
     out << "\n";
 }
 
+bool uses_c99_math(const bh_instruction &instr) {
+    if (bh_opcode_is_system(instr.opcode)) {
+        return false;
+    }
+    bool float_operands = false;
+    for (size_t i = 0; i < instr.operand.size(); ++i) {
+        const bh_type t = instr.operand_type(i);
+        if (bh_type_is_complex(t)) {
+            return true;
+        }
+        float_operands = float_operands or bh_type_is_float(t);
+    }
+    if (instr.has_constant() and bh_type_is_float(instr.constant.type) and
+        not std::isfinite(instr.constant.get_double())) {
+        return true;
+    }
+    switch (instr.opcode) {
+        case BH_BITWISE_AND:
+        case BH_BITWISE_AND_REDUCE:
+        case BH_BITWISE_OR:
+        case BH_BITWISE_OR_REDUCE:
+        case BH_BITWISE_XOR:
+        case BH_BITWISE_XOR_REDUCE:
+        case BH_LOGICAL_NOT:
+        case BH_LOGICAL_OR:
+        case BH_LOGICAL_OR_REDUCE:
+        case BH_LOGICAL_AND:
+        case BH_LOGICAL_AND_REDUCE:
+        case BH_LOGICAL_XOR:
+        case BH_LOGICAL_XOR_REDUCE:
+        case BH_LEFT_SHIFT:
+        case BH_RIGHT_SHIFT:
+        case BH_GREATER:
+        case BH_GREATER_EQUAL:
+        case BH_LESS:
+        case BH_LESS_EQUAL:
+        case BH_EQUAL:
+        case BH_NOT_EQUAL:
+        case BH_MAXIMUM:
+        case BH_MAXIMUM_REDUCE:
+        case BH_MINIMUM:
+        case BH_MINIMUM_REDUCE:
+        case BH_INVERT:
+        case BH_ADD:
+        case BH_ADD_REDUCE:
+        case BH_ADD_ACCUMULATE:
+        case BH_SUBTRACT:
+        case BH_MULTIPLY:
+        case BH_MULTIPLY_REDUCE:
+        case BH_MULTIPLY_ACCUMULATE:
+        case BH_DIVIDE:
+        case BH_SIGN:
+        case BH_IDENTITY:
+        case BH_RANGE:
+        case BH_RANDOM:
+        case BH_GATHER:
+        case BH_SCATTER:
+        case BH_COND_SCATTER:
+            return false;
+        case BH_MOD:
+        case BH_REMAINDER: // `fmod()` and `floor()` of floats
+            return float_operands;
+        case BH_ABSOLUTE: // `fabs()`, `llabs()`, and `abs()` of signed types
+            return bh_type_is_float(instr.operand_type(1)) or bh_type_is_signed_integer(instr.operand_type(1));
+        default:
+            return true;
+    }
+}
+
 bh_constant sweep_identity(bh_opcode opcode, bh_type dtype) {
     switch (opcode) {
         case BH_ADD_REDUCE:
@@ -592,6 +724,64 @@ vector<bh_instruction *> remove_non_computed_system_instr(vector <bh_instruction
     return ret;
 }
 
+vector<bh_instruction> extract_extmethod_dependencies(vector<bh_instruction> &instr_list,
+                                                      const bh_instruction &ext_instr) {
+    // The accesses of the instructions that must be executed before `ext_instr` (incl. `ext_instr` itself).
+    // Each base maps to a list of accessing views and whether the view is written.
+    map<const bh_base *, vector<pair<const bh_view *, bool> > > accesses;
+    for (const bh_view &view: ext_instr.getViews()) {
+        accesses[view.base].emplace_back(&view, true);
+    }
+
+    // Returns true when `instr` conflicts with one of the accesses in `accesses`
+    auto conflicts = [&accesses](const bh_instruction &instr) -> bool {
+        for (size_t i = 0; i < instr.operand.size(); ++i) {
+            const bh_view &view = instr.operand[i];
+            if (view.isConstant()) {
+                continue;
+            }
+            auto it = accesses.find(view.base);
+            if (it == accesses.end()) {
+                continue;
+            }
+            const bool write = (i == 0);
+            for (const auto &access: it->second) {
+                if ((write or access.second) and not bh_view_disjoint(&view, access.first)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    // We traverse the instructions backwards, which makes the dependency transitive: an instruction that one of
+    // the already found dependencies depends on is also a dependency.
+    vector<bool> is_dependency(instr_list.size(), false);
+    for (size_t i = instr_list.size(); i-- > 0;) {
+        const bh_instruction &instr = instr_list[i];
+        if (conflicts(instr)) {
+            is_dependency[i] = true;
+            for (size_t o = 0; o < instr.operand.size(); ++o) {
+                const bh_view &view = instr.operand[o];
+                if (not view.isConstant()) {
+                    accesses[view.base].emplace_back(&view, o == 0);
+                }
+            }
+        }
+    }
+
+    vector<bh_instruction> ret, independent;
+    for (size_t i = 0; i < instr_list.size(); ++i) {
+        if (is_dependency[i]) {
+            ret.push_back(std::move(instr_list[i]));
+        } else {
+            independent.push_back(std::move(instr_list[i]));
+        }
+    }
+    instr_list = std::move(independent);
+    return ret;
+}
+
 InstrPtr reshape_rank(const InstrPtr &instr, int rank, int64_t size_of_rank_dim) {
     vector <int64_t> shape((size_t) rank + 1);
     // The dimensions up til 'rank' (not including 'rank') are unchanged
@@ -0,0 +1,213 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <bohrium/jitk/plan_cache.hpp>
+#include <bohrium/jitk/iterator.hpp>
+
+using namespace std;
+
+namespace bohrium {
+namespace jitk {
+
+namespace {
+
+// Tags that separates the fields of the hash
+constexpr uint64_t TAG_INSTR = UINT64_MAX;
+constexpr uint64_t TAG_VIEW = UINT64_MAX - 1;
+constexpr uint64_t TAG_CONSTANT = UINT64_MAX - 2;
+constexpr uint64_t TAG_SLIDE = UINT64_MAX - 3;
+
+// Return the ID of `key` in `ids`, which assigns new IDs in the order the keys appear
+template<typename T>
+uint64_t get_id(unordered_map<T, uint64_t> &ids, const T &key) {
+    return ids.insert(make_pair(key, ids.size())).first->second;
+}
+} // Anonymous Namespace
+
+/* The instruction list hash consists of the following fields per instruction:
+ * <TAG_INSTR><opcode><constructor><sweep_axis()>
+ * [<TAG_VIEW><base_id><dtype><start_id><start or TAG_SLIDE><ndim>[<shape><stride>...] or <TAG_CONSTANT><dtype>...]
+ * Compared to the fuse cache, the hash also covers everything that the symbol tables and the codegen depend on:
+ * the aliasing of arrays (the base IDs), the data types, and which views share their start (the start IDs).
+ * Since the starts of single-element sliding views are bound to the instruction list, they are only represented by
+ * their start IDs, which also reflects whether two of them are the same element.
+ */
+const PlanCache::Plan *PlanCache::lookup(const vector<bh_instruction *> &instr_list, StructuralKey &key) {
+    ++stat.plan_cache_lookups;
+    _hasher.clear();
+    _bases.clear();
+    _base_ids.clear();
+    _start_ids.clear();
+    _pending.clear();
+    _lookup_size = instr_list.size();
+    _lookup_has_slides = false;
+    for (const bh_instruction *instr: instr_list) {
+        _hasher.add(TAG_INSTR);
+        _hasher.add(instr->opcode);
+        _hasher.add(instr->constructor);
+        _hasher.add_signed(instr->sweep_axis());
+        for (const bh_view &view: instr->operand) {
+            if (view.isConstant()) {
+                _hasher.add(TAG_CONSTANT);
+                _hasher.add(static_cast<uint64_t>(instr->constant.type));
+                continue;
+            }
+            _hasher.add(TAG_VIEW);
+            const uint64_t base_id = get_id(_base_ids, const_cast<const bh_base *>(view.base));
+            if (base_id == _bases.size()) {
+                _bases.push_back(view.base);
+            }
+            _hasher.add(base_id);
+            _hasher.add(static_cast<uint64_t>(view.base->dtype()));
+            _hasher.add(get_id(_start_ids, view.start));
+            // Like the fuse cache, we only leave out the start of single-element sliding views since the
+            // overlap of larger sliding views depends on their starts
+            bool include_start = true;
+            if (view.hasSlide()) {
+                include_start = false;
+                for (int64_t i = 0; i < view.ndim; ++i) {
+                    if (view.shape[i] != 1) {
+                        include_start = true;
+                        break;
+                    }
+                }
+            }
+            if (include_start) {
+                _hasher.add_signed(view.start);
+            } else {
+                _hasher.add(TAG_SLIDE);
+                _lookup_has_slides = true;
+            }
+            _hasher.add_signed(view.ndim);
+            for (int64_t i = 0; i < view.ndim; ++i) {
+                _hasher.add_signed(view.shape[i]);
+                _hasher.add_signed(view.stride[i]);
+            }
+        }
+    }
+    _lookup_hash = _hasher.digest();
+    key.hash = _lookup_hash;
+    key.fields.clear();
+    auto lookup = _cache.find(_lookup_hash);
+    // NB: a hash collision is detected by comparing the hashed fields and is handled as a cache miss
+    if (lookup != _cache.end() and lookup->second.fields == _hasher.fields()) { // Cache hit!
+        _plannable = false;
+        return &lookup->second;
+    }
+    ++stat.plan_cache_misses;
+    key.fields = _hasher.release();
+    _plannable = true;
+    return nullptr;
+}
+
+bool PlanCache::addKernel(const LoopB &kernel, const SymbolTable &symbols, const CodegenCache::Source *source,
+                          uint64_t codegen_hash, const bh_instruction *single) {
+    if (not _plannable) {
+        return false;
+    }
+    _plannable = false; // We set it back when the kernel has been bound
+    Kernel ret;
+    ret.source = source;
+    ret.codegen_hash = codegen_hash;
+    if (single != nullptr) {
+        if (single->origin_id < 0 or static_cast<uint64_t>(single->origin_id) >= _lookup_size) {
+            return false;
+        }
+        ret.single_instr = single->origin_id;
+    }
+    ret.num_base_arrays = symbols.getNumBaseArrays();
+    ret.num_params = symbols.getParams().size();
+
+    for (const bh_base *base: symbols.getParams()) {
+        auto it = _base_ids.find(base);
+        if (it == _base_ids.end()) {
+            return false;
+        }
+        ret.params.push_back(it->second);
+    }
+    for (const bh_base *base: kernel.getAllFrees()) {
+        auto it = _base_ids.find(base);
+        if (it == _base_ids.end()) {
+            return false;
+        }
+        ret.frees.push_back(it->second);
+    }
+
+    if (source != nullptr) {
+        // The operands of the kernel instructions that originate from the instruction list. Notice, fusion
+        // might reshape the views of an instruction but it never changes their starts or the operand order.
+        map<bh_view, pair<uint64_t, uint64_t>, OffsetAndStrides_less> origins;
+        for (const InstrPtr &instr: iterator::allInstr(kernel)) {
+            if (instr->origin_id < 0 or static_cast<uint64_t>(instr->origin_id) >= _lookup_size) {
+                continue;
+            }
+            for (uint64_t i = 0; i < instr->operand.size(); ++i) {
+                if (not instr->operand[i].isConstant()) {
+                    origins.insert(make_pair(instr->operand[i], make_pair(instr->origin_id, i)));
+                }
+            }
+        }
+        for (const bh_view *view: symbols.offsetStrideViews()) {
+            const uint64_t slot = ret.offset_strides.size();
+            ret.offset_strides.push_back(static_cast<uint64_t>(view->start));
+            for (int64_t i = 0; i < view->ndim; ++i) {
+                ret.offset_strides.push_back(static_cast<uint64_t>(view->stride[i]));
+            }
+            auto it = origins.find(*view);
+            if (it != origins.end()) {
+                ret.starts.push_back(StartBinding{slot, it->second.first, it->second.second});
+            } else if (_lookup_has_slides) {
+                // Without slides, the starts are part of the hash thus the start of the view is constant
+                return false;
+            }
+        }
+        for (const InstrPtr &instr: symbols.constIDs()) {
+            const uint64_t slot = ret.constants.size();
+            ret.constants.push_back(instr->constant.value);
+            // NB: the constants of sweeps are their axis, which is part of the hash
+            if (instr->origin_id >= 0 and static_cast<uint64_t>(instr->origin_id) < _lookup_size and
+                not bh_opcode_is_sweep(instr->opcode)) {
+                ret.const_bindings.push_back(ConstBinding{slot, static_cast<uint64_t>(instr->origin_id)});
+            }
+        }
+    }
+    _pending.push_back(std::move(ret));
+    _plannable = true;
+    return true;
+}
+
+void PlanCache::insert(StructuralKey key) {
+    if (not _plannable) {
+        return;
+    }
+    // The pending kernels belong to the latest lookup thus the key must be of that lookup
+    if (key.hash != _lookup_hash) {
+        throw runtime_error("PlanCache::insert(): `key` must come from the latest lookup()");
+    }
+    // NB: on a hash collision, we replace the existing plan
+    Plan &plan = _cache[key.hash];
+    plan.fields = std::move(key.fields);
+    plan.kernels = std::move(_pending);
+    _pending.clear();
+    _plannable = false;
+}
+
+} // jitk
+} // bohrium
@@ -35,7 +35,18 @@ Scope::writeIdxDeclaration(const bh_view &view, const std::string &type_str, int
     out << " = (";
     write_array_index(*this, view, out, false, hidden_axis);
     out << ");";
-    _declared_idx.insert(view);
+    _declared_idx.insert(&view);
+}
+
+void Scope::writeIdxBaseDeclaration(const bh_view &view, const std::string &type_str, int rank,
+                                    std::stringstream &out) {
+    assert(idxBaseRank(view) < rank);
+    out << "const " << type_str << " ";
+    getIdxBaseName(view, rank, out);
+    out << " = (";
+    write_array_index_base(*this, view, rank, out);
+    out << ");";
+    _declared_idx_bases.insert(&view, static_cast<size_t>(rank));
 }
 
 } // jitk
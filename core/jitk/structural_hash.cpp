@@ -0,0 +1,76 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <bohrium/jitk/structural_hash.hpp>
+
+namespace bohrium {
+namespace jitk {
+
+namespace {
+
+constexpr uint64_t P0 = 0xa0761d6478bd642full;
+constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t P3 = 0x589965cc75374cc3ull;
+
+// Multiply `a` and `b` into 128 bits and fold the result into 64 bits (the "mum" mixing of wyhash)
+inline uint64_t mum(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    const __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+    const uint64_t a_lo = a & 0xffffffffull, a_hi = a >> 32;
+    const uint64_t b_lo = b & 0xffffffffull, b_hi = b >> 32;
+    const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffffull) + lo_hi;
+    const uint64_t lo = (cross << 32) | (lo_lo & 0xffffffffull);
+    const uint64_t hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+    return lo ^ hi;
+#endif
+}
+} // Anonymous Namespace
+
+Hash128 hash128(const uint64_t *fields, uint64_t n, uint64_t seed) {
+    // Two lanes that both absorb every pair of fields but with different constants and operand order
+    uint64_t lo = mum(seed ^ P0, P1);
+    uint64_t hi = mum(seed ^ P2, P3);
+    uint64_t i = 0;
+    for (; i + 1 < n; i += 2) {
+        const uint64_t x = fields[i];
+        const uint64_t y = fields[i + 1];
+        const uint64_t new_lo = mum(x ^ lo ^ P1, y ^ hi ^ P2);
+        hi = mum(y ^ lo ^ P3, x ^ hi ^ P0);
+        lo = new_lo;
+    }
+    if (i < n) {
+        const uint64_t x = fields[i];
+        const uint64_t new_lo = mum(x ^ lo ^ P1, hi ^ P2);
+        hi = mum(lo ^ P3, x ^ hi ^ P0);
+        lo = new_lo;
+    }
+    // Finally, we absorb the number of fields and avalanche the lanes into each other
+    lo = mum(lo ^ P0, n ^ P1);
+    hi = mum(hi ^ P2, lo ^ P3);
+    lo = mum(lo ^ P1, hi ^ P0);
+    return Hash128{lo, hi};
+}
+
+} // jitk
+} // bohrium
@@ -28,11 +28,36 @@ using namespace std;
 namespace bohrium {
 namespace jitk {
 
+namespace {
+// Returns the number of views in `kernel`, which bounds the size of the symbol table
+size_t num_views(const LoopB &kernel) {
+    size_t ret = 0;
+    for (const InstrPtr &instr: iterator::allInstr(kernel)) {
+        ret += instr->operand.size();
+    }
+    return ret;
+}
+}
+
 SymbolTable::SymbolTable(const LoopB &kernel,
                          bool use_volatile,
                          bool strides_as_var,
                          bool index_as_var,
-                         bool const_as_var) : _useRandom(false),
+                         bool const_as_var) : SymbolTable(kernel, num_views(kernel), use_volatile, strides_as_var,
+                                                          index_as_var, const_as_var) {}
+
+SymbolTable::SymbolTable(const LoopB &kernel,
+                         size_t num_views,
+                         bool use_volatile,
+                         bool strides_as_var,
+                         bool index_as_var,
+                         bool const_as_var) : _arena(4 * 64 * (num_views + 16)),
+                                              _base_map(_arena, num_views),
+                                              _view_map(_arena, num_views),
+                                              _idx_map(_arena, index_as_var ? num_views : 0),
+                                              _offset_strides_map(_arena, num_views),
+                                              _array_always(_arena),
+                                              _useRandom(false),
                                               use_volatile(use_volatile),
                                               strides_as_var(strides_as_var),
                                               index_as_var(index_as_var),
@@ -42,17 +67,19 @@ SymbolTable::SymbolTable(const LoopB &kernel,
     //     the kernels can better be reused
     for (const InstrPtr &instr: iterator::allInstr(kernel)) {
         for (const bh_view &view: instr->getViews()) {
-            _base_map.insert(std::make_pair(view.base, _base_map.size()));
-            _view_map.insert(std::make_pair(view, _view_map.size()));
+            _base_map.insert(view.base, _base_map.size());
+            _view_map.insert(&view, _view_map.size());
             if (index_as_var) {
-                _idx_map.insert(std::make_pair(view, _idx_map.size()));
+                _idx_map.insert(&view, _idx_map.size());
+            }
+            if (_offset_strides_map.insert(&view, _offset_strides_map.size()).second and strides_as_var) {
+                _offset_stride_views.push_back(&view);
             }
-            _offset_strides_map.insert(std::make_pair(view, _offset_strides_map.size()));
         }
         if (const_as_var) {
             assert(instr->origin_id >= 0);
             if (instr->has_constant()) {
-                _constant_set.insert(instr);
+                _constants.push_back(instr);
             }
         }
         // Since accumulate accesses the previous index, it should always be an array
@@ -69,33 +96,35 @@ SymbolTable::SymbolTable(const LoopB &kernel,
             _useRandom = true;
         }
     }
-    
+
+    // The constant IDs are the positions in `_constants`, ordered by `origin_id`, starting at one
+    std::sort(_constants.begin(), _constants.end(),
+              [](const InstrPtr &i1, const InstrPtr &i2) { return i1->origin_id < i2->origin_id; });
+    _constants.erase(std::unique(_constants.begin(), _constants.end(),
+                                 [](const InstrPtr &i1, const InstrPtr &i2) {
+                                     return i1->origin_id == i2->origin_id;
+                                 }), _constants.end());
+
     // Add frees to the base map since the are not in `kernel.getAllInstr()`
     for (const bh_base *base: kernel.getAllFrees()) {
-        _base_map.insert(std::make_pair(base, _base_map.size()));
+        _base_map.insert(base, _base_map.size());
     }
 
     // Find bases that are the parameters to the JIT kernel, which are non-temporary arrays not
     // already in `_params`. NB: the order of `_params` matches the order of the array IDs
     {
-        auto non_temp_arrays = kernel.getAllNonTemps();
-        non_temp_arrays.insert(_array_always.begin(), _array_always.end());
+        const auto non_temp_arrays = kernel.getAllNonTemps();
+        FlatMap<const bh_base*, char> params(_arena, _base_map.size());
         for (const InstrPtr &instr: iterator::allInstr(kernel)) {
             for (const bh_view &v: instr->getViews()) {
-                if (util::exist(non_temp_arrays, v.base)) {
-                    if (not util::exist_linearly(_params, v.base)) {
+                if (util::exist(non_temp_arrays, v.base) or _array_always.exist(v.base)) {
+                    if (params.insert(v.base).second) {
                         _params.push_back(v.base);
                     }
                 }
             }
         }
     }
-    if (strides_as_var) {
-        _offset_stride_views.resize(_offset_strides_map.size());
-        for (auto &v: _offset_strides_map) {
-            _offset_stride_views[v.second] = &(v.first);
-        }
-    }
 }
 
 
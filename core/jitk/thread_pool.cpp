@@ -0,0 +1,179 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include <bohrium/jitk/thread_pool.hpp>
+
+using namespace std;
+
+namespace bohrium {
+namespace jitk {
+
+namespace {
+// The pool and queue ID of the calling thread, if it is a worker thread
+thread_local const ThreadPool *worker_pool = nullptr;
+thread_local uint64_t worker_id = 0;
+}
+
+ThreadPool::ThreadPool(uint64_t num_threads) {
+    num_threads = std::max(num_threads, uint64_t{1});
+    for (uint64_t i = 0; i < num_threads; ++i) {
+        _queues.emplace_back(new Queue());
+    }
+    for (uint64_t i = 0; i < num_threads; ++i) {
+        _threads.emplace_back(&ThreadPool::_worker, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        unique_lock<mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond_work.notify_all();
+    for (thread &t: _threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    uint64_t id;
+    {
+        unique_lock<mutex> lock(_mutex);
+        if (worker_pool == this) {
+            id = worker_id;
+        } else {
+            id = _next_queue++ % _queues.size();
+        }
+        ++_num_unfinished;
+    }
+    {
+        Queue &q = *_queues[id];
+        unique_lock<mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        unique_lock<mutex> lock(_mutex);
+        ++_num_queued;
+    }
+    _cond_work.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> lock(_mutex);
+    _cond_done.wait(lock, [this] { return _num_unfinished == 0; });
+}
+
+void ThreadPool::parallelFor(uint64_t size, uint64_t grain, uint64_t max_threads,
+                             const std::function<void(uint64_t, uint64_t)> &body) {
+    grain = std::max(grain, uint64_t{1});
+    const uint64_t num_chunks = (size + grain - 1) / grain;
+    uint64_t num_helpers = num_chunks > 0 ? std::min(num_chunks - 1, static_cast<uint64_t>(_threads.size())) : 0;
+    if (max_threads > 0) {
+        num_helpers = std::min(num_helpers, max_threads - 1);
+    }
+    if (num_helpers == 0) {
+        body(0, size);
+        return;
+    }
+
+    // The state shared with the helpers. Helpers that start after all chunks are taken might still
+    // access the state after we return thus it is reference counted.
+    struct State {
+        std::atomic<uint64_t> next_chunk{0};
+        std::atomic<uint64_t> num_finished{0};
+    };
+    const auto state = make_shared<State>();
+
+    // Execute chunks until there are no more
+    auto work = [state, num_chunks, grain, size, &body]() {
+        uint64_t chunk;
+        while ((chunk = state->next_chunk++) < num_chunks) {
+            const uint64_t begin = chunk * grain;
+            body(begin, std::min(begin + grain, size));
+            ++state->num_finished;
+        }
+    };
+    for (uint64_t i = 0; i < num_helpers; ++i) {
+        submit(work);
+    }
+    work();
+
+    // Wait for the chunks taken by the helpers
+    while (state->num_finished < num_chunks) {
+        this_thread::yield();
+    }
+}
+
+bool ThreadPool::_pop(uint64_t id, Task &task) {
+    // First, we try our own queue (newest first, which is cache friendly)
+    {
+        Queue &q = *_queues[id];
+        unique_lock<mutex> lock(q.mutex);
+        if (not q.tasks.empty()) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+    // Then, we steal the oldest task of another queue
+    for (uint64_t i = 1; i < _queues.size(); ++i) {
+        Queue &q = *_queues[(id + i) % _queues.size()];
+        unique_lock<mutex> lock(q.mutex);
+        if (not q.tasks.empty()) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::_worker(uint64_t id) {
+    worker_pool = this;
+    worker_id = id;
+    while (true) {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _cond_work.wait(lock, [this] { return _stop or _num_queued > 0; });
+            if (_stop) {
+                return;
+            }
+            // We reserve a task, which makes sure that the task we pop below cannot be taken by other workers
+            --_num_queued;
+        }
+        Task task;
+        // The reserved task might not be visible in a queue yet, in which case we retry
+        while (not _pop(id, task)) {
+            this_thread::yield();
+        }
+        task();
+        {
+            unique_lock<mutex> lock(_mutex);
+            if (--_num_unfinished == 0) {
+                _cond_done.notify_all();
+            }
+        }
+    }
+}
+
+} // jitk
+} // bohrium
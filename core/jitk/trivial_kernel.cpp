@@ -0,0 +1,309 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include <bohrium/jitk/trivial_kernel.hpp>
+#include <bohrium/jitk/iterator.hpp>
+#include <bohrium/jitk/kernel_dependencies/nontemporal.h>
+#include <bohrium/bh_main_memory.hpp>
+#include <bohrium/bh_opcode.h>
+#include <bohrium/bh_util.hpp>
+
+using namespace std;
+
+namespace bohrium {
+namespace jitk {
+
+namespace {
+
+// The minimum number of bytes per thread, below which a trivial kernel doesn't gain from more threads
+constexpr uint64_t MIN_BYTES_PER_THREAD = 256 * 1024;
+
+// A 16-byte element (complex128), which we fill as raw bits
+struct Bits128 {
+    uint64_t lo, hi;
+};
+
+// Execute `body(begin, end)` on [0, size) split in one contiguous chunk per thread
+void parallel_chunks(uint64_t size, uint64_t elem_size, ThreadPool *pool, uint64_t max_threads,
+                     const function<void(uint64_t begin, uint64_t end)> &body) {
+    uint64_t nthreads = pool == nullptr ? 1 : pool->size() + 1;
+    if (max_threads > 0) {
+        nthreads = std::min(nthreads, max_threads);
+    }
+    nthreads = std::min(nthreads, std::max(uint64_t{1}, size * elem_size / MIN_BYTES_PER_THREAD));
+    if (nthreads <= 1) {
+        body(0, size);
+    } else {
+        pool->parallelFor(size, (size + nthreads - 1) / nthreads, nthreads, body);
+    }
+}
+
+// The number of bytes of the local tiles that the kernels compute before copying them to the output
+constexpr uint64_t STREAM_TILE_BYTES = 4096;
+
+// Fill `size` elements of type `T` at `dst` with the bits of `value`. We fill a local tile and copy it to the
+// output using `memcpy()`, which uses the widest vector instructions of the machine.
+template<typename T>
+void fill_bits(void *dst, uint64_t size, const void *value, bool stream, ThreadPool *pool, uint64_t max_threads) {
+    T *out = static_cast<T *>(dst);
+    T val;
+    memcpy(&val, value, sizeof(T));
+    parallel_chunks(size, sizeof(T), pool, max_threads, [out, val, stream](uint64_t begin, uint64_t end) {
+        constexpr uint64_t tile_size = STREAM_TILE_BYTES / sizeof(T);
+        T tile[tile_size];
+        std::fill(tile, tile + std::min(tile_size, end - begin), val);
+        for (uint64_t i = begin; i < end; i += tile_size) {
+            const uint64_t nbytes = std::min(tile_size, end - i) * sizeof(T);
+            if (stream) {
+                bh_stream(out + i, tile, nbytes);
+            } else {
+                memcpy(out + i, tile, nbytes);
+            }
+        }
+        if (stream) {
+            bh_stream_fence();
+        }
+    });
+}
+
+// Write the flat array index of the output view, which starts at `start`, into `size` elements at `dst`
+template<typename T>
+void iota(void *dst, uint64_t size, int64_t start, bool stream, ThreadPool *pool, uint64_t max_threads) {
+    T *out = static_cast<T *>(dst);
+    parallel_chunks(size, sizeof(T), pool, max_threads, [out, start, stream](uint64_t begin, uint64_t end) {
+        if (stream) {
+            constexpr uint64_t tile_size = STREAM_TILE_BYTES / sizeof(T);
+            T tile[tile_size];
+            for (uint64_t i = begin; i < end; i += tile_size) {
+                const uint64_t n = std::min(tile_size, end - i);
+                for (uint64_t j = 0; j < n; ++j) {
+                    tile[j] = static_cast<T>(start + static_cast<int64_t>(i + j));
+                }
+                bh_stream(out + i, tile, n * sizeof(T));
+            }
+            bh_stream_fence();
+        } else {
+            for (uint64_t i = begin; i < end; ++i) {
+                out[i] = static_cast<T>(start + static_cast<int64_t>(i));
+            }
+        }
+    });
+}
+
+// Return true when `view` is a contiguous non-empty view of an allocatable array
+bool is_contiguous_array(const bh_view &view) {
+    return not view.isConstant() and view.shape.prod() > 0 and view.isContiguous();
+}
+
+// Return true when the bytes of `nbytes` at `mem` all equal the first byte
+bool is_byte_pattern(const void *mem, uint64_t nbytes) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(mem);
+    return std::all_of(bytes, bytes + nbytes, [bytes](unsigned char b) { return b == bytes[0]; });
+}
+
+} // Anonymous Namespace
+
+TrivialKernel classify_trivial_instr(const bh_instruction &instr) {
+    TrivialKernel ret;
+    if (instr.operand.empty() or not is_contiguous_array(instr.operand[0])) {
+        return ret;
+    }
+    const bh_view &out = instr.operand[0];
+    const bh_type dtype = out.base->dtype();
+    if (instr.opcode == BH_IDENTITY and instr.operand.size() == 2) {
+        const bh_view &in = instr.operand[1];
+        if (in.isConstant()) {
+            if (instr.constant.type == dtype and dtype != bh_type::R123) {
+                ret.kind = TrivialKernel::FILL;
+            }
+        } else if (is_contiguous_array(in) and in.base->dtype() == dtype and in.base != out.base and
+                   in.shape.prod() == out.shape.prod()) {
+            ret.kind = TrivialKernel::COPY;
+        }
+    } else if (instr.opcode == BH_RANGE) {
+        switch (dtype) {
+            case bh_type::INT8:
+            case bh_type::INT16:
+            case bh_type::INT32:
+            case bh_type::INT64:
+            case bh_type::UINT8:
+            case bh_type::UINT16:
+            case bh_type::UINT32:
+            case bh_type::UINT64:
+            case bh_type::FLOAT32:
+            case bh_type::FLOAT64:
+                ret.kind = TrivialKernel::RANGE;
+                break;
+            default:
+                break;
+        }
+    }
+    if (ret.kind != TrivialKernel::NONE) {
+        ret.instr = &instr;
+    }
+    return ret;
+}
+
+const bh_instruction *single_instr_of_kernel(const LoopB &kernel) {
+    const bh_instruction *computation = nullptr;
+    for (const InstrPtr &instr: iterator::allInstr(kernel)) {
+        if (bh_opcode_is_system(instr->opcode)) {
+            continue;
+        }
+        if (computation != nullptr) {
+            // The identity fill of a reduction precedes the reduction
+            const bool identity_of_reduction = computation->opcode == BH_IDENTITY and
+                                               computation->operand[1].isConstant() and
+                                               bh_opcode_is_reduction(instr->opcode) and
+                                               computation->operand[0] == instr->operand[0];
+            if (not identity_of_reduction) {
+                return nullptr;
+            }
+        }
+        computation = instr.get();
+    }
+    if (computation == nullptr) {
+        return nullptr;
+    }
+    const set<bh_base *> frees = kernel.getAllFrees();
+    if (util::exist(frees, computation->operand[0].base)) {
+        return nullptr;
+    }
+    return computation;
+}
+
+TrivialKernel classify_trivial_kernel(const LoopB &kernel) {
+    const bh_instruction *instr = single_instr_of_kernel(kernel);
+    return instr == nullptr ? TrivialKernel() : classify_trivial_instr(*instr);
+}
+
+bool alloc_trivial_kernel(const TrivialKernel &kernel) {
+    assert(kernel.kind != TrivialKernel::NONE);
+    const bh_instruction &instr = *kernel.instr;
+    const bool fresh = bh_data_malloc(instr.operand[0].base);
+    if (kernel.kind == TrivialKernel::COPY) {
+        bh_data_malloc(instr.operand[1].base);
+    }
+    return fresh and kernel.kind == TrivialKernel::FILL and
+           is_byte_pattern(&instr.constant.value, static_cast<uint64_t>(bh_type_size(instr.constant.type))) and
+           *reinterpret_cast<const unsigned char *>(&instr.constant.value) == 0;
+}
+
+void run_trivial_kernel(const TrivialKernel &kernel, uint64_t nontemporal_threshold, ThreadPool *pool,
+                        uint64_t max_threads) {
+    assert(kernel.kind != TrivialKernel::NONE);
+    const bh_instruction &instr = *kernel.instr;
+    const bh_view &out = instr.operand[0];
+    const bh_type dtype = out.base->dtype();
+    const uint64_t elem_size = static_cast<uint64_t>(bh_type_size(dtype));
+    const uint64_t size = static_cast<uint64_t>(out.shape.prod());
+    char *dst = static_cast<char *>(out.base->getDataPtr()) + out.start * elem_size;
+    const bool stream = nontemporal_threshold > 0 and size * elem_size >= nontemporal_threshold;
+
+    switch (kernel.kind) {
+        case TrivialKernel::FILL: {
+            const void *value = &instr.constant.value;
+            if (not stream and is_byte_pattern(value, elem_size)) {
+                const int byte = *static_cast<const unsigned char *>(value);
+                parallel_chunks(size * elem_size, 1, pool, max_threads, [dst, byte](uint64_t begin, uint64_t end) {
+                    memset(dst + begin, byte, end - begin);
+                });
+                break;
+            }
+            switch (elem_size) {
+                case 1:
+                    fill_bits<uint8_t>(dst, size, value, stream, pool, max_threads);
+                    break;
+                case 2:
+                    fill_bits<uint16_t>(dst, size, value, stream, pool, max_threads);
+                    break;
+                case 4:
+                    fill_bits<uint32_t>(dst, size, value, stream, pool, max_threads);
+                    break;
+                case 8:
+                    fill_bits<uint64_t>(dst, size, value, stream, pool, max_threads);
+                    break;
+                case 16:
+                    fill_bits<Bits128>(dst, size, value, stream, pool, max_threads);
+                    break;
+                default:
+                    throw runtime_error("run_trivial_kernel(): unsupported element size");
+            }
+            break;
+        }
+        case TrivialKernel::COPY: {
+            const bh_view &in = instr.operand[1];
+            const char *src = static_cast<const char *>(in.base->getDataPtr()) + in.start * elem_size;
+            parallel_chunks(size * elem_size, 1, pool, max_threads, [dst, src, stream](uint64_t begin, uint64_t end) {
+                if (stream) {
+                    bh_stream(dst + begin, src + begin, end - begin);
+                    bh_stream_fence();
+                } else {
+                    memcpy(dst + begin, src + begin, end - begin);
+                }
+            });
+            break;
+        }
+        case TrivialKernel::RANGE:
+            switch (dtype) {
+                case bh_type::INT8:
+                    iota<int8_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::INT16:
+                    iota<int16_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::INT32:
+                    iota<int32_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::INT64:
+                    iota<int64_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::UINT8:
+                    iota<uint8_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::UINT16:
+                    iota<uint16_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::UINT32:
+                    iota<uint32_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::UINT64:
+                    iota<uint64_t>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::FLOAT32:
+                    iota<float>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                case bh_type::FLOAT64:
+                    iota<double>(dst, size, out.start, stream, pool, max_threads);
+                    break;
+                default:
+                    throw runtime_error("run_trivial_kernel(): unsupported range type");
+            }
+            break;
+        default:
+            throw runtime_error("run_trivial_kernel(): not a trivial kernel");
+    }
+}
+
+} // jitk
+} // bohrium
@@ -28,34 +28,44 @@ using namespace std;
 namespace bohrium {
 namespace jitk {
 
-void write_array_index(const Scope &scope, const bh_view &view, stringstream &out, bool ignore_declared_indexes,
-                       int hidden_axis, const pair<int, int> axis_offset) {
-
-    // Let's check if the index is already declared as a variable
-    if (not ignore_declared_indexes) {
-        if (scope.isIdxDeclared(view)) {
-            scope.getIdxName(view, out);
-            return;
+namespace {
+// Write the terms of the loop iterators of 'view', e.g. " +i0*10 +i1", where the rank of the iterator is
+// in ['rank_begin', 'rank_end'). Returns true when a term was written.
+bool write_iterator_terms(const Scope &scope, const bh_view &view, stringstream &out, int hidden_axis,
+                          const pair<int, int> axis_offset, int rank_begin, int rank_end) {
+    bool ret = false;
+    const bool strides_as_var = scope.symbols.strides_as_var and scope.symbols.existOffsetStridesID(view);
+    for (int i = 0; i < view.ndim; ++i) {
+        int t = i;
+        if (i >= hidden_axis) {
+            ++t;
         }
+        if (t < rank_begin or t >= rank_end or (not strides_as_var and view.stride[i] == 0)) {
+            continue;
+        }
+        if (axis_offset.first == t) {
+            out << " +(i" << t << "+(i" << t << "==0?0:" << axis_offset.second << ")) ";
+        } else {
+            out << " +i" << t;
+        }
+        if (strides_as_var) {
+            out << "*vs" << scope.symbols.offsetStridesID(view) << "_" << i;
+        } else if (view.stride[i] != 1) {
+            out << "*" << view.stride[i];
+        }
+        ret = true;
     }
+    return ret;
+}
 
+// Write the offset of 'view' and the terms of the iterators of rank less than 'rank_end'
+void write_offset_and_terms(const Scope &scope, const bh_view &view, stringstream &out, int hidden_axis,
+                            const pair<int, int> axis_offset, int rank_end) {
     if (scope.symbols.strides_as_var and scope.symbols.existOffsetStridesID(view)) {
         // Write view.start using the offset-and-strides variable
         out << "vo" << scope.symbols.offsetStridesID(view);
-
         if (not view.is_scalar()) { // NB: this optimization is required when reducing a vector to a scalar!
-            for (int i = 0; i < view.ndim; ++i) {
-                int t = i;
-                if (i >= hidden_axis) {
-                    ++t;
-                }
-                if (axis_offset.first == t) {
-                    out << " +(i" << t << "+(i" << t << "==0?0:" << axis_offset.second << ")) ";
-                } else {
-                    out << " +i" << t;
-                }
-                out << "*vs" << scope.symbols.offsetStridesID(view) << "_" << i;
-            }
+            write_iterator_terms(scope, view, out, hidden_axis, axis_offset, 0, rank_end);
         }
     } else {
         bool empty_subscription = true;
@@ -64,21 +74,8 @@ void write_array_index(const Scope &scope, const bh_view &view, stringstream &ou
             empty_subscription = false;
         }
         if (not view.is_scalar()) { // NB: this optimization is required when reducing a vector to a scalar!
-            for (int i = 0; i < view.ndim; ++i) {
-                int t = i;
-                if (i >= hidden_axis)
-                    ++t;
-                if (view.stride[i] != 0) {
-                    if (axis_offset.first == t) {
-                        out << " +(i" << t << "+(i" << t << "==0?0:" << axis_offset.second << ")) ";
-                    } else {
-                        out << " +i" << t;
-                    }
-                    if (view.stride[i] != 1) {
-                        out << "*" << view.stride[i];
-                    }
-                    empty_subscription = false;
-                }
+            if (write_iterator_terms(scope, view, out, hidden_axis, axis_offset, 0, rank_end)) {
+                empty_subscription = false;
             }
         }
         if (empty_subscription) {
@@ -86,6 +83,33 @@ void write_array_index(const Scope &scope, const bh_view &view, stringstream &ou
         }
     }
 }
+}
+
+void write_array_index(const Scope &scope, const bh_view &view, stringstream &out, bool ignore_declared_indexes,
+                       int hidden_axis, const pair<int, int> axis_offset) {
+
+    // Let's check if the index is already declared as a variable
+    if (not ignore_declared_indexes) {
+        if (scope.isIdxDeclared(view)) {
+            scope.getIdxName(view, out);
+            return;
+        }
+        // Or if the part of the index that depends on the outer loops is declared as a variable
+        if (hidden_axis == BH_MAXDIM and not view.is_scalar()) {
+            const int rank = scope.idxBaseRank(view);
+            if (rank > 0 and axis_offset.first >= rank) {
+                scope.getIdxBaseName(view, rank, out);
+                write_iterator_terms(scope, view, out, hidden_axis, axis_offset, rank, BH_MAXDIM + 1);
+                return;
+            }
+        }
+    }
+    write_offset_and_terms(scope, view, out, hidden_axis, axis_offset, BH_MAXDIM + 1);
+}
+
+void write_array_index_base(const Scope &scope, const bh_view &view, int rank, stringstream &out) {
+    write_offset_and_terms(scope, view, out, BH_MAXDIM, make_pair(BH_MAXDIM, 0), rank);
+}
 
 void write_array_subscription(const Scope &scope, const bh_view &view, stringstream &out, bool ignore_declared_indexes,
                               int hidden_axis, const pair<int, int> axis_offset) {
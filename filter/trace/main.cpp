@@ -0,0 +1,122 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <bohrium/bh_component.hpp>
+
+#include "trace.hpp"
+
+using namespace bohrium;
+using namespace component;
+using namespace std;
+
+namespace {
+class Impl : public ComponentImpl {
+  private:
+    const string path;
+    trace::Writer writer;
+    // Record the contents of the arrays that the bridge passes (otherwise they are zeros at replay)
+    const bool record_data;
+    // The state of the serializing end of the trace (see `BhIR::writeSerialized()`)
+    set<bh_base *> known_base_arrays;
+    BhIRViewDict view_dict;
+    // Known base arrays that the bridge might have written, thus their data are recorded again at the next BhIR
+    set<bh_base *> dirty;
+
+    // Make `base` unknown since the bridge might write its data
+    void markDirty(bh_base *base) {
+        if (known_base_arrays.erase(base) > 0) {
+            dirty.insert(base);
+        }
+    }
+
+  public:
+    Impl(int stack_level) : ComponentImpl(stack_level),
+                            path(config.defaultGet<string>("file", "trace.bhtrace")),
+                            writer(path),
+                            record_data(config.defaultGet("data", true)) {
+        cout << "trace-filter: writing trace('" << path << "')." << endl;
+    }
+    ~Impl() override = default;
+
+    void execute(BhIR *bhir) override {
+        vector<bh_base *> new_data;
+        const vector<char> buf = bhir->writeSerialized(known_base_arrays, view_dict, new_data);
+        writer.write(trace::Kind::BHIR, 0, buf.data(), buf.size());
+        for (bh_base *base: new_data) {
+            const uint32_t flags = dirty.erase(base) > 0 ? trace::flag_update : 0;
+            writer.write(trace::Kind::DATA, flags, base->getDataPtr(), record_data ? base->nbytes() : 0);
+        }
+        child.execute(bhir);
+
+        // The freed base arrays are unknown, which makes their pointers available for new base arrays
+        for (const bh_instruction &instr: bhir->instr_list) {
+            if (instr.opcode == BH_FREE) {
+                known_base_arrays.erase(instr.operand[0].base);
+                dirty.erase(instr.operand[0].base);
+            }
+        }
+    }
+
+    void extmethod(const string &name, bh_opcode opcode) override {
+        vector<char> buf(sizeof(uint64_t) + name.size());
+        const uint64_t op = opcode;
+        memcpy(buf.data(), &op, sizeof(op));
+        memcpy(buf.data() + sizeof(op), name.data(), name.size());
+        writer.write(trace::Kind::EXTMETHOD, 0, buf.data(), buf.size());
+        child.extmethod(name, opcode);
+    }
+
+    void *getMemoryPointer(bh_base &base, bool copy2host, bool force_alloc, bool nullify) override {
+        void *ret = child.getMemoryPointer(base, copy2host, force_alloc, nullify);
+        if (nullify) {
+            // The bridge takes over the data thus the replayer discards the array like the proxy backend does
+            if (known_base_arrays.erase(&base) > 0 or dirty.erase(&base) > 0) {
+                const auto id = reinterpret_cast<uint64_t>(&base);
+                writer.write(trace::Kind::DISCARD, 0, &id, sizeof(id));
+            }
+        } else {
+            markDirty(&base);
+        }
+        return ret;
+    }
+
+    void setMemoryPointer(bh_base *base, bool host_ptr, void *mem) override {
+        child.setMemoryPointer(base, host_ptr, mem);
+        markDirty(base);
+    }
+
+    void memCopy(bh_view &src, bh_view &dst, const string &param) override {
+        child.memCopy(src, dst, param);
+        markDirty(dst.base);
+    }
+};
+} //Unnamed namespace
+
+extern "C" ComponentImpl* create(int stack_level) {
+    return new Impl(stack_level);
+}
+extern "C" void destroy(ComponentImpl* self) {
+    delete self;
+}
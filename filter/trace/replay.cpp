@@ -0,0 +1,199 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Replays a trace of the trace filter on the stack of BH_STACK, which must not include the trace filter itself.
+ * The replayer takes the place of the bridge: it executes the recorded BhIRs in order with the recorded array
+ * contents and prints the time of each pass. The first pass includes the compilation of the kernels thus running
+ * it once is also a way to populate the kernel cache, e.g. before a deploy.
+ *
+ * Usage: bh_trace_replay <trace file> [passes]
+ */
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+
+#include <bohrium/bh_component.hpp>
+#include <bohrium/bh_main_memory.hpp>
+
+#include "trace.hpp"
+
+using namespace std;
+using namespace bohrium;
+using namespace component;
+
+namespace {
+
+// The statistics of a pass over the trace
+struct PassStat {
+    uint64_t nbhir = 0;
+    uint64_t ninstr = 0;
+    uint64_t nbytes_data = 0;
+    std::chrono::duration<double> exec{0};
+    std::chrono::duration<double> data{0};
+    std::chrono::duration<double> total{0};
+};
+
+class Replayer {
+private:
+    ConfigParser config;
+    ComponentFace runtime;
+    // The registered extension methods, which are registered at the first pass only
+    set<bh_opcode> extmethods;
+
+    // Set the data of `base` to the contents of a DATA record
+    void loadData(bh_base &base, const trace::RecordHeader &head, const vector<char> &data) {
+        if (not data.empty() and static_cast<int64_t>(data.size()) != base.nbytes()) {
+            throw runtime_error("[TRACE-REPLAY] the recorded array data has the wrong size");
+        }
+        void *mem;
+        if (head.flags & trace::flag_update) {
+            // The array is in use by the stack thus we write through its host memory
+            mem = runtime.getMemoryPointer(base, true, true, false);
+        } else {
+            base.resetDataPtr();
+            bh_data_malloc(&base);
+            mem = base.getDataPtr();
+        }
+        // Notice, we zero-fill unrecorded data since neither the stack nor `bh_data_malloc()` does it
+        // (the malloc cache recycles memory)
+        if (data.empty()) {
+            memset(mem, 0, static_cast<size_t>(base.nbytes()));
+        } else {
+            memcpy(mem, data.data(), data.size());
+        }
+    }
+
+public:
+    // The replayer is the bridge thus at stack level -1
+    Replayer() : config(-1), runtime(config.getChildLibraryPath(), 0) {}
+
+    PassStat run(trace::Reader &reader) {
+        PassStat stat;
+        map<const bh_base *, bh_base> remote2local;
+        BhIRViewDict view_dict;
+        trace::RecordHeader head{};
+        vector<char> payload, data;
+        const auto t_begin = chrono::steady_clock::now();
+
+        reader.rewind();
+        while (reader.next(head, payload)) {
+            switch (head.kind) {
+                case trace::Kind::BHIR: {
+                    vector<bh_base *> data_recv;
+                    set<bh_base *> freed;
+                    BhIR bhir(payload, remote2local, view_dict, data_recv, freed);
+
+                    // The array data follows as DATA records in the order of `data_recv`
+                    auto t = chrono::steady_clock::now();
+                    for (bh_base *base: data_recv) {
+                        if (not reader.next(head, data) or head.kind != trace::Kind::DATA) {
+                            throw runtime_error("[TRACE-REPLAY] the trace file is missing array data");
+                        }
+                        loadData(*base, head, data);
+                        stat.nbytes_data += data.size();
+                    }
+                    stat.data += chrono::steady_clock::now() - t;
+
+                    ++stat.nbhir;
+                    stat.ninstr += bhir.instr_list.size();
+                    t = chrono::steady_clock::now();
+                    runtime.execute(&bhir);
+                    stat.exec += chrono::steady_clock::now() - t;
+
+                    // Let's remove the freed base arrays
+                    for (const bh_base *base: freed) {
+                        bh_data_free(&remote2local[base]);
+                        remote2local.erase(base);
+                    }
+                    break;
+                }
+                case trace::Kind::EXTMETHOD: {
+                    if (payload.size() < sizeof(uint64_t)) {
+                        throw runtime_error("[TRACE-REPLAY] corrupt extension method record");
+                    }
+                    uint64_t opcode;
+                    memcpy(&opcode, payload.data(), sizeof(opcode));
+                    if (extmethods.insert(static_cast<bh_opcode>(opcode)).second) {
+                        runtime.extmethod(string(payload.begin() + sizeof(opcode), payload.end()),
+                                          static_cast<bh_opcode>(opcode));
+                    }
+                    break;
+                }
+                case trace::Kind::DISCARD: {
+                    uint64_t id;
+                    if (payload.size() != sizeof(id)) {
+                        throw runtime_error("[TRACE-REPLAY] corrupt discard record");
+                    }
+                    memcpy(&id, payload.data(), sizeof(id));
+                    auto it = remote2local.find(reinterpret_cast<const bh_base *>(id));
+                    if (it != remote2local.end()) {
+                        // Like the bridge, we take over the data, which we free right away
+                        it->second.resetDataPtr(runtime.getMemoryPointer(it->second, true, false, true));
+                        bh_data_free(&it->second);
+                        remote2local.erase(it);
+                    }
+                    break;
+                }
+                default: {
+                    throw runtime_error("[TRACE-REPLAY] unexpected record in the trace file");
+                }
+            }
+        }
+
+        // Free the base arrays that the trace never freed, which makes the next pass start from scratch
+        if (not remote2local.empty()) {
+            vector<bh_instruction> instr_list;
+            for (auto &b: remote2local) {
+                instr_list.emplace_back(BH_FREE, vector<bh_view>{bh_view(&b.second)});
+            }
+            BhIR bhir(std::move(instr_list), {});
+            runtime.execute(&bhir);
+            for (auto &b: remote2local) {
+                bh_data_free(&b.second);
+            }
+        }
+        stat.total = chrono::steady_clock::now() - t_begin;
+        return stat;
+    }
+};
+} //Unnamed namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 or argc > 3) {
+        cout << "Usage: " << argv[0] << " <trace file> [passes]" << endl;
+        return 0;
+    }
+    const int passes = argc == 3 ? atoi(argv[2]) : 1;
+
+    trace::Reader reader(argv[1]);
+    Replayer replayer;
+    for (int i = 0; i < passes; ++i) {
+        const PassStat stat = replayer.run(reader);
+        cout << "Pass " << i + 1 << ": " << stat.nbhir << " BhIRs, " << stat.ninstr << " instructions, "
+             << stat.nbytes_data / 1024.0 / 1024.0 << "MB of array data" << endl;
+        cout << "  Total:   " << stat.total.count() << "s" << endl;
+        cout << "  Execute: " << stat.exec.count() << "s" << endl;
+        cout << "  Data:    " << stat.data.count() << "s" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdexcept>
+
+#include "trace.hpp"
+
+using namespace std;
+
+namespace bohrium {
+namespace trace {
+
+namespace {
+constexpr uint32_t file_magic = 0x52546842; // "BhTR"
+constexpr uint32_t file_version = 1;
+constexpr std::streamoff first_record = 2 * sizeof(uint32_t);
+}
+
+Writer::Writer(const std::string &path) : _file(path, ios::binary | ios::trunc) {
+    if (not _file) {
+        throw runtime_error("[TRACE-FILTER] cannot create the trace file '" + path + "'");
+    }
+    _file.write(reinterpret_cast<const char *>(&file_magic), sizeof(file_magic));
+    _file.write(reinterpret_cast<const char *>(&file_version), sizeof(file_version));
+}
+
+void Writer::write(Kind kind, uint32_t flags, const void *payload, uint64_t nbytes) {
+    const RecordHeader head{kind, flags, nbytes};
+    _file.write(reinterpret_cast<const char *>(&head), sizeof(head));
+    if (nbytes > 0) {
+        _file.write(static_cast<const char *>(payload), nbytes);
+    }
+    if (not _file) {
+        throw runtime_error("[TRACE-FILTER] failed writing the trace file");
+    }
+}
+
+Reader::Reader(const std::string &path) : _file(path, ios::binary) {
+    if (not _file) {
+        throw runtime_error("[TRACE-FILTER] cannot open the trace file '" + path + "'");
+    }
+    uint32_t magic = 0, version = 0;
+    _file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    _file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    if (not _file or magic != file_magic) {
+        throw runtime_error("[TRACE-FILTER] '" + path + "' is not a trace file");
+    }
+    if (version != file_version) {
+        throw runtime_error("[TRACE-FILTER] '" + path + "' is of an unsupported version");
+    }
+}
+
+bool Reader::next(RecordHeader &head, std::vector<char> &payload) {
+    if (not _file.read(reinterpret_cast<char *>(&head), sizeof(head))) {
+        if (_file.gcount() != 0) {
+            throw runtime_error("[TRACE-FILTER] the trace file is truncated");
+        }
+        return false;
+    }
+    payload.resize(head.nbytes);
+    if (head.nbytes > 0 and not _file.read(payload.data(), head.nbytes)) {
+        throw runtime_error("[TRACE-FILTER] the trace file is truncated");
+    }
+    return true;
+}
+
+void Reader::rewind() {
+    _file.clear();
+    _file.seekg(first_record);
+}
+
+} // trace
+} // bohrium
@@ -0,0 +1,87 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bohrium {
+namespace trace {
+
+/* The binary trace file of the trace filter (version 1), which `bh_trace_replay` replays. All values are in the
+ * byte order of the host. The file starts with a magic number and the version (uint32_t each) followed by records,
+ * each of which is a `RecordHeader` and `nbytes` bytes of payload:
+ *
+ *   BHIR       a BhIR serialized by `BhIR::writeSerialized()` against the view dictionary and the known base
+ *              arrays of the whole trace
+ *   DATA       the contents of a base array of the preceding BhIR that had data when the BhIR was recorded, one
+ *              record for each in the order of `new_data` of `writeSerialized()`. The payload is empty when the
+ *              contents were not recorded.
+ *   EXTMETHOD  the registration of an extension method: the opcode (uint64_t) followed by the name
+ *   DISCARD    the id (uint64_t) of a base array whose data the bridge took over (`getMemoryPointer()` with nullify)
+ */
+enum class Kind : uint32_t {
+    BHIR = 1,
+    DATA = 2,
+    EXTMETHOD = 3,
+    DISCARD = 4,
+};
+
+// Flag of a DATA record: the base array is known from a previous BhIR and the bridge might have written its data
+constexpr uint32_t flag_update = 1;
+
+struct RecordHeader {
+    Kind kind;
+    uint32_t flags;
+    uint64_t nbytes;
+};
+
+/// Writer of a trace file
+class Writer {
+private:
+    std::ofstream _file;
+public:
+    /// Create the trace file `path`
+    explicit Writer(const std::string &path);
+
+    /// Write a record of `nbytes` bytes of `payload`
+    void write(Kind kind, uint32_t flags, const void *payload, uint64_t nbytes);
+};
+
+/// Reader of a trace file
+class Reader {
+private:
+    std::ifstream _file;
+public:
+    /// Open the trace file `path`
+    explicit Reader(const std::string &path);
+
+    /// Read the next record into `head` and `payload`. Returns false at the end of the file.
+    bool next(RecordHeader &head, std::vector<char> &payload);
+
+    /// Go back to the first record
+    void rewind();
+};
+
+} // trace
+} // bohrium
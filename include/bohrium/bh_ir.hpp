@@ -22,9 +22,31 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 #include <bohrium/bh_instruction.hpp>
 
+/* The dictionary of the views that a stream of serialized BhIRs has transferred. The serializing and the
+ * de-serializing end each keep a dictionary, which stay identical as long as the BhIRs are de-serialized in the
+ * order they were serialized. A view already in the dictionary is transferred as its index. */
+struct BhIRViewDict {
+    // The maximum number of views in the dictionary. The BhIR that would exceed it starts a new dictionary.
+    static constexpr uint32_t max_size = 1u << 14;
+
+    // Hash of the views in `index`, which never have slides
+    struct ViewHash {
+        size_t operator()(const bh_view &view) const;
+    };
+
+    // The serializing end: the index of the views that have been sent (views with slides are never looked up)
+    std::unordered_map<bh_view, uint32_t, ViewHash> index;
+    // The serializing end: the number of views that have been sent
+    uint32_t size = 0;
+
+    // The de-serializing end: the received views by their index. NB: the base pointers are "remote"
+    std::vector<bh_view> views;
+};
+
 /* The Bohrium Internal Representation (BhIR) represents an instruction
  * batch created by the Bridge component typically. */
 class BhIR
@@ -51,42 +73,49 @@ public:
         _nrepeats(nrepeats),
         _repeat_condition(repeat_condition) {}
 
-    /** Constructor that takes a serialized archive. All base array pointers are updated so that they point to
+    /** Constructor that takes a serialized BhIR. All base array pointers are updated so that they point to
      *  local base arrays in `remote2local`.
      *
-     *
-     * \param serialized_archive Byte vector that makes up the serialized archive. The archive should be created with
-     *                           `writeSerializedArchive`, which uses `boost::archive::binary_iarchive`.
+     * \param serialized Byte vector that makes up the serialized BhIR, which should be created with
+     *                   `writeSerialized()`. The fixed-size records of the format are read in place.
      *
      * \param remote2local Map that maps remote array bases to local bases. The map is updated to include the new
      *                     array bases encountered in this BhIR thus this map should stay allocated throughout the
      *                     whole program execution.
      *
+     * \param view_dict The view dictionary of the de-serializing end, which is updated with the new views.
+     *
      * \param frees On return, will contain pointers to base arrays freed in this BhIR. NB: the pointer are "remote"
      *
      * \note We use the notion of remote and local base arrays. Remote base arrays are pointers to memory on
-     *       the machine that serialized `serialized_archive`. Remote base arrays cannot be de-referenced instead they
+     *       the machine that serialized `serialized`. Remote base arrays cannot be de-referenced instead they
      *       act as base array IDs.
      *       Use `remote2local` to translate remote base arrays to local base arrays, which are regular base arrays
      *       that can de-referenced.
      */
-    BhIR(const std::vector<char> &serialized_archive,
+    BhIR(const std::vector<char> &serialized,
          std::map<const bh_base*, bh_base> &remote2local,
+         BhIRViewDict &view_dict,
          std::vector<bh_base*> &data_recv,
          std::set<bh_base*> &frees);
 
 
-    /** Write the BhIR into a serialized archive.
+    /** Write the BhIR into the versioned flat binary format (see bh_ir.cpp), which consists of fixed-size
+     *  records that the de-serializing end reads in place.
      *
      * \param known_base_arrays Set of known base arrays. The set is updated to include new base arrays in this BhIR.
-     *                          The new base arrays are also serialized into the return archive.
+     *                          The new base arrays are also serialized into the return buffer.
+     *
+     * \param view_dict The view dictionary of the serializing end. Views in the dictionary are written as their
+     *                  index and new views are added.
      *
      * \param new_data On return, will contain all base arrays that points to new array data i.e. the `bh_base.data`
      *                 pointers that are unknown to the de-serializing component. The bases are order as they appear
      *                 in the BhIR, thus their data should be transferred to the de-serializing component in the order
      *                 they appear.
      */
-    std::vector<char> writeSerializedArchive(std::set<bh_base*> &known_base_arrays, std::vector<bh_base*> &new_data);
+    std::vector<char> writeSerialized(std::set<bh_base*> &known_base_arrays, BhIRViewDict &view_dict,
+                                      std::vector<bh_base*> &new_data);
 
     /** Returns the set of sync'ed arrays */
     const std::set<bh_base *> getSyncs() const {
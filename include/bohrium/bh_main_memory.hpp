@@ -34,8 +34,18 @@ int64_t bh_main_memory_unused();
  * For convenience, the base is allowed to be NULL.
  *
  * @base    The base in question
+ * @return  True when the data memory is a new allocation, which is zero-filled
  */
-void bh_data_malloc(bh_base* base);
+bool bh_data_malloc(bh_base* base);
+
+/** Set the data memory of the given base to `mem`, which must be a memory mapping (see mmap(2)) of
+ * `base->nbytes()` bytes that the caller hands over. Like any other data memory, it must be freed
+ * through bh_data_free(), which unmaps it.
+ *
+ * @base    The base in question, which must not have data memory
+ * @mem     The memory mapping
+ */
+void bh_data_adopt(bh_base* base, void *mem);
 
 /** Frees data memory for the given view.
  * For convenience, the view is allowed to be NULL.
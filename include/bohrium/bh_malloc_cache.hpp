@@ -181,9 +181,13 @@ public:
     /** Alloc a memory allocation of size `nbytes`
      *
      * @param nbytes Number of bytes to allocate
+     * @param fresh  When not NULL, set to true when the allocation is new thus not reused from the cache
      * @return The memory allocation
      */
-    void *alloc(uint64_t nbytes) {
+    void *alloc(uint64_t nbytes, bool *fresh = nullptr) {
+        if (fresh != nullptr) {
+            *fresh = false;
+        }
         if (nbytes == 0) {
             return nullptr;
         }
@@ -203,9 +207,25 @@ public:
         shrinkToFitLimit(nbytes);
 
         void *ret = _malloc(nbytes); // Cache miss
+        if (fresh != nullptr) {
+            *fresh = true;
+        }
         return ret;
     }
 
+    /** Take over a memory allocation of size `nbytes`, which was not allocated by this cache but which the free
+     * function of this cache can free. Like any other allocation, it must be freed through `free()`.
+     *
+     * @param nbytes The size of the memory allocation
+     */
+    void adopt(uint64_t nbytes) {
+        shrinkToFitLimit(nbytes);
+        _mem_allocated += nbytes;
+        if (_mem_allocated > _stat_allocated_max) {
+            _stat_allocated_max = _mem_allocated;
+        }
+    }
+
     /** Frees a memory allocation of size `nbytes`
      *
      * @param nbytes The size of the memory allocation
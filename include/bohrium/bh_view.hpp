@@ -93,6 +93,9 @@ struct bh_view {
     /// Transposes by swapping the two axes 'axis1' and 'axis2'
     void transpose(int64_t axis1, int64_t axis2);
 
+    /// Slide this view one iteration as specified by `slides` (used between the iterations of a repeat)
+    void slide();
+
     /// Return true when this view only represent one element
     bool is_scalar() const {
         return shape.prod() == 1;
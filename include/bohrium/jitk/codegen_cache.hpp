@@ -19,20 +19,36 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 
+#include <list>
 #include <map>
 #include <string>
 
 #include <bohrium/bh_instruction.hpp>
 #include <bohrium/jitk/block.hpp>
 #include <bohrium/jitk/statistics.hpp>
+#include <bohrium/jitk/structural_hash.hpp>
 
 
 namespace bohrium {
 namespace jitk {
 
 class CodegenCache {
+public:
+    // A cached source code
+    struct Source {
+        std::string code;
+        uint64_t hash; // The "pure" hash of `code` i.e. `util::hash(code)`
+    };
 private:
-    std::map<size_t, std::string> _cache;
+    // A cached source code and the hashed fields of its kernel, which verifies cache hits
+    struct Entry {
+        std::vector<uint64_t> fields;
+        Source source;
+    };
+    // The hash to entries map (the entries of a hash are only more than one on hash collisions)
+    std::map<Hash128, std::list<Entry> > _cache;
+    // The hasher of the kernels
+    StructuralHasher _hasher;
     // Some statistics
     jitk::Statistics &stat;
 public:
@@ -43,17 +59,18 @@ public:
      *
      * @param kernel  The kernel
      * @param symbols The symbol table
-     * @return The source code and the hash of the source or the empty string on cache misses
+     * @return The cached source code (or nullptr on cache misses) and the key of the kernel, which hash is the
+     *         hash of the kernel (`key.hash.lo`) and which fields are only set on cache misses
      */
-    std::pair<std::string, uint64_t> lookup(const LoopB &kernel, const SymbolTable &symbols);
+    std::pair<const Source *, StructuralKey> lookup(const LoopB &kernel, const SymbolTable &symbols);
 
-    /** Insert `source` as a hit when requesting `kernel`
+    /** Insert `source` as a hit when requesting the kernel with the key `key`
      *
-     * @param source  The source code
-     * @param kernel  The kernel
-     * @param symbols The symbol table
+     * @param source The source code
+     * @param key    The key of the kernel as returned by a `lookup()`, which was a cache miss
+     * @return The cached source code, which stays valid for the lifetime of the cache
      */
-    void insert(std::string source, const LoopB &kernel, const SymbolTable &symbols);
+    const Source &insert(std::string source, StructuralKey key);
 };
 
 } // jit
@@ -81,6 +81,10 @@ protected:
     int64_t malloc_cache_limit_in_percent{-1};
     int64_t malloc_cache_limit_in_bytes{-1};
 
+    // Write the transcendental functions as calls to the vector math library of the kernels rather than libm.
+    // NB: each backend that ships the library should set this value
+    bool fast_math{false};
+
 public:
     /** The only constructor */
     Engine(component::ComponentVE &comp, Statistics &stat) :
@@ -123,7 +127,7 @@ public:
 
     /** Set the `bh_instruction->constructor` flag of all instruction in `instr_list`
      * The constructor flag indicates whether the instruction construct the output array
-     * (i.e. is the first operation on that array)
+     * (i.e. is the first operation on an array that has no data yet)
      *
      * @param instr_list         The list of instruction to update
      * @param constructed_arrays Arrays already constructed. Will be updated with arrays constructed in `instr_list`
@@ -132,7 +136,7 @@ public:
 
     /** Set the `bh_instruction->constructor` flag of all instruction in `instr_list`
      * The constructor flag indicates whether the instruction construct the output array
-     * (i.e. is the first operation on that array)
+     * (i.e. is the first operation on an array that has no data yet)
      *
      * @param instr_list  The list of instruction to update
      */
@@ -192,6 +196,18 @@ protected:
                                 const std::vector<uint64_t> &thread_stack,
                                 std::stringstream &out) = 0;
 
+    /** Write the code that follows the closing brace of a loop (default nothing)
+     *
+     * @param symbols       The symbol table
+     * @param scope         The scope of the loop header
+     * @param block         The block
+     * @param out           The stream output
+     */
+    virtual void loopTailWriter(const SymbolTable &symbols,
+                                Scope &scope,
+                                const LoopB &block,
+                                std::stringstream &out) {}
+
     /** Write the source code of an instruction
      *
      * @param scope     The scope
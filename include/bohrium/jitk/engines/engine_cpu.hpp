@@ -19,11 +19,17 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include "engine.hpp"
 
 #include <bohrium/bh_config_parser.hpp>
 #include <bohrium/jitk/statistics.hpp>
 #include <bohrium/jitk/apply_fusion.hpp>
+#include <bohrium/jitk/plan_cache.hpp>
+#include <bohrium/jitk/thread_pool.hpp>
+#include <bohrium/jitk/trivial_kernel.hpp>
 
 #include <bohrium/bh_view.hpp>
 #include <bohrium/bh_component.hpp>
@@ -37,24 +43,165 @@ class EngineCPU : public Engine {
 protected:
     // In order to avoid duplicate calls to `ConfigParser`, we store config settings here
     const FusionConfig fusion_config;
+
+    // Maximum number of independent kernels to execute concurrently (one disables concurrent execution)
+    const int64_t kernel_concurrency;
+
+    // Execute repeats that fit in a single kernel within one kernel launch?
+    const bool repeat_in_kernel;
+
+    // Execute repeated flushes using the plan cache? (requires starts, strides, and constants as variables)
+    const bool use_plan_cache;
+
+    // Execute single fill, copy, and range kernels using built-in routines instead of generated kernels?
+    const bool trivial_kernels;
+
+    // Outputs of at least this many bytes that a kernel only writes are written with non-temporal stores
+    // (zero disables). Code generators apply it to the unit-stride version of their kernels.
+    const uint64_t nontemporal_threshold;
+
+    // The thread pool that executes independent kernels concurrently (created on first use)
+    std::unique_ptr<ThreadPool> _kernel_pool;
+
+    // The worker threads that execute the chunks of data-parallel loops such as large trivial kernels. Engines might
+    // create it with their own number of threads, otherwise it is created on first use.
+    std::unique_ptr<ThreadPool> _pool;
+
+    // The execution plans of the flushes
+    PlanCache plan_cache;
+
+    // Execute the `kernel_list` concurrently while respecting their dependencies.
+    // Returns false if there is nothing to gain, in which case nothing is executed.
+    bool executeConcurrently(const std::vector<LoopB> &kernel_list);
+
+    // Returns the trivial kernel of `kernel` or a trivial kernel of kind NONE if `trivial_kernels` is disabled
+    TrivialKernel getTrivialKernel(const LoopB &kernel) const;
+
+    // Execute the trivial `kernel` using at most `max_threads` threads (zero means no limit)
+    void executeTrivial(const TrivialKernel &kernel, uint64_t max_threads);
+
+    // Execute the kernels of `plan` bound to the arrays of the latest plan cache lookup and to `instr_list`
+    void executePlan(const PlanCache::Plan &plan, const std::vector<bh_instruction *> &instr_list);
+
 public:
-    EngineCPU(component::ComponentVE &comp, Statistics &stat) : Engine(comp, stat), fusion_config(comp.config, false) {}
+    EngineCPU(component::ComponentVE &comp, Statistics &stat) :
+            Engine(comp, stat),
+            fusion_config(comp.config, false),
+            kernel_concurrency(comp.config.defaultGet<int64_t>("kernel_concurrency", 1)),
+            repeat_in_kernel(comp.config.defaultGet<bool>("repeat_in_kernel", true)),
+            use_plan_cache(comp.config.defaultGet<bool>("plan_cache", true) and strides_as_var and const_as_var),
+            trivial_kernels(comp.config.defaultGet<bool>("trivial_kernels", true)),
+            nontemporal_threshold(comp.config.defaultGet<uint64_t>("nontemporal_threshold", 16777216)),
+            plan_cache(stat) {}
 
     ~EngineCPU() override = default;
 
+    /// A compiled kernel that has its arguments ready
+    struct KernelLaunch {
+        // Executes the kernel using at most `max_threads` threads (zero means no limit)
+        std::function<void(int max_threads)> run;
+        // The source filename of the kernel, which is the key of `Statistics::time_per_kernel`
+        std::string filename;
+    };
+
+    /// The arguments of a kernel launch
+    struct KernelArgs {
+        std::vector<void *> data_list; // The data pointers of the kernel parameters
+        std::vector<uint64_t> offset_strides;
+        std::vector<bh_constant_value> constants;
+    };
+
+protected:
+    // The arguments of the plan kernels (kept between flushes to reuse their memory)
+    KernelArgs _plan_args;
+
+    // Run `launch` using all threads and record its execution time
+    void runLaunch(const KernelLaunch &launch);
+
+public:
+
     virtual void writeKernel(const LoopB &kernel,
                              const SymbolTable &symbols,
                              const std::vector<bh_base *> &kernel_temps,
                              uint64_t codegen_hash,
                              std::stringstream &ss) = 0;
 
+    /** Compile the kernel in `source` (if not already compiled) and prepare the kernel arguments.
+     *  NB: the arrays of `symbols` are allocated, which makes the returned launch ready to run.
+     *
+     * @param symbols       The symbol table of the kernel
+     * @param source        The kernel source code
+     * @param codegen_hash  The hash of the kernel as returned by the codegen cache
+     * @param constants     The constants of the kernel
+     * @return              The launch of the kernel
+     */
+    virtual KernelLaunch prepare(const jitk::SymbolTable &symbols,
+                                 const CodegenCache::Source &source,
+                                 uint64_t codegen_hash,
+                                 const std::vector<const bh_instruction *> &constants) = 0;
+
+    /** Prepare a shape-generic kernel that executes `instr` on its own, which saves the codegen and compilation
+     *  of a kernel specialized to the shapes of `instr`.
+     *  NB: when a launch is returned, the arrays of `instr` are allocated, which makes the launch ready to run.
+     *  The default implementation has no shape-generic kernels.
+     *
+     * @param instr  The instruction
+     * @return       The launch of the kernel or an empty launch (no `run`) when no shape-generic kernel applies
+     */
+    virtual KernelLaunch prepareGeneric(const bh_instruction &instr) {
+        return KernelLaunch();
+    }
+
+    /** Compile and execute the kernel in `source`.
+     *  The default implementation runs the launch returned by `prepare()`, engines can implement a faster path.
+     */
     virtual void execute(const jitk::SymbolTable &symbols,
-                         const std::string &source,
+                         const CodegenCache::Source &source,
                          uint64_t codegen_hash,
-                         const std::vector<const bh_instruction *> &constants) = 0;
+                         const std::vector<const bh_instruction *> &constants);
+
+    /** Compile (if not already compiled) and execute the kernel in `source` using the arguments in `args`
+     *  NB: the arrays of the kernel parameters must be allocated.
+     *
+     * @param source        The kernel source code
+     * @param codegen_hash  The hash of the kernel as returned by the codegen cache
+     * @param args          The kernel arguments
+     */
+    virtual void execute(const CodegenCache::Source &source, uint64_t codegen_hash, KernelArgs &args) = 0;
+
+    /** Compile the kernel in `source` and execute it `nrepeats` times, or until `condition` is false, within one
+     *  kernel launch. Between the iterations, the kernel slides the views of `symbols` as specified by their slides.
+     *
+     * @param symbols       The symbol table of the kernel
+     * @param source        The kernel source code
+     * @param codegen_hash  The hash of the kernel as returned by the codegen cache
+     * @param constants     The constants of the kernel
+     * @param nrepeats      The maximum number of iterations
+     * @param condition     Repeat while the first element of `condition` is true (or if it is null)
+     * @return              The number of executed iterations
+     */
+    virtual uint64_t executeRepeat(const jitk::SymbolTable &symbols,
+                                   const CodegenCache::Source &source,
+                                   uint64_t codegen_hash,
+                                   const std::vector<const bh_instruction *> &constants,
+                                   uint64_t nrepeats,
+                                   bh_base *condition) = 0;
+
+    /** Execute all iterations of the repeat `bhir` within one kernel launch.
+     *  Returns false if the repeat doesn't fit in a single kernel, in which case nothing is executed. If the repeat
+     *  was rejected after fusion, `kernel_list` is set to the fused kernels of the first iteration, which the caller
+     *  should pass on to `handleExecution()` rather than fusing again.
+     */
+    bool handleRepeat(BhIR *bhir, std::vector<LoopB> &kernel_list);
 
     void handleExecution(BhIR *bhir) override;
 
+    /** Execute `bhir` like `handleExecution(bhir)` but using `kernel_list`, the kernels of `bhir` as fused by
+     *  `handleRepeat()` (the fusion is done when `kernel_list` is empty). The plan of a pre-fused execution isn't
+     *  recorded in the plan cache.
+     */
+    void handleExecution(BhIR *bhir, std::vector<LoopB> kernel_list);
+
     void handleExtmethod(BhIR *bhir) override;
 };
 
@@ -167,10 +167,12 @@ public:
             auto childext = comp.child_extmethods.find(instr.opcode);
 
             if (ext != comp.extmethods.end() or childext != comp.child_extmethods.end()) {
-                // Execute the instructions up until now
-                BhIR b(std::move(instr_list), bhir->getSyncs());
-                comp.execute(&b);
-                instr_list.clear(); // Notice, it is legal to clear a moved vector.
+                // Execute the instructions up until now that the extension method depends on. The rest of the
+                // instructions stays in `instr_list`, which makes them fusible with the instructions that follows.
+                BhIR b(extract_extmethod_dependencies(instr_list, instr), bhir->getSyncs());
+                if (not b.instr_list.empty()) {
+                    comp.execute(&b);
+                }
 
                 if (ext != comp.extmethods.end()) {
                     const auto texecution = std::chrono::steady_clock::now();
@@ -247,27 +249,27 @@ private:
             constants.push_back(&(*instr));
         }
 
-        const auto lookup = codegen_cache.lookup(kernel, symbols);
-        if (not lookup.first.empty()) {
+        auto lookup = codegen_cache.lookup(kernel, symbols);
+        const uint64_t codegen_hash = lookup.second.hash.lo;
+        if (lookup.first != nullptr) {
             // In debug mode, we check that the cached source code is correct
             #ifndef NDEBUG
                 stringstream ss;
-                writeKernel(kernel, symbols, thread_stack, lookup.second, ss);
-                if (ss.str().compare(lookup.first) != 0) {
-                    cout << "\nCached source code: \n" << lookup.first;
+                writeKernel(kernel, symbols, thread_stack, codegen_hash, ss);
+                if (ss.str().compare(lookup.first->code) != 0) {
+                    cout << "\nCached source code: \n" << lookup.first->code;
                     cout << "\nReal source code: \n" << ss.str();
                     assert(1 == 2);
                 }
             #endif
-            execute(symbols, lookup.first, lookup.second, thread_stack, constants);
+            execute(symbols, lookup.first->code, codegen_hash, thread_stack, constants);
         } else {
             const auto tcodegen = chrono::steady_clock::now();
             stringstream ss;
-            writeKernel(kernel, symbols, thread_stack, lookup.second, ss);
-            string source = ss.str();
+            writeKernel(kernel, symbols, thread_stack, codegen_hash, ss);
             stat.time_codegen += chrono::steady_clock::now() - tcodegen;
-            execute(symbols, source, lookup.second, thread_stack, constants);
-            codegen_cache.insert(std::move(source), kernel, symbols);
+            const CodegenCache::Source &source = codegen_cache.insert(ss.str(), std::move(lookup.second));
+            execute(symbols, source.code, codegen_hash, thread_stack, constants);
         }
     }
 };
@@ -0,0 +1,216 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+
+namespace bohrium {
+namespace jitk {
+
+/** A bump allocator of the per-kernel metadata.
+ * The memory is handed out from a few large chunks and is released all at once when the arena is destroyed,
+ * thus building the symbol table and the scopes of a kernel does not allocate per entry.
+ */
+class Arena {
+private:
+    std::vector<std::unique_ptr<char[]> > _chunks;
+    char *_cur = nullptr;
+    size_t _left = 0;
+    size_t _chunk_size;
+public:
+    explicit Arena(size_t chunk_size = 4096) : _chunk_size(chunk_size) {}
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Allocate `nbytes` aligned to `alignment`, which must be a power of two
+    void *allocate(size_t nbytes, size_t alignment) {
+        size_t pad = (alignment - reinterpret_cast<uintptr_t>(_cur) % alignment) % alignment;
+        if (_cur == nullptr or pad + nbytes > _left) {
+            const size_t size = std::max(_chunk_size, nbytes + alignment);
+            _chunks.emplace_back(new char[size]);
+            _cur = _chunks.back().get();
+            _left = size;
+            pad = (alignment - reinterpret_cast<uintptr_t>(_cur) % alignment) % alignment;
+            _chunk_size *= 2;
+        }
+        void *ret = _cur + pad;
+        _cur += pad + nbytes;
+        _left -= pad + nbytes;
+        return ret;
+    }
+
+    // Allocate an array of `n` elements of type `T`
+    template<typename T>
+    T *allocate(size_t n) {
+        return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+    }
+};
+
+// Returns the mix of the fingerprint `h` and the value `v`
+inline uint64_t fingerprint_mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+// Hash of pointers (the default hash of the flat maps)
+template<typename T>
+struct Pointer_hash {
+    uint64_t operator()(const T *p) const {
+        return fingerprint_mix(0, reinterpret_cast<uintptr_t>(p));
+    }
+};
+
+/** An open-addressing hash map (linear probing) that lives in an `Arena`.
+ * The slots store the fingerprint (the hash) of their key, which is compared before the potentially expensive
+ * `Equal`. Keys and values must be trivially copyable, e.g. pointers to views and IDs; the pointed-to objects
+ * must outlive the map.
+ */
+template<typename Key, typename Value, typename Hash = Pointer_hash<typename std::remove_pointer<Key>::type>,
+        typename Equal = std::equal_to<Key> >
+class FlatMap {
+private:
+    static_assert(std::is_trivially_copyable<Key>::value and std::is_trivially_copyable<Value>::value,
+                  "FlatMap keys and values must be trivially copyable");
+
+    struct Slot {
+        uint64_t fingerprint; // Zero marks an empty slot
+        Key key;
+        Value value;
+    };
+    Arena *_arena;
+    Slot *_slots = nullptr;
+    size_t _mask = 0;
+    size_t _size = 0;
+
+    static uint64_t fingerprint(const Key &key) {
+        const uint64_t h = Hash()(key);
+        return h == 0 ? 1 : h;
+    }
+
+    // Returns the slot of `key` or the empty slot where it should be inserted
+    Slot *probe(const Key &key, uint64_t fp) const {
+        for (size_t i = fp & _mask;; i = (i + 1) & _mask) {
+            Slot &s = _slots[i];
+            if (s.fingerprint == 0 or (s.fingerprint == fp and Equal()(s.key, key))) {
+                return &s;
+            }
+        }
+    }
+
+    void rehash(size_t capacity) {
+        Slot *old = _slots;
+        const size_t old_capacity = _slots == nullptr ? 0 : _mask + 1;
+        _slots = _arena->allocate<Slot>(capacity);
+        _mask = capacity - 1;
+        for (size_t i = 0; i < capacity; ++i) {
+            _slots[i].fingerprint = 0;
+        }
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old[i].fingerprint != 0) {
+                *probe(old[i].key, old[i].fingerprint) = old[i];
+            }
+        }
+    }
+
+public:
+    // Create a map in `arena` with room for `expected` entries before growing
+    explicit FlatMap(Arena &arena, size_t expected = 8) : _arena(&arena) {
+        size_t capacity = 16;
+        while (capacity * 3 < expected * 4) {
+            capacity *= 2;
+        }
+        rehash(capacity);
+    }
+
+    // Number of entries
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    // Insert `key` with `value` unless `key` exists. Returns the value of `key` and whether it was inserted.
+    std::pair<Value *, bool> insert(const Key &key, const Value &value = Value()) {
+        if ((_size + 1) * 4 > (_mask + 1) * 3) {
+            rehash((_mask + 1) * 2);
+        }
+        const uint64_t fp = fingerprint(key);
+        Slot *s = probe(key, fp);
+        if (s->fingerprint != 0) {
+            return std::make_pair(&s->value, false);
+        }
+        s->fingerprint = fp;
+        s->key = key;
+        s->value = value;
+        ++_size;
+        return std::make_pair(&s->value, true);
+    }
+
+    // Returns the value of `key` or nullptr when `key` doesn't exist
+    const Value *find(const Key &key) const {
+        const Slot *s = probe(key, fingerprint(key));
+        return s->fingerprint == 0 ? nullptr : &s->value;
+    }
+
+    // Returns the value of `key`, throws exception if `key` doesn't exist
+    const Value &at(const Key &key) const {
+        const Value *ret = find(key);
+        if (ret == nullptr) {
+            throw std::out_of_range("FlatMap::at()");
+        }
+        return *ret;
+    }
+
+    bool exist(const Key &key) const {
+        return find(key) != nullptr;
+    }
+
+    // Erase `key` if it exists. NB: uses backward shift deletion thus no tombstones are left behind
+    void erase(const Key &key) {
+        Slot *s = probe(key, fingerprint(key));
+        if (s->fingerprint == 0) {
+            return;
+        }
+        size_t i = static_cast<size_t>(s - _slots);
+        for (size_t j = (i + 1) & _mask; _slots[j].fingerprint != 0; j = (j + 1) & _mask) {
+            // Move the entry at `j` into the hole at `i` unless its home slot is cyclically in (i, j]
+            const size_t home = _slots[j].fingerprint & _mask;
+            if (((j - home) & _mask) >= ((j - i) & _mask)) {
+                _slots[i] = _slots[j];
+                i = j;
+            }
+        }
+        _slots[i].fingerprint = 0;
+        --_size;
+    }
+};
+
+} // jitk
+} // bohrium
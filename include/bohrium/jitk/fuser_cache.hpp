@@ -25,6 +25,7 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <bohrium/bh_instruction.hpp>
 #include <bohrium/jitk/block.hpp>
 #include <bohrium/jitk/statistics.hpp>
+#include <bohrium/jitk/structural_hash.hpp>
 
 
 namespace bohrium {
@@ -34,11 +35,14 @@ class FuseCache {
 private:
     // Help struct to contain the payload of the FuseCache
     struct CachePayload {
+        std::vector<uint64_t> fields; // The hashed fields of the instruction list, which verifies cache hits
         std::vector<Block> block_list;
         std::vector<bh_base*> base_ids; // The base IDs corresponds to their position in `base_ids`
     };
     // The hash to payload map
-    std::map<size_t, CachePayload> _cache;
+    std::map<Hash128, CachePayload> _cache;
+    // The hasher of the instruction lists (kept between lookups to reuse its memory)
+    StructuralHasher _hasher;
 public:
     // Some statistics
     jitk::Statistics &stat;
@@ -35,13 +35,28 @@ bh_constant sweep_identity(bh_opcode opcode, bh_type dtype);
 std::vector<bh_instruction *> remove_non_computed_system_instr(std::vector<bh_instruction> &instr_list,
                                                                std::set<bh_base *> &frees);
 
+/// Moves the instructions in 'instr_list' that the extension method 'ext_instr' depends on (directly or through
+/// other instructions) into the returned list. The instructions left in 'instr_list' are independent of 'ext_instr'
+/// thus they can be executed after 'ext_instr' and fused with later instructions.
+/// NB: the relative order of the instructions is preserved in both lists and, since extension methods might
+///     work in-place, all operands of 'ext_instr' are considered written.
+std::vector<bh_instruction> extract_extmethod_dependencies(std::vector<bh_instruction> &instr_list,
+                                                           const bh_instruction &ext_instr);
+
 /// Reshape 'instr' to match 'size_of_rank_dim' at the 'rank' dimension.
 /// The dimensions from zero to 'rank-1' are untouched.
 InstrPtr reshape_rank(const InstrPtr &instr, int rank, int64_t size_of_rank_dim);
 
-/// Write the `instr` operation given the operands in `ops` as strings
+/// Write the `instr` operation given the operands in `ops` as strings.
+/// When `fast_math` is true, the transcendental functions of real floating-point types are written as calls
+/// to the vector math library in `kernel_dependencies/vmath.h` (C99 kernels only).
 void write_operation(const bh_instruction &instr, const std::vector<std::string> &ops, std::stringstream &out,
-                     bool opencl);
+                     bool opencl, bool fast_math = false);
+
+/// Returns true when the C99 code of the `instr` operation needs the math or complex library, i.e. when it calls
+/// a function such as `sqrt()` or `llabs()`, writes a NAN or INFINITY constant, or works on complex numbers.
+/// Operations that `write_operation()` writes as plain C operators return false.
+bool uses_c99_math(const bh_instruction &instr);
 
 } // jitk
 } // bohrium
@@ -0,0 +1,70 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+/* Non-temporal (streaming) stores of the OpenMP kernels.
+ * The kernels compute a tile of a write-only output into a local buffer and stream the tile to the output,
+ * which writes the cache lines of the output without reading them first.
+ * NB: streaming stores are weakly ordered thus a thread must call `bh_stream_fence()` before another thread
+ *     reads the output. The barriers at the end of OpenMP loops and thread pool chunks use locked instructions,
+ *     which also drain the streaming stores. */
+
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Copy `nbytes` from `src` to `dst` using streaming stores for the 64-byte aligned part of `dst`
+static inline void bh_stream(void *dst, const void *src, uint64_t nbytes) {
+    char *d = (char *) dst;
+    const char *s = (const char *) src;
+#if defined(__SSE2__)
+    uint64_t head = (64 - ((uintptr_t) d & 63)) & 63;
+    if (head > nbytes) {
+        head = nbytes;
+    }
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    nbytes -= head;
+    for (; nbytes >= 64; nbytes -= 64, d += 64, s += 64) {
+#if defined(__AVX512F__)
+        _mm512_stream_si512((__m512i *) d, _mm512_loadu_si512((const void *) s));
+#elif defined(__AVX__)
+        _mm256_stream_si256((__m256i *) d, _mm256_loadu_si256((const __m256i *) s));
+        _mm256_stream_si256((__m256i *) (d + 32), _mm256_loadu_si256((const __m256i *) (s + 32)));
+#else
+        _mm_stream_si128((__m128i *) d, _mm_loadu_si128((const __m128i *) s));
+        _mm_stream_si128((__m128i *) (d + 16), _mm_loadu_si128((const __m128i *) (s + 16)));
+        _mm_stream_si128((__m128i *) (d + 32), _mm_loadu_si128((const __m128i *) (s + 32)));
+        _mm_stream_si128((__m128i *) (d + 48), _mm_loadu_si128((const __m128i *) (s + 48)));
+#endif
+    }
+#endif
+    memcpy(d, s, nbytes);
+}
+
+// Order the streaming stores of the calling thread before its following stores
+static inline void bh_stream_fence(void) {
+#if defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
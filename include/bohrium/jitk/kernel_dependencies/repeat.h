@@ -0,0 +1,68 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+/* The in-kernel sliding of views between the iterations of a repeat (see `bh_view::slide()`).
+ * NB: this file is included by both the C99 kernels and the C++ engine. */
+
+#include <stdint.h>
+#include <stddef.h> // NULL
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The slide of one dimension of a view, which corresponds to a `bh_slide_dim` without shape changes and resets
+typedef struct {
+    // The index of the start of the view in the `offset_strides` argument of the kernel
+    uint64_t offset;
+    // The `offset_change`, `stride`, `shape`, and `step_delay` of the `bh_slide_dim`
+    int64_t offset_change;
+    int64_t stride;
+    int64_t shape;
+    int64_t step_delay;
+    // The iteration counter of the view before the first iteration
+    int64_t iteration_counter;
+} bh_slide_t;
+
+// Slide the view starts in `offset_strides` after the iteration `iteration` (counting from zero)
+static inline void bh_slide(uint64_t offset_strides[], const bh_slide_t slides[], uint64_t nslides,
+                            uint64_t iteration) {
+    for (uint64_t i = 0; i < nslides; ++i) {
+        const bh_slide_t *s = &slides[i];
+        const int64_t counter = s->iteration_counter + (int64_t) iteration;
+        if (s->stride != 0 && (s->step_delay == 1 || counter % s->step_delay == s->step_delay - 1)) {
+            const int64_t start = (int64_t) offset_strides[s->offset];
+            const int64_t max_rel_idx = s->stride * s->shape;
+            int64_t change = s->offset_change * s->stride;
+            const int64_t rel_idx = start % max_rel_idx + change;
+            if (rel_idx < 0) {
+                change += max_rel_idx;
+            } else if (rel_idx >= max_rel_idx) {
+                change -= max_rel_idx;
+            }
+            offset_strides[s->offset] = (uint64_t) (start + change);
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,53 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+/* The interface between the OpenMP kernels and the thread pool of the `pool` parallel runtime.
+ * NB: this file is included by both the C99 kernels and the C++ engine. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The function that executes the iterations [begin, end) of the outermost loop of a kernel
+typedef void (*bh_pool_body_t)(void *args, uint64_t begin, uint64_t end);
+
+// The handle of the thread pool given to the kernel launchers
+typedef struct bh_pool {
+    // Executes `body` on chunks of the iterations [0, size) where `cost` is the cost of one iteration
+    void (*parallel_for)(const struct bh_pool *pool, uint64_t size, uint64_t cost, bh_pool_body_t body, void *args);
+    // The thread pool implementation, which is opaque to the kernels
+    void *impl;
+    // Maximum number of threads to use (zero means no limit)
+    uint64_t max_threads;
+} bh_pool_t;
+
+// The launcher arguments that the launcher passes on to the `body` of `parallel_for()`
+typedef struct {
+    void **data_list;
+    uint64_t *offset_strides;
+    void *constants;
+} bh_pool_args_t;
+
+#ifdef __cplusplus
+}
+#endif
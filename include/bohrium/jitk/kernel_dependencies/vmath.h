@@ -0,0 +1,330 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+/* Vector math library of the OpenMP kernels, which is used when `math_precision = fast`.
+ * The functions are branch-free polynomial approximations (in the style of SLEEF) that the compiler inlines
+ * and vectorizes in SIMD loops, where the libm functions are scalar calls.
+ * The double precision functions are within 4 ulp of the correctly rounded result. The reduction of the
+ * trigonometric functions is exact for |x| < 2^20 * pi/2, thus the 4 ulp only applies to sin, cos, and tan within
+ * that range. Beyond it, the absolute error grows with |x| (about 2^-29 at 2^24 and 2^-3 at 2^50) and the results
+ * are meaningless from |x| = 2^51. Non-finite arguments give NaN like libm.
+ * The single precision functions evaluate the double precision functions, which makes them within 1 ulp. */
+
+#include <stdint.h>
+#include <math.h>
+
+// The functions select between special results, which the compiler turns into branches. A branch that contains
+// a floating-point operation prevents vectorization unless the compiler may assume that the operation doesn't trap.
+// NB: this also applies to the kernel that includes this header, which doesn't read the floating-point exceptions.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("no-trapping-math")
+#endif
+
+#define BH_VM_LN2_HI 6.93147180369123816490e-01 // The upper 32 bits of ln(2), which makes `k * BH_VM_LN2_HI` exact
+#define BH_VM_LN2_LO 1.90821492927058770002e-10
+#define BH_VM_INV_LN2 1.4426950408889634
+#define BH_VM_INV_LN2_LO 2.0355273740931033e-17
+#define BH_VM_INV_LN10 0.4342944819032518
+#define BH_VM_INV_LN10_LO 1.098319650216765e-17
+#define BH_VM_LOG10_2 0.3010299956639812
+#define BH_VM_LOG10_2_LO -2.8037281277851704e-18
+#define BH_VM_PIO2_1 1.57079632673412561417e+00 // The upper 33 bits of pi/2
+#define BH_VM_PIO2_2 6.07710050630396597660e-11 // The next 33 bits of pi/2
+#define BH_VM_PIO2_2T 2.02226624879595063154e-21 // pi/2 - (BH_VM_PIO2_1 + BH_VM_PIO2_2)
+
+static inline int64_t bh_vm_as_int(double x) {
+    int64_t i;
+    __builtin_memcpy(&i, &x, sizeof(i));
+    return i;
+}
+
+static inline double bh_vm_as_double(int64_t i) {
+    double x;
+    __builtin_memcpy(&x, &i, sizeof(x));
+    return x;
+}
+
+// Return `x * 2^k` for |k| <= 2044, which scales in two steps to reach the subnormal range with one rounding.
+// NB: converting a NaN to an integer is undefined, thus we read the integer `k` from the low bits of the mantissa of
+//     `k + 1.5 * 2^52` instead. When `k` is NaN, the masks keep the exponents defined and `x` is NaN anyway.
+static inline double bh_vm_ldexp(double x, double k) {
+    const int64_t ki = bh_vm_as_int(k + 6755399441055744.0) - 0x4338000000000000;
+    const int64_t k1 = ki >> 1;
+    const int64_t k2 = ki - k1;
+    return x * bh_vm_as_double(((k1 + 1023) & 0x7ff) << 52) * bh_vm_as_double(((k2 + 1023) & 0x7ff) << 52);
+}
+
+// Return `exp(s) - 1` for |s| <= ln(2)/2 using the Taylor series to the 13th degree
+static inline double bh_vm_expm1_kernel(double s) {
+    double p = 1.6059043836821613e-10;     // 1/13!
+    p = p * s + 2.08767569878681e-09;      // 1/12!
+    p = p * s + 2.505210838544172e-08;     // 1/11!
+    p = p * s + 2.755731922398589e-07;     // 1/10!
+    p = p * s + 2.7557319223985893e-06;    // 1/9!
+    p = p * s + 2.48015873015873e-05;      // 1/8!
+    p = p * s + 0.0001984126984126984;     // 1/7!
+    p = p * s + 0.001388888888888889;      // 1/6!
+    p = p * s + 0.008333333333333333;      // 1/5!
+    p = p * s + 0.041666666666666664;      // 1/4!
+    p = p * s + 0.16666666666666666;       // 1/3!
+    p = p * s + 0.5;                       // 1/2!
+    return s * s * p + s;
+}
+
+// Return `exp(xh + xl)` where |xl| is much smaller than |xh|
+static inline double bh_vm_exp_dd(double xh, double xl) {
+    const double x = xh > 709.8 ? 709.8 : (xh < -745.2 ? -745.2 : xh);
+    const double k = __builtin_rint(x * BH_VM_INV_LN2);
+    const double s = (x - k * BH_VM_LN2_HI) - k * BH_VM_LN2_LO + xl;
+    const double r = bh_vm_ldexp(bh_vm_expm1_kernel(s) + 1.0, k);
+    return xh > 709.782712893384 ? INFINITY : (xh < -745.1332191019412 ? 0.0 : r);
+}
+
+// Return `log(x) = hi + lo` for a positive and finite `x` as the pair `hi` (returned) and `lo`.
+// `e` is set to the binary exponent of `x` and the pair excludes `e * ln(2)`.
+static inline double bh_vm_log_dd(double x, double *e, double *lo) {
+    // Subnormal numbers are scaled into the normal range by 2^54.
+    // NB: the reduction uses integer operations only. The compiler turns selects between floating-point
+    //     values into branches and a floating-point operation in a branch prevents vectorization (it might trap).
+    const int64_t subnormal = x < 2.2250738585072014e-308;
+    const int64_t bits = bh_vm_as_int(x * bh_vm_as_double(0x3ff0000000000000 + (-subnormal & (54LL << 52))));
+    // The mantissa in [sqrt(2)/2; sqrt(2)[, which is halved when above sqrt(2)
+    const int64_t mbits = (bits & 0x000fffffffffffff) | 0x3ff0000000000000;
+    const int64_t big = mbits > 0x3ff6a09e667f3bcd;
+    const double m = bh_vm_as_double(mbits - (-big & (1LL << 52)));
+    *e = (double) (((bits >> 52) & 0x7ff) - 1023 - (-subnormal & 54) + big);
+
+    // log(m) = 2*atanh(f) = 2*(f + f^3/3 + f^5/5 + ...) where f = (m-1)/(m+1) and |f| < 0.172.
+    // `f = fh + fl` is computed to twice the precision since `m - 1` is exact and `m + 1 = bh + bl`.
+    const double a = m - 1.0;
+    const double bh = m + 1.0;
+    const double bl = m - (bh - 1.0);
+    const double fh = a / bh;
+    const double fl = (__builtin_fma(-fh, bh, a) - fh * bl) / bh;
+    const double f2 = fh * fh;
+    double p = 0.043478260869565216;       // 1/23
+    p = p * f2 + 0.047619047619047616;     // 1/21
+    p = p * f2 + 0.05263157894736842;      // 1/19
+    p = p * f2 + 0.058823529411764705;     // 1/17
+    p = p * f2 + 0.06666666666666667;      // 1/15
+    p = p * f2 + 0.07692307692307693;      // 1/13
+    p = p * f2 + 0.09090909090909091;      // 1/11
+    p = p * f2 + 0.1111111111111111;       // 1/9
+    p = p * f2 + 0.14285714285714285;      // 1/7
+    p = p * f2 + 0.2;                      // 1/5
+    p = p * f2 + 0.3333333333333333;       // 1/3
+    const double t = 2.0 * fl + 2.0 * fh * (f2 * p);
+    const double hi = 2.0 * fh + t;
+    *lo = t - (hi - 2.0 * fh);
+    return hi;
+}
+
+// Return `log(x) = hi + lo` including the exponent of `x`
+static inline double bh_vm_log_full_dd(double x, double *lo) {
+    double e, ml;
+    const double mh = bh_vm_log_dd(x, &e, &ml);
+    const double eh = e * BH_VM_LN2_HI;
+    const double s = eh + mh;
+    const double t = s - eh;
+    const double l = ((eh - (s - t)) + (mh - t)) + ml + e * BH_VM_LN2_LO;
+    const double hi = s + l;
+    *lo = l - (hi - s);
+    return hi;
+}
+
+// Return the logarithm `r` of `x` including the special results of non-positive and non-finite values.
+// NB: `r` is finite for all `x`, which makes it possible to add the special results instead of selecting them.
+//     The compiler moves the computation of a selected value into a branch, which prevents vectorization.
+static inline double bh_vm_log_special(double x, double r) {
+    const double special = x < 0.0 || x != x ? NAN : (x == 0.0 ? -INFINITY : (x == INFINITY ? INFINITY : 0.0));
+    return r + special;
+}
+
+static inline double bh_vexp(double x) {
+    return bh_vm_exp_dd(x, 0.0);
+}
+
+static inline double bh_vexp2(double x) {
+    const double xc = x > 1025.0 ? 1025.0 : (x < -1076.0 ? -1076.0 : x);
+    const double k = __builtin_rint(xc);
+    const double r = bh_vm_ldexp(bh_vm_expm1_kernel((xc - k) * 0.6931471805599453) + 1.0, k);
+    return x > 1024.0 ? INFINITY : (x < -1075.0 ? 0.0 : r);
+}
+
+static inline double bh_vexpm1(double x) {
+    const double xc = x > 709.8 ? 709.8 : (x < -40.0 ? -40.0 : x);
+    const double k = __builtin_rint(xc * BH_VM_INV_LN2);
+    const double s = (xc - k * BH_VM_LN2_HI) - k * BH_VM_LN2_LO;
+    // exp(x) - 1 = 2^k * (exp(s) - 1) + (2^k - 1)
+    const double r = bh_vm_ldexp(bh_vm_expm1_kernel(s), k) + (bh_vm_ldexp(1.0, k) - 1.0);
+    return x > 709.782712893384 ? INFINITY : r;
+}
+
+static inline double bh_vlog(double x) {
+    double lo;
+    const double hi = bh_vm_log_full_dd(x, &lo);
+    return bh_vm_log_special(x, hi + lo);
+}
+
+static inline double bh_vlog2(double x) {
+    double e, lo;
+    const double hi = bh_vm_log_dd(x, &e, &lo);
+    const double r = e + (hi * BH_VM_INV_LN2 + (lo * BH_VM_INV_LN2 + hi * BH_VM_INV_LN2_LO));
+    return bh_vm_log_special(x, r);
+}
+
+static inline double bh_vlog10(double x) {
+    double e, lo;
+    const double hi = bh_vm_log_dd(x, &e, &lo);
+    const double r = e * BH_VM_LOG10_2 + (hi * BH_VM_INV_LN10 + (lo * BH_VM_INV_LN10 + hi * BH_VM_INV_LN10_LO +
+                                                                  e * BH_VM_LOG10_2_LO));
+    return bh_vm_log_special(x, r);
+}
+
+static inline double bh_vlog1p(double x) {
+    // log(1 + x) = log(u) + (x - (u - 1)) / u where `u = 1 + x` is rounded.
+    // NB: the correction is zero when `u` is zero or infinite, which keeps `r` finite.
+    const double u = 1.0 + x;
+    const int64_t finite = u != 0.0 && u != INFINITY;
+    const double uc = finite ? u : 1.0;
+    const double xc = finite ? x : 0.0;
+    double lo;
+    const double hi = bh_vm_log_full_dd(u, &lo);
+    const double r = hi + (lo + (xc - (uc - 1.0)) / uc);
+    return bh_vm_log_special(u, r); // NB: `r` is `x` when `u` is one
+}
+
+static inline double bh_vpow(double x, double y) {
+    const double ax = __builtin_fabs(x);
+    double lo;
+    const double hi = bh_vm_log_full_dd(ax, &lo);
+    // y * log(|x|) to twice the precision
+    const double ph = y * hi;
+    const double pl = __builtin_fma(y, hi, -ph) + y * lo;
+    double r = bh_vm_exp_dd(ph, pl);
+
+    // Negative bases are defined for integer exponents only. NB: |y| >= 2^53 are even integers.
+    const double yh = y * 0.5;
+    const int64_t y_int = __builtin_rint(y) == y;
+    const int64_t y_odd = y_int & (__builtin_rint(yh) != yh);
+    const double neg_r = -r;
+    r = x < 0.0 ? (y_int ? (y_odd ? neg_r : r) : NAN) : r;
+
+    // Zero and infinite bases and exponents
+    const double r_zero = y < 0.0 ? INFINITY : 0.0;
+    r = ax == 0.0 ? r_zero : r;
+    r = ax == INFINITY ? (y < 0.0 ? 0.0 : INFINITY) : r;
+    // Odd exponents keep the sign of zero and infinite bases
+    r = (ax == 0.0 || ax == INFINITY) && y_odd && bh_vm_as_int(x) < 0 ? __builtin_copysign(r, -1.0) : r;
+    r = y == INFINITY ? (ax < 1.0 ? 0.0 : INFINITY) : r;
+    r = y == -INFINITY ? (ax < 1.0 ? INFINITY : 0.0) : r;
+    const double nan = x + y;
+    r = x != x || y != y ? nan : r;
+    return y == 0.0 || x == 1.0 || (ax == 1.0 && (y == INFINITY || y == -INFINITY)) ? 1.0 : r;
+}
+
+static inline double bh_vtanh(double x) {
+    const double ax = __builtin_fabs(x);
+    // tanh(|x|) = (exp(2|x|) - 1) / (exp(2|x|) + 1)
+    const double em1 = bh_vexpm1(2.0 * (ax > 22.0 ? 22.0 : ax));
+    const double r = ax > 22.0 ? 1.0 : em1 / (em1 + 2.0);
+    return x != x ? x : __builtin_copysign(r, x);
+}
+
+// Return `x - k*pi/2` where `k` (returned) is the nearest integer of `x/(pi/2)`
+static inline double bh_vm_trig_reduce(double x, double *r) {
+    const double k = __builtin_rint(x * 0.6366197723675814);
+    *r = ((x - k * BH_VM_PIO2_1) - k * BH_VM_PIO2_2) - k * BH_VM_PIO2_2T;
+    return k;
+}
+
+// Return the quadrant `k mod 4` of a reduction, which is in [0; 3].
+// NB: converting `k` to an integer is undefined when |x| is huge or `x` isn't finite. Instead, we read it from the
+//     mantissa of `k + 1.5 * 2^52` like `bh_vm_ldexp()`, which is exact for |k| < 2^51. Beyond that, the quadrant
+//     is wrong but so is the reduction (see above).
+static inline int64_t bh_vm_quadrant(double k) {
+    return bh_vm_as_int(k + 6755399441055744.0) & 3;
+}
+
+// Return `sin(r)` for |r| <= pi/4 using the Taylor series to the 17th degree
+static inline double bh_vm_sin_kernel(double r) {
+    const double r2 = r * r;
+    double p = 2.8114572543455206e-15;     // 1/17!
+    p = p * r2 - 7.647163731819816e-13;    // -1/15!
+    p = p * r2 + 1.6059043836821613e-10;   // 1/13!
+    p = p * r2 - 2.505210838544172e-08;    // -1/11!
+    p = p * r2 + 2.7557319223985893e-06;   // 1/9!
+    p = p * r2 - 0.0001984126984126984;    // -1/7!
+    p = p * r2 + 0.008333333333333333;     // 1/5!
+    p = p * r2 - 0.16666666666666666;      // -1/3!
+    return r + r * r2 * p;
+}
+
+// Return `cos(r)` for |r| <= pi/4 using the Taylor series to the 18th degree
+static inline double bh_vm_cos_kernel(double r) {
+    const double r2 = r * r;
+    double p = -1.5619206968586225e-16;    // -1/18!
+    p = p * r2 + 4.779477332387385e-14;    // 1/16!
+    p = p * r2 - 1.1470745597729725e-11;   // -1/14!
+    p = p * r2 + 2.08767569878681e-09;     // 1/12!
+    p = p * r2 - 2.755731922398589e-07;    // -1/10!
+    p = p * r2 + 2.48015873015873e-05;     // 1/8!
+    p = p * r2 - 0.001388888888888889;     // -1/6!
+    p = p * r2 + 0.041666666666666664;     // 1/4!
+    p = p * r2 - 0.5;                      // -1/2!
+    return 1.0 + r2 * p;
+}
+
+static inline double bh_vsin(double x) {
+    double r;
+    const int64_t q = bh_vm_quadrant(bh_vm_trig_reduce(x, &r));
+    const double s = q & 1 ? bh_vm_cos_kernel(r) : bh_vm_sin_kernel(r);
+    return q & 2 ? -s : s;
+}
+
+static inline double bh_vcos(double x) {
+    double r;
+    const int64_t q = bh_vm_quadrant(bh_vm_trig_reduce(x, &r));
+    const double c = q & 1 ? bh_vm_sin_kernel(r) : bh_vm_cos_kernel(r);
+    return (q + 1) & 2 ? -c : c;
+}
+
+static inline double bh_vtan(double x) {
+    double r;
+    const int64_t q = bh_vm_quadrant(bh_vm_trig_reduce(x, &r)) & 1;
+    const double s = bh_vm_sin_kernel(r);
+    const double c = bh_vm_cos_kernel(r);
+    return q ? -c / s : s / c;
+}
+
+/* The single precision functions */
+static inline float bh_vexpf(float x) { return (float) bh_vexp(x); }
+static inline float bh_vexp2f(float x) { return (float) bh_vexp2(x); }
+static inline float bh_vexpm1f(float x) { return (float) bh_vexpm1(x); }
+static inline float bh_vlogf(float x) { return (float) bh_vlog(x); }
+static inline float bh_vlog2f(float x) { return (float) bh_vlog2(x); }
+static inline float bh_vlog10f(float x) { return (float) bh_vlog10(x); }
+static inline float bh_vlog1pf(float x) { return (float) bh_vlog1p(x); }
+static inline float bh_vpowf(float x, float y) { return (float) bh_vpow(x, y); }
+static inline float bh_vtanhf(float x) { return (float) bh_vtanh(x); }
+static inline float bh_vsinf(float x) { return (float) bh_vsin(x); }
+static inline float bh_vcosf(float x) { return (float) bh_vcos(x); }
+static inline float bh_vtanf(float x) { return (float) bh_vtan(x); }
@@ -0,0 +1,133 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <map>
+#include <vector>
+#include <unordered_map>
+
+#include <bohrium/bh_instruction.hpp>
+#include <bohrium/jitk/block.hpp>
+#include <bohrium/jitk/statistics.hpp>
+#include <bohrium/jitk/symbol_table.hpp>
+#include <bohrium/jitk/codegen_cache.hpp>
+#include <bohrium/jitk/structural_hash.hpp>
+
+namespace bohrium {
+namespace jitk {
+
+/** Cache of execution plans by the structure of instruction lists.
+ * A plan is the kernels of a flush in execution order together with binding tables that map the arrays, view
+ * starts, and constants of a new instruction list to the kernel arguments. Thus, a repeated flush skips fusion,
+ * symbol tables, and codegen.
+ * NB: the array IDs of a plan are the positions of the arrays in the order they appear in the instruction list.
+ */
+class PlanCache {
+public:
+    // Binds a start in the offset-and-strides of a kernel to the view of an operand in the instruction list
+    struct StartBinding {
+        uint64_t slot;    // The position of the start in the offset-and-strides of the kernel
+        uint64_t instr;   // The position of the instruction in the instruction list
+        uint64_t operand; // The operand index of the view
+    };
+    // Binds a constant of a kernel to the constant of an instruction in the instruction list
+    struct ConstBinding {
+        uint64_t slot;  // The position of the constant in the constants of the kernel
+        uint64_t instr; // The position of the instruction in the instruction list
+    };
+    // A kernel of a plan
+    struct Kernel {
+        // The source of the kernel or nullptr when the kernel does no computation or executes a single instruction
+        const CodegenCache::Source *source = nullptr;
+        // The position in the instruction list of the instruction of a trivial or shape-generic kernel or -1
+        int64_t single_instr = -1;
+        uint64_t codegen_hash = 0;
+        std::vector<uint64_t> params; // The array IDs of the kernel parameters
+        std::vector<uint64_t> frees;  // The array IDs to free after the kernel
+        std::vector<uint64_t> offset_strides; // The offset-and-strides where the bound starts are overwritten
+        std::vector<StartBinding> starts;
+        std::vector<bh_constant_value> constants; // The constants where the bound constants are overwritten
+        std::vector<ConstBinding> const_bindings;
+        // The number of arrays and parameters of the symbol table (for the statistics)
+        uint64_t num_base_arrays = 0;
+        uint64_t num_params = 0;
+    };
+    // An execution plan
+    struct Plan {
+        std::vector<uint64_t> fields; // The hashed fields of the instruction list, which verifies cache hits
+        std::vector<Kernel> kernels;
+    };
+
+private:
+    std::map<Hash128, Plan> _cache;
+    // The hasher, the hash, and the arrays of the latest lookup
+    StructuralHasher _hasher;
+    Hash128 _lookup_hash = {0, 0};
+    uint64_t _lookup_size = 0;
+    bool _lookup_has_slides = false;
+    std::vector<bh_base *> _bases;
+    std::unordered_map<const bh_base *, uint64_t> _base_ids;
+    std::unordered_map<int64_t, uint64_t> _start_ids;
+    // The kernels of the plan under construction and whether the plan can still be inserted
+    std::vector<Kernel> _pending;
+    bool _plannable = false;
+    // Some statistics
+    Statistics &stat;
+
+public:
+    // The constructor takes the statistic object
+    explicit PlanCache(Statistics &stat) : stat(stat) {}
+
+    /** Check the cache for a plan that matches `instr_list`
+     *
+     * @param instr_list The instruction list, which must have its constructor flags set
+     * @param key        Is set to the key of the instruction list, which fields are only set on cache misses
+     * @return The cached plan or nullptr on cache misses
+     */
+    const Plan *lookup(const std::vector<bh_instruction *> &instr_list, StructuralKey &key);
+
+    // Return the arrays of the latest lookup in the order of their IDs
+    const std::vector<bh_base *> &bases() const {
+        return _bases;
+    }
+
+    /** Add `kernel` to the plan of the latest lookup, which was a cache miss
+     *
+     * @param kernel       The kernel, which instructions have their `origin_id` set to their list position
+     * @param symbols      The symbol table of the kernel
+     * @param source       The source of the kernel or nullptr when the kernel does no computation or executes
+     *                     a single instruction
+     * @param codegen_hash The hash of the kernel as returned by the codegen cache
+     * @param single       The instruction of the instruction list that a trivial or shape-generic kernel executes
+     *                     or nullptr
+     * @return False when the kernel cannot be bound to the instruction list, in which case no plan is inserted
+     */
+    bool addKernel(const LoopB &kernel, const SymbolTable &symbols, const CodegenCache::Source *source,
+                   uint64_t codegen_hash, const bh_instruction *single = nullptr);
+
+    /** Insert the kernels added since the latest lookup as the plan of the instruction list of the lookup
+     *
+     * @param key The key as returned by the latest `lookup()`, which was a cache miss
+     */
+    void insert(StructuralKey key);
+};
+
+} // jitk
+} // bohrium
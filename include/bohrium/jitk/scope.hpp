@@ -36,13 +36,28 @@ public:
     const SymbolTable &symbols;
     const Scope *const parent;
 private:
-    std::set<const bh_base *> _tmps; // Set of temporary arrays
-    std::set<bh_view, IgnoreOneDim_less> _scalar_replacements; // Set of scalar replaced arrays
-    std::set<InstrPtr> _omp_atomic; // Set of instructions that should be guarded by OpenMP atomic
-    std::set<InstrPtr> _omp_critical; // Set of instructions that should be guarded by OpenMP critical
-    std::set<bh_view, OffsetAndStrides_less> _declared_idx; // Set of indexes that have been locally declared
+    // NB: the sets live in the arena of `symbols` and refer to the views and instructions of the kernel
+    FlatMap<const bh_base *, char> _tmps; // Set of temporary arrays
+    IgnoreOneDimMap _scalar_replacements; // Set of scalar replaced arrays
+    FlatMap<const bh_instruction *, char> _omp_atomic; // Set of instructions that should be guarded by OpenMP atomic
+    FlatMap<const bh_instruction *, char> _omp_critical; // Set of instructions that should be guarded by OpenMP critical
+    OffsetAndStridesMap _declared_idx; // Set of indexes that have been locally declared
+    OffsetAndStridesMap _declared_idx_bases; // Indexes that have their outer-loop part declared, mapped to the loop rank
+    FlatMap<const bh_base *, size_t> _streamed; // Arrays written through a tile buffer, mapped to the loop rank
+    FlatMap<const LoopB *, const std::vector<const bh_view *> *> _stream_loops; // Loops and their streamed outputs
 public:
-    Scope(const SymbolTable &symbols, const Scope *parent) : symbols(symbols), parent(parent) {}
+    Scope(const SymbolTable &symbols, const Scope *parent) : symbols(symbols),
+                                                             parent(parent),
+                                                             _tmps(symbols.arena()),
+                                                             _scalar_replacements(symbols.arena()),
+                                                             _omp_atomic(symbols.arena()),
+                                                             _omp_critical(symbols.arena()),
+                                                             _declared_idx(symbols.arena()),
+                                                             _declared_idx_bases(symbols.arena()),
+                                                             _streamed(symbols.arena()),
+                                                             _stream_loops(symbols.arena()) {}
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
 
     /// Insert `base` as a temporary array
     void insertTmp(const bh_base *base) {
@@ -51,7 +66,7 @@ public:
 
     /// Check if 'base' is temporary
     bool isTmp(const bh_base *base) const {
-        if (util::exist(_tmps, base)) {
+        if (_tmps.exist(base)) {
             return true;
         } else if (parent != nullptr) {
             return parent->isTmp(base);
@@ -62,17 +77,17 @@ public:
 
     /// Insert `view` as a scalar-replaced array
     void insertScalarReplaced(const bh_view &view) {
-        _scalar_replacements.insert(view);
+        _scalar_replacements.insert(&view);
     }
 
     /// Remove `view` from the set of scalar-replaced array
     void eraseScalarReplaced(const bh_view &view) {
-        _scalar_replacements.erase(view);
+        _scalar_replacements.erase(&view);
     }
 
     /// Check if 'view' has been scalar-replaced
     bool isScalarReplaced(const bh_view &view) const {
-        if (util::exist(_scalar_replacements, view)) {
+        if (_scalar_replacements.exist(&view)) {
             return true;
         } else if (parent != nullptr) {
             return parent->isScalarReplaced(view);
@@ -83,17 +98,56 @@ public:
 
     /// Check if 'view' is a regular array (not temporary, scalar-replaced etc.)
     bool isArray(const bh_view &view) const {
-        return not(isTmp(view.base) or isScalarReplaced(view));
+        return not(isTmp(view.base) or isScalarReplaced(view) or isStreamed(view.base));
+    }
+
+    /// Insert `base` as an array that the loop at `rank` writes through a tile buffer, which is streamed to `base`
+    void insertStreamed(const bh_base *base, int rank) {
+        _streamed.insert(base, static_cast<size_t>(rank));
+    }
+
+    /// Returns the rank of the loop that writes 'base' through a tile buffer or -1
+    int streamedRank(const bh_base *base) const {
+        const size_t *rank = _streamed.find(base);
+        if (rank != nullptr) {
+            return static_cast<int>(*rank);
+        } else if (parent != nullptr) {
+            return parent->streamedRank(base);
+        } else {
+            return -1;
+        }
+    }
+
+    /// Check if 'base' is written through a tile buffer
+    bool isStreamed(const bh_base *base) const {
+        return streamedRank(base) >= 0;
+    }
+
+    /// Insert that `loop` writes `outputs` through tile buffers. NB: `outputs` must outlive the scope
+    void insertStreamLoop(const LoopB *loop, const std::vector<const bh_view *> &outputs) {
+        _stream_loops.insert(loop, &outputs);
+    }
+
+    /// Returns the outputs that `loop` writes through tile buffers or nullptr
+    const std::vector<const bh_view *> *streamOutputs(const LoopB *loop) const {
+        const std::vector<const bh_view *> *const *outputs = _stream_loops.find(loop);
+        if (outputs != nullptr) {
+            return *outputs;
+        } else if (parent != nullptr) {
+            return parent->streamOutputs(loop);
+        } else {
+            return nullptr;
+        }
     }
 
     /// Insert that 'instr' should be guarded by OpenMP atomic
     void insertOpenmpAtomic(const InstrPtr &instr) {
-        _omp_atomic.insert(instr);
+        _omp_atomic.insert(instr.get());
     }
 
     /// Check if 'instr' should be guarded by OpenMP atomic
     bool isOpenmpAtomic(const InstrPtr &instr) const {
-        if (_omp_atomic.find(instr) != _omp_atomic.end()) {
+        if (_omp_atomic.exist(instr.get())) {
             return true;
         } else if (parent != nullptr) {
             return parent->isOpenmpAtomic(instr);
@@ -104,12 +158,12 @@ public:
 
     /// Insert that 'instr' should be guarded by OpenMP critical
     void insertOpenmpCritical(const InstrPtr &instr) {
-        _omp_critical.insert(instr);
+        _omp_critical.insert(instr.get());
     }
 
     /// Check if 'base' should be guarded by OpenMP critical
     bool isOpenmpCritical(const InstrPtr &instr) const {
-        if (_omp_critical.find(instr) != _omp_critical.end()) {
+        if (_omp_critical.exist(instr.get())) {
             return true;
         } else if (parent != nullptr) {
             return parent->isOpenmpCritical(instr);
@@ -120,12 +174,12 @@ public:
 
     /// Check if 'view' has been locally declared (e.g. a temporary or scalar-replaced variable)
     bool isDeclared(const bh_view &view) const {
-        return isTmp(view.base) or isScalarReplaced(view);
+        return isTmp(view.base) or isScalarReplaced(view) or isStreamed(view.base);
     }
 
     /// Check if 'index' has been locally declared
     bool isIdxDeclared(const bh_view &index) const {
-        if (util::exist(_declared_idx, index)) {
+        if (_declared_idx.exist(&index)) {
             return true;
         } else if (parent != nullptr) {
             return parent->isIdxDeclared(index);
@@ -134,6 +188,18 @@ public:
         }
     }
 
+    /// Returns the rank of the innermost loop that has the outer-loop part of 'index' declared or -1
+    int idxBaseRank(const bh_view &index) const {
+        const size_t *rank = _declared_idx_bases.find(&index);
+        if (rank != nullptr) {
+            return static_cast<int>(*rank);
+        } else if (parent != nullptr) {
+            return parent->idxBaseRank(index);
+        } else {
+            return -1;
+        }
+    }
+
     /// Get the name (symbol) of the 'base'
     template<typename T>
     void getName(const bh_view &view, T &out) const {
@@ -142,6 +208,9 @@ public:
         } else if (isScalarReplaced(view)) {
             out << "s" << symbols.baseID(view.base);
             out << "_" << symbols.viewID(view);
+        } else if (isStreamed(view.base)) {
+            const int rank = streamedRank(view.base);
+            out << "st" << symbols.baseID(view.base) << "[i" << rank << "-i" << rank << "_tile]";
         } else {
             out << "a" << symbols.baseID(view.base);
         }
@@ -174,6 +243,16 @@ public:
         return ss.str();
     }
 
+    // Get the name (symbol) of the outer-loop part of the index of 'view' declared for the loop at 'rank'
+    template<typename T>
+    void getIdxBaseName(const bh_view &view, int rank, T &out) const {
+        out << "ib" << symbols.idxID(view) << "_" << rank;
+    }
+
+    // Write the variable declaration of the part of the index of 'view' that only depends on the loops outside
+    // of the loop at 'rank'. NB: the declaration goes before the header of the loop at 'rank'
+    void writeIdxBaseDeclaration(const bh_view &view, const std::string &type_str, int rank, std::stringstream &out);
+
     // Write the variable declaration of the index calculation of 'view' using 'type_str' as the type string
     void writeIdxDeclaration(const bh_view &view, const std::string &type_str, int hidden_axis, std::stringstream &out);
 };
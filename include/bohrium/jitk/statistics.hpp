@@ -84,10 +84,20 @@ class Statistics {
     uint64_t codegen_cache_misses      = 0;
     uint64_t kernel_cache_lookups      = 0;
     uint64_t kernel_cache_misses       = 0;
+    uint64_t plan_cache_lookups        = 0;
+    uint64_t plan_cache_misses         = 0;
     uint64_t num_instrs_into_fuser     = 0;
     uint64_t num_blocks_out_of_fuser   = 0;
     uint64_t malloc_cache_lookups      = 0;
     uint64_t malloc_cache_misses       = 0;
+    uint64_t num_concurrent_flushes    = 0;
+    uint64_t max_kernel_concurrency    = 0;
+    uint64_t num_repeat_kernels        = 0;
+    uint64_t num_repeat_iterations     = 0;
+    uint64_t num_trivial_kernels       = 0;
+    uint64_t num_skipped_zero_fills    = 0;
+    uint64_t num_generic_kernels       = 0;
+    uint64_t num_aot_functions         = 0;
     std::chrono::duration<double> time_total_execution{0};
     std::chrono::duration<double> time_pre_fusion{0};
     std::chrono::duration<double> time_fusion{0};
@@ -98,6 +108,8 @@ class Statistics {
     std::chrono::duration<double> time_copy2dev{0};
     std::chrono::duration<double> time_copy2host{0};
     std::chrono::duration<double> time_ext_method{0};
+    std::chrono::duration<double> time_concurrent_busy{0}; // Sum of the kernel times of concurrent flushes
+    std::chrono::duration<double> time_concurrent_wall{0}; // Wall clock time of concurrent flushes
 
     // key: kernel source filename, value: kernel statistics
     std::map<std::string, KernelStats> time_per_kernel;
@@ -131,6 +143,7 @@ class Statistics {
             out << "Fuse cache hits:                 " << GRN << fuseCacheHits()                     << "\n" << RST;
             out << "Codegen cache hits:              " << GRN << codegenCacheHits()                  << "\n" << RST;
             out << "Compilation cache hits:          " << GRN << kernelCacheHits()                   << "\n" << RST;
+            out << "Plan cache hits:                 " << GRN << planCacheHits()                     << "\n" << RST;
             out << "Array contractions:              " << GRN << arrayContractions()                 << "\n" << RST;
             out << "Outer-fusion ratio:              " << GRN << outerFusionRatio()                  << "\n" << RST;
             out << "Malloc cache hits:               " << GRN << MallocCacheHits()                   << "\n" << RST;
@@ -140,6 +153,10 @@ class Statistics {
             out << "Total Work:                      " << GRN << totalwork << " operations"          << "\n" << RST;
             out << "Throughput:                      " << GRN << throughput() << "ops"               << "\n" << RST;
             out << "Work below par-threshold (1000): " << GRN << workBelowThredshold() << "%"        << "\n" << RST;
+            out << "Kernel concurrency:              " << GRN << kernelConcurrency()                 << "\n" << RST;
+            out << "Repeats within kernels:          " << GRN << repeatsWithinKernels()              << "\n" << RST;
+            out << "Trivial kernels:                 " << GRN << trivialKernels()                    << "\n" << RST;
+            out << "Shape-generic kernels:           " << GRN << genericKernels()                    << "\n" << RST;
             out << "\n";
             out << "Wall clock:                      " << BLU << wallclock.count() << "s"            << "\n" << RST;
             out << "Total Execution:                 " << BLU << time_total_execution.count() << "s" << "\n" << RST;
@@ -221,6 +238,7 @@ class Statistics {
             file << "  fuse_cache_hits: "       << fuseCacheHits()                   << "\n";
             file << "  codegen_cache_hits: "    << codegenCacheHits()                << "\n";
             file << "  kernel_cache_hits: "     << kernelCacheHits()                 << "\n";
+            file << "  plan_cache_hits: "       << planCacheHits()                   << "\n";
             file << "  array_contractions: "    << arrayContractions()               << "\n";
             file << "  outer_fusion_ratio: "    << outerFusionRatio()                << "\n";
             file << "  memory_usage: "          << memoryUsage()                     << "\n"; // mb
@@ -228,6 +246,15 @@ class Statistics {
             file << "  total_work: "            << totalwork                         << "\n"; // ops
             file << "  throughput: "            << throughput()                      << "\n"; // ops
             file << "  work_below_thredshold: " << workBelowThredshold()             << "\n"; // %
+            file << "  concurrent_flushes: "    << num_concurrent_flushes            << "\n";
+            file << "  kernel_concurrency: "    << averageConcurrency()              << "\n";
+            file << "  max_kernel_concurrency: "<< max_kernel_concurrency            << "\n";
+            file << "  repeat_kernels: "        << num_repeat_kernels                << "\n";
+            file << "  repeat_iterations: "     << num_repeat_iterations             << "\n";
+            file << "  trivial_kernels: "       << num_trivial_kernels               << "\n";
+            file << "  skipped_zero_fills: "    << num_skipped_zero_fills            << "\n";
+            file << "  generic_kernels: "       << num_generic_kernels               << "\n";
+            file << "  aot_functions: "         << num_aot_functions                 << "\n";
             file << "  timing:"                                                      << "\n";
             file << "    wall_clock: "          << wallclock.count()                 << "\n"; // s
             file << "    total_execution: "     << time_total_execution.count()      << "\n"; // s
@@ -269,6 +296,29 @@ class Statistics {
         }
     }
 
+    // Record the concurrency of a flush that executed its kernels concurrently, where 'busy' is the sum of the
+    // kernel execution times, 'wall' is the wall clock time of the flush, and 'max_concurrency' is the maximum
+    // number of kernels running at the same time
+    void record_concurrency(std::chrono::duration<double> busy, std::chrono::duration<double> wall,
+                            uint64_t max_concurrency) {
+        ++num_concurrent_flushes;
+        time_concurrent_busy += busy;
+        time_concurrent_wall += wall;
+        max_kernel_concurrency = std::max(max_kernel_concurrency, max_concurrency);
+    }
+
+    // Record a repeat of 'bhir' that executed 'iterations' iterations within one kernel
+    void record_repeat(const BhIR &bhir, uint64_t iterations) {
+        // Every iteration counts as a flush of 'bhir'
+        const uint64_t work_before = totalwork;
+        const uint64_t syncs_before = num_syncs;
+        record(bhir);
+        totalwork += (totalwork - work_before) * (iterations - 1);
+        num_syncs += (num_syncs - syncs_before) * (iterations - 1);
+        ++num_repeat_kernels;
+        num_repeat_iterations += iterations;
+    }
+
     // Record statistics based on the 'symbols'
     void record(const SymbolTable& symbols) {
       num_base_arrays += symbols.getNumBaseArrays();
@@ -288,6 +338,10 @@ class Statistics {
         return pprint_ratio(kernel_cache_lookups - kernel_cache_misses, kernel_cache_lookups);
     }
 
+    std::string planCacheHits() {
+        return pprint_ratio(plan_cache_lookups - plan_cache_misses, plan_cache_lookups);
+    }
+
     std::string arrayContractions() {
         return pprint_ratio(num_temp_arrays, num_base_arrays);
     }
@@ -312,6 +366,35 @@ class Statistics {
         return (double) threading_below_threshold / (double) totalwork * 100.0;
     }
 
+    double averageConcurrency() {
+        return num_concurrent_flushes == 0 ? 1.0 : time_concurrent_busy.count() / time_concurrent_wall.count();
+    }
+
+    std::string kernelConcurrency() {
+        std::stringstream ss;
+        ss << averageConcurrency() << " (max: " << max_kernel_concurrency << ", flushes: "
+           << num_concurrent_flushes << ")";
+        return ss.str();
+    }
+
+    std::string repeatsWithinKernels() {
+        std::stringstream ss;
+        ss << num_repeat_iterations << " iterations (kernels: " << num_repeat_kernels << ")";
+        return ss.str();
+    }
+
+    std::string trivialKernels() {
+        std::stringstream ss;
+        ss << num_trivial_kernels << " (skipped zero-fills: " << num_skipped_zero_fills << ")";
+        return ss.str();
+    }
+
+    std::string genericKernels() {
+        std::stringstream ss;
+        ss << num_generic_kernels << " (functions from the AOT library: " << num_aot_functions << ")";
+        return ss.str();
+    }
+
     double timeOther() {
         return (time_total_execution - time_pre_fusion - time_fusion - time_codegen - time_compile - time_exec
                 - time_copy2dev - time_copy2host - time_offload).count();
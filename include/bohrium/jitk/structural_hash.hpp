@@ -0,0 +1,95 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace bohrium {
+namespace jitk {
+
+// A 128-bit hash value
+struct Hash128 {
+    uint64_t lo;
+    uint64_t hi;
+
+    bool operator==(const Hash128 &other) const {
+        return lo == other.lo and hi == other.hi;
+    }
+    bool operator!=(const Hash128 &other) const {
+        return not (*this == other);
+    }
+    bool operator<(const Hash128 &other) const {
+        return hi < other.hi or (hi == other.hi and lo < other.lo);
+    }
+};
+
+/** The key of a cache lookup, which the caller passes back when inserting on a cache miss.
+ * The fields are only kept on cache misses since they verify the hits of the inserted entry.
+ */
+struct StructuralKey {
+    Hash128 hash = {0, 0};
+    std::vector<uint64_t> fields;
+};
+
+/** Returns the 128-bit hash of the `n` fields in `fields`.
+ * The hash only depends on the values of the fields thus it is persistent between executions.
+ */
+Hash128 hash128(const uint64_t *fields, uint64_t n, uint64_t seed = 0);
+
+/** A hasher of the structure of instruction lists and kernels.
+ * The structure is written as a stream of packed 64-bit fields, which are kept such that a cache hit can be
+ * verified by comparing the fields with the fields of the cached entry.
+ * NB: since the hasher reuses its memory, the caches keep their hasher between lookups.
+ */
+class StructuralHasher {
+private:
+    std::vector<uint64_t> _fields;
+public:
+    // Start a new stream of fields
+    void clear() {
+        _fields.clear();
+    }
+    // Write a field
+    void add(uint64_t field) {
+        _fields.push_back(field);
+    }
+    // Write a signed field
+    void add_signed(int64_t field) {
+        _fields.push_back(static_cast<uint64_t>(field));
+    }
+    // Return the hash of the fields written since the last `clear()`
+    Hash128 digest() const {
+        return hash128(_fields.data(), _fields.size());
+    }
+    // Return the fields written since the last `clear()`
+    const std::vector<uint64_t> &fields() const {
+        return _fields;
+    }
+    // Move the fields out of the hasher, which leaves the hasher cleared
+    std::vector<uint64_t> release() {
+        std::vector<uint64_t> ret = std::move(_fields);
+        _fields.clear();
+        return ret;
+    }
+};
+
+} // jitk
+} // bohrium
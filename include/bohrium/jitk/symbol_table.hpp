@@ -21,6 +21,7 @@ If not, see <http://www.gnu.org/licenses/>.
 
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <sstream>
 
@@ -28,6 +29,7 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <bohrium/bh_util.hpp>
 
 #include <bohrium/jitk/block.hpp>
+#include <bohrium/jitk/flat_map.hpp>
 
 namespace bohrium {
 namespace jitk {
@@ -54,77 +56,73 @@ struct OffsetAndStrides_less {
     }
 };
 
-// Compare class for the constant_map
-struct Constant_less {
-    // This compare the 'origin_id' member of the instructions
-    bool operator() (const InstrPtr &i1, const InstrPtr& i2) const {
-        return i1->origin_id < i2->origin_id;
+// Hash and equality of the offset-and-strides maps, which ignore the bases of the views like `OffsetAndStrides_less`
+struct OffsetAndStrides_hash {
+    uint64_t operator() (const bh_view* v) const {
+        uint64_t h = fingerprint_mix(static_cast<uint64_t>(v->ndim), static_cast<uint64_t>(v->start));
+        for (int64_t i = 0; i < v->ndim; ++i) {
+            h = fingerprint_mix(h, static_cast<uint64_t>(v->shape[i]));
+            h = fingerprint_mix(h, static_cast<uint64_t>(v->stride[i]));
+        }
+        return h;
     }
 };
-
-// Compare class for the viewID sets and maps
-struct IgnoreOneDim_less {
-    BhIntVec get_shape_where_shape_is_greater_than_one(const bh_view &view) const {
-        BhIntVec ret;
-        for (int64_t i = 0; i < view.ndim; ++i) {
-            if (view.shape[i] > 1) {
-                ret.push_back(view.shape[i]);
-            }
+struct OffsetAndStrides_equal {
+    bool operator() (const bh_view* v1, const bh_view* v2) const {
+        if (v1->ndim != v2->ndim or v1->start != v2->start) return false;
+        for (int64_t i = 0; i < v1->ndim; ++i) {
+            if (v1->shape[i] != v2->shape[i] or v1->stride[i] != v2->stride[i]) return false;
         }
-        return ret;
+        return true;
     }
+};
 
-    BhIntVec get_stride_where_shape_is_greater_than_one(const bh_view &view) const {
-        BhIntVec ret;
-        for (int64_t i = 0; i < view.ndim; ++i) {
-            if (view.shape[i] > 1) {
-                ret.push_back(view.stride[i]);
+// Hash and equality of the viewID maps, which ignore zero or one-sized dimensions
+struct IgnoreOneDim_hash {
+    uint64_t operator() (const bh_view* v) const {
+        uint64_t h = fingerprint_mix(reinterpret_cast<uintptr_t>(v->base), static_cast<uint64_t>(v->start));
+        for (int64_t i = 0; i < v->ndim; ++i) {
+            if (v->shape[i] > 1) {
+                h = fingerprint_mix(h, static_cast<uint64_t>(v->shape[i]));
+                h = fingerprint_mix(h, static_cast<uint64_t>(v->stride[i]));
             }
         }
-        return ret;
-    }
-
-    // This compare is the same as view compare ('v1 < v2') but ignoring their bases and zero or one-sized dimensions
-    bool operator() (const bh_view& v1, const bh_view& v2) const {
-        if (v1.base < v2.base) return true;
-        if (v2.base < v1.base) return false;
-        if (v1.start < v2.start) return true;
-        if (v2.start < v1.start) return false;
-
-        auto v1_shape = get_shape_where_shape_is_greater_than_one(v1);
-        auto v2_shape = get_shape_where_shape_is_greater_than_one(v2);
-        if (v1_shape.size() < v2_shape.size()) return true;
-        if (v2_shape.size() < v1_shape.size()) return false;
-
-        auto v1_stride = get_stride_where_shape_is_greater_than_one(v1);
-        auto v2_stride = get_stride_where_shape_is_greater_than_one(v2);
-        assert(v1_shape.size() == v1_stride.size());
-        assert(v2_shape.size() == v2_stride.size());
-
-        for (size_t i=0; i < v1_shape.size(); ++i) {
-            if (v1_stride[i] < v2_stride[i]) return true;
-            if (v2_stride[i] < v1_stride[i]) return false;
-            if (v1_shape[i] < v2_shape[i]) return true;
-            if (v2_shape[i] < v1_shape[i]) return false;
-        }
-        return false;
+        return h;
     }
+};
+struct IgnoreOneDim_equal {
     bool operator() (const bh_view* v1, const bh_view* v2) const {
-        return (*this)(*v1, *v2);
+        if (v1->base != v2->base or v1->start != v2->start) return false;
+        int64_t i = 0, j = 0;
+        while (true) {
+            while (i < v1->ndim and v1->shape[i] <= 1) ++i;
+            while (j < v2->ndim and v2->shape[j] <= 1) ++j;
+            if (i == v1->ndim or j == v2->ndim) {
+                return i == v1->ndim and j == v2->ndim;
+            }
+            if (v1->shape[i] != v2->shape[j] or v1->stride[i] != v2->stride[j]) return false;
+            ++i;
+            ++j;
+        }
     }
 };
 
+typedef FlatMap<const bh_view*, size_t, OffsetAndStrides_hash, OffsetAndStrides_equal> OffsetAndStridesMap;
+typedef FlatMap<const bh_view*, size_t, IgnoreOneDim_hash, IgnoreOneDim_equal> IgnoreOneDimMap;
 
 // The SymbolTable class contains all array meta date needed for a JIT kernel.
+// NB: the tables are flat hash maps in a per-kernel arena, which refer to the views of the instructions
+//     in the kernel thus the kernel must outlive its symbol table.
 class SymbolTable {
 private:
-    std::map<const bh_base*, size_t> _base_map; // Mapping a base to its ID
-    std::map<bh_view, size_t, IgnoreOneDim_less> _view_map; // Mapping a view to its ID
-    std::map<bh_view, size_t, OffsetAndStrides_less> _idx_map; // Mapping a index (of an array) to its ID
-    std::map<bh_view, size_t, OffsetAndStrides_less> _offset_strides_map; // Mapping a offset-and-strides to its ID
+    mutable Arena _arena; // The memory of the tables below and of the scopes of the kernel
+    FlatMap<const bh_base*, size_t> _base_map; // Mapping a base to its ID
+    IgnoreOneDimMap _view_map; // Mapping a view to its ID
+    OffsetAndStridesMap _idx_map; // Mapping a index (of an array) to its ID
+    OffsetAndStridesMap _offset_strides_map; // Mapping a offset-and-strides to its ID
     std::vector<const bh_view*> _offset_stride_views; // Vector of all offset-and-stride views
-    std::set<InstrPtr, Constant_less> _constant_set; // Set of instructions to a constant ID (Order by `origin_id`)
-    std::set<bh_base*> _array_always; // Set of base arrays that should always be arrays
+    std::vector<InstrPtr> _constants; // Instructions with a constant ID (Ordered by `origin_id`)
+    FlatMap<const bh_base*, char> _array_always; // Set of base arrays that should always be arrays
     std::vector<bh_base*> _params; // Vector of non-temporary arrays, which are the in-/out-puts of the JIT kernel
     bool _useRandom; // Flag: is any instructions using random?
 
@@ -139,6 +137,17 @@ public:
     const bool const_as_var;
 
     SymbolTable(const LoopB &kernel, bool use_volatile, bool strides_as_var, bool index_as_var, bool const_as_var);
+private:
+    SymbolTable(const LoopB &kernel, size_t num_views, bool use_volatile, bool strides_as_var, bool index_as_var,
+                bool const_as_var);
+public:
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    // The arena of the kernel, which the scopes allocate from
+    Arena &arena() const {
+        return _arena;
+    }
 
     // Get the ID of 'base', throws exception if 'base' doesn't exist
     size_t baseID(const bh_base *base) const {
@@ -150,46 +159,44 @@ public:
     }
     // Get the ID of 'view', throws exception if 'view' doesn't exist
     size_t viewID(const bh_view &view) const {
-        return _view_map.at(view);
+        return _view_map.at(&view);
     }
     // Get the ID of 'index', throws exception if 'index' doesn't exist
     size_t idxID(const bh_view &index) const {
-        return _idx_map.at(index);
+        return _idx_map.at(&index);
     }
     // Check if 'index' exist
     bool existIdxID(const bh_view &index) const {
-        return util::exist(_idx_map, index);
+        return _idx_map.exist(&index);
     }
     // Get the offset-and-strides ID of 'view', throws exception if 'view' doesn't exist
     size_t offsetStridesID(const bh_view &view) const {
-        return _offset_strides_map.at(view);
+        return _offset_strides_map.at(&view);
     }
     bool existOffsetStridesID(const bh_view &view) const {
-        return util::exist(_offset_strides_map,view);
+        return _offset_strides_map.exist(&view);
     }
     const std::vector<const bh_view*> &offsetStrideViews() const {
         return _offset_stride_views;
     }
-    // Get the set of constants
-    const std::set<InstrPtr, Constant_less> &constIDs() const {
-        return _constant_set;
+    // Get the instructions with a constant ID in the order of their IDs
+    const std::vector<InstrPtr> &constIDs() const {
+        return _constants;
     };
     // Get the ID of the constant within 'instr', which is the number it appear in the set of constants.
     // Or returns -1 when 'instr' has no ID
     int64_t constID(const bh_instruction &instr) const {
         assert(instr.origin_id >= 0);
-        size_t count=0;
-        // Since the size of '_constant_set' is small (way below a 1000), we simply do a linear search
-        for (const InstrPtr &i: _constant_set) {
-            count++;
-            if (i->origin_id == instr.origin_id)
-                return count;
+        const auto it = std::lower_bound(_constants.begin(), _constants.end(), instr.origin_id,
+                                         [](const InstrPtr &i, int64_t id) { return i->origin_id < id; });
+        if (it == _constants.end() or (*it)->origin_id != instr.origin_id) {
+            return -1;
         }
-        return -1;
+        return it - _constants.begin() + 1;
     }
     // Return true when 'base' should always be an array
     bool isAlwaysArray(const bh_base *base) const {
-        return util::exist_nconst(_array_always, base);
+        return _array_always.exist(base);
     }
     // Return non-temporary arrays, which are the in-/out-puts of the JIT kernel, in the order of their IDs
     const std::vector<bh_base*> &getParams() const {
@@ -0,0 +1,102 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+namespace bohrium {
+namespace jitk {
+
+/** A pool of persistent worker threads with a task queue per thread.
+ * A task submitted by a worker goes into its own queue, which it pops in LIFO order.
+ * Idle workers steal tasks in FIFO order from the queues of the other workers.
+ */
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+private:
+    // A task queue that belongs to one worker
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<Queue> > _queues;
+    std::vector<std::thread> _threads;
+
+    // Protects the sleep and wake-up of the workers and of `wait()`
+    std::mutex _mutex;
+    std::condition_variable _cond_work;
+    std::condition_variable _cond_done;
+
+    uint64_t _num_queued = 0; // Number of tasks in the queues (protected by `_mutex`)
+    uint64_t _num_unfinished = 0; // Number of submitted tasks not yet finished (protected by `_mutex`)
+    uint64_t _next_queue = 0; // The queue of the next task submitted by a non-worker thread
+    bool _stop = false;
+
+    // Pop a task from the queue of worker `id` or steal one from the other queues
+    bool _pop(uint64_t id, Task &task);
+
+    // The main loop of worker `id`
+    void _worker(uint64_t id);
+
+public:
+    /** Start a pool of `num_threads` worker threads (at least one) */
+    explicit ThreadPool(uint64_t num_threads);
+
+    /** Stop and join all worker threads. Tasks not yet started are discarded */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /** Returns the number of worker threads */
+    uint64_t size() const {
+        return _threads.size();
+    }
+
+    /** Submit `task` for execution. Tasks may submit new tasks themselves. */
+    void submit(Task task);
+
+    /** Wait until all submitted tasks, including tasks submitted by tasks, have finished */
+    void wait();
+
+    /** Execute `body(begin, end)` on chunks of `grain` iterations that together cover [0, size).
+     *  The calling thread executes chunks as well and returns when all chunks have finished, thus
+     *  it is safe to call from within a task.
+     *
+     * @param size         The number of iterations
+     * @param grain        The number of iterations per chunk
+     * @param max_threads  The maximum number of threads to use including the caller (zero means no limit)
+     * @param body         The function to execute on each chunk
+     */
+    void parallelFor(uint64_t size, uint64_t grain, uint64_t max_threads,
+                     const std::function<void(uint64_t begin, uint64_t end)> &body);
+};
+
+} // jitk
+} // bohrium
@@ -0,0 +1,78 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <bohrium/bh_instruction.hpp>
+#include <bohrium/jitk/block.hpp>
+#include <bohrium/jitk/thread_pool.hpp>
+
+namespace bohrium {
+namespace jitk {
+
+/** A kernel that consists of a single fill, copy, or range, which the engine executes using built-in routines
+ * instead of generating, compiling, and loading a kernel.
+ */
+struct TrivialKernel {
+    enum Kind {
+        NONE,  // Not a trivial kernel
+        FILL,  // BH_IDENTITY of a constant into a contiguous view of the same type
+        COPY,  // BH_IDENTITY between contiguous views of the same type and different bases
+        RANGE  // BH_RANGE into a contiguous view
+    };
+    Kind kind = NONE;
+    const bh_instruction *instr = nullptr; // The instruction of the kernel
+};
+
+/// Returns the only non-system instruction of `kernel` or nullptr when the kernel has none or several, or when it
+/// frees the output of the instruction (which makes the output a temporary array that is never written).
+/// NB: the identity fill that the fusion adds in front of a reduction doesn't count since the reduction
+///     writes every element of its output.
+const bh_instruction *single_instr_of_kernel(const LoopB &kernel);
+
+/// Classify `instr` as a trivial kernel on its own
+TrivialKernel classify_trivial_instr(const bh_instruction &instr);
+
+/// Classify `kernel`, which is trivial when it has exactly one non-system instruction that is trivial
+/// and doesn't free the output of that instruction
+TrivialKernel classify_trivial_kernel(const LoopB &kernel);
+
+/** Allocate the arrays of the trivial kernel `kernel` if not already allocated
+ *
+ * @param kernel  The trivial kernel, which kind must not be NONE
+ * @return        True when the kernel is a zero-fill of a new allocation, which is already zero thus the kernel
+ *                needs no execution
+ */
+bool alloc_trivial_kernel(const TrivialKernel &kernel);
+
+/** Execute the trivial kernel `kernel`, which arrays must be allocated.
+ *  Large kernels are split in one contiguous chunk per thread, which matches the static schedule of the
+ *  generated kernels thus the pages are first touched by the threads that use them later.
+ *
+ * @param kernel                 The trivial kernel, which kind must not be NONE
+ * @param nontemporal_threshold  Outputs of at least this many bytes are written with non-temporal stores
+ *                               (zero disables)
+ * @param pool                   The threads that execute large kernels (the caller participates) or nullptr
+ * @param max_threads            The maximum number of threads to use including the caller (zero means no limit)
+ */
+void run_trivial_kernel(const TrivialKernel &kernel, uint64_t nontemporal_threshold, ThreadPool *pool,
+                        uint64_t max_threads);
+
+} // jitk
+} // bohrium
@@ -34,6 +34,9 @@ void write_array_index(const Scope &scope, const bh_view &view, std::stringstrea
                        bool ignore_declared_indexes = false, int hidden_axis = BH_MAXDIM,
                        const std::pair<int, int> axis_offset = std::make_pair(BH_MAXDIM, 0));
 
+// Write the part of the array index that only depends on the loops outside of the loop at 'rank', e.g. (2+i0*10)
+void write_array_index_base(const Scope &scope, const bh_view &view, int rank, std::stringstream &out);
+
 // Write the array subscription, e.g. A[2+i0*1+i1*10], but ignore the loop-variant of 'hidden_axis' if it isn't 'BH_MAXDIM'
 // Set 'ignore_declared_indexes' to not use indexes variables
 void write_array_subscription(const Scope &scope, const bh_view &view, std::stringstream &out,
@@ -0,0 +1,62 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Helpers of the C++ tests, which exit with a non-zero status on the first failed check
+namespace bhxx_test {
+
+// Fail the test with `msg`
+[[noreturn]] inline void fail(const std::string &msg) {
+    std::cerr << "FAIL: " << msg << std::endl;
+    std::exit(1);
+}
+
+// Check that `cond` is true
+inline void check(bool cond, const std::string &msg) {
+    if (not cond) {
+        fail(msg);
+    }
+}
+
+// Check that `got` equals `expected` element by element (within `tolerance` for floating point values)
+template<typename T>
+void check_equal(const std::string &name, const std::vector<T> &got, const std::vector<T> &expected,
+                 double tolerance = 0) {
+    if (got.size() != expected.size()) {
+        fail(name + ": got " + std::to_string(got.size()) + " elements, expected " +
+             std::to_string(expected.size()));
+    }
+    for (size_t i = 0; i < got.size(); ++i) {
+        const double diff = std::fabs(static_cast<double>(got[i]) - static_cast<double>(expected[i]));
+        if (not (diff <= tolerance)) {
+            std::cerr << "FAIL: " << name << ": element " << i << " is " << got[i] << ", expected "
+                      << expected[i] << std::endl;
+            std::exit(1);
+        }
+    }
+}
+
+} // bhxx_test
@@ -0,0 +1,46 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Updates an array that has data from an earlier flush, reads it, and frees it, all in one flush.
+ * The update must not be taken as the constructor of the array, which would make the array a temporary
+ * and lose the data from the earlier flush. */
+
+#include <bhxx/bhxx.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+int main() {
+    const uint64_t n = 1000;
+    BhArray<double> a({n});
+    identity(a, 5.0);
+    Runtime::instance().flush();
+
+    // The first write to `a` in this flush also reads `a`, which makes the data from the earlier flush matter
+    add(a, a, 1.0);
+    BhArray<double> b({n});
+    multiply(b, a, 2.0);
+    free(a);
+
+    check_equal("update, read, and free in one flush", b.vec(), std::vector<double>(n, 12.0));
+    return 0;
+}
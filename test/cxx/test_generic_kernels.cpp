@@ -0,0 +1,186 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Single-instruction kernels on views of many layouts: contiguous, strided, transposed, broadcast, and offset views
+ * of rank 1 to 3. The OpenMP engine executes such kernels through shape-generic kernels, which take the shapes,
+ * offsets, and strides as arguments and collapse the contiguous dimensions of element-wise views. Thus, one
+ * compiled kernel serves all layouts and every one of them must be addressed correctly. */
+
+#include <algorithm>
+#include <cmath>
+
+#include <bhxx/bhxx.hpp>
+#include <bhxx/array_create.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+namespace {
+// The number of elements of the arrays that the views view
+constexpr uint64_t N = 20000;
+
+struct Layout {
+    std::string name;
+    Shape shape;
+    Stride stride;
+    uint64_t offset;
+};
+
+// Returns the array indices of the elements of `layout` in row-major order
+std::vector<uint64_t> indices(const Layout &layout) {
+    std::vector<uint64_t> ret{layout.offset};
+    for (uint64_t d = 0; d < layout.shape.size(); ++d) {
+        std::vector<uint64_t> next;
+        for (uint64_t idx: ret) {
+            for (uint64_t i = 0; i < layout.shape[d]; ++i) {
+                next.push_back(idx + i * layout.stride[d]);
+            }
+        }
+        ret = std::move(next);
+    }
+    return ret;
+}
+
+// The element-wise expected values of `f` applied to the elements of `layout` of an arange array
+template<typename T, typename F>
+std::vector<T> expected_of(const Layout &layout, F f) {
+    std::vector<T> ret;
+    for (uint64_t idx: indices(layout)) {
+        ret.push_back(static_cast<T>(f(static_cast<double>(idx))));
+    }
+    return ret;
+}
+
+void check_layout(const Layout &layout) {
+    const std::string &name = layout.name;
+    const std::vector<uint64_t> idx = indices(layout);
+    BhArray<double> src = arange<double>(N);
+    BhArray<double> dst = zeros<double>({N});
+    Runtime::instance().flush();
+    BhArray<double> in(src.base(), layout.shape, layout.stride, layout.offset);
+
+    {// An element-wise output with the same layout, where the other elements stay zero
+        BhArray<double> out(dst.base(), layout.shape, layout.stride, layout.offset);
+        multiply(out, in, 2.0);
+        Runtime::instance().flush();
+        std::vector<double> expected(N, 0);
+        for (uint64_t i: idx) {
+            expected[i] = 2.0 * i;
+        }
+        check_equal(name + ": multiply into the layout", dst.vec(), expected);
+    }
+
+    BhArray<double> a(layout.shape);
+    sqrt(a, in);
+    Runtime::instance().flush();
+    check_equal(name + ": sqrt", a.vec(), expected_of<double>(layout, [](double x) { return std::sqrt(x); }));
+
+    BhArray<double> b(layout.shape);
+    subtract(b, 1.0, in);
+    Runtime::instance().flush();
+    check_equal(name + ": subtract from a constant", b.vec(), expected_of<double>(layout, [](double x) {
+        return 1.0 - x;
+    }));
+
+    BhArray<double> c(layout.shape);
+    add(c, in, b);
+    Runtime::instance().flush();
+    check_equal(name + ": add", c.vec(), std::vector<double>(idx.size(), 1.0));
+
+    BhArray<bool> g(layout.shape);
+    greater(g, in, 100.0);
+    Runtime::instance().flush();
+    check_equal(name + ": greater", g.vec(), expected_of<bool>(layout, [](double x) { return x > 100.0; }));
+
+    BhArray<float> h(layout.shape);
+    identity(h, in);
+    Runtime::instance().flush();
+    check_equal(name + ": conversion", h.vec(), expected_of<float>(layout, [](double x) { return x; }));
+
+    // Reductions of every axis
+    for (uint64_t axis = 0; axis < layout.shape.size(); ++axis) {
+        Shape shape;
+        Stride stride;
+        for (uint64_t d = 0; d < layout.shape.size(); ++d) {
+            if (d != axis) {
+                shape.push_back(layout.shape[d]);
+                stride.push_back(layout.stride[d]);
+            }
+        }
+        if (shape.empty()) {
+            shape.push_back(1);
+            stride.push_back(0);
+        }
+        Layout rest{name, shape, stride, layout.offset};
+        std::vector<double> sums, maxima;
+        for (uint64_t first: indices(rest)) {
+            double sum = 0, maximum = -INFINITY;
+            for (uint64_t i = 0; i < layout.shape[axis]; ++i) {
+                const double x = static_cast<double>(first + i * layout.stride[axis]);
+                sum += x;
+                maximum = std::max(maximum, x);
+            }
+            sums.push_back(sum);
+            maxima.push_back(maximum);
+        }
+        BhArray<double> r(shape);
+        add_reduce(r, in, static_cast<int64_t>(axis));
+        Runtime::instance().flush();
+        check_equal(name + ": add_reduce of axis " + std::to_string(axis), r.vec(), sums);
+        BhArray<double> m(shape);
+        maximum_reduce(m, in, static_cast<int64_t>(axis));
+        Runtime::instance().flush();
+        check_equal(name + ": maximum_reduce of axis " + std::to_string(axis), m.vec(), maxima);
+    }
+}
+} // Anonymous namespace
+
+int main() {
+    const std::vector<Layout> layouts{
+            {"one element", {1}, {1}, 0},
+            {"contiguous", {1000}, {1}, 0},
+            {"offset", {999}, {1}, 7},
+            {"strided", {500}, {3}, 2},
+            {"broadcast", {100}, {0}, 5},
+            {"2-D contiguous", {20, 30}, {30, 1}, 0},
+            {"2-D transposed", {30, 20}, {1, 30}, 0},
+            {"2-D every other column", {20, 15}, {30, 2}, 1},
+            {"2-D broadcast rows", {20, 30}, {0, 1}, 3},
+            {"2-D single column", {20, 1}, {30, 1}, 4},
+            {"3-D contiguous", {4, 5, 6}, {30, 6, 1}, 0},
+            {"3-D contiguous rows", {4, 5, 6}, {60, 6, 1}, 10},
+            {"3-D reversed", {4, 5, 6}, {1, 4, 20}, 0},
+    };
+    // New shapes of the same layouts re-use the kernels of the first shapes
+    for (int pass = 0; pass < 2; ++pass) {
+        for (Layout layout: layouts) {
+            if (pass == 1) {
+                layout.name += " (second shape)";
+                for (uint64_t &n: layout.shape) {
+                    n += n > 1 ? 1 : 0;
+                }
+            }
+            check_layout(layout);
+        }
+    }
+    return 0;
+}
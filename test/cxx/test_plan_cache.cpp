@@ -0,0 +1,103 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Flushes that repeat the same structure with new arrays, constants, and starts of single-element sliding views,
+ * which the OpenMP engine executes through the plan cache after the first flush. Every flush must bind its own
+ * arrays, starts, and constants to the cached kernels. */
+
+#include <bhxx/bhxx.hpp>
+#include <bhxx/array_create.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+int main() {
+    const uint64_t n = 16;
+    const uint64_t flushes = 8;
+
+    {// New arrays and constants in every flush: t = a * c, out = t + b, free(t), rows = sum(out, 1), total = sum(rows)
+        for (uint64_t i = 0; i < flushes; ++i) {
+            const double c = 1.0 + i;
+            BhArray<double> a = full<double>({n, n}, static_cast<double>(i));
+            BhArray<double> b = full<double>({n, n}, 2.0);
+            Runtime::instance().flush();
+
+            BhArray<double> t({n, n});
+            BhArray<double> out({n, n});
+            BhArray<double> rows({n});
+            BhArray<double> total({1});
+            multiply(t, a, c);
+            add(out, t, b);
+            free(t);
+            add_reduce(rows, out, 1);
+            add_reduce(total, rows, 0);
+            Runtime::instance().flush();
+
+            const double elem = i * c + 2.0;
+            check_equal("new arrays and constants", out.vec(), std::vector<double>(n * n, elem));
+            check_equal("row sums", rows.vec(), std::vector<double>(n, n * elem));
+            check_equal("total", total.vec(), std::vector<double>{n * n * elem});
+        }
+    }
+
+    {// Single-element views that slide, which the plan binds to the starts of each iteration of a repeat:
+     // x[i+1] = x[i] * 0.5 + 1 and acc += x[i]. The accumulator starts where `x[0]` starts, which keeps the
+     // OpenMP engine from running all iterations within one kernel.
+        const uint64_t steps = 20;
+        BhArray<double> x = zeros<double>({steps + 1});
+        BhArray<double> acc = zeros<double>({1});
+        Runtime::instance().flush();
+
+        BhArray<double> cur(x.base(), {1}, {1}, 0);
+        BhArray<double> next(x.base(), {1}, {1}, 1);
+        Runtime::instance().slide_view(&cur, 0, 1, 0, steps + 1, 1, 1);
+        Runtime::instance().slide_view(&next, 0, 1, 0, steps + 1, 1, 1);
+        multiply(next, cur, 0.5);
+        add(next, next, 1.0);
+        add(acc, acc, cur);
+        Runtime::instance().flushAndRepeat(steps, nullptr);
+
+        std::vector<double> expected_x(steps + 1, 0);
+        double expected_acc = 0;
+        for (uint64_t i = 0; i < steps; ++i) {
+            expected_x[i + 1] = expected_x[i] * 0.5 + 1;
+            expected_acc += expected_x[i];
+        }
+        check_equal("sliding single-element views", x.vec(), expected_x);
+        check_equal("accumulator", acc.vec(), std::vector<double>{expected_acc});
+    }
+
+    {// An array updated by every flush: a = a * 0.5 + b, thus a = 2 - 2^(1-i) after `i` flushes of a = 0 and b = 1
+        BhArray<double> a = zeros<double>({n});
+        BhArray<double> b = ones<double>({n});
+        Runtime::instance().flush();
+        double expected = 0;
+        for (uint64_t i = 0; i < flushes; ++i) {
+            multiply(a, a, 0.5);
+            add(a, a, b);
+            Runtime::instance().flush();
+            expected = expected * 0.5 + 1;
+            check_equal("updated array", a.vec(), std::vector<double>(n, expected));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Round trips of BhIRs through the batch caches of the proxy VEM: a miss followed by a hit with other base arrays
+ * and constants, the new base arrays and the order of their data, the freed and sync'ed arrays, and the re-use of
+ * IDs when the frontend runs out of them. */
+
+#include <deque>
+#include <memory>
+
+#include "batch_cache.hpp"
+#include "check.hpp"
+
+using namespace std;
+using namespace bohrium;
+using namespace bhxx_test;
+
+namespace {
+// The two ends of the batch cache and of the serialization
+struct Link {
+    BatchCacheFrontend front;
+    set<bh_base *> known_base_arrays;
+    BhIRViewDict front_views;
+    BatchCacheBackend back;
+    map<const bh_base *, bh_base> remote2local;
+    BhIRViewDict back_views;
+
+    // The result of one message
+    struct Result {
+        msg::Type type;
+        vector<bh_base *> new_data;  // The frontend arrays whose data is sent
+        vector<bh_base *> data_recv; // The backend arrays that receive the data
+        set<bh_base *> frees;        // The remote IDs of the freed arrays
+        unique_ptr<BhIR> bhir;       // The BhIR that the backend executes
+    };
+
+    // Send `bhir` from the frontend to the backend
+    Result send(BhIR &bhir) {
+        Result ret;
+        vector<char> body;
+        ret.type = front.write(bhir, known_base_arrays, front_views, ret.new_data, body);
+        if (ret.type == msg::Type::EXEC_REF) {
+            ret.bhir.reset(new BhIR(back.instantiate(body, remote2local, ret.data_recv, ret.frees)));
+        } else {
+            check(ret.type == msg::Type::EXEC_CACHE, "the message is neither EXEC_REF nor EXEC_CACHE");
+            ret.bhir.reset(new BhIR(body, remote2local, back_views, ret.data_recv, ret.frees));
+            back.insert(body, *ret.bhir, ret.data_recv);
+        }
+        return ret;
+    }
+
+    // Returns the backend array of the frontend array `base`
+    bh_base *local(const bh_base *base) {
+        auto it = remote2local.find(base);
+        check(it != remote2local.end(), "the backend does not know a base array");
+        return &it->second;
+    }
+};
+
+// The frontend arrays of one execution of `program()`
+struct Arrays {
+    vector<double> a_data, d_data;
+    bh_base a, d, t, out;
+
+    Arrays(int64_t n) : a_data(n, 1.0), d_data(n, 2.0), a(n, bh_type::FLOAT64, a_data.data()),
+                        d(n, bh_type::FLOAT64, d_data.data()), t(n, bh_type::FLOAT64), out(n, bh_type::FLOAT64) {}
+};
+
+// out = (a + c) * d, where `a` and `d` are new arrays with data and `a` and `t` are freed
+BhIR program(Arrays &x, double c, uint64_t nrepeats = 1) {
+    bh_instruction add(BH_ADD, {bh_view(&x.t), bh_view(&x.a), bh_view()});
+    add.constant = bh_constant(c);
+    vector<bh_instruction> instr_list{add,
+                                      bh_instruction(BH_MULTIPLY, {bh_view(&x.out), bh_view(&x.t), bh_view(&x.d)}),
+                                      bh_instruction(BH_FREE, {bh_view(&x.a)}),
+                                      bh_instruction(BH_FREE, {bh_view(&x.t)})};
+    return BhIR(std::move(instr_list), {&x.out}, nrepeats);
+}
+
+// Check that the backend received `program(x, c, nrepeats)`
+void check_program(Link &link, const Link::Result &res, Arrays &x, double c, uint64_t nrepeats,
+                   const string &name) {
+    check(res.new_data == vector<bh_base *>({&x.a, &x.d}), name + ": the new data is not [a, d]");
+    check(res.data_recv == vector<bh_base *>({link.local(&x.a), link.local(&x.d)}),
+          name + ": the data is not received in the order it is sent");
+    check(res.frees == set<bh_base *>({&x.a, &x.t}), name + ": the freed arrays are not {a, t}");
+    for (const bh_base *base: {&x.a, &x.d, &x.t, &x.out}) {
+        check(link.local(base)->nelem() == base->nelem() and link.local(base)->dtype() == base->dtype(),
+              name + ": a backend array does not match its frontend array");
+    }
+    const BhIR &bhir = *res.bhir;
+    check(bhir.getSyncs() == set<bh_base *>({link.local(&x.out)}), name + ": the sync'ed arrays are not {out}");
+    check(bhir.getNRepeats() == nrepeats, name + ": the number of repeats differs");
+    check(bhir.instr_list.size() == 4, name + ": the number of instructions differs");
+    const vector<bh_opcode> opcodes{BH_ADD, BH_MULTIPLY, BH_FREE, BH_FREE};
+    const vector<vector<const bh_base *> > operands{{&x.t, &x.a, nullptr}, {&x.out, &x.t, &x.d}, {&x.a}, {&x.t}};
+    for (size_t i = 0; i < 4; ++i) {
+        const bh_instruction &instr = bhir.instr_list[i];
+        check(instr.opcode == opcodes[i], name + ": an opcode differs");
+        check(instr.operand.size() == operands[i].size(), name + ": the number of operands differs");
+        for (size_t j = 0; j < operands[i].size(); ++j) {
+            if (operands[i][j] == nullptr) {
+                check(instr.operand[j].isConstant(), name + ": the constant operand is an array");
+            } else {
+                check(instr.operand[j].base == link.local(operands[i][j]) and
+                      instr.operand[j].shape == bh_view(link.local(operands[i][j])).shape and
+                      instr.operand[j].stride == bh_view(link.local(operands[i][j])).stride,
+                      name + ": an operand is not the view of its backend array");
+            }
+        }
+    }
+    check(bhir.instr_list[0].constant.value.float64 == c, name + ": the constant differs");
+}
+
+// out = c, where `out` is a new array of `nelem` elements
+BhIR fill(bh_base &out, double c) {
+    bh_instruction instr(BH_IDENTITY, {bh_view(&out), bh_view()});
+    instr.constant = bh_constant(c);
+    return BhIR({instr}, {&out});
+}
+} // Anonymous namespace
+
+int main() {
+    {// A miss followed by hits with other base arrays and constants
+        Link link;
+        deque<Arrays> arrays;
+        arrays.emplace_back(100);
+        BhIR first = program(arrays.back(), 1.5);
+        Link::Result res = link.send(first);
+        check(res.type == msg::Type::EXEC_CACHE, "the first BhIR is not a cache miss");
+        check_program(link, res, arrays.back(), 1.5, 1, "miss");
+
+        for (double c: {2.5, -7.0}) {
+            arrays.emplace_back(100);
+            BhIR bhir = program(arrays.back(), c);
+            res = link.send(bhir);
+            check(res.type == msg::Type::EXEC_REF, "a repeated BhIR is not a cache hit");
+            check_program(link, res, arrays.back(), c, 1, "hit");
+        }
+        check(link.front.stat_hits == 2 and link.front.stat_misses == 1, "the statistics are wrong");
+
+        // Other sizes and repeats are other structures
+        arrays.emplace_back(101);
+        BhIR other_size = program(arrays.back(), 1.5);
+        res = link.send(other_size);
+        check(res.type == msg::Type::EXEC_CACHE, "a BhIR of other sizes is a cache hit");
+        check_program(link, res, arrays.back(), 1.5, 1, "other size");
+        arrays.emplace_back(100);
+        BhIR other_repeats = program(arrays.back(), 1.5, 3);
+        res = link.send(other_repeats);
+        check(res.type == msg::Type::EXEC_CACHE, "a BhIR of other repeats is a cache hit");
+        check_program(link, res, arrays.back(), 1.5, 3, "other repeats");
+        arrays.emplace_back(100);
+        BhIR repeated = program(arrays.back(), 4.0, 3);
+        res = link.send(repeated);
+        check(res.type == msg::Type::EXEC_REF, "a repeated BhIR with repeats is not a cache hit");
+        check_program(link, res, arrays.back(), 4.0, 3, "hit with repeats");
+
+        // An array that the backend knows is another structure than a new array of the same size
+        Arrays &x = arrays.back();
+        bh_base out2(100, bh_type::FLOAT64);
+        BhIR known = fill(x.out, 1.0);
+        res = link.send(known);
+        check(res.type == msg::Type::EXEC_CACHE, "a known array is a cache hit of a new array");
+        BhIR unknown = fill(out2, 2.0);
+        res = link.send(unknown);
+        check(res.type == msg::Type::EXEC_CACHE, "a new array is a cache hit of a known array");
+        BhIR known_again = fill(x.out, 3.0);
+        res = link.send(known_again);
+        check(res.type == msg::Type::EXEC_REF, "a known array is not a cache hit");
+        check(res.bhir->instr_list[0].operand[0].base == link.local(&x.out), "the known array is not re-used");
+        check(res.bhir->instr_list[0].constant.value.float64 == 3.0, "the constant of the known array differs");
+    }
+
+    {// The frontend starts over from ID zero when it runs out of IDs and the backend overwrites its entries
+        Link link;
+        deque<bh_base> bases;
+        auto send_fill = [&](int64_t nelem, double c) {
+            bases.emplace_back(nelem, bh_type::FLOAT64);
+            BhIR bhir = fill(bases.back(), c);
+            Link::Result res = link.send(bhir);
+            check(res.bhir->instr_list[0].operand[0].base == link.local(&bases.back()) and
+                  link.local(&bases.back())->nelem() == nelem, "the array of a fill differs");
+            check(res.bhir->instr_list[0].constant.value.float64 == c, "the constant of a fill differs");
+            return res.type;
+        };
+        for (uint32_t i = 0; i < batch_cache_max_size; ++i) {
+            check(send_fill(i + 1, 0) == msg::Type::EXEC_CACHE, "a new structure is a cache hit");
+        }
+        check(send_fill(1, 1) == msg::Type::EXEC_REF, "the first structure is not a cache hit");
+        check(send_fill(batch_cache_max_size, 1) == msg::Type::EXEC_REF, "the last structure is not a cache hit");
+
+        // The next structure takes ID zero, which replaces the first structure on the backend
+        check(send_fill(batch_cache_max_size + 1, 0) == msg::Type::EXEC_CACHE, "a new structure is a cache hit");
+        check(send_fill(batch_cache_max_size + 1, 2) == msg::Type::EXEC_REF, "the re-used ID is not a cache hit");
+        check(send_fill(1, 2) == msg::Type::EXEC_CACHE, "an entry from before the restart is a cache hit");
+        check(send_fill(1, 3) == msg::Type::EXEC_REF, "a structure is not a cache hit after the restart");
+        check(send_fill(batch_cache_max_size + 1, 3) == msg::Type::EXEC_REF,
+              "the first structure after the restart is not a cache hit");
+    }
+    return 0;
+}
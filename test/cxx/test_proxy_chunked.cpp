@@ -0,0 +1,191 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Round trips of the chunked container of the proxy VEM through every codec and filter of this build, and checks
+ * of the container layout: the head, the table of stored chunk sizes, and the chunks that are stored as is. */
+
+#include <cstring>
+#include <random>
+#include <boost/algorithm/string.hpp>
+
+#include "chunked.hpp"
+#include "check.hpp"
+
+using namespace std;
+using namespace bohrium;
+using namespace bhxx_test;
+
+namespace {
+// The offsets of the fields of the head of the container, which the table of stored chunk sizes follows
+constexpr size_t head_elem_size = 8;
+constexpr size_t head_nbytes = 16;
+constexpr size_t head_chunk_size = 24;
+constexpr size_t head_nchunks = 32;
+constexpr size_t head_size = 40;
+
+uint64_t read_u64(const vector<unsigned char> &data, size_t offset) {
+    uint64_t ret;
+    memcpy(&ret, data.data() + offset, sizeof(ret));
+    return ret;
+}
+
+// Returns the stored size of each chunk of `container`
+vector<uint64_t> chunk_sizes(const vector<unsigned char> &container) {
+    vector<uint64_t> ret(read_u64(container, head_nchunks));
+    for (size_t i = 0; i < ret.size(); ++i) {
+        ret[i] = read_u64(container, head_size + i * sizeof(uint64_t));
+    }
+    return ret;
+}
+
+// `nbytes` of smooth doubles, which compress well, followed by bytes that make `nbytes` a non-multiple of 8
+vector<unsigned char> smooth_data(uint64_t nbytes) {
+    vector<unsigned char> ret(nbytes);
+    for (uint64_t i = 0; i + sizeof(double) <= nbytes; i += sizeof(double)) {
+        const double v = 1000.0 + static_cast<double>(i / sizeof(double)) * 0.25;
+        memcpy(ret.data() + i, &v, sizeof(v));
+    }
+    for (uint64_t i = nbytes / sizeof(double) * sizeof(double); i < nbytes; ++i) {
+        ret[i] = static_cast<unsigned char>(i);
+    }
+    return ret;
+}
+
+// `nbytes` of random bytes, which do not compress
+vector<unsigned char> noise_data(uint64_t nbytes) {
+    vector<unsigned char> ret(nbytes);
+    mt19937_64 rng(42);
+    for (auto &b: ret) {
+        b = static_cast<unsigned char>(rng());
+    }
+    return ret;
+}
+
+// Compress and uncompress `data` and check the result and the layout of the container
+void round_trip(const string &name, const vector<unsigned char> &data, uint64_t elem_size,
+                const chunked::Options &opt, jitk::ThreadPool *pool) {
+    const vector<unsigned char> container = chunked::compress(data.data(), data.size(), elem_size, opt, pool);
+    check(container.size() >= head_size, name + ": the container has no head");
+    check(memcmp(container.data(), "BHCZ", 4) == 0, name + ": wrong magic");
+    check(read_u64(container, head_elem_size) == elem_size, name + ": wrong element size in the head");
+    check(read_u64(container, head_nbytes) == data.size(), name + ": wrong size in the head");
+
+    const uint64_t chunk_size = read_u64(container, head_chunk_size);
+    check(chunk_size % elem_size == 0, name + ": the chunks do not consist of whole elements");
+    const vector<uint64_t> sizes = chunk_sizes(container);
+    check(sizes.size() == (data.size() + chunk_size - 1) / chunk_size, name + ": wrong number of chunks");
+    uint64_t total = head_size + sizes.size() * sizeof(uint64_t);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        const uint64_t raw = min(chunk_size, data.size() - i * chunk_size);
+        check(sizes[i] > 0 and sizes[i] <= raw, name + ": a chunk is stored larger than its raw size");
+        if (opt.codec == chunked::Codec::NONE) {
+            check(sizes[i] == raw, name + ": a chunk of codec none is not stored as is");
+        }
+        total += sizes[i];
+    }
+    check(total == container.size(), name + ": the size table does not add up to the container size");
+
+    vector<unsigned char> result(data.size());
+    chunked::uncompress(container, result.data(), result.size(), pool);
+    check(result == data, name + ": the round trip changed the data");
+}
+} // Anonymous namespace
+
+int main() {
+    jitk::ThreadPool pool(2);
+    const vector<chunked::Codec> codecs = {chunked::Codec::NONE, chunked::Codec::ZLIB, chunked::Codec::LZ4,
+                                           chunked::Codec::ZSTD};
+    const vector<chunked::Filter> filters = {chunked::Filter::NONE, chunked::Filter::SHUFFLE,
+                                             chunked::Filter::BITSHUFFLE};
+    // Empty, tiny (less than an element), a single chunk, and many chunks with an incomplete last chunk
+    const vector<uint64_t> sizes = {0, 1, 7, 8, 1000, 64 * 1024 + 13};
+
+    for (chunked::Codec codec: codecs) {
+        if (not chunked::available(codec)) {
+            continue;
+        }
+        for (chunked::Filter filter: filters) {
+            chunked::Options opt;
+            opt.codec = codec;
+            opt.filter = filter;
+            opt.chunk_size = 4096;
+            for (uint64_t nbytes: sizes) {
+                for (jitk::ThreadPool *p: {static_cast<jitk::ThreadPool *>(nullptr), &pool}) {
+                    const string name = opt.str() + ", " + to_string(nbytes) + " bytes" + (p ? ", pool" : "");
+                    round_trip(name + ", smooth", smooth_data(nbytes), sizeof(double), opt, p);
+                    round_trip(name + ", random", noise_data(nbytes), sizeof(double), opt, p);
+                    round_trip(name + ", bytes", smooth_data(nbytes), 1, opt, p);
+                }
+            }
+        }
+    }
+
+    {// Chunks that do not compress are stored as is, which `uncompress()` recognizes by their stored size
+        chunked::Options opt;
+        opt.chunk_size = 4096;
+        const vector<unsigned char> data = noise_data(3 * 4096 + 100);
+        const vector<unsigned char> container = chunked::compress(data.data(), data.size(), 8, opt, nullptr);
+        const vector<uint64_t> stored = chunk_sizes(container);
+        check_equal("stored sizes of random chunks", stored, vector<uint64_t>{4096, 4096, 4096, 100});
+        check(memcmp(container.data() + head_size + 4 * sizeof(uint64_t), data.data(), data.size()) == 0,
+              "random chunks are not stored as is");
+    }
+
+    {// Compressible chunks are stored smaller
+        chunked::Options opt;
+        opt.chunk_size = 4096;
+        const vector<unsigned char> data = smooth_data(2 * 4096);
+        for (uint64_t size: chunk_sizes(chunked::compress(data.data(), data.size(), 8, opt, nullptr))) {
+            check(size < 4096, "a smooth chunk is stored as is");
+        }
+    }
+
+    {// A container that is truncated or does not match the destination is rejected
+        chunked::Options opt;
+        opt.chunk_size = 4096;
+        const vector<unsigned char> data = smooth_data(10000);
+        const vector<unsigned char> container = chunked::compress(data.data(), data.size(), 8, opt, nullptr);
+        vector<unsigned char> result(data.size());
+        bool thrown = false;
+        try {
+            chunked::uncompress(vector<unsigned char>(container.begin(), container.end() - 1), result.data(),
+                                result.size(), nullptr);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        check(thrown, "a truncated container is accepted");
+        thrown = false;
+        try {
+            chunked::uncompress(container, result.data(), result.size() - 8, nullptr);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        check(thrown, "a container of another size is accepted");
+    }
+
+    {// The options survive the `compress_param` string
+        for (const string &param: vector<string>{"zlib", "zlib,9,shuffle", "zlib,bitshuffle"}) {
+            vector<string> param_list;
+            boost::split(param_list, param, boost::is_any_of(","));
+            check(chunked::parse(param_list).str() == param, "the options of '" + param + "' do not round trip");
+        }
+    }
+    return 0;
+}
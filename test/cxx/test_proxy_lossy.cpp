@@ -0,0 +1,191 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Round trips of the error-bounded lossy compression of the proxy VEM: the error bound, the reported max error,
+ * the values that are stored exact (NaN, Inf, huge values, and jumps too large for a code), negative differences,
+ * and the relative bound of constant arrays. */
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "lossy.hpp"
+#include "check.hpp"
+
+using namespace std;
+using namespace bohrium;
+using namespace bhxx_test;
+
+namespace {
+template<typename T>
+bh_type type_of();
+
+template<>
+bh_type type_of<float>() { return bh_type::FLOAT32; }
+
+template<>
+bh_type type_of<double>() { return bh_type::FLOAT64; }
+
+// Returns the bound that `opt` gives `data`
+template<typename T>
+double bound_of(const vector<T> &data, const lossy::Options &opt) {
+    if (opt.abs_error > 0) {
+        return opt.abs_error;
+    }
+    double lo = INFINITY, hi = -INFINITY;
+    for (T v: data) {
+        if (std::isfinite(v)) {
+            lo = std::min(lo, static_cast<double>(v));
+            hi = std::max(hi, static_cast<double>(v));
+        }
+    }
+    return hi > lo ? opt.rel_error * (hi - lo) : opt.rel_error;
+}
+
+// Compress and uncompress `data` and check that every finite value is within the bound and that the non-finite
+// values are exact. Returns the result.
+template<typename T>
+vector<T> round_trip(const string &name, const vector<T> &data, const lossy::Options &opt,
+                     jitk::ThreadPool *pool) {
+    double max_error = -1;
+    const vector<unsigned char> compressed = lossy::compress(data.data(), data.size(), type_of<T>(), opt, pool,
+                                                             max_error);
+    vector<T> result(data.size());
+    lossy::uncompress(compressed, result.data(), result.size(), type_of<T>(), pool);
+
+    const double bound = bound_of(data, opt);
+    double error = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (std::isnan(data[i])) {
+            check(std::isnan(result[i]), name + ": NaN at " + to_string(i) + " is not NaN");
+        } else if (std::isinf(data[i])) {
+            check(result[i] == data[i], name + ": Inf at " + to_string(i) + " is not exact");
+        } else {
+            const double e = std::fabs(static_cast<double>(data[i]) - static_cast<double>(result[i]));
+            check(e <= bound, name + ": element " + to_string(i) + " breaks the bound");
+            error = std::max(error, e);
+        }
+    }
+    check(max_error >= error and max_error <= bound, name + ": wrong reported max error");
+    return result;
+}
+
+template<typename T>
+void test_type(jitk::ThreadPool *pool) {
+    const string type = sizeof(T) == 4 ? "float32" : "float64";
+    lossy::Options abs;
+    abs.abs_error = 1e-3;
+    lossy::Options rel;
+    rel.rel_error = 1e-4;
+
+    // Empty, tiny, and more than one chunk (of 256K elements) of smooth data with a little noise
+    mt19937_64 rng(7);
+    for (uint64_t n: {0, 1, 5, 600000}) {
+        vector<T> data(n);
+        for (uint64_t i = 0; i < n; ++i) {
+            data[i] = static_cast<T>(std::sin(i * 1e-4) * 50 + (rng() % 1000) * 1e-6);
+        }
+        for (const lossy::Options &opt: {abs, rel}) {
+            const string name = type + ", " + to_string(n) + " elements, " + (opt.abs_error > 0 ? "abs" : "rel");
+            round_trip(name, data, opt, nullptr);
+            round_trip(name + ", pool", data, opt, pool);
+        }
+    }
+
+    {// Values that are stored exact: NaN, Inf, values too large to quantize, and jumps too large for a code
+        vector<T> data(1000);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<T>(i % 10);
+        }
+        data[3] = numeric_limits<T>::quiet_NaN();
+        data[7] = numeric_limits<T>::infinity();
+        data[11] = -numeric_limits<T>::infinity();
+        data[13] = static_cast<T>(1e30);
+        data[17] = static_cast<T>(-3e25);
+        data[500] = static_cast<T>(1e7); // A jump of 1e7 / 2e-3 codes is more than 2^31
+        const vector<T> result = round_trip(type + ", special values", data, abs, pool);
+        for (size_t i: {13, 17, 500}) {
+            check(result[i] == data[i], type + ": the outlier at " + to_string(i) + " is not exact");
+        }
+    }
+
+    {// Decreasing values give negative differences, which the codes must keep
+        vector<T> data(5000);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<T>(100.0 - i * 0.37);
+        }
+        round_trip(type + ", decreasing", data, abs, nullptr);
+    }
+
+    // A constant array has no value range thus the relative bound is used as an absolute bound
+    for (T value: {T(0), T(3.5), T(-1e6)}) {
+        const string name = type + ", constant " + to_string(value);
+        const vector<T> result = round_trip(name, vector<T>(1000, value), rel, nullptr);
+        for (T v: result) {
+            check(v == result[0], name + ": the values are not equal");
+        }
+    }
+}
+} // Anonymous namespace
+
+int main() {
+    jitk::ThreadPool pool(2);
+    test_type<float>(&pool);
+    test_type<double>(&pool);
+
+    {// Parsing of the `compress_param` list
+        check(lossy::parse({"sz", "abs=1e-3"}).abs_error == 1e-3, "abs= is not parsed");
+        check(lossy::parse({"sz", "rel=1e-6"}).rel_error == 1e-6, "rel= is not parsed");
+        for (const vector<string> &param_list: vector<vector<string> >{{"sz"}, {"sz", "abs=0"}, {"sz", "x=1"}}) {
+            bool thrown = false;
+            try {
+                lossy::parse(param_list);
+            } catch (const std::runtime_error &) {
+                thrown = true;
+            }
+            check(thrown, "a parameter list without a positive bound is accepted");
+        }
+    }
+
+    {// Other types and mismatching destinations are rejected
+        const vector<double> data(10, 1.0);
+        lossy::Options opt;
+        opt.abs_error = 1e-3;
+        double max_error;
+        bool thrown = false;
+        try {
+            lossy::compress(data.data(), data.size(), bh_type::INT64, opt, nullptr, max_error);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        check(thrown, "an int64 array is accepted");
+        const vector<unsigned char> compressed = lossy::compress(data.data(), data.size(), bh_type::FLOAT64, opt,
+                                                                 nullptr, max_error);
+        vector<float> result(10);
+        thrown = false;
+        try {
+            lossy::uncompress(compressed, result.data(), result.size(), bh_type::FLOAT32, nullptr);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        check(thrown, "float64 data is uncompressed as float32");
+    }
+    return 0;
+}
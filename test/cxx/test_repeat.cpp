@@ -0,0 +1,137 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Time-stepping loops through `flushAndRepeat()`: a row of a grid computed from the previous row through views
+ * that slide one row per iteration, the same with an accumulator that does not slide (which keeps the OpenMP engine
+ * from running all iterations within one kernel), and a repeat condition that stops the loop before the number of
+ * repeats is reached, also with as many repeats as `do_while()` of the Python bridge requests when it has no limit. */
+
+#include <limits>
+
+#include <algorithm>
+#include <cmath>
+
+#include <bhxx/bhxx.hpp>
+#include <bhxx/array_create.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+int main() {
+    const uint64_t size = 10;
+    const uint64_t steps = 40;
+    const auto nrows = static_cast<int64_t>(steps + 1);
+    const auto row_stride = static_cast<int64_t>(size);
+
+    // The expected grid of `grid[i+1] = grid[i] * 0.5 + 1`, which is `grid[i] = 2 - 2^(1-i)`
+    std::vector<double> expected_grid;
+    double expected_acc = 0;
+    for (uint64_t i = 0; i <= steps; ++i) {
+        const double row = i == 0 ? 0 : 2 - std::ldexp(1.0, 1 - static_cast<int>(i));
+        expected_grid.insert(expected_grid.end(), size, row);
+        if (i < steps) {
+            expected_acc += row;
+        }
+    }
+
+    {// grid[i+1] = grid[i] * 0.5 + 1
+        BhArray<double> grid = zeros<double>({steps + 1, size});
+        Runtime::instance().flush();
+
+        BhArray<double> cur(grid.base(), {size}, {1}, 0);
+        BhArray<double> next(grid.base(), {size}, {1}, size);
+        Runtime::instance().slide_view(&cur, 0, 1, 0, nrows, row_stride, 1);
+        Runtime::instance().slide_view(&next, 0, 1, 0, nrows, row_stride, 1);
+        multiply(next, cur, 0.5);
+        add(next, next, 1.0);
+        Runtime::instance().flushAndRepeat(steps, nullptr);
+
+        BhArray<double> flat(grid.base(), {(steps + 1) * size});
+        check_equal("sliding rows", flat.vec(), expected_grid);
+    }
+
+    {// Also acc += grid[i], where `acc` starts where `grid[0]` starts but does not slide
+        BhArray<double> grid = zeros<double>({steps + 1, size});
+        BhArray<double> acc = zeros<double>({size});
+        Runtime::instance().flush();
+
+        BhArray<double> cur(grid.base(), {size}, {1}, 0);
+        BhArray<double> next(grid.base(), {size}, {1}, size);
+        Runtime::instance().slide_view(&cur, 0, 1, 0, nrows, row_stride, 1);
+        Runtime::instance().slide_view(&next, 0, 1, 0, nrows, row_stride, 1);
+        multiply(next, cur, 0.5);
+        add(next, next, 1.0);
+        add(acc, acc, cur);
+        Runtime::instance().flushAndRepeat(steps, nullptr);
+
+        BhArray<double> flat(grid.base(), {(steps + 1) * size});
+        check_equal("sliding rows with an accumulator", flat.vec(), expected_grid);
+        check_equal("accumulator", acc.vec(), std::vector<double>(size, expected_acc));
+    }
+
+    {// count += 1 while count < 7 (checked after each iteration), thus the loop stops after 7 of the 40 repeats
+        BhArray<double> count = zeros<double>({1});
+        BhArray<bool> cond({1});
+        BhArray<double> grid = zeros<double>({steps + 1, size});
+        Runtime::instance().flush();
+
+        BhArray<double> row(grid.base(), {size}, {1}, size);
+        Runtime::instance().slide_view(&row, 0, 1, 0, nrows, row_stride, 1);
+        add(count, count, 1.0);
+        add(row, row, count);
+        less(cond, count, 7.0);
+        Runtime::instance().flushAndRepeat(steps, cond.base());
+
+        std::vector<double> expected_grid((steps + 1) * size, 0);
+        for (uint64_t i = 1; i <= 7; ++i) {
+            std::fill_n(expected_grid.begin() + i * size, size, static_cast<double>(i));
+        }
+        BhArray<double> flat(grid.base(), {(steps + 1) * size});
+        check_equal("count", count.vec(), std::vector<double>{7});
+        check_equal("rows written before the condition stops the loop", flat.vec(), expected_grid);
+    }
+
+    {// grid[i+1] = grid[i] * 0.5 + 1 while count < 7, with the number of repeats of an unlimited `do_while()`
+        const uint64_t nrepeats = std::numeric_limits<int64_t>::max() - 1;
+        BhArray<double> count = zeros<double>({1});
+        BhArray<bool> cond({1});
+        BhArray<double> grid = zeros<double>({steps + 1, size});
+        Runtime::instance().flush();
+
+        BhArray<double> cur(grid.base(), {size}, {1}, 0);
+        BhArray<double> next(grid.base(), {size}, {1}, size);
+        Runtime::instance().slide_view(&cur, 0, 1, 0, nrows, row_stride, 1);
+        Runtime::instance().slide_view(&next, 0, 1, 0, nrows, row_stride, 1);
+        multiply(next, cur, 0.5);
+        add(next, next, 1.0);
+        add(count, count, 1.0);
+        less(cond, count, 7.0);
+        Runtime::instance().flushAndRepeat(nrepeats, cond.base());
+
+        std::vector<double> expected(expected_grid.begin(), expected_grid.begin() + 8 * size);
+        expected.resize((steps + 1) * size, 0);
+        BhArray<double> flat(grid.base(), {(steps + 1) * size});
+        check_equal("count of an unlimited repeat", count.vec(), std::vector<double>{7});
+        check_equal("rows of an unlimited repeat", flat.vec(), expected);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Scatters into an array that has data from an earlier flush, which must keep the elements that the index
+ * doesn't select. On the cluster stack, the arrays are larger than the replicate threshold thus they are split
+ * into shards, which the scatter must gather first. */
+
+#include <bhxx/bhxx.hpp>
+#include <bhxx/array_create.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+int main() {
+    const int64_t n = 200000;
+    const int64_t step = 7;
+    const int64_t m = (n + step - 1) / step;
+
+    BhArray<double> out = arange<double>(n);
+    add(out, out, 0.5);
+    BhArray<double> out_cond = arange<double>(n);
+    Runtime::instance().flush();
+
+    // The values to scatter and the mask of even positions
+    const BhArray<int64_t> pos = arange<int64_t>(m);
+    BhArray<double> src({static_cast<uint64_t>(m)});
+    identity(src, pos);
+    multiply(src, src, -1.0);
+    BhArray<int64_t> parity({static_cast<uint64_t>(m)});
+    bitwise_and(parity, pos, int64_t{1});
+    BhArray<bool> mask({static_cast<uint64_t>(m)});
+    less(mask, parity, int64_t{1});
+    const BhArray<uint64_t> idx = arange<uint64_t>(0, n, step);
+
+    scatter(out, src, idx);
+    cond_scatter(out_cond, src, idx, mask);
+
+    std::vector<double> expected(n), expected_cond(n);
+    for (int64_t i = 0; i < n; ++i) {
+        expected[i] = i + 0.5;
+        expected_cond[i] = i;
+    }
+    for (int64_t i = 0; i < m; ++i) {
+        expected[i * step] = -i;
+        if (i % 2 == 0) {
+            expected_cond[i * step] = -i;
+        }
+    }
+    check_equal("scatter", out.vec(), expected);
+    check_equal("cond_scatter", out_cond.vec(), expected_cond);
+    return 0;
+}
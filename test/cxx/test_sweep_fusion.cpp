@@ -0,0 +1,52 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Reduces a square array along the rows, reduces the result, and then reduces the array along the rows again,
+ * all in one flush. The second reduction along the rows must not fuse with the reduction of the result, which
+ * reads the result while the second reduction along the rows rewrites all of it in every row. */
+
+#include <bhxx/bhxx.hpp>
+#include <bhxx/array_create.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+int main() {
+    const uint64_t n = 64;
+    BhArray<double> flat = arange<double>(n * n);
+    BhArray<double> grid(flat.base(), {n, n}, {static_cast<int64_t>(n), 1});
+    BhArray<double> sums({n});
+    BhArray<double> total({1});
+    Runtime::instance().flush();
+
+    add_reduce(sums, grid, 0);
+    add_reduce(total, sums, 0);
+    add_reduce(sums, grid, 0);
+
+    std::vector<double> expected_sums(n);
+    for (uint64_t j = 0; j < n; ++j) {
+        expected_sums[j] = n * (n * (n - 1) / 2.0) + n * j;
+    }
+    check_equal("total", total.vec(), std::vector<double>{n * n * (n * n - 1) / 2.0});
+    check_equal("sums", sums.vec(), expected_sums);
+    return 0;
+}
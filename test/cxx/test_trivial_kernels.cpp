@@ -0,0 +1,137 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Fills, copies, and ranges, which the CPU engines execute without generated kernels when they are kernels of their
+ * own. The values must match whether a fill writes its memory or is skipped as a zero-fill of new memory, including
+ * memory that the malloc cache re-uses, and whether the kernels run serially or on all threads. */
+
+#include <complex>
+
+#include <bhxx/bhxx.hpp>
+#include <bhxx/array_create.hpp>
+
+#include "check.hpp"
+
+using namespace bhxx;
+using namespace bhxx_test;
+
+namespace {
+// Fill a new array of each size with `value` in a flush of its own
+template<typename T>
+void check_fill(T value, const std::string &name) {
+    for (uint64_t n: {uint64_t{1}, uint64_t{1000}, uint64_t{1} << 21}) {
+        BhArray<T> a({n});
+        identity(a, value);
+        Runtime::instance().flush();
+        check_equal(name + " of " + std::to_string(n) + " elements", a.vec(), std::vector<T>(n, value));
+    }
+}
+} // Anonymous namespace
+
+int main() {
+    const uint64_t n = uint64_t{1} << 21; // Large enough for all threads and non-temporal stores
+
+    check_fill<double>(0.0, "zero-fill of new float64 memory");
+    check_fill<double>(1.5, "fill of float64");
+    check_fill<double>(0.0, "zero-fill of float64");
+    check_fill<double>(-0.0, "fill of float64 negative zero");
+    check_fill<float>(-2.25f, "fill of float32");
+    check_fill<int8_t>(-1, "fill of int8");
+    check_fill<int32_t>(0x01010101, "fill of int32 with a byte pattern");
+    check_fill<uint64_t>(12345678901234ull, "fill of uint64");
+    check_fill<bool>(true, "fill of bool");
+    {// The bits of a complex value are not a byte pattern
+        BhArray<std::complex<double> > a({1001});
+        identity(a, std::complex<double>(1.0, -2.0));
+        Runtime::instance().flush();
+        for (const std::complex<double> &v: a.vec()) {
+            check(v == std::complex<double>(1.0, -2.0), "fill of complex128");
+        }
+    }
+
+    {// A zero-fill of an array that has data
+        BhArray<double> a = full<double>({n}, 7.0);
+        Runtime::instance().flush();
+        identity(a, 0.0);
+        Runtime::instance().flush();
+        check_equal("zero-fill of an array with data", a.vec(), std::vector<double>(n, 0));
+    }
+
+    {// A zero-fill of memory that the malloc cache re-uses after a free
+        for (int i = 0; i < 3; ++i) {
+            BhArray<double> a = full<double>({n}, 7.0);
+            Runtime::instance().flush();
+            free(a);
+            Runtime::instance().flush();
+            BhArray<double> b({n});
+            identity(b, 0.0);
+            Runtime::instance().flush();
+            check_equal("zero-fill of re-used memory", b.vec(), std::vector<double>(n, 0));
+        }
+    }
+
+    {// Fills and copies of contiguous views that are part of their array
+        BhArray<double> a = full<double>({100}, 1.0);
+        BhArray<double> src = arange<double>(100);
+        Runtime::instance().flush();
+        BhArray<double> part(a.base(), {10}, {1}, 20);
+        identity(part, 0.0);
+        Runtime::instance().flush();
+        BhArray<double> dst(a.base(), {10}, {1}, 50);
+        BhArray<double> src_part(src.base(), {10}, {1}, 5);
+        identity(dst, src_part);
+        Runtime::instance().flush();
+        std::vector<double> expected(100, 1.0);
+        for (uint64_t i = 0; i < 10; ++i) {
+            expected[20 + i] = 0.0;
+            expected[50 + i] = 5.0 + i;
+        }
+        check_equal("fills and copies of views", a.vec(), expected);
+    }
+
+    {// A copy of a whole array
+        BhArray<double> src = arange<double>(n);
+        Runtime::instance().flush();
+        BhArray<double> dst({n});
+        identity(dst, src);
+        Runtime::instance().flush();
+        check_equal("copy", dst.vec(), src.vec());
+    }
+
+    {// Ranges
+        for (uint64_t size: {uint64_t{1}, uint64_t{1000}, n}) {
+            BhArray<uint64_t> a({size});
+            range(a);
+            BhArray<uint32_t> b({size});
+            Runtime::instance().flush();
+            range(b);
+            Runtime::instance().flush();
+            std::vector<uint64_t> expected_a(size);
+            std::vector<uint32_t> expected_b(size);
+            for (uint64_t i = 0; i < size; ++i) {
+                expected_a[i] = i;
+                expected_b[i] = static_cast<uint32_t>(i);
+            }
+            check_equal("range of uint64", a.vec(), expected_a);
+            check_equal("range of uint32", b.vec(), expected_b);
+        }
+    }
+    return 0;
+}
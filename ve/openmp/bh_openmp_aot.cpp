@@ -0,0 +1,55 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Builds the library of ahead-of-time compiled shape-generic kernels of the OpenMP vector engine, which is the
+ * `aot_library` option of the [openmp] config section. The library is only rebuilt when it is out of date.
+ *
+ * Usage: bh_openmp_aot
+ */
+#include <iostream>
+#include <string>
+
+#include <bohrium/bh_config_parser.hpp>
+#include <bohrium/bh_component.hpp>
+
+using namespace std;
+using namespace bohrium;
+
+// Returns the level of `name` in the stack of the config. NB: `ConfigParser` throws when the level is out of bound.
+int find_stack_level(const string &name) {
+    for (int level = 0;; ++level) {
+        if (ConfigParser(level).getName() == name) {
+            return level;
+        }
+    }
+}
+
+int main() {
+    try {
+        // We load the vector engine directly, which skips the filters and managers of the stack
+        const int level = find_stack_level("openmp");
+        component::ComponentFace engine(ConfigParser(level - 1).getChildLibraryPath(), level);
+        cout << engine.message("openmp_aot_build");
+    } catch (const std::exception &e) {
+        cerr << "bh_openmp_aot: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
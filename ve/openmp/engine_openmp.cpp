@@ -23,13 +23,19 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <fstream>
 #include <string>
 #include <map>
+#include <set>
 #include <iomanip>
+#include <deque>
 #include <dlfcn.h>
+#include <unistd.h>
+#include <boost/algorithm/string/replace.hpp>
 #include <bohrium/jitk/codegen_util.hpp>
 #include <bohrium/jitk/compiler.hpp>
 #include <bohrium/jitk/fuser_cache.hpp>
 #include <bohrium/jitk/codegen_cache.hpp>
 #include <bohrium/jitk/block.hpp>
+#include <bohrium/jitk/instruction.hpp>
+#include <bohrium/jitk/iterator.hpp>
 #include <thread>
 
 #include <bohrium/bh_util.hpp>
@@ -42,12 +48,63 @@ namespace fs = boost::filesystem;
 
 namespace bohrium {
 
+namespace {
+// The headers of the kernels that call the math library or use complex numbers. They make up most of the time it
+// takes the compiler to parse a kernel thus other kernels omit them and `compiler_pch` precompiles them.
+const char *const math_includes = "#include <stdlib.h>\n"
+                                  "#include <complex.h>\n"
+                                  "#include <tgmath.h>\n"
+                                  "#include <math.h>\n";
+
+// Returns the number of threads of the `pool` parallel runtime based on the config value `pool_threads`
+uint64_t get_pool_threads(const ConfigParser &config) {
+    const int64_t ret = config.defaultGet<int64_t>("pool_threads", 0);
+    if (ret < 0) {
+        throw std::runtime_error("config: `pool_threads` must be positive or zero");
+    }
+    return ret > 0 ? static_cast<uint64_t>(ret) : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Returns true if the `parallel_runtime` config value is "pool" and false if it is "openmp"
+bool get_pool_runtime(const ConfigParser &config) {
+    const string runtime = config.defaultGet<string>("parallel_runtime", "openmp");
+    if (runtime != "openmp" and runtime != "pool") {
+        throw std::runtime_error("config: `parallel_runtime` must be `openmp` or `pool`");
+    }
+    return runtime == "pool";
+}
+
+// Returns true if the `math_precision` config value is "fast" and false if it is "exact"
+bool get_fast_math(const ConfigParser &config) {
+    const string precision = config.defaultGet<string>("math_precision", "exact");
+    if (precision != "exact" and precision != "fast") {
+        throw std::runtime_error("config: `math_precision` must be `exact` or `fast`");
+    }
+    return precision == "fast";
+}
+}
+
 EngineOpenMP::EngineOpenMP(component::ComponentVE &comp, jitk::Statistics &stat) : EngineCPU(comp, stat), compiler(
-        comp.config.get<string>("compiler_cmd"), comp.config.file_dir.string(), verbose), compiler_openmp(
+        comp.config.get<string>("compiler_cmd"), comp.config.file_dir.string(), verbose), compiler_pch(
+        comp.config.defaultGet<bool>("compiler_pch", true)), compiler_openmp(
         comp.config.defaultGet<bool>("compiler_openmp", false)), compiler_openmp_simd(
-        comp.config.defaultGet<bool>("compiler_openmp_simd", false)) {
+        comp.config.defaultGet<bool>("compiler_openmp_simd", false)), multi_versioning(
+        comp.config.defaultGet<bool>("multi_versioning", true)), pool_runtime(
+        get_pool_runtime(comp.config)), pool_threads(get_pool_threads(comp.config)), pool_serial_threshold(
+        comp.config.defaultGet<uint64_t>("pool_serial_threshold", 32768)), pool_grain(
+        comp.config.defaultGet<uint64_t>("pool_grain", 4096)), generic_kernels(
+        comp.config.defaultGet<bool>("generic_kernels", true)), aot_library(
+        comp.config.defaultGet<fs::path>("aot_library", fs::path())) {
 
     compilation_hash = util::hash(compiler.cmd_template);
+    fast_math = get_fast_math(comp.config);
+    loadAotLibrary();
+
+    // The `pool` parallel runtime uses the worker pool of EngineCPU, which it creates with `pool_threads`.
+    // NB: the calling thread also executes chunks thus the pool needs one thread less
+    if (pool_runtime and pool_threads > 1) {
+        _pool.reset(new jitk::ThreadPool(pool_threads - 1));
+    }
 
     // Initiate cache limits
     malloc_cache_limit_in_percent = comp.config.defaultGet<int64_t>("malloc_cache_limit", 80);
@@ -119,8 +176,56 @@ EngineOpenMP::~EngineOpenMP() {
     // }
 }
 
-KernelFunction EngineOpenMP::getFunction(const string &source, const string &func_name, const string &compile_cmd) {
-    uint64_t hash = util::hash(source);
+void EngineOpenMP::buildPrecompiledHeader() {
+    // The precompiled header must be compiled with the flags of the kernels but as a C header
+    string pch_cmd = compiler.cmd_template;
+    if (pch_cmd.find("-x c ") == string::npos) {
+        return;
+    }
+    boost::replace_first(pch_cmd, "-x c ", "-x c-header ");
+
+    // The header goes to the cache dir thus it is only built once. NB: GCC ignores a precompiled header that
+    // another compiler version wrote and includes the header itself.
+    const string header = string("#include <stdint.h>\n#include <stdbool.h>\n") + math_includes;
+    const bool use_cache = not (cache_readonly or cache_bin_dir.empty());
+    const fs::path dir = use_cache ? cache_bin_dir : tmp_bin_dir;
+    const fs::path header_file = dir / jitk::hash_filename(compilation_hash, util::hash(header), ".h");
+    const fs::path pch_file = header_file.string() + ".gch";
+    try {
+        if (not fs::exists(pch_file)) {
+            // Other processes might build the same header concurrently thus we write and rename
+            const string tmp_suffix = "." + std::to_string(getpid()) + ".tmp";
+            const fs::path tmp_header = header_file.string() + tmp_suffix;
+            std::ofstream(tmp_header.string()) << header;
+            fs::rename(tmp_header, header_file);
+            const fs::path tmp_pch = pch_file.string() + tmp_suffix;
+            compiler.compile(tmp_pch, header_file, pch_cmd);
+            fs::rename(tmp_pch, pch_file);
+        }
+    } catch (const std::exception &e) {
+        if (verbose) {
+            cout << "Compiling kernels without a precompiled header: " << e.what() << endl;
+        }
+        return;
+    }
+    _pch_cmd = compiler.cmd_template;
+    boost::replace_first(_pch_cmd, "{IN}", "-include " + header_file.string() + " {IN}");
+}
+
+const std::string &EngineOpenMP::compileCommand(const std::string &source) {
+    if (not compiler_pch or source.find(math_includes) == string::npos) {
+        return compiler.cmd_template;
+    }
+    if (not _pch_built) {
+        buildPrecompiledHeader();
+        _pch_built = true;
+    }
+    return _pch_cmd.empty() ? compiler.cmd_template : _pch_cmd;
+}
+
+KernelFunction EngineOpenMP::getFunction(const string &source, uint64_t source_hash, const string &func_name,
+                                         const string &compile_cmd) {
+    const uint64_t hash = source_hash;
     ++stat.kernel_cache_lookups;
 
     // Do we have the function compiled and ready already?
@@ -128,6 +233,16 @@ KernelFunction EngineOpenMP::getFunction(const string &source, const string &fun
         return _functions.at(hash);
     }
 
+    // The AOT kernel library provides the launchers of the common shape-generic kernels
+    if (_aot_handle != nullptr) {
+        KernelFunction func;
+        *(void **) (&func) = dlsym(_aot_handle, func_name.c_str());
+        if (func != nullptr) {
+            ++stat.num_aot_functions;
+            return _functions[hash] = func;
+        }
+    }
+
     // The path to the shared library file.
     fs::path binfile = cache_bin_dir / jitk::hash_filename(compilation_hash, hash, ".so");
     
@@ -147,14 +262,14 @@ KernelFunction EngineOpenMP::getFunction(const string &source, const string &fun
             std::string source_filename = jitk::hash_filename(compilation_hash, hash, ".c");
             fs::path srcfile = jitk::write_source2file(source, tmp_src_dir, source_filename, true);
             if (compile_cmd.empty()) {
-                compiler.compile(binfile, srcfile);
+                compiler.compile(binfile, srcfile, compileCommand(source));
             } else {
                 compiler.compile(binfile, srcfile, compile_cmd);
             }
         } else {
             // Pipe the source directly into the compiler thus no source file is written
             if (compile_cmd.empty()) {
-                compiler.compile(binfile, source);
+                compiler.compile(binfile, source, compileCommand(source));
             } else {
                 compiler.compile(binfile, source, compile_cmd);
             }
@@ -171,6 +286,11 @@ KernelFunction EngineOpenMP::getFunction(const string &source, const string &fun
     }
     _lib_handles.push_back(lib_handle);
 
+    // We use the OpenMP runtime of the kernels to limit the number of threads of a kernel
+    if (compiler_openmp and _omp_set_num_threads == nullptr) {
+        *(void **) (&_omp_set_num_threads) = dlsym(lib_handle, "omp_set_num_threads");
+    }
+
     // Load the launcher function
     // The (clumsy) cast conforms with the ISO C standard and will
     // avoid any compiler warnings.
@@ -185,43 +305,51 @@ KernelFunction EngineOpenMP::getFunction(const string &source, const string &fun
 }
 
 
-void EngineOpenMP::execute(const jitk::SymbolTable &symbols,
-                           const std::string &source,
-                           uint64_t codegen_hash,
-                           const std::vector<const bh_instruction *> &constants) {
-    // Notice, we use a "pure" hash of `source` to make sure that the `source_filename` always
-    // corresponds to `source` even if `codegen_hash` is buggy.
-    uint64_t hash = util::hash(source);
-    std::string source_filename = jitk::hash_filename(compilation_hash, hash, ".c");
+void EngineOpenMP::poolParallelFor(const bh_pool_t *pool, uint64_t size, uint64_t cost, bh_pool_body_t body,
+                                   void *args) {
+    const EngineOpenMP &engine = *static_cast<const EngineOpenMP *>(pool->impl);
+    cost = std::max(cost, uint64_t{1});
 
-    // Make sure all arrays are allocated
-    for (bh_base *base: symbols.getParams()) {
-        bh_data_malloc(base);
+    // Small loops are not worth the synchronization
+    if (engine._pool == nullptr or size < 2 or size * cost < engine.pool_serial_threshold) {
+        body(args, 0, size);
+        return;
     }
 
-    // Compile the kernel
-    auto tbuild = chrono::steady_clock::now();
-    string func_name;
-    {
-        stringstream t;
-        t << "launcher_" << codegen_hash;
-        func_name = t.str();
+    uint64_t num_threads = engine.pool_threads;
+    if (pool->max_threads > 0) {
+        num_threads = std::min(num_threads, pool->max_threads);
     }
-    KernelFunction func = getFunction(source, func_name);
-    assert(func != nullptr);
-    stat.time_compile += chrono::steady_clock::now() - tbuild;
+    // The grain size is the number of iterations that costs at least `pool_grain`. However, we also want about
+    // four chunks per thread to balance the load thus we use larger chunks when the loop is big.
+    const uint64_t min_grain = (engine.pool_grain + cost - 1) / cost;
+    const uint64_t balanced_grain = (size + 4 * num_threads - 1) / (4 * num_threads);
+    const uint64_t grain = std::max(min_grain, balanced_grain);
+
+    engine._pool->parallelFor(size, grain, num_threads, [body, args](uint64_t begin, uint64_t end) {
+        body(args, begin, end);
+    });
+}
+
+namespace {
+// Returns the name of the launcher function of the kernel with the codegen hash `codegen_hash`
+string launcher_name(uint64_t codegen_hash) {
+    return "launcher_" + std::to_string(codegen_hash);
+}
 
+// Write the arguments of the kernel with the symbol table `symbols` into the argument buffers
+void write_arguments(const jitk::SymbolTable &symbols, const std::vector<const bh_instruction *> &constants,
+                     vector<void *> &data_list, vector<uint64_t> &offset_and_strides,
+                     vector<bh_constant_value> &constant_arg) {
     // Create a 'data_list' of data pointers
-    vector<void *> data_list;
-    data_list.reserve(symbols.getParams().size());
+    data_list.clear();
     for (bh_base *base: symbols.getParams()) {
         assert(base->getDataPtr() != nullptr);
         data_list.push_back(base->getDataPtr());
     }
 
     // And the offset-and-strides
-    vector<uint64_t> offset_and_strides;
-    offset_and_strides.reserve(symbols.offsetStrideViews().size());
+    offset_and_strides.clear();
     for (const bh_view *view: symbols.offsetStrideViews()) {
         const uint64_t t = (uint64_t) view->start;
         offset_and_strides.push_back(t);
@@ -232,19 +360,184 @@ void EngineOpenMP::execute(const jitk::SymbolTable &symbols,
     }
 
     // And the constants
-    vector<bh_constant_value> constant_arg;
-    constant_arg.reserve(constants.size());
+    constant_arg.clear();
     for (const bh_instruction *instr: constants) {
         constant_arg.push_back(instr->constant.value);
     }
+}
+}
+
+jitk::EngineCPU::KernelLaunch EngineOpenMP::prepare(const jitk::SymbolTable &symbols,
+                                                    const jitk::CodegenCache::Source &source,
+                                                    uint64_t codegen_hash,
+                                                    const std::vector<const bh_instruction *> &constants) {
+    // Notice, we use a "pure" hash of `source` to make sure that the `source_filename` always
+    // corresponds to `source` even if `codegen_hash` is buggy.
+    std::string source_filename = jitk::hash_filename(compilation_hash, source.hash, ".c");
+
+    // Make sure all arrays are allocated
+    for (bh_base *base: symbols.getParams()) {
+        bh_data_malloc(base);
+    }
 
+    // Compile the kernel
+    auto tbuild = chrono::steady_clock::now();
+    KernelFunction func = getFunction(source.code, source.hash, launcher_name(codegen_hash));
+    assert(func != nullptr);
+    stat.time_compile += chrono::steady_clock::now() - tbuild;
+
+    vector<void *> data_list;
+    vector<uint64_t> offset_and_strides;
+    vector<bh_constant_value> constant_arg;
+    write_arguments(symbols, constants, data_list, offset_and_strides, constant_arg);
+
+    // The launch calls the launcher function, which will execute the kernel
+    auto set_num_threads = _omp_set_num_threads;
+    EngineOpenMP *engine = pool_runtime ? this : nullptr;
+    auto run = [func, set_num_threads, engine, data_list, offset_and_strides, constant_arg](int max_threads) mutable {
+        if (max_threads > 0 and set_num_threads != nullptr) {
+            set_num_threads(max_threads);
+        }
+        if (engine != nullptr) {
+            const bh_pool_t pool{&EngineOpenMP::poolParallelFor, engine, static_cast<uint64_t>(max_threads)};
+            func(&data_list[0], &offset_and_strides[0], &constant_arg[0], &pool);
+        } else {
+            func(&data_list[0], &offset_and_strides[0], &constant_arg[0], nullptr);
+        }
+    };
+    return {std::move(run), std::move(source_filename)};
+}
+
+EngineOpenMP::LaunchDescriptor &EngineOpenMP::getLaunchDescriptor(const jitk::CodegenCache::Source &source,
+                                                                   uint64_t codegen_hash) {
+    // Find the launch descriptor or compile the kernel and create it
+    auto launch = _launches.find(source.hash);
+    if (launch == _launches.end()) {
+        auto tbuild = chrono::steady_clock::now();
+        LaunchDescriptor desc;
+        desc.func = getFunction(source.code, source.hash, launcher_name(codegen_hash));
+        assert(desc.func != nullptr);
+        // Notice, we use a "pure" hash of `source` to make sure that the source filename always
+        // corresponds to `source` even if `codegen_hash` is buggy.
+        desc.stats = &stat.time_per_kernel[jitk::hash_filename(compilation_hash, source.hash, ".c")];
+        launch = _launches.emplace(source.hash, std::move(desc)).first;
+        stat.time_compile += chrono::steady_clock::now() - tbuild;
+    } else {
+        ++stat.kernel_cache_lookups;
+    }
+    return launch->second;
+}
+
+void EngineOpenMP::launch(const LaunchDescriptor &desc, void *data_list[], uint64_t offset_strides[],
+                          bh_constant_value constants[]) {
     auto start_exec = chrono::steady_clock::now();
     // Call the launcher function, which will execute the kernel
-    func(&data_list[0], &offset_and_strides[0], &constant_arg[0]);
+    if (pool_runtime) {
+        const bh_pool_t pool{&EngineOpenMP::poolParallelFor, this, 0};
+        desc.func(data_list, offset_strides, constants, &pool);
+    } else {
+        desc.func(data_list, offset_strides, constants, nullptr);
+    }
     auto texec = chrono::steady_clock::now() - start_exec;
     stat.time_exec += texec;
-    stat.time_per_kernel[source_filename].register_exec_time(texec);
+    desc.stats->register_exec_time(texec);
+}
+
+void EngineOpenMP::execute(const jitk::SymbolTable &symbols,
+                           const jitk::CodegenCache::Source &source,
+                           uint64_t codegen_hash,
+                           const std::vector<const bh_instruction *> &constants) {
+    // Make sure all arrays are allocated
+    for (bh_base *base: symbols.getParams()) {
+        bh_data_malloc(base);
+    }
+    LaunchDescriptor &desc = getLaunchDescriptor(source, codegen_hash);
+
+    // Patch the argument buffers, which reuses the memory of the previous launch
+    write_arguments(symbols, constants, desc.data_list, desc.offset_strides, desc.constants);
+    launch(desc, desc.data_list.data(), desc.offset_strides.data(), desc.constants.data());
+}
+
+void EngineOpenMP::execute(const jitk::CodegenCache::Source &source, uint64_t codegen_hash, KernelArgs &args) {
+    launch(getLaunchDescriptor(source, codegen_hash), args.data_list.data(), args.offset_strides.data(),
+           args.constants.data());
+}
+
+uint64_t EngineOpenMP::executeRepeat(const jitk::SymbolTable &symbols,
+                                     const jitk::CodegenCache::Source &source,
+                                     uint64_t codegen_hash,
+                                     const std::vector<const bh_instruction *> &constants,
+                                     uint64_t nrepeats,
+                                     bh_base *condition) {
+    // Make sure all arrays are allocated
+    for (bh_base *base: symbols.getParams()) {
+        bh_data_malloc(base);
+    }
+
+    // Find the repeat function or compile it. The repeat function iterates the launcher of the kernel
+    // and slides the views in between.
+    auto repeat = _repeats.find(source.hash);
+    if (repeat == _repeats.end()) {
+        auto tbuild = chrono::steady_clock::now();
+        stringstream ss;
+        ss << source.code << "\n";
+        ss << "#include <kernel_dependencies/repeat.h>\n\n";
+        ss << "uint64_t repeat_" << codegen_hash << "(void* data_list[], uint64_t offset_strides[], "
+           << "union dtype constants[], const void *pool, uint64_t nrepeats, const bool *condition, "
+           << "const bh_slide_t slides[], uint64_t nslides) {\n";
+        ss << "    for (uint64_t i = 0; i < nrepeats; ++i) {\n";
+        ss << "        " << launcher_name(codegen_hash) << "(data_list, offset_strides, constants, pool);\n";
+        ss << "        if (condition != NULL && !*condition) {\n";
+        ss << "            return i + 1;\n";
+        ss << "        }\n";
+        ss << "        bh_slide(offset_strides, slides, nslides, i);\n";
+        ss << "    }\n";
+        ss << "    return nrepeats;\n";
+        ss << "}\n";
+        const string repeat_source = ss.str();
+        const uint64_t repeat_hash = util::hash(repeat_source);
+        KernelFunction func = getFunction(repeat_source, repeat_hash, "repeat_" + std::to_string(codegen_hash));
+        assert(func != nullptr);
+        jitk::KernelStats *stats = &stat.time_per_kernel[jitk::hash_filename(compilation_hash, repeat_hash, ".c")];
+        repeat = _repeats.emplace(source.hash, make_pair(reinterpret_cast<RepeatKernelFunction>(func), stats)).first;
+        stat.time_compile += chrono::steady_clock::now() - tbuild;
+    } else {
+        ++stat.kernel_cache_lookups;
+    }
+
+    vector<void *> data_list;
+    vector<uint64_t> offset_and_strides;
+    vector<bh_constant_value> constant_arg;
+    write_arguments(symbols, constants, data_list, offset_and_strides, constant_arg);
 
+    // The slides of the views, which index the view starts in `offset_and_strides`
+    vector<bh_slide_t> slides;
+    uint64_t offset = 0;
+    for (const bh_view *view: symbols.offsetStrideViews()) {
+        for (const bh_slide_dim &dim: view->slides.dims) {
+            slides.push_back({offset, dim.offset_change, dim.stride, dim.shape, dim.step_delay,
+                              view->slides.iteration_counter});
+        }
+        offset += 1 + view->ndim;
+    }
+
+    // Repeat while the condition is true (if allocated)
+    const bool *cond = condition == nullptr ? nullptr : static_cast<const bool *>(condition->getDataPtr());
+
+    auto start_exec = chrono::steady_clock::now();
+    uint64_t iterations;
+    if (pool_runtime) {
+        const bh_pool_t pool{&EngineOpenMP::poolParallelFor, this, 0};
+        iterations = repeat->second.first(&data_list[0], &offset_and_strides[0], &constant_arg[0], &pool, nrepeats,
+                                          cond, slides.data(), slides.size());
+    } else {
+        iterations = repeat->second.first(&data_list[0], &offset_and_strides[0], &constant_arg[0], nullptr, nrepeats,
+                                          cond, slides.data(), slides.size());
+    }
+    auto texec = chrono::steady_clock::now() - start_exec;
+    stat.time_exec += texec;
+    repeat->second.second->register_exec_time(texec);
+    return iterations;
 }
 
 // Writes the OpenMP specific for-loop header
@@ -253,11 +546,23 @@ void EngineOpenMP::loopHeadWriter(const jitk::SymbolTable &symbols,
                                   const jitk::LoopB &block,
                                   const vector<uint64_t> &thread_stack,
                                   stringstream &out) {
+    // Streamed outputs are written to tile buffers, which `loopTailWriter()` streams to memory
+    const vector<const bh_view *> *stream = scope.streamOutputs(&block);
+    // The thread pool executes the outermost loop of a kernel written with a `thread_stack` in chunks, which
+    // range is given by the arguments of the execute function (see `writeKernel()`)
+    const bool pool_range = block.rank == 0 and not thread_stack.empty();
+
     // Let's write the OpenMP loop header
     int64_t for_loop_size = block.size;
     // No need to parallel one-sized loops
     if (for_loop_size > 1) {
-        writeHeader(symbols, scope, block, out);
+        if (stream == nullptr) {
+            writeHeader(symbols, scope, block, pool_range, out);
+        } else if (compiler_openmp and block.rank == 0 and openmp_compatible(block) and not pool_range) {
+            // NB: the tile loop goes in parallel and the "simd" goes to the loop inside the tile
+            out << "#pragma omp parallel for\n";
+            util::spaces(out, 4);
+        }
     }
     // Write the for-loop header
     string itername;
@@ -266,14 +571,71 @@ void EngineOpenMP::loopHeadWriter(const jitk::SymbolTable &symbols,
         t << "i" << block.rank;
         itername = t.str();
     }
-    out << "for(uint64_t " << itername << " = 0; ";
-    out << itername << " < " << block.size << "; ++" << itername << ") {\n";
+    if (stream != nullptr) {
+        const uint64_t tile = 1024;
+        const string begin = pool_range ? itername + "_begin" : "0";
+        const string end = pool_range ? itername + "_end" : std::to_string(block.size);
+        out << "for(uint64_t " << itername << "_tile = " << begin << "; " << itername << "_tile < " << end
+            << "; " << itername << "_tile += " << tile << ") {\n";
+        util::spaces(out, 8 + block.rank * 4);
+        out << "const uint64_t " << itername << "_tile_end = " << itername << "_tile + " << tile << " < " << end
+            << " ? " << itername << "_tile + " << tile << " : " << end << ";\n";
+        for (const bh_view *view: *stream) {
+            util::spaces(out, 8 + block.rank * 4);
+            out << writeType(view->base->dtype()) << " st" << symbols.baseID(view->base) << "[" << tile
+                << "] __attribute__((aligned(64)));\n";
+            scope.insertStreamed(view->base, block.rank);
+        }
+        util::spaces(out, 8 + block.rank * 4);
+        if (compiler_openmp_simd and simd_compatible(block, scope)) {
+            out << "#pragma omp simd\n";
+            util::spaces(out, 8 + block.rank * 4);
+        }
+        out << "for(uint64_t " << itername << " = " << itername << "_tile; " << itername << " < " << itername
+            << "_tile_end; ++" << itername << ") {\n";
+    } else if (pool_range) {
+        // The thread pool gives each chunk its own range of iterations
+        out << "for(uint64_t " << itername << " = " << itername << "_begin; ";
+        out << itername << " < " << itername << "_end; ++" << itername << ") {\n";
+    } else {
+        out << "for(uint64_t " << itername << " = 0; ";
+        out << itername << " < " << block.size << "; ++" << itername << ") {\n";
+    }
+}
+
+// Writes the streaming of the tile buffers of the streamed outputs of `block` and closes the tile loop
+void EngineOpenMP::loopTailWriter(const jitk::SymbolTable &symbols,
+                                  jitk::Scope &scope,
+                                  const jitk::LoopB &block,
+                                  stringstream &out) {
+    const vector<const bh_view *> *stream = scope.streamOutputs(&block);
+    if (stream == nullptr) {
+        return;
+    }
+    const string itername = "i" + std::to_string(block.rank);
+    for (const bh_view *view: *stream) {
+        const size_t id = symbols.baseID(view->base);
+        util::spaces(out, 8 + block.rank * 4);
+        out << "{\n";
+        util::spaces(out, 12 + block.rank * 4);
+        out << "const uint64_t " << itername << " = " << itername << "_tile;\n";
+        util::spaces(out, 12 + block.rank * 4);
+        out << "bh_stream(&a" << id << "[";
+        write_array_index(scope, *view, out);
+        out << "], st" << id << ", (" << itername << "_tile_end - " << itername << "_tile) * sizeof(st" << id
+            << "[0]));\n";
+        util::spaces(out, 8 + block.rank * 4);
+        out << "}\n";
+    }
+    util::spaces(out, 4 + block.rank * 4);
+    out << "}\n";
 }
 
 // Writing the OpenMP header, which include "parallel for" and "simd"
 void EngineOpenMP::writeHeader(const jitk::SymbolTable &symbols,
                                jitk::Scope &scope,
                                const jitk::LoopB &block,
+                               bool pool_range,
                                std::stringstream &out) {
     if (not compiler_openmp) {
         return;
@@ -287,8 +649,8 @@ void EngineOpenMP::writeHeader(const jitk::SymbolTable &symbols,
     const std::vector<jitk::InstrPtr> ordered_block_sweeps = order_sweep_set(block._sweeps, symbols);
 
     stringstream ss;
-    // "OpenMP for" goes to the outermost loop
-    if (block.rank == 0 and openmp_compatible(block)) {
+    // "OpenMP for" goes to the outermost loop unless the thread pool executes it
+    if (block.rank == 0 and openmp_compatible(block) and not pool_range) {
         ss << " parallel for";
         // Since we are doing parallel for, we should either do OpenMP reductions or protect the sweep instructions
         for (const jitk::InstrPtr &instr: ordered_block_sweeps) {
@@ -336,48 +698,149 @@ void EngineOpenMP::writeKernel(const LoopB &kernel,
 
     assert(kernel.rank == -1);
 
-    // Write the need includes
+    // Write the need includes. The math headers are only needed by kernels that call the math library.
+    bool use_math = false;
+    for (const InstrPtr &instr: jitk::iterator::allInstr(kernel)) {
+        if (uses_c99_math(*instr)) {
+            use_math = true;
+            break;
+        }
+    }
     ss << "#include <stdint.h>\n";
-    ss << "#include <stdlib.h>\n";
     ss << "#include <stdbool.h>\n";
-    ss << "#include <complex.h>\n";
-    ss << "#include <tgmath.h>\n";
-    ss << "#include <math.h>\n";
+    if (use_math) {
+        ss << math_includes;
+    } else if (not kernel_temps.empty()) { // For malloc() and free()
+        ss << "#include <stdlib.h>\n";
+    }
     if (symbols.useRandom()) { // Write the random function
         ss << "#include <kernel_dependencies/random123_openmp.h>\n";
     }
+    if (fast_math) {
+        ss << "#include <kernel_dependencies/vmath.h>\n";
+    }
+    // Should the thread pool execute the outermost loop in chunks?
+    const bool pool_kernel = pool_runtime and pool_compatible(kernel);
+    if (pool_kernel) {
+        ss << "#include <kernel_dependencies/thread_pool.h>\n";
+    }
+
+    // The innermost strides that are zero or one when the kernel is generated, which the unit-stride version
+    // of the kernel fixes to their values. The elements are the indexes in `offset_strides` and the values.
+    vector<pair<uint64_t, int64_t> > unit_strides;
+    // The offset-and-stride views that have their innermost stride fixed to one
+    std::set<const bh_view *> unit_views;
+    if (multi_versioning and symbols.strides_as_var and not kernel.isSystemOnly()) {
+        uint64_t count = 0;
+        for (const bh_view *view: symbols.offsetStrideViews()) {
+            if (view->ndim > 0 and not view->is_scalar()) {
+                const int64_t dim = view->ndim - 1;
+                if (view->shape[dim] > 1 and (view->stride[dim] == 0 or view->stride[dim] == 1)) {
+                    unit_strides.emplace_back(count + 1 + dim, view->stride[dim]);
+                    if (view->stride[dim] == 1) {
+                        unit_views.insert(view);
+                    }
+                }
+            }
+            count += 1 + view->ndim;
+        }
+    }
+
+    // The large outputs that the unit-stride version writes with non-temporal stores
+    std::map<const LoopB *, std::vector<const bh_view *> > stream_loops;
+    if (nontemporal_threshold > 0 and not unit_views.empty()) {
+        stream_loops = find_stream_outputs(kernel, symbols, unit_views, nontemporal_threshold);
+        if (not stream_loops.empty()) {
+            ss << "#include <kernel_dependencies/nontemporal.h>\n";
+        }
+    }
     writeUnionType(ss); // We always need to declare the union of all constant data types
     ss << "\n";
 
-    // Write the header of the execute function
-    ss << "void execute_" << codegen_hash;
-    writeKernelFunctionArguments(symbols, ss, nullptr);
+    // Writes the block that makes up the body of 'execute()' where the outputs in `streams` are streamed
+    auto write_body = [&](const std::map<const LoopB *, std::vector<const bh_view *> > &streams,
+                          stringstream &body) {
+        // Write allocations of the kernel temporaries
+        for (const bh_base *b: kernel_temps) {
+            util::spaces(body, 4);
+            body << writeType(b->dtype()) << " * __restrict__ a" << symbols.baseID(b) << " = malloc("
+                 << b->nbytes() << ");\n";
+        }
+        body << "\n";
+
+        // NB: the thread stack tells that the thread pool parallelizes the outermost loop
+        const vector<uint64_t> thread_stack =
+                pool_kernel ? vector<uint64_t>{static_cast<uint64_t>(kernel._block_list[0].getLoop().size)} :
+                              vector<uint64_t>{};
+        // The loops that stream their outputs are looked up through the scope of the kernel
+        jitk::Scope scope(symbols, nullptr);
+        for (const auto &stream: streams) {
+            scope.insertStreamLoop(stream.first, stream.second);
+        }
+        writeBlock(symbols, &scope, kernel, thread_stack, false, body);
 
-    // Write the block that makes up the body of 'execute()'
-    ss << "{\n";
-    // Write allocations of the kernel temporaries
-    for (const bh_base *b: kernel_temps) {
-        util::spaces(ss, 4);
-        ss << writeType(b->dtype()) << " * __restrict__ a" << symbols.baseID(b) << " = malloc(" << b->nbytes()
-           << ");\n";
+        // The streamed stores must be visible before the kernel returns
+        if (not streams.empty()) {
+            util::spaces(body, 4);
+            body << "bh_stream_fence();\n";
+        }
+
+        // Write frees of the kernel temporaries
+        body << "\n";
+        for (const bh_base *b: kernel_temps) {
+            util::spaces(body, 4);
+            body << "free(" << "a" << symbols.baseID(b) << ");\n";
+        }
+    };
+    stringstream body;
+    write_body({}, body);
+
+    // Write the arguments of the execute function
+    string args_str;
+    {
+        stringstream args;
+        writeKernelFunctionArguments(symbols, args, nullptr);
+        args_str = args.str();
+        if (pool_kernel) { // The range of the outermost loop goes last
+            args_str.insert(args_str.size() - 1, args_str == "()" ? "" : ", ");
+            args_str.insert(args_str.size() - 1, "uint64_t i0_begin, uint64_t i0_end");
+        }
     }
-    ss << "\n";
 
-    writeBlock(symbols, nullptr, kernel, {}, false, ss);
+    // Write the generic execute function
+    ss << "void execute_" << codegen_hash << args_str << "{\n" << body.str() << "}\n\n";
 
-    // Write frees of the kernel temporaries
-    ss << "\n";
-    for (const bh_base *b: kernel_temps) {
-        util::spaces(ss, 4);
-        ss << "free(" << "a" << symbols.baseID(b) << ");\n";
+    // Write the unit-stride execute function, which shadows the fixed strides with constants such that
+    // the compiler sees contiguous (or broadcast) accesses in the innermost loops
+    if (not unit_strides.empty()) {
+        ss << "void execute_unit_" << codegen_hash << args_str << "{\n";
+        ss << "{ // The strides fixed by the launcher\n";
+        uint64_t count = 0;
+        size_t next = 0;
+        for (const bh_view *view: symbols.offsetStrideViews()) {
+            for (int i = 0; i < view->ndim; ++i) {
+                if (next < unit_strides.size() and unit_strides[next].first == count + 1 + i) {
+                    util::spaces(ss, 4);
+                    ss << "const uint64_t vs" << symbols.offsetStridesID(*view) << "_" << i << " = "
+                       << unit_strides[next].second << ";\n";
+                    ++next;
+                }
+            }
+            count += 1 + view->ndim;
+        }
+        if (stream_loops.empty()) {
+            ss << body.str() << "}\n";
+        } else {
+            stringstream unit_body;
+            write_body(stream_loops, unit_body);
+            ss << unit_body.str() << "}\n";
+        }
+        ss << "}\n\n";
     }
-    ss << "}\n\n";
 
-    // Write the launcher function, which will convert the data_list of void pointers
-    // to typed arrays and call the execute function
-    {
-        ss << "void launcher_" << codegen_hash
-           << "(void* data_list[], uint64_t offset_strides[], union dtype constants[]) {\n";
+    // Writes the conversion of the `data_list` of void pointers to typed arrays and the call
+    // of the execute function. `extra_args` is appended to the arguments of the call.
+    auto write_execute_call = [&](const string &extra_args) {
         for (size_t i = 0; i < symbols.getParams().size(); ++i) {
             util::spaces(ss, 4);
             bh_base *b = symbols.getParams()[i];
@@ -385,9 +848,6 @@ void EngineOpenMP::writeKernel(const LoopB &kernel,
             ss << " = data_list[" << i << "];\n";
         }
 
-        util::spaces(ss, 4);
-        ss << "execute_" << codegen_hash << "(";
-
         // We create the comma separated list of args and saves it in `stmp`
         stringstream stmp;
         for (size_t i = 0; i < symbols.getParams().size(); ++i) {
@@ -410,17 +870,454 @@ void EngineOpenMP::writeKernel(const LoopB &kernel,
                 stmp << "constants[" << i++ << "]." << bh_type_text(instr->constant.type) << ", ";
             }
         }
+        if (not extra_args.empty()) {
+            stmp << extra_args << ", ";
+        }
 
-        // And then we write `stmp` into `ss` excluding the last comma
-        const string strtmp = stmp.str();
+        // And then we write `stmp` excluding the last comma
+        string strtmp = stmp.str();
         if (not strtmp.empty()) {
-            ss << strtmp.substr(0, strtmp.size() - 2);
+            strtmp.resize(strtmp.size() - 2);
         }
-        ss << ");\n";
+
+        // Call the unit-stride version when the fixed strides match
+        if (unit_strides.empty()) {
+            util::spaces(ss, 4);
+            ss << "execute_" << codegen_hash << "(" << strtmp << ");\n";
+        } else {
+            util::spaces(ss, 4);
+            ss << "if (";
+            for (size_t i = 0; i < unit_strides.size(); ++i) {
+                if (i > 0) {
+                    ss << " && ";
+                }
+                ss << "offset_strides[" << unit_strides[i].first << "] == " << unit_strides[i].second;
+            }
+            ss << ") {\n";
+            util::spaces(ss, 8);
+            ss << "execute_unit_" << codegen_hash << "(" << strtmp << ");\n";
+            util::spaces(ss, 4);
+            ss << "} else {\n";
+            util::spaces(ss, 8);
+            ss << "execute_" << codegen_hash << "(" << strtmp << ");\n";
+            util::spaces(ss, 4);
+            ss << "}\n";
+        }
+    };
+
+    // Write the launcher function, which will convert the data_list of void pointers
+    // to typed arrays and call the execute function
+    if (pool_kernel) {
+        const LoopB &loop = kernel._block_list[0].getLoop();
+
+        // The cost of one iteration of the outermost loop
+        uint64_t cost = 0;
+        for (const jitk::InstrPtr &instr: jitk::iterator::allInstr(loop)) {
+            if (not bh_opcode_is_system(instr->opcode)) {
+                cost += instr->shape().prod();
+            }
+        }
+        cost /= loop.size;
+
+        // The body of the thread pool executes a chunk of the iterations
+        ss << "static void body_" << codegen_hash << "(void *args, uint64_t i0_begin, uint64_t i0_end) {\n";
+        ss << "    void **data_list = ((bh_pool_args_t *) args)->data_list;\n";
+        ss << "    uint64_t *offset_strides = ((bh_pool_args_t *) args)->offset_strides;\n";
+        ss << "    union dtype *constants = ((bh_pool_args_t *) args)->constants;\n";
+        write_execute_call("i0_begin, i0_end");
+        ss << "}\n\n";
+
+        ss << "void launcher_" << codegen_hash
+           << "(void* data_list[], uint64_t offset_strides[], union dtype constants[], const bh_pool_t *pool) {\n";
+        ss << "    bh_pool_args_t args = {data_list, offset_strides, constants};\n";
+        ss << "    pool->parallel_for(pool, " << loop.size << ", " << cost << ", body_" << codegen_hash
+           << ", &args);\n";
+        ss << "}\n";
+    } else {
+        ss << "void launcher_" << codegen_hash
+           << "(void* data_list[], uint64_t offset_strides[], union dtype constants[], const void *pool) {\n";
+        write_execute_call("");
         ss << "}\n";
     }
 }
 
+void EngineOpenMP::loadAotLibrary() {
+    if (not generic_kernels or pool_runtime or aot_library.empty() or not fs::exists(aot_library)) {
+        return;
+    }
+    void *handle = dlopen(aot_library.string().c_str(), RTLD_NOW);
+    if (handle == nullptr) {
+        cerr << "Warning: cannot load the AOT kernel library: " << dlerror() << endl;
+        return;
+    }
+    // The kernels of the library must be compiled like the JIT kernels.
+    // NB: like the JIT kernels, we never close a library that is in use (see `~EngineOpenMP()`)
+    const uint64_t *hash = static_cast<const uint64_t *>(dlsym(handle, "bh_aot_compilation_hash"));
+    if (hash == nullptr or *hash != compilation_hash) {
+        if (verbose) {
+            cout << "Ignoring the AOT kernel library " << aot_library << ", which has another compile command" << endl;
+        }
+        dlclose(handle);
+        return;
+    }
+    _aot_handle = handle;
+    if (compiler_openmp and _omp_set_num_threads == nullptr) {
+        *(void **) (&_omp_set_num_threads) = dlsym(handle, "omp_set_num_threads");
+    }
+}
+
+void EngineOpenMP::writeGenericPreamble(std::stringstream &ss) {
+    ss << "#include <stdint.h>\n";
+    ss << "#include <stdbool.h>\n";
+    ss << math_includes;
+    if (fast_math) {
+        ss << "#include <kernel_dependencies/vmath.h>\n";
+    }
+    writeUnionType(ss);
+    ss << "\n";
+}
+
+void EngineOpenMP::writeGenericFunctions(const GenericKernel &kernel, const std::string &suffix,
+                                         std::stringstream &ss) {
+    const int rank = kernel.rank;
+    const bool reduction = kernel.axis >= 0;
+
+    // The instruction that `write_operation()` writes, which operands are views of dummy bases
+    std::deque<bh_base> bases;
+    bh_instruction instr;
+    instr.opcode = kernel.opcode;
+    vector<bh_type> array_types;
+    for (size_t i = 0; i < kernel.types.size(); ++i) {
+        if (static_cast<int>(i) == kernel.constant) {
+            instr.operand.emplace_back();
+            instr.constant = bh_constant(0, kernel.types[i]);
+        } else {
+            bases.emplace_back(1, kernel.types[i]);
+            instr.operand.emplace_back(&bases.back());
+            array_types.push_back(kernel.types[i]);
+        }
+    }
+    if (reduction) {
+        instr.operand.emplace_back();
+        instr.constant = bh_constant(static_cast<int64_t>(kernel.axis));
+    }
+
+    // Returns the element of the array operand `i` where `unit` fixes the innermost stride to one.
+    // NB: the output of a reduction has no reduced axis.
+    auto element = [&](size_t i, bool unit) {
+        stringstream out;
+        out << "a" << i << "[o" << i;
+        for (int d = 0; d < rank; ++d) {
+            if (i == 0 and d == kernel.axis) {
+                continue;
+            }
+            out << " + i" << d;
+            if (not (unit and d == rank - 1)) {
+                out << " * s" << i << "_" << d;
+            }
+        }
+        out << "]";
+        return out.str();
+    };
+    // Returns the operands of the operation
+    auto operands = [&](bool unit) {
+        vector<string> ops;
+        size_t array = 0;
+        for (size_t i = 0; i < kernel.types.size(); ++i) {
+            ops.push_back(static_cast<int>(i) == kernel.constant ? string("c") : element(array++, unit));
+        }
+        if (reduction) {
+            ops[0] = "acc";
+            ops.emplace_back("");
+        }
+        return ops;
+    };
+    // Writes the operation with the indentation `indent`
+    auto write_op = [&](const vector<string> &ops, int indent) {
+        util::spaces(ss, indent);
+        write_operation(instr, ops, ss, false, fast_math);
+    };
+    // Writes an OpenMP pragma with the indentation `indent` if `clauses` is not empty
+    auto write_pragma = [&](const string &clauses, int indent) {
+        if (not clauses.empty()) {
+            ss << "#pragma omp" << clauses << "\n";
+            util::spaces(ss, indent);
+        }
+    };
+    const string parallel = compiler_openmp ? " parallel for" : "";
+    const string simd = compiler_openmp_simd ? " simd" : "";
+    const string acc_type = reduction ? writeType(array_types[0]) : "";
+    const string red = reduction ? string(" reduction(") + openmp_reduce_symbol(kernel.opcode) + ":acc)" : "";
+
+    // The parameters of the execute functions and the matching arguments of the launcher
+    stringstream params, args;
+    uint64_t count = 0;
+    for (size_t i = 0; i < array_types.size(); ++i) {
+        params << writeType(array_types[i]) << " *a" << i << ", ";
+        args << "data_list[" << i << "], ";
+    }
+    for (int d = 0; d < rank; ++d) {
+        params << "int64_t n" << d << ", ";
+        args << "offset_strides[" << count++ << "], ";
+    }
+    // The positions of the innermost strides in `offset_strides` that the unit-stride version fixes to one
+    vector<uint64_t> unit_strides;
+    for (size_t i = 0; i < array_types.size(); ++i) {
+        params << "int64_t o" << i << ", ";
+        args << "offset_strides[" << count++ << "], ";
+        for (int d = 0; d < rank; ++d) {
+            if (d == rank - 1 and kernel.hasInnermostStride(i)) {
+                unit_strides.push_back(count);
+            }
+            params << "int64_t s" << i << "_" << d << ", ";
+            args << "offset_strides[" << count++ << "], ";
+        }
+    }
+    if (kernel.constant >= 0) {
+        params << writeType(kernel.types[kernel.constant]) << " c, ";
+        args << "constants[0]." << bh_type_text(kernel.types[kernel.constant]) << ", ";
+    }
+    string params_str = params.str(), args_str = args.str();
+    params_str.resize(params_str.size() - 2);
+    args_str.resize(args_str.size() - 2);
+
+    // Writes the execute function named `name` where `unit` fixes the innermost strides to one
+    auto write_execute = [&](const string &name, bool unit) {
+        ss << "void " << name << suffix << "(" << params_str << ") {\n";
+        util::spaces(ss, 4);
+        if (not reduction) {
+            if (rank == 1) {
+                write_pragma(parallel + simd, 4);
+                ss << "for(int64_t i0 = 0; i0 < n0; ++i0) {\n";
+                write_op(operands(unit), 8);
+            } else {
+                write_pragma(parallel, 4);
+                ss << "for(int64_t i0 = 0; i0 < n0; ++i0) {\n";
+                util::spaces(ss, 8);
+                write_pragma(simd, 8);
+                ss << "for(int64_t i1 = 0; i1 < n1; ++i1) {\n";
+                write_op(operands(unit), 12);
+                util::spaces(ss, 8);
+                ss << "}\n";
+            }
+            util::spaces(ss, 4);
+            ss << "}\n";
+        } else if (rank == 1) {
+            // The accumulator starts at the first element, which makes the identity of the operation unneeded
+            ss << acc_type << " acc = a1[o1];\n";
+            util::spaces(ss, 4);
+            write_pragma(parallel.empty() and simd.empty() ? "" : parallel + simd + red, 4);
+            ss << "for(int64_t i0 = 1; i0 < n0; ++i0) {\n";
+            write_op(operands(unit), 8);
+            util::spaces(ss, 4);
+            ss << "}\n";
+            util::spaces(ss, 4);
+            ss << "a0[o0] = acc;\n";
+        } else if (kernel.axis == 1) {
+            write_pragma(parallel, 4);
+            ss << "for(int64_t i0 = 0; i0 < n0; ++i0) {\n";
+            util::spaces(ss, 8);
+            ss << acc_type << " acc = a1[o1 + i0 * s1_0];\n";
+            util::spaces(ss, 8);
+            write_pragma(simd.empty() ? "" : simd + red, 8);
+            ss << "for(int64_t i1 = 1; i1 < n1; ++i1) {\n";
+            write_op(operands(unit), 12);
+            util::spaces(ss, 8);
+            ss << "}\n";
+            util::spaces(ss, 8);
+            ss << element(0, unit) << " = acc;\n";
+            util::spaces(ss, 4);
+            ss << "}\n";
+        } else {
+            // The columns are reduced in tiles, which accumulates into the output row by row
+            vector<string> ops = operands(unit);
+            ops[0] = element(0, unit);
+            const uint64_t tile = 512;
+            write_pragma(parallel, 4);
+            ss << "for(int64_t t1 = 0; t1 < n1; t1 += " << tile << ") {\n";
+            util::spaces(ss, 8);
+            ss << "const int64_t t1_end = t1 + " << tile << " < n1 ? t1 + " << tile << " : n1;\n";
+            util::spaces(ss, 8);
+            ss << "{\n";
+            util::spaces(ss, 12);
+            ss << "const int64_t i0 = 0;\n";
+            util::spaces(ss, 12);
+            write_pragma(simd, 12);
+            ss << "for(int64_t i1 = t1; i1 < t1_end; ++i1) {\n";
+            util::spaces(ss, 16);
+            ss << ops[0] << " = " << ops[1] << ";\n";
+            util::spaces(ss, 12);
+            ss << "}\n";
+            util::spaces(ss, 8);
+            ss << "}\n";
+            util::spaces(ss, 8);
+            ss << "for(int64_t i0 = 1; i0 < n0; ++i0) {\n";
+            util::spaces(ss, 12);
+            write_pragma(simd, 12);
+            ss << "for(int64_t i1 = t1; i1 < t1_end; ++i1) {\n";
+            write_op(ops, 16);
+            util::spaces(ss, 12);
+            ss << "}\n";
+            util::spaces(ss, 8);
+            ss << "}\n";
+            util::spaces(ss, 4);
+            ss << "}\n";
+        }
+        ss << "}\n\n";
+    };
+    write_execute("execute_generic", false);
+    if (multi_versioning) {
+        write_execute("execute_unit_generic", true);
+    }
+
+    // The launcher calls the unit-stride version when the innermost strides are one
+    ss << "void launcher_generic" << suffix
+       << "(void* data_list[], uint64_t offset_strides[], union dtype constants[], const void *pool) {\n";
+    if (multi_versioning) {
+        ss << "    if (";
+        for (size_t i = 0; i < unit_strides.size(); ++i) {
+            ss << (i > 0 ? " && " : "") << "offset_strides[" << unit_strides[i] << "] == 1";
+        }
+        ss << ") {\n";
+        ss << "        execute_unit_generic" << suffix << "(" << args_str << ");\n";
+        ss << "    } else {\n";
+        ss << "        execute_generic" << suffix << "(" << args_str << ");\n";
+        ss << "    }\n";
+    } else {
+        ss << "    execute_generic" << suffix << "(" << args_str << ");\n";
+    }
+    ss << "}\n";
+}
+
+std::pair<std::string, std::string> EngineOpenMP::writeGenericKernel(const GenericKernel &kernel) {
+    const string name = "_" + kernel.name();
+    stringstream draft;
+    writeGenericPreamble(draft);
+    writeGenericFunctions(kernel, name, draft);
+
+    const string suffix = name + "_" + std::to_string(util::hash(draft.str()));
+    stringstream ss;
+    writeGenericFunctions(kernel, suffix, ss);
+    return make_pair(ss.str(), "launcher_generic" + suffix);
+}
+
+const EngineOpenMP::GenericFunction &EngineOpenMP::getGenericFunction(const GenericKernel &kernel) {
+    const string name = kernel.name();
+    auto it = _generic_functions.find(name);
+    if (it != _generic_functions.end()) {
+        ++stat.kernel_cache_lookups;
+        return it->second;
+    }
+
+    const auto tcodegen = chrono::steady_clock::now();
+    const auto functions = writeGenericKernel(kernel);
+    stringstream ss;
+    writeGenericPreamble(ss);
+    ss << functions.first;
+    const string source = ss.str();
+    const uint64_t source_hash = util::hash(source);
+    stat.time_codegen += chrono::steady_clock::now() - tcodegen;
+
+    const auto tbuild = chrono::steady_clock::now();
+    GenericFunction ret;
+    ret.func = getFunction(source, source_hash, functions.second);
+    assert(ret.func != nullptr);
+    ret.filename = jitk::hash_filename(compilation_hash, source_hash, ".c");
+    stat.time_compile += chrono::steady_clock::now() - tbuild;
+    return _generic_functions.emplace(name, std::move(ret)).first->second;
+}
+
+jitk::EngineCPU::KernelLaunch EngineOpenMP::prepareGeneric(const bh_instruction &instr) {
+    // NB: the shape-generic kernels are parallelized by OpenMP
+    if (not generic_kernels or pool_runtime) {
+        return KernelLaunch();
+    }
+    GenericKernel kernel;
+    GenericArgs args;
+    if (not get_generic_kernel(instr, kernel, args)) {
+        return KernelLaunch();
+    }
+    // Large element-wise outputs are better off with the non-temporal stores of the generated kernels
+    const bh_view &out = instr.operand[0];
+    if (kernel.axis < 0 and nontemporal_threshold > 0 and
+        static_cast<uint64_t>(out.shape.prod() * bh_type_size(out.base->dtype())) >= nontemporal_threshold) {
+        return KernelLaunch();
+    }
+    const GenericFunction &func = getGenericFunction(kernel);
+
+    vector<void *> data_list;
+    for (bh_base *base: args.bases) {
+        bh_data_malloc(base);
+        data_list.push_back(base->getDataPtr());
+    }
+    vector<uint64_t> offset_strides = std::move(args.offset_strides);
+    vector<bh_constant_value> constants(1);
+    if (kernel.constant >= 0) {
+        constants[0] = instr.constant.value;
+    }
+
+    KernelFunction f = func.func;
+    auto set_num_threads = _omp_set_num_threads;
+    auto run = [f, set_num_threads, data_list, offset_strides, constants](int max_threads) mutable {
+        if (max_threads > 0 and set_num_threads != nullptr) {
+            set_num_threads(max_threads);
+        }
+        f(&data_list[0], &offset_strides[0], &constants[0], nullptr);
+    };
+    return {std::move(run), func.filename};
+}
+
+std::string EngineOpenMP::buildAotLibrary() {
+    stringstream ret;
+    if (aot_library.empty()) {
+        ret << "The AOT kernel library is disabled since `aot_library` is empty\n";
+        return ret.str();
+    }
+    if (pool_runtime) {
+        ret << "The AOT kernel library is unused by the `pool` parallel runtime\n";
+        return ret.str();
+    }
+
+    const vector<GenericKernel> kernels = aot_generic_kernels();
+    stringstream ss;
+    writeGenericPreamble(ss);
+    ss << "const uint64_t bh_aot_compilation_hash = " << compilation_hash << "ull;\n\n";
+    vector<string> launchers;
+    for (const GenericKernel &kernel: kernels) {
+        const auto functions = writeGenericKernel(kernel);
+        ss << functions.first << "\n";
+        launchers.push_back(functions.second);
+    }
+
+    // The library is up to date when it provides all the launchers
+    if (_aot_handle != nullptr) {
+        bool up_to_date = true;
+        for (const string &launcher: launchers) {
+            if (dlsym(_aot_handle, launcher.c_str()) == nullptr) {
+                up_to_date = false;
+                break;
+            }
+        }
+        if (up_to_date) {
+            ret << "The AOT kernel library " << aot_library << " is up to date (" << kernels.size() << " kernels)\n";
+            return ret.str();
+        }
+    }
+
+    // We compile into a temporary file and rename it, which never changes a library that is loaded
+    const auto tbuild = chrono::steady_clock::now();
+    if (aot_library.has_parent_path()) {
+        fs::create_directories(aot_library.parent_path());
+    }
+    const fs::path tmp_file = aot_library.string() + ".tmp";
+    compiler.compile(tmp_file, ss.str());
+    fs::rename(tmp_file, aot_library);
+    const chrono::duration<double> tcompile = chrono::steady_clock::now() - tbuild;
+    ret << "Compiled " << kernels.size() << " kernels into the AOT kernel library " << aot_library << " in "
+        << tcompile.count() << "s\n";
+    return ret.str();
+}
+
 std::string EngineOpenMP::info() const {
     stringstream ss;
     ss << std::boolalpha; // Printing true/false instead of 1/0
@@ -436,11 +1333,16 @@ std::string EngineOpenMP::info() const {
     ss << "  Codegen flags:\n";
     ss << "    OpenMP: " << comp.config.defaultGet<bool>("compiler_openmp", false) << "\n";
     ss << "    OpenMP+SIMD: " << comp.config.defaultGet<bool>("compiler_openmp_simd", false) << "\n";
+    ss << "    Parallel runtime: " << (pool_runtime ? "pool" : "openmp") << "\n";
+    ss << "    Math precision: " << (fast_math ? "fast" : "exact") << "\n";
+    ss << "    Shape-generic kernels: " << generic_kernels << "\n";
     ss << "    Index-as-var: " << comp.config.defaultGet<bool>("index_as_var", true) << "\n";
     ss << "    Strides-as-var: " << comp.config.defaultGet<bool>("strides_as_var", true) << "\n";
     ss << "    Const-as-var: " << comp.config.defaultGet<bool>("const_as_var", true) << "\n";
 
     ss << "  JIT Command: \"" << compiler.cmd_template << "\"\n";
+    ss << "  Precompiled header: " << compiler_pch << "\n";
+    ss << "  AOT kernel library: " << (_aot_handle != nullptr ? aot_library.string() : "NONE") << "\n";
     return ss.str();
 }
 
@@ -470,9 +1372,9 @@ const std::string EngineOpenMP::writeType(bh_type dtype) {
         case bh_type::FLOAT64:
             return "double";
         case bh_type::COMPLEX64:
-            return "float complex";
+            return "float _Complex"; // NB: the keyword rather than the macro of <complex.h>
         case bh_type::COMPLEX128:
-            return "double complex";
+            return "double _Complex";
         case bh_type::R123:
             return "r123_t"; // Defined by `write_c99_dtype_union()`
         default:
@@ -23,8 +23,11 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <boost/filesystem.hpp>
 
+#include <bohrium/bh_util.hpp>
 #include <bohrium/bh_config_parser.hpp>
 #include <bohrium/jitk/statistics.hpp>
 #include <bohrium/jitk/block.hpp>
@@ -33,50 +36,175 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <bohrium/jitk/codegen_util.hpp>
 #include <bohrium/jitk/codegen_cache.hpp>
 
+#include <bohrium/jitk/thread_pool.hpp>
 #include <bohrium/jitk/engines/engine_cpu.hpp>
+#include <bohrium/jitk/kernel_dependencies/thread_pool.h>
+#include <bohrium/jitk/kernel_dependencies/repeat.h>
+
+#include "generic_kernel.hpp"
 
 namespace bohrium {
 
-typedef void (*KernelFunction)(void* data_list[], uint64_t offset_strides[], bh_constant_value constants[]);
+// NB: `pool` is the handle of the thread pool when using the `pool` parallel runtime, else it is NULL
+typedef void (*KernelFunction)(void* data_list[], uint64_t offset_strides[], bh_constant_value constants[],
+                               const bh_pool_t *pool);
 typedef void (*UserKernelFunction)(void* data_list[]);
+// Executes the launcher `nrepeats` times, or until `condition` is false, and returns the number of iterations
+typedef uint64_t (*RepeatKernelFunction)(void* data_list[], uint64_t offset_strides[], bh_constant_value constants[],
+                                         const bh_pool_t *pool, uint64_t nrepeats, const bool *condition,
+                                         const bh_slide_t slides[], uint64_t nslides);
 
 class EngineOpenMP : public jitk::EngineCPU {
 private:
     std::map<uint64_t, KernelFunction> _functions;
+
+    // The launch descriptor of a compiled kernel. It holds everything needed to launch the kernel again
+    // including argument buffers that are reused between launches.
+    struct LaunchDescriptor {
+        KernelFunction func;
+        // The statistics of the kernel (an element in `stat.time_per_kernel`)
+        jitk::KernelStats *stats;
+        std::vector<void *> data_list;
+        std::vector<uint64_t> offset_strides;
+        std::vector<bh_constant_value> constants;
+    };
+    // Launch descriptors by the hash of the kernel source
+    std::unordered_map<uint64_t, LaunchDescriptor> _launches;
+    // The repeat functions and their statistics by the hash of the kernel source
+    std::unordered_map<uint64_t, std::pair<RepeatKernelFunction, jitk::KernelStats *> > _repeats;
     std::vector<void*> _lib_handles;
 
     // The compiler to use when function doesn't exist
     const jitk::Compiler compiler;
+    // Compile the headers of the kernels that call the math library once into a precompiled header?
+    const bool compiler_pch;
+    // The compile command that includes the precompiled header, which is empty if it couldn't be built
+    std::string _pch_cmd;
+    // Set when the build of the precompiled header has been attempted
+    bool _pch_built = false;
 
     // Generate OpenMP code?
     const bool compiler_openmp;
     // Generate SIMD code?
     const bool compiler_openmp_simd;
+    // Generate a version of the kernels with the innermost strides fixed to their unit values next to the
+    // generic version, which the launcher selects when the strides match
+    const bool multi_versioning;
+    // The `omp_set_num_threads()` of the OpenMP runtime the kernels are linked with (if any)
+    void (*_omp_set_num_threads)(int) = nullptr;
+
+    // Use the thread pool (the `pool` parallel runtime) rather than OpenMP to parallelize the outermost loops?
+    const bool pool_runtime;
+    // Number of threads of the `pool` parallel runtime including the calling thread
+    const uint64_t pool_threads;
+    // Outermost loops that cost less than this threshold are executed in serial
+    const uint64_t pool_serial_threshold;
+    // The minimum cost of a chunk of iterations
+    const uint64_t pool_grain;
+
+    // Execute single instructions using shape-generic kernels rather than kernels generated for their shapes?
+    const bool generic_kernels;
+    // The path to the library of ahead-of-time compiled shape-generic kernels
+    const boost::filesystem::path aot_library;
+    // The handle of the AOT kernel library or nullptr when it isn't loaded
+    void *_aot_handle = nullptr;
+
+    // A compiled shape-generic kernel
+    struct GenericFunction {
+        KernelFunction func;
+        // The source filename of the kernel, which is the key of `Statistics::time_per_kernel`
+        std::string filename;
+    };
+    // The compiled shape-generic kernels by the name of their signature
+    std::unordered_map<std::string, GenericFunction> _generic_functions;
+
+    // Build the precompiled header of the math headers and set `_pch_cmd` on success
+    void buildPrecompiledHeader();
+
+    // Return the default compile command of the kernel in `source`
+    const std::string &compileCommand(const std::string &source);
+
+    // Load the AOT kernel library if it exists and matches the compile command
+    void loadAotLibrary();
+
+    // Write the includes and types that the functions of shape-generic kernels require
+    void writeGenericPreamble(std::stringstream &ss);
+
+    // Write the functions of the shape-generic `kernel`, which names end with `suffix`
+    void writeGenericFunctions(const GenericKernel &kernel, const std::string &suffix, std::stringstream &ss);
+
+    // Return the functions of the shape-generic `kernel` and the name of its launcher. The function names end with
+    // a hash of their source thus a stale AOT kernel library never provides the launcher.
+    std::pair<std::string, std::string> writeGenericKernel(const GenericKernel &kernel);
+
+    // Return the compiled shape-generic `kernel`, which is taken from the AOT kernel library or compiled
+    const GenericFunction &getGenericFunction(const GenericKernel &kernel);
+
+    // The `parallel_for()` of the `bh_pool_t` handle, which splits the iterations into chunks
+    static void poolParallelFor(const bh_pool_t *pool, uint64_t size, uint64_t cost, bh_pool_body_t body,
+                                void *args);
+
+    // Return the launch descriptor of the kernel in `source`, which is compiled if not already compiled
+    LaunchDescriptor &getLaunchDescriptor(const jitk::CodegenCache::Source &source, uint64_t codegen_hash);
+
+    // Call the launcher function of `desc` with the given arguments
+    void launch(const LaunchDescriptor &desc, void *data_list[], uint64_t offset_strides[],
+                bh_constant_value constants[]);
 
 public:
     // Return a kernel function based on the given 'source' and the name of the kernel function
     KernelFunction getFunction(const std::string &source, const std::string &func_name,
+                               const std::string &compile_cmd = "") {
+        return getFunction(source, util::hash(source), func_name, compile_cmd);
+    }
+
+    // Return a kernel function based on the given 'source', which hash is `source_hash`, and the name of
+    // the kernel function
+    KernelFunction getFunction(const std::string &source, uint64_t source_hash, const std::string &func_name,
                                const std::string &compile_cmd = "");
 
     EngineOpenMP(component::ComponentVE &comp, jitk::Statistics &stat);
 
     ~EngineOpenMP() override;
 
+    KernelLaunch prepare(const jitk::SymbolTable &symbols,
+                         const jitk::CodegenCache::Source &source,
+                         uint64_t codegen_hash,
+                         const std::vector<const bh_instruction*> &constants) override;
+
+    // Execute the kernel using its launch descriptor, which makes repeated executions cheap
     void execute(const jitk::SymbolTable &symbols,
-                 const std::string &source,
+                 const jitk::CodegenCache::Source &source,
                  uint64_t codegen_hash,
                  const std::vector<const bh_instruction*> &constants) override;
 
+    void execute(const jitk::CodegenCache::Source &source, uint64_t codegen_hash, KernelArgs &args) override;
+
+    KernelLaunch prepareGeneric(const bh_instruction &instr) override;
+
+    // Compile the shape-generic kernels of the common instructions into the AOT kernel library at `aot_library`
+    // unless it is up to date. Returns a description of the outcome.
+    std::string buildAotLibrary();
+
+    uint64_t executeRepeat(const jitk::SymbolTable &symbols,
+                           const jitk::CodegenCache::Source &source,
+                           uint64_t codegen_hash,
+                           const std::vector<const bh_instruction*> &constants,
+                           uint64_t nrepeats,
+                           bh_base *condition) override;
+
     void writeKernel(const jitk::LoopB &kernel,
                      const jitk::SymbolTable &symbols,
                      const std::vector<bh_base *> &kernel_temps,
                      uint64_t codegen_hash,
                      std::stringstream &ss) override;
 
-     // Writing the OpenMP header, which include "parallel for" and "simd"
+     // Writing the OpenMP header, which include "parallel for" and "simd". The outermost loop goes in parallel
+     // unless `pool_range` i.e. the thread pool executes it in chunks.
     void writeHeader(const jitk::SymbolTable &symbols,
                      jitk::Scope &scope,
                      const jitk::LoopB &block,
+                     bool pool_range,
                      std::stringstream &out);
 
     void loopHeadWriter(const jitk::SymbolTable &symbols,
@@ -85,6 +213,11 @@ public:
                         const std::vector<uint64_t> &thread_stack,
                         std::stringstream &out) override;
 
+    void loopTailWriter(const jitk::SymbolTable &symbols,
+                        jitk::Scope &scope,
+                        const jitk::LoopB &block,
+                        std::stringstream &out) override;
+
     // Return a YAML string describing this component
     std::string info() const override;
 
@@ -0,0 +1,268 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cctype>
+
+#include <bohrium/bh_opcode.h>
+#include "generic_kernel.hpp"
+
+using namespace std;
+
+namespace bohrium {
+
+namespace {
+// Returns `text` in lower case without the "BH_" prefix
+string c_name(const char *text) {
+    string ret(text);
+    if (ret.compare(0, 3, "BH_") == 0) {
+        ret.erase(0, 3);
+    }
+    std::transform(ret.begin(), ret.end(), ret.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ret;
+}
+
+// Is `opcode` a reduction that the OpenMP `reduction` clause supports
+bool reduce_supported(bh_opcode opcode) {
+    switch (opcode) {
+        case BH_ADD_REDUCE:
+        case BH_MULTIPLY_REDUCE:
+        case BH_MINIMUM_REDUCE:
+        case BH_MAXIMUM_REDUCE:
+        case BH_BITWISE_AND_REDUCE:
+        case BH_BITWISE_OR_REDUCE:
+        case BH_BITWISE_XOR_REDUCE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Find the kernel of the element-wise `instr`
+bool get_elementwise(const bh_instruction &instr, GenericKernel &kernel, GenericArgs &args) {
+    // All array operands have the same shape
+    const bh_view &out = instr.operand[0];
+    vector<const bh_view *> views;
+    for (const bh_view &view: instr.operand) {
+        if (not view.isConstant()) {
+            if (view.ndim != out.ndim or view.shape != out.shape) {
+                return false;
+            }
+            // Overlapping views of the output would race when the loops are parallel
+            if (view.base == out.base and not (view == out)) {
+                return false;
+            }
+            views.push_back(&view);
+        }
+    }
+
+    // Let's drop the dimensions of size one and collapse the dimensions that are contiguous in all views
+    vector<int64_t> shape;
+    vector<vector<int64_t> > strides(views.size());
+    for (int64_t d = 0; d < out.ndim; ++d) {
+        if (out.shape[d] == 1) {
+            continue;
+        }
+        bool contiguous = not shape.empty();
+        for (size_t i = 0; i < views.size() and contiguous; ++i) {
+            contiguous = strides[i].back() == views[i]->stride[d] * out.shape[d];
+        }
+        if (contiguous) {
+            shape.back() *= out.shape[d];
+            for (size_t i = 0; i < views.size(); ++i) {
+                strides[i].back() = views[i]->stride[d];
+            }
+        } else {
+            shape.push_back(out.shape[d]);
+            for (size_t i = 0; i < views.size(); ++i) {
+                strides[i].push_back(views[i]->stride[d]);
+            }
+        }
+    }
+    if (shape.empty()) {
+        shape.push_back(1);
+        for (vector<int64_t> &s: strides) {
+            s.push_back(0);
+        }
+    }
+    if (shape.size() > 2) {
+        return false;
+    }
+
+    kernel.rank = static_cast<int>(shape.size());
+    args.offset_strides.assign(shape.begin(), shape.end());
+    for (size_t i = 0; i < views.size(); ++i) {
+        args.bases.push_back(views[i]->base);
+        args.offset_strides.push_back(static_cast<uint64_t>(views[i]->start));
+        args.offset_strides.insert(args.offset_strides.end(), strides[i].begin(), strides[i].end());
+    }
+    return true;
+}
+
+// Find the kernel of the reduction `instr`
+bool get_reduction(const bh_instruction &instr, GenericKernel &kernel, GenericArgs &args) {
+    const bh_view &out = instr.operand[0];
+    const bh_view &in = instr.operand[1];
+    const int64_t axis = instr.sweep_axis();
+    if (in.isConstant() or out.base == in.base or in.ndim < 1 or in.ndim > 2 or axis < 0 or axis >= in.ndim or
+        in.shape[axis] < 1) {
+        return false;
+    }
+    // The output has the shape of the input without the reduced axis
+    vector<int64_t> out_strides(in.ndim, 0);
+    if (in.ndim == 1) {
+        if (out.shape.prod() != 1) {
+            return false;
+        }
+    } else {
+        const int64_t other = 1 - axis;
+        if (out.ndim != 1 or out.shape[0] != in.shape[other]) {
+            return false;
+        }
+        out_strides[other] = out.stride[0];
+    }
+
+    kernel.rank = static_cast<int>(in.ndim);
+    kernel.axis = static_cast<int>(axis);
+    args.offset_strides.assign(in.shape.begin(), in.shape.begin() + in.ndim);
+    args.bases = {out.base, in.base};
+    args.offset_strides.push_back(static_cast<uint64_t>(out.start));
+    args.offset_strides.insert(args.offset_strides.end(), out_strides.begin(), out_strides.end());
+    args.offset_strides.push_back(static_cast<uint64_t>(in.start));
+    args.offset_strides.insert(args.offset_strides.end(), in.stride.begin(), in.stride.begin() + in.ndim);
+    return true;
+}
+
+// Add the kernels of `opcode` over the type signatures in `type_list` to `out`. The signatures of element-wise
+// opcodes are added in rank 1 and 2 and, if `with_constants`, with each input as the constant.
+void add_kernels(bh_opcode opcode, const vector<vector<bh_type> > &type_list, bool with_constants,
+                 vector<GenericKernel> &out) {
+    for (const vector<bh_type> &types: type_list) {
+        GenericKernel kernel;
+        kernel.opcode = opcode;
+        kernel.types = types;
+        if (bh_opcode_is_reduction(opcode)) {
+            for (const pair<int, int> &rank_and_axis: {make_pair(1, 0), make_pair(2, 0), make_pair(2, 1)}) {
+                kernel.rank = rank_and_axis.first;
+                kernel.axis = rank_and_axis.second;
+                out.push_back(kernel);
+            }
+            continue;
+        }
+        for (int rank = 1; rank <= 2; ++rank) {
+            kernel.rank = rank;
+            for (int constant = -1; constant < static_cast<int>(types.size()); ++constant) {
+                if (constant == 0 or (constant > 0 and not with_constants)) {
+                    continue;
+                }
+                kernel.constant = constant;
+                out.push_back(kernel);
+            }
+        }
+    }
+}
+}
+
+string GenericKernel::name() const {
+    string ret = c_name(bh_opcode_text(opcode));
+    for (size_t i = 0; i < types.size(); ++i) {
+        ret += static_cast<int>(i) == constant ? "_c" : "_";
+        ret += c_name(bh_type_text(types[i]));
+    }
+    ret += "_r" + std::to_string(rank);
+    if (axis >= 0) {
+        ret += "_a" + std::to_string(axis);
+    }
+    return ret;
+}
+
+bool get_generic_kernel(const bh_instruction &instr, GenericKernel &kernel, GenericArgs &args) {
+    const bool reduction = bh_opcode_is_reduction(instr.opcode);
+    if (reduction ? not reduce_supported(instr.opcode) : not bh_opcode_is_elementwise(instr.opcode)) {
+        return false;
+    }
+    if (instr.operand.size() < 2 or instr.operand[0].isConstant() or instr.operand[0].ndim < 1) {
+        return false;
+    }
+
+    kernel = GenericKernel();
+    args = GenericArgs();
+    kernel.opcode = instr.opcode;
+    const size_t num_operands = reduction ? 2 : instr.operand.size();
+    for (size_t i = 0; i < num_operands; ++i) {
+        const bh_type type = instr.operand_type(static_cast<int>(i));
+        // Random123 needs the element index and the reductions of complex and boolean types have no OpenMP clause
+        if (type == bh_type::R123 or (reduction and (bh_type_is_complex(type) or type == bh_type::BOOL))) {
+            return false;
+        }
+        if (instr.operand[i].isConstant()) {
+            kernel.constant = static_cast<int>(i);
+        }
+        kernel.types.push_back(type);
+    }
+    return reduction ? get_reduction(instr, kernel, args) : get_elementwise(instr, kernel, args);
+}
+
+vector<GenericKernel> aot_generic_kernels() {
+    const bh_type B = bh_type::BOOL, F = bh_type::FLOAT32, D = bh_type::FLOAT64, I = bh_type::INT32,
+                  L = bh_type::INT64;
+    vector<GenericKernel> ret;
+
+    // Arithmetic on the common types
+    for (bh_opcode opcode: {BH_ADD, BH_SUBTRACT, BH_MULTIPLY, BH_DIVIDE, BH_POWER, BH_MOD, BH_MAXIMUM, BH_MINIMUM}) {
+        add_kernels(opcode, {{F, F, F}, {D, D, D}, {I, I, I}, {L, L, L}}, true, ret);
+    }
+    for (bh_opcode opcode: {BH_GREATER, BH_GREATER_EQUAL, BH_LESS, BH_LESS_EQUAL, BH_EQUAL, BH_NOT_EQUAL}) {
+        add_kernels(opcode, {{B, F, F}, {B, D, D}, {B, I, I}, {B, L, L}}, true, ret);
+    }
+    for (bh_opcode opcode: {BH_BITWISE_AND, BH_BITWISE_OR, BH_BITWISE_XOR, BH_LEFT_SHIFT, BH_RIGHT_SHIFT}) {
+        add_kernels(opcode, {{I, I, I}, {L, L, L}}, true, ret);
+    }
+    add_kernels(BH_ARCTAN2, {{F, F, F}, {D, D, D}}, true, ret);
+
+    // Math functions
+    for (bh_opcode opcode: {BH_COS, BH_SIN, BH_TAN, BH_COSH, BH_SINH, BH_TANH, BH_ARCSIN, BH_ARCCOS, BH_ARCTAN,
+                            BH_EXP, BH_EXP2, BH_EXPM1, BH_LOG, BH_LOG2, BH_LOG10, BH_LOG1P, BH_SQRT, BH_CEIL,
+                            BH_TRUNC, BH_FLOOR, BH_RINT}) {
+        add_kernels(opcode, {{F, F}, {D, D}}, false, ret);
+    }
+    for (bh_opcode opcode: {BH_ABSOLUTE, BH_SIGN}) {
+        add_kernels(opcode, {{F, F}, {D, D}, {I, I}, {L, L}}, false, ret);
+    }
+    add_kernels(BH_INVERT, {{I, I}, {L, L}}, false, ret);
+    for (bh_opcode opcode: {BH_ISNAN, BH_ISINF, BH_ISFINITE}) {
+        add_kernels(opcode, {{B, F}, {B, D}}, false, ret);
+    }
+
+    // Copies and conversions, which includes fills from a constant
+    for (bh_type t0: {B, F, D, I, L}) {
+        for (bh_type t1: {B, F, D, I, L}) {
+            add_kernels(BH_IDENTITY, {{t0, t1}}, true, ret);
+        }
+    }
+
+    // Reductions
+    for (bh_opcode opcode: {BH_ADD_REDUCE, BH_MULTIPLY_REDUCE, BH_MINIMUM_REDUCE, BH_MAXIMUM_REDUCE}) {
+        add_kernels(opcode, {{F, F}, {D, D}, {I, I}, {L, L}}, false, ret);
+    }
+    return ret;
+}
+
+} // bohrium
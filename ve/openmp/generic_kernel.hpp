@@ -0,0 +1,77 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <bohrium/bh_instruction.hpp>
+
+namespace bohrium {
+
+/** The signature of a shape-generic kernel, which executes a single instruction on views of any shape, strides,
+ * and offsets of a given rank. Since the loop sizes, offsets, and strides are arguments rather than baked into
+ * the source, one compiled kernel serves all instructions of the signature, which makes it possible to compile
+ * the kernels of common instructions ahead of time.
+ */
+struct GenericKernel {
+    bh_opcode opcode = BH_NONE;
+    // The types of the operands (the type of the constant for the constant operand) excluding the axis of a reduction
+    std::vector<bh_type> types;
+    // The position of the constant operand or -1
+    int constant = -1;
+    // The rank of the iteration space (1 or 2)
+    int rank = 0;
+    // The reduced axis or -1 when the instruction is element-wise
+    int axis = -1;
+
+    /// Returns true when the array operand `i` has a stride in the innermost dimension of the iteration space
+    bool hasInnermostStride(size_t i) const {
+        return not (i == 0 and axis == rank - 1);
+    }
+
+    /// Returns a C identifier that is unique for the signature e.g. "add_float64_float64_cfloat64_r1"
+    std::string name() const;
+};
+
+/// The arguments of a shape-generic kernel
+struct GenericArgs {
+    // The bases of the array operands
+    std::vector<bh_base *> bases;
+    // The loop sizes followed by the offset and `rank` strides of each array operand. The stride of the reduced
+    // axis of the output of a reduction is zero.
+    std::vector<uint64_t> offset_strides;
+};
+
+/** Find the shape-generic kernel that executes `instr`.
+ * Element-wise instructions have the dimensions that are contiguous in all operands collapsed, thus views of
+ * any rank might fit a rank 1 or 2 kernel.
+ *
+ * @param instr   The instruction
+ * @param kernel  The signature of the kernel (output)
+ * @param args    The arguments of the kernel (output)
+ * @return        False when no shape-generic kernel applies to `instr`
+ */
+bool get_generic_kernel(const bh_instruction &instr, GenericKernel &kernel, GenericArgs &args);
+
+/// Returns the signatures of the common instructions, which are the kernels of the AOT kernel library
+std::vector<GenericKernel> aot_generic_kernels();
+
+} // bohrium
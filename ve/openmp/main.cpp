@@ -81,6 +81,8 @@ public:
             return ss.str();
         } else if (msg == "info") {
             ss << engine.info();
+        } else if (msg == "openmp_aot_build") {
+            ss << engine.buildAotLibrary();
         }
         return ss.str();
     }
@@ -150,6 +152,13 @@ Impl::~Impl() {
 }
 
 void Impl::execute(BhIR *bhir) {
+    // Repeats that fit in a single kernel execute all iterations within one kernel launch. Otherwise, the first
+    // iteration uses the kernels that the attempt fused (if any).
+    vector<LoopB> kernel_list;
+    if (engine.handleRepeat(bhir, kernel_list)) {
+        return;
+    }
+
     bh_base *cond = bhir->getRepeatCondition();
 
     for (uint64_t i = 0; i < bhir->getNRepeats(); ++i) {
@@ -157,7 +166,8 @@ void Impl::execute(BhIR *bhir) {
         engine.handleExtmethod(bhir);
 
         // And then the regular instructions
-        engine.handleExecution(bhir);
+        engine.handleExecution(bhir, std::move(kernel_list));
+        kernel_list.clear();
 
         // Check condition
         if (cond != nullptr and cond->getDataPtr() != nullptr and not((bool *) cond->getDataPtr())[0]) {
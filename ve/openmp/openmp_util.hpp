@@ -20,8 +20,14 @@ If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <bohrium/bh_opcode.h>
+#include <bohrium/bh_util.hpp>
 #include <bohrium/jitk/symbol_table.hpp>
 #include <bohrium/jitk/iterator.hpp>
+#include <bohrium/jitk/scope.hpp>
+
+#include <map>
+#include <set>
+#include <vector>
 
 // Return the OpenMP reduction symbol
 const char* openmp_reduce_symbol(bh_opcode opcode) {
@@ -61,6 +67,16 @@ bool openmp_compatible(const bohrium::jitk::LoopB &block) {
     return true;
 }
 
+// Is the outermost loop of the 'kernel' executable in chunks by the thread pool of the `pool` parallel runtime.
+// For now, the kernel must consist of one loop that does not sweep its own axis.
+bool pool_compatible(const bohrium::jitk::LoopB &kernel) {
+    if (kernel._block_list.size() != 1 or kernel._block_list[0].isInstr()) {
+        return false;
+    }
+    const bohrium::jitk::LoopB &loop = kernel._block_list[0].getLoop();
+    return loop.size > 1 and loop._sweeps.empty() and not loop.isSystemOnly();
+}
+
 // Is the 'block' compatible with OpenMP SIMD
 bool simd_compatible(const bohrium::jitk::LoopB &block,
                      const bohrium::jitk::Scope &scope) {
@@ -92,3 +108,69 @@ bool openmp_atomic_compatible(bh_opcode opcode) {
             return false;
     }
 }
+
+// Collect the innermost loops of 'block' into 'out'
+void collect_innermost_loops(const bohrium::jitk::LoopB &block, std::vector<const bohrium::jitk::LoopB *> &out) {
+    if (block.isInnermost()) {
+        out.push_back(&block);
+        return;
+    }
+    for (const bohrium::jitk::Block &b: block._block_list) {
+        if (not b.isInstr()) {
+            collect_innermost_loops(b.getLoop(), out);
+        }
+    }
+}
+
+// Find the outputs of the innermost loops of 'kernel' that should be written with non-temporal stores.
+// An output qualifies when an element-wise instruction constructs it, it is a parameter of the kernel (not a
+// temporary array), the kernel accesses it nowhere else, it is at least 'threshold' bytes, and its stride in the
+// innermost dimension is fixed to one. 'unit_views' are the offset-and-stride views with a stride fixed to one.
+// Returns the outputs of each innermost loop.
+std::map<const bohrium::jitk::LoopB *, std::vector<const bh_view *> >
+find_stream_outputs(const bohrium::jitk::LoopB &kernel, const bohrium::jitk::SymbolTable &symbols,
+                    const std::set<const bh_view *> &unit_views, uint64_t threshold) {
+    using namespace bohrium::jitk;
+    std::map<const LoopB *, std::vector<const bh_view *> > ret;
+
+    // The number of accesses of each base in the kernel
+    std::map<const bh_base *, int> accesses;
+    for (const InstrPtr &instr: iterator::allInstr(kernel)) {
+        for (const bh_view &view: instr->getViews()) {
+            ++accesses[view.base];
+        }
+    }
+    const std::set<const bh_base *> params(symbols.getParams().begin(), symbols.getParams().end());
+
+    std::vector<const LoopB *> loops;
+    collect_innermost_loops(kernel, loops);
+    for (const LoopB *loop: loops) {
+        // NB: small loops would stream mostly unaligned cache lines
+        if (loop->rank < 0 or loop->size < 256 or not loop->_sweeps.empty()) {
+            continue;
+        }
+        for (const InstrPtr &instr: iterator::allLocalInstr(*loop)) {
+            const bh_opcode opcode = instr->opcode;
+            if (instr->operand.empty() or not instr->constructor or bh_opcode_is_system(opcode) or
+                bh_opcode_is_sweep(opcode) or opcode == BH_GATHER or opcode == BH_SCATTER or
+                opcode == BH_COND_SCATTER) {
+                continue;
+            }
+            const bh_view &view = instr->operand[0];
+            if (view.ndim != loop->rank + 1 or view.is_scalar() or accesses[view.base] != 1 or
+                not util::exist(params, view.base) or symbols.isAlwaysArray(view.base)) {
+                continue;
+            }
+            if (static_cast<uint64_t>(view.shape.prod() * bh_type_size(view.base->dtype())) < threshold) {
+                continue;
+            }
+            if (not symbols.existOffsetStridesID(view) or
+                not util::exist(unit_views, symbols.offsetStrideViews()[symbols.offsetStridesID(view)])) {
+                continue;
+            }
+            ret[loop].push_back(&view);
+        }
+    }
+    return ret;
+}
+
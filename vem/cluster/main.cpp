@@ -0,0 +1,927 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <boost/algorithm/string.hpp>
+#include <bohrium/bh_component.hpp>
+#include <bohrium/bh_main_memory.hpp>
+#include <bohrium/bh_util.hpp>
+
+#include "../proxy/serialize.hpp"
+#include "../proxy/comm.hpp"
+#include "../proxy/compression.hpp"
+#include "../proxy/batch_cache.hpp"
+#include "partition.hpp"
+
+using namespace bohrium;
+using namespace component;
+using namespace std;
+
+namespace {
+
+// A worker process, which is a proxy backend that executes the instructions of one shard
+struct Shard {
+    std::unique_ptr<CommFrontend> comm;
+    std::set<bh_base *> known_base_arrays;
+    BhIRViewDict view_dict;
+    BatchCacheFrontend batch_cache;
+    // The instructions that have not been sent yet
+    std::vector<bh_instruction> pending;
+    // Base arrays of this shard that point to the data of a parent base array until their data has been sent
+    std::vector<bh_base *> borrowed;
+};
+
+// A base array of the parent, which the shards hold
+struct DistBase {
+    ShardLayout layout;
+    // The base array of each shard, which is the ID of the array at the shard (nullptr when its block is empty)
+    std::vector<std::unique_ptr<bh_base> > local;
+};
+
+// A range of elements of a base array of a shard, which the parent fetches
+struct Piece {
+    int shard;
+    bh_base *local;
+    int64_t start;
+    int64_t nelem;
+
+    bool operator<(const Piece &other) const {
+        return std::tie(shard, local, start, nelem) < std::tie(other.shard, other.local, other.start, other.nelem);
+    }
+};
+
+// Returns true when `opcode` writes every element of its output view. Notice, scatters only write the elements
+// that their index selects.
+bool writesWholeOutput(bh_opcode opcode) {
+    return bh_opcode_is_elementwise(opcode) or bh_opcode_is_sweep(opcode) or opcode == BH_RANDOM or
+           opcode == BH_RANGE or opcode == BH_GATHER;
+}
+
+class Impl : public ComponentVE {
+private:
+    Compression compressor;
+    std::vector<std::unique_ptr<Shard> > shards;
+    std::vector<pid_t> workers;
+    std::map<bh_base *, DistBase> dist;
+    string compress_param;
+    bool use_batch_cache;
+    int64_t replicate_threshold;
+
+    // Base arrays that the parent creates while translating a BhIR, which live until the BhIR has been sent
+    std::vector<std::unique_ptr<bh_base> > temps;
+    // Parent base arrays freed by the BhIR, which data is freed when the BhIR has been sent
+    std::vector<bh_base *> frees;
+
+    bool stat_print_on_exit;
+    uint64_t num_halo_instrs{0};
+    uint64_t num_reduce_instrs{0};
+    uint64_t num_fallback_instrs{0};
+    uint64_t num_fetches{0};
+    uint64_t nbytes_fetched{0};
+    std::chrono::duration<double> time_fetch{0};
+
+    int nshards() const {
+        return static_cast<int>(shards.size());
+    }
+
+    // Return a base array of the parent that only the shards know about
+    bh_base *newTemp(int64_t nelem, bh_type dtype) {
+        temps.emplace_back(new bh_base(nelem, dtype));
+        return temps.back().get();
+    }
+
+    // Return the distribution of `view.base`, which is decided at first sight. A base array smaller than
+    // `replicate_threshold` is replicated when `replicate_small`.
+    DistBase &track(const bh_view &view, bool replicate_small);
+
+    // Stop tracking `base`, which the shards have freed or never had
+    void untrack(bh_base *base);
+
+    // Return `view` of a tracked base array translated to the base array of shard `k`
+    bh_view localView(const bh_view &view, int k) {
+        bh_view ret = view;
+        const DistBase &d = dist.at(view.base);
+        ret.base = d.local[k].get();
+        ret.start -= d.layout.lo(k);
+        ret.slides = bh_slide();
+        return ret;
+    }
+
+    // Queue an instruction at shard `k`
+    void emit(int k, bh_opcode opcode, std::vector<bh_view> operands, const bh_constant &constant = bh_constant()) {
+        bh_instruction instr(opcode, std::move(operands));
+        instr.constant = constant;
+        shards[k]->pending.push_back(std::move(instr));
+    }
+
+    // Send the queued instructions of shard `k`
+    void flush(int k);
+
+    // Send a GET_DATA request of `views` to shard `k`
+    void sendGetData(int k, std::vector<bh_view> views, bool nullify, bool reply);
+
+    // Fetch `pieces` into new temporary base arrays with parent data
+    std::map<Piece, bh_base *> fetch(const std::set<Piece> &pieces);
+
+    // Copy the data of the tracked `base` into `dest` of the parent. When `nullify`, the shards free the data.
+    void gather(bh_base *base, bh_base &dest, bool nullify);
+
+    // Translate `instr`, which operands are tracked, into instructions of the shards
+    void translate(const bh_instruction &instr);
+
+    // Translate `instr` into instructions of the shards that compute the rows of the output that they hold.
+    // Returns false when the output rows are not within the blocks.
+    bool translateRows(const bh_instruction &instr);
+
+    // Translate a reduction along the rows into partial reductions at the shards, which are combined.
+    // Returns false when the input rows are not within the blocks.
+    bool translateReduction(const bh_instruction &instr);
+
+    // Translate `instr` into instructions that every shard executes on full copies of the distributed operands
+    void translateFallback(const bh_instruction &instr);
+
+    // Send the translated BhIR to the shards and free its temporary base arrays
+    void endBatch();
+
+    // Execute `bhir` once
+    void executeOnce(BhIR *bhir);
+
+public:
+    Impl(int stack_level);
+
+    ~Impl() override;
+
+    void execute(BhIR *bhir) override;
+
+    void extmethod(const string &name, bh_opcode opcode) override {
+        // ExtmethodFace does not have a default or copy constructor thus
+        // we have to use its move constructor.
+        extmethods.insert(make_pair(opcode, extmethod::ExtmethodFace(config, name)));
+    }
+
+    // Handle messages from parent
+    string message(const string &msg) override {
+        stringstream ss;
+        if (msg == "info") {
+            ss << "----" << "\n";
+            ss << "Cluster:" << "\n";
+            ss << "  Shards: " << shards.size() << "\n";
+        }
+        for (auto &shard: shards) {
+            vector<char> buf_body;
+            msg::Message body(msg);
+            body.serialize(buf_body);
+            vector<char> buf_head;
+            msg::Header head(msg::Type::MSG, buf_body.size());
+            head.serialize(buf_head);
+            shard->comm->write(std::move(buf_head));
+            shard->comm->write(std::move(buf_body));
+        }
+        for (auto &shard: shards) {
+            ss << shard->comm->read();
+        }
+        return ss.str();
+    }
+
+    // Handle memory pointer retrieval
+    void *getMemoryPointer(bh_base &base, bool copy2host, bool force_alloc, bool nullify) override {
+        if (not copy2host) {
+            throw runtime_error("CLUSTER - getMemoryPointer(): `copy2host` is not True");
+        }
+        if (dist.find(&base) != dist.end()) {
+            gather(&base, base, nullify);
+            if (nullify) {
+                untrack(&base);
+            }
+        }
+        if (force_alloc) {
+            bh_data_malloc(&base);
+        }
+        void *ret = base.getDataPtr();
+        if (nullify) {
+            base.resetDataPtr();
+        }
+        return ret;
+    }
+
+    // Handle memory pointer obtainment
+    void setMemoryPointer(bh_base *base, bool host_ptr, void *mem) override {
+        throw runtime_error("CLUSTER - setMemoryPointer(): not implemented");
+    }
+
+    // Handle memory copy. The shards send their data uncompressed thus `param` is ignored.
+    void memCopy(bh_view &src, bh_view &dst, const std::string &param) override {
+        if (src.isConstant() or dst.isConstant()) {
+            throw runtime_error("CLUSTER - memCopy(): `src` and `dst` cannot be constants");
+        }
+        if (src.shape.prod() != dst.shape.prod()) {
+            throw runtime_error("CLUSTER - memCopy(): `src` and `dst` must have same size");
+        }
+        if (util::exist(dist, dst.base) or dst.base->getDataPtr() != nullptr) {
+            throw runtime_error("CLUSTER - memCopy(): `dst` must be un-initiated");
+        }
+        bh_base copy(src.base->nelem(), src.base->dtype());
+        bh_view view = src;
+        if (util::exist(dist, src.base)) {
+            gather(src.base, copy, false);
+            view.base = &copy;
+        }
+        bh_data_malloc(dst.base);
+        if (view.base->getDataPtr() != nullptr) {
+            std::vector<char> packed(static_cast<size_t>(view.shape.prod() * bh_type_size(view.base->dtype())));
+            viewGather(view, packed.data());
+            viewScatter(packed.data(), dst);
+        }
+        bh_data_free(&copy);
+    }
+
+    // We have no context so returning NULL
+    void *getDeviceContext() override {
+        return nullptr;
+    };
+
+    // We have no context so doing nothing
+    void setDeviceContext(void *device_context) override {};
+
+    // Handle extension methods in `bhir`, which the parent executes on its copy of the operands
+    void handleExtmethod(BhIR *bhir) {
+        std::vector<bh_instruction> instr_list;
+        for (bh_instruction &instr: bhir->instr_list) {
+            auto ext = extmethods.find(instr.opcode);
+
+            if (ext != extmethods.end()) { // Execute the instructions up until now
+                BhIR b(std::move(instr_list), bhir->getSyncs());
+                executeOnce(&b);
+                instr_list.clear(); // Notice, it is legal to clear a moved vector.
+                for (size_t i = 0; i < instr.operand.size(); ++i) {
+                    bh_base *base = instr.operand[i].base;
+                    if (util::exist(dist, base)) {
+                        gather(base, *base, i == 0);
+                        // The output is written by the parent thus the shards get it anew
+                        if (i == 0) {
+                            untrack(base);
+                        }
+                    }
+                    bh_data_malloc(base);
+                }
+                ext->second.execute(&instr, nullptr); // Execute the extension method
+            } else {
+                instr_list.push_back(instr);
+            }
+        }
+        bhir->instr_list = instr_list;
+    }
+};
+} //Unnamed namespace
+
+
+extern "C" ComponentImpl *create(int stack_level) {
+    return new Impl(stack_level);
+}
+extern "C" void destroy(ComponentImpl *self) {
+    delete self;
+}
+
+Impl::Impl(int stack_level) : ComponentVE(stack_level, false),
+                              compress_param(config.defaultGet<string>("compress_param", "none")),
+                              use_batch_cache(config.defaultGet("batch_cache", true)),
+                              replicate_threshold(config.defaultGet<int64_t>("replicate_threshold", 65536)),
+                              stat_print_on_exit(config.defaultGet("prof", false)) {
+    const int nworkers = config.defaultGet<int>("workers", 2);
+    if (nworkers < 1) {
+        throw runtime_error("CLUSTER - `workers` must be at least one");
+    }
+    vector<string> addresses;
+    const string address = config.defaultGet<string>("address", "localhost");
+    boost::split(addresses, address, boost::is_any_of(","));
+    const int port = config.defaultGet<int>("port", 4300);
+
+    // Start the workers on this host, which listen on consecutive ports
+    if (config.defaultGet("spawn_workers", true)) {
+        const string cmd = config.defaultGet<string>("worker_cmd", "bh_proxy_backend");
+        for (int k = 0; k < nworkers; ++k) {
+            const string worker_port = std::to_string(port + k);
+            const pid_t pid = fork();
+            if (pid == 0) {
+                execlp(cmd.c_str(), cmd.c_str(), "-a", "localhost", "-p", worker_port.c_str(), (char *) nullptr);
+                cerr << "[CLUSTER-VEM] cannot execute the worker `" << cmd << "`" << endl;
+                _exit(1);
+            } else if (pid < 0) {
+                throw runtime_error("CLUSTER - fork() failed");
+            }
+            workers.push_back(pid);
+        }
+    }
+    for (int k = 0; k < nworkers; ++k) {
+        shards.emplace_back(new Shard());
+        shards.back()->comm.reset(new CommFrontend(stack_level, addresses[k % addresses.size()], port + k, 0,
+                                                   config.defaultGet<size_t>("send_queue_size", 64) * 1024 * 1024,
+                                                   config.defaultGet<string>("transport", "auto")));
+    }
+}
+
+Impl::~Impl() {
+    if (stat_print_on_exit) {
+        cout << "[CLUSTER-VEM] Profiling: \n";
+        cout << "  Shards:           " << shards.size() << "\n";
+        cout << "  Halo instrs:      " << num_halo_instrs << "\n";
+        cout << "  Reduction instrs: " << num_reduce_instrs << "\n";
+        cout << "  Fallback instrs:  " << num_fallback_instrs << "\n";
+        cout << "  Fetches:          " << num_fetches << "\n";
+        cout << "    Recv:  " << nbytes_fetched / 1024.0 / 1024.0 << "MB\n";
+        cout << "    Time:  " << time_fetch.count() << "s" << endl;
+    }
+    shards.clear(); // Shutdown the workers
+    for (pid_t pid: workers) {
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+DistBase &Impl::track(const bh_view &view, bool replicate_small) {
+    auto it = dist.find(view.base);
+    if (it != dist.end()) {
+        return it->second;
+    }
+    bh_base *base = view.base;
+
+    // The rows of the first view decide the blocks
+    int64_t row_nelem = 1;
+    if (viewIsWholeBase(view) and view.ndim > 1) {
+        row_nelem = view.stride[0];
+    }
+    const bool replicated = (replicate_small and base->nelem() < replicate_threshold) or nshards() == 1;
+    DistBase d{ShardLayout(base->nelem(), row_nelem, nshards(), replicated), {}};
+    for (int k = 0; k < nshards(); ++k) {
+        const int64_t nelem = d.layout.hi(k) - d.layout.lo(k);
+        d.local.emplace_back(nelem > 0 ? new bh_base(nelem, base->dtype()) : nullptr);
+
+        // The data of the parent is sent along with the first instruction that uses the block
+        if (nelem > 0 and base->getDataPtr() != nullptr) {
+            auto *data = static_cast<char *>(base->getDataPtr()) + d.layout.lo(k) * bh_type_size(base->dtype());
+            d.local[k]->resetDataPtr(data);
+            shards[k]->borrowed.push_back(d.local[k].get());
+        }
+    }
+    return dist.emplace(base, std::move(d)).first->second;
+}
+
+void Impl::untrack(bh_base *base) {
+    DistBase &d = dist.at(base);
+    for (int k = 0; k < nshards(); ++k) {
+        if (d.local[k] != nullptr) {
+            std::vector<bh_base *> &borrowed = shards[k]->borrowed;
+            borrowed.erase(std::remove(borrowed.begin(), borrowed.end(), d.local[k].get()), borrowed.end());
+        }
+    }
+    dist.erase(base);
+}
+
+void Impl::flush(int k) {
+    Shard &shard = *shards[k];
+    if (shard.pending.empty()) {
+        return;
+    }
+    BhIR bhir(std::move(shard.pending), {});
+    shard.pending.clear(); // Notice, it is legal to clear a moved vector.
+
+    // Serialize the BhIR, which becomes the message body. A repeated BhIR is sent as a reference to the batch cache.
+    vector<bh_base *> new_data;
+    vector<char> buf_body;
+    msg::Type type = msg::Type::EXEC;
+    if (use_batch_cache) {
+        type = shard.batch_cache.write(bhir, shard.known_base_arrays, shard.view_dict, new_data, buf_body);
+    } else {
+        buf_body = bhir.writeSerialized(shard.known_base_arrays, shard.view_dict, new_data);
+    }
+    vector<char> buf_head;
+    msg::Header head(type, buf_body.size());
+    head.serialize(buf_head);
+    shard.comm->write(std::move(buf_head));
+    shard.comm->write(std::move(buf_body));
+
+    // Send the array data
+    compressor.setLinkBandwidth(shard.comm->bandwidth());
+    for (bh_base *base: new_data) {
+        if (shard.comm->sharedMemory()) {
+            shard.comm->send_handle(base->getDataPtr(), base->nbytes());
+        } else {
+            shard.comm->send_data(compressor.compress(*base, compress_param));
+        }
+    }
+    for (const bh_instruction &instr: bhir.instr_list) {
+        if (instr.opcode == BH_FREE) {
+            shard.known_base_arrays.erase(instr.operand[0].base);
+        }
+    }
+
+    // The borrowed data that has been sent is the parent's again
+    auto sent = std::partition(shard.borrowed.begin(), shard.borrowed.end(), [&](bh_base *base) {
+        return std::find(new_data.begin(), new_data.end(), base) == new_data.end();
+    });
+    for (auto it = sent; it != shard.borrowed.end(); ++it) {
+        (*it)->resetDataPtr();
+    }
+    shard.borrowed.erase(sent, shard.borrowed.end());
+}
+
+void Impl::sendGetData(int k, std::vector<bh_view> views, bool nullify, bool reply) {
+    vector<char> buf_body;
+    msg::GetData body(std::move(views), nullify, reply);
+    body.serialize(buf_body);
+    vector<char> buf_head;
+    msg::Header head(msg::Type::GET_DATA, buf_body.size());
+    head.serialize(buf_head);
+    shards[k]->comm->write(std::move(buf_head));
+    shards[k]->comm->write(std::move(buf_body));
+}
+
+std::map<Piece, bh_base *> Impl::fetch(const std::set<Piece> &pieces) {
+    auto t = chrono::steady_clock::now();
+    std::map<Piece, bh_base *> ret;
+    std::vector<std::vector<Piece> > per_shard(shards.size());
+    for (const Piece &piece: pieces) {
+        per_shard[piece.shard].push_back(piece);
+    }
+    // All the requests are sent before the first reply is received
+    for (int k = 0; k < nshards(); ++k) {
+        if (not per_shard[k].empty()) {
+            flush(k);
+            vector<bh_view> views;
+            for (const Piece &piece: per_shard[k]) {
+                views.emplace_back(piece.local, piece.start, 1, BhIntVec({piece.nelem}), BhIntVec({1}));
+            }
+            sendGetData(k, std::move(views), false, true);
+        }
+    }
+    for (int k = 0; k < nshards(); ++k) {
+        for (const Piece &piece: per_shard[k]) {
+            bh_base *dest = newTemp(piece.nelem, piece.local->dtype());
+            bh_view view(dest);
+            nbytes_fetched += recvFrame(shards[k]->comm->pop(), view, compressor, compress_param);
+            ret[piece] = dest;
+            ++num_fetches;
+        }
+    }
+    time_fetch += chrono::steady_clock::now() - t;
+    return ret;
+}
+
+void Impl::gather(bh_base *base, bh_base &dest, bool nullify) {
+    const DistBase &d = dist.at(base);
+    std::vector<int> replies;
+    for (int k = 0; k < nshards(); ++k) {
+        if (d.local[k] == nullptr) {
+            continue;
+        }
+        // Of a replicated base array, only the first shard replies
+        const bool reply = not d.layout.replicated() or k == 0;
+        if (reply or nullify) {
+            flush(k);
+            sendGetData(k, {bh_view(d.local[k].get())}, nullify, reply);
+        }
+        if (reply) {
+            replies.push_back(k);
+        }
+    }
+    for (int k: replies) {
+        const int64_t nelem = d.layout.hi(k) - d.layout.lo(k);
+        bh_view view(&dest, d.layout.lo(k), 1, BhIntVec({nelem}), BhIntVec({1}));
+        recvFrame(shards[k]->comm->pop(), view, compressor, compress_param);
+    }
+}
+
+void Impl::translate(const bh_instruction &instr) {
+    switch (instr.opcode) {
+        case BH_NONE:
+            return;
+        case BH_TALLY:
+            for (int k = 0; k < nshards(); ++k) {
+                emit(k, BH_TALLY, {});
+            }
+            return;
+        case BH_FREE: {
+            bh_base *base = instr.operand[0].base;
+            auto it = dist.find(base);
+            if (it != dist.end()) {
+                for (int k = 0; k < nshards(); ++k) {
+                    if (it->second.local[k] != nullptr) {
+                        emit(k, BH_FREE, {bh_view(it->second.local[k].get())});
+                    }
+                }
+                // Notice, the base arrays of the shards must live until the BhIR has been sent, which also sends
+                // the data they borrow (if any)
+                for (auto &local: it->second.local) {
+                    if (local != nullptr) {
+                        temps.push_back(std::move(local));
+                    }
+                }
+                dist.erase(it);
+            }
+            frees.push_back(base);
+            return;
+        }
+        default:
+            break;
+    }
+
+    // An empty output is never written
+    const bh_view &out = instr.operand[0];
+    if (out.shape.prod() == 0 and not bh_opcode_is_sweep(instr.opcode)) {
+        return;
+    }
+    // A small output is replicated when its inputs are, or when it is the result of a reduction along the rows,
+    // which gathers the partial results anyway. Otherwise, the shards that hold the inputs compute it.
+    bool all_replicated = true;
+    for (size_t i = 1; i < instr.operand.size(); ++i) {
+        if (not instr.operand[i].isConstant()) {
+            all_replicated &= track(instr.operand[i], true).layout.replicated();
+        }
+    }
+    const bool row_reduction = bh_opcode_is_reduction(instr.opcode) and instr.sweep_axis() == 0;
+    all_replicated &= track(out, all_replicated or row_reduction).layout.replicated();
+    if (all_replicated) {
+        for (int k = 0; k < nshards(); ++k) {
+            bh_instruction local = instr;
+            for (bh_view &view: local.operand) {
+                if (not view.isConstant()) {
+                    view = localView(view, k);
+                }
+            }
+            shards[k]->pending.push_back(std::move(local));
+        }
+        return;
+    }
+
+    // The rows of every operand must match the rows of the output, which rules out the sweeps along the rows
+    bool row_wise = bh_opcode_is_elementwise(instr.opcode) or
+                    (bh_opcode_is_sweep(instr.opcode) and instr.sweep_axis() > 0);
+    for (const bh_view &view: instr.operand) {
+        if (not view.isConstant() and view.shape.prod() == 0) {
+            row_wise = false;
+        } else if (not view.isConstant() and ViewRows(view).nrows != ViewRows(out).nrows) {
+            row_wise = false;
+        }
+    }
+    if (row_wise and translateRows(instr)) {
+        return;
+    }
+    if (row_reduction and not dist.at(instr.operand[1].base).layout.replicated() and translateReduction(instr)) {
+        return;
+    }
+    translateFallback(instr);
+}
+
+bool Impl::translateRows(const bh_instruction &instr) {
+    const bh_view &out = instr.operand[0];
+    const DistBase &dout = dist.at(out.base);
+    const ViewRows out_rows(out);
+    if (out_rows.stride == 0 and out_rows.nrows > 1) {
+        return false;
+    }
+
+    // A segment of rows at a shard and the elements [lo, hi) of each operand that a temporary array holds
+    // (lo == hi when the operand is local)
+    struct Segment {
+        int shard;
+        RowRange rows;
+        std::vector<std::pair<int64_t, int64_t> > temps;
+    };
+    std::vector<Segment> segments;
+    std::set<Piece> pieces;
+    for (int k = 0; k < nshards(); ++k) {
+        const RowRange rows = out_rows.startingIn(out_rows.all(), dout.layout.lo(k), dout.layout.hi(k));
+        if (rows.empty()) {
+            continue;
+        }
+        if (not(out_rows.within(rows, dout.layout.lo(k), dout.layout.hi(k)) == rows)) {
+            return false;
+        }
+
+        // The interior rows, where every input is local, and the boundary rows, which read a halo
+        RowRange interior = rows;
+        for (size_t i = 1; i < instr.operand.size(); ++i) {
+            const bh_view &view = instr.operand[i];
+            if (view.isConstant() or dist.at(view.base).layout.replicated()) {
+                continue;
+            }
+            const ShardLayout &layout = dist.at(view.base).layout;
+            const RowRange local = ViewRows(view).within(rows, layout.lo(k), layout.hi(k));
+            interior.begin = std::max(interior.begin, local.begin);
+            interior.end = std::min(interior.end, local.end);
+        }
+        std::vector<RowRange> ranges;
+        if (interior.empty()) {
+            ranges.push_back(rows);
+        } else {
+            ranges = {RowRange{rows.begin, interior.begin}, interior, RowRange{interior.end, rows.end}};
+        }
+        for (const RowRange &range: ranges) {
+            if (range.empty()) {
+                continue;
+            }
+            Segment seg{k, range, std::vector<std::pair<int64_t, int64_t> >(instr.operand.size(), {0, 0})};
+            for (size_t i = 1; i < instr.operand.size(); ++i) {
+                const bh_view &view = instr.operand[i];
+                if (view.isConstant() or dist.at(view.base).layout.replicated()) {
+                    continue;
+                }
+                const DistBase &d = dist.at(view.base);
+                const ViewRows vrows(view);
+                if (vrows.within(range, d.layout.lo(k), d.layout.hi(k)) == range) {
+                    continue;
+                }
+                seg.temps[i] = vrows.span(range);
+                for (int j = 0; j < nshards(); ++j) {
+                    const int64_t lo = std::max(seg.temps[i].first, d.layout.lo(j));
+                    const int64_t hi = std::min(seg.temps[i].second, d.layout.hi(j));
+                    if (j != k and lo < hi) {
+                        pieces.insert(Piece{j, d.local[j].get(), lo - d.layout.lo(j), hi - lo});
+                    }
+                }
+            }
+            segments.push_back(std::move(seg));
+        }
+    }
+
+    // Fetch the halos and queue the instructions. The fetched pieces are freed when all segments of the shard
+    // have used them.
+    const std::map<Piece, bh_base *> fetched = fetch(pieces);
+    if (not pieces.empty()) {
+        ++num_halo_instrs;
+    }
+    std::vector<std::set<bh_base *> > used(shards.size());
+    for (const Segment &seg: segments) {
+        const int k = seg.shard;
+        bh_instruction local = instr;
+        std::vector<bh_base *> seg_temps;
+        for (size_t i = 0; i < instr.operand.size(); ++i) {
+            const bh_view &view = instr.operand[i];
+            if (view.isConstant()) {
+                continue;
+            }
+            if (seg.temps[i].first == seg.temps[i].second) {
+                local.operand[i] = localView(restrictRows(view, seg.rows), k);
+                continue;
+            }
+            // Assemble the elements [lo, hi) in a temporary array from the local block and the fetched pieces
+            const DistBase &d = dist.at(view.base);
+            const int64_t lo = seg.temps[i].first;
+            const int64_t hi = seg.temps[i].second;
+            bh_base *temp = newTemp(hi - lo, view.base->dtype());
+            for (int j = 0; j < nshards(); ++j) {
+                const int64_t plo = std::max(lo, d.layout.lo(j));
+                const int64_t phi = std::min(hi, d.layout.hi(j));
+                if (plo >= phi) {
+                    continue;
+                }
+                const bh_view dst(temp, plo - lo, 1, {phi - plo}, {1});
+                if (j == k) {
+                    emit(k, BH_IDENTITY, {dst, bh_view(d.local[k].get(), plo - d.layout.lo(k), 1, {phi - plo}, {1})});
+                } else {
+                    bh_base *piece = fetched.at(Piece{j, d.local[j].get(), plo - d.layout.lo(j), phi - plo});
+                    emit(k, BH_IDENTITY, {dst, bh_view(piece)});
+                    used[k].insert(piece);
+                }
+            }
+            bh_view tview = restrictRows(view, seg.rows);
+            tview.base = temp;
+            tview.start -= lo;
+            tview.slides = bh_slide();
+            local.operand[i] = tview;
+            seg_temps.push_back(temp);
+        }
+        shards[k]->pending.push_back(std::move(local));
+        for (bh_base *temp: seg_temps) {
+            emit(k, BH_FREE, {bh_view(temp)});
+        }
+    }
+    for (int k = 0; k < nshards(); ++k) {
+        for (bh_base *piece: used[k]) {
+            emit(k, BH_FREE, {bh_view(piece)});
+        }
+    }
+    return true;
+}
+
+bool Impl::translateReduction(const bh_instruction &instr) {
+    const bh_view &out = instr.operand[0];
+    const bh_view &in = instr.operand[1];
+    const DistBase &din = dist.at(in.base);
+    const ViewRows in_rows(in);
+
+    std::vector<RowRange> rows(shards.size());
+    for (int k = 0; k < nshards(); ++k) {
+        rows[k] = in_rows.startingIn(in_rows.all(), din.layout.lo(k), din.layout.hi(k));
+        if (not rows[k].empty() and not(in_rows.within(rows[k], din.layout.lo(k), din.layout.hi(k)) == rows[k])) {
+            return false;
+        }
+    }
+    ++num_reduce_instrs;
+
+    // Each shard reduces its rows into a partial result, which has the shape of the output
+    BhIntVec stride(out.shape.size(), 1);
+    for (int64_t d = out.ndim - 2; d >= 0; --d) {
+        stride[d] = stride[d + 1] * out.shape[d + 1];
+    }
+    std::set<Piece> pieces;
+    std::vector<bh_base *> partials(shards.size(), nullptr);
+    for (int k = 0; k < nshards(); ++k) {
+        if (rows[k].empty()) {
+            continue;
+        }
+        partials[k] = newTemp(out.shape.prod(), out.base->dtype());
+        const bh_view partial(partials[k], 0, out.ndim, out.shape, stride);
+        emit(k, instr.opcode, {partial, localView(restrictRows(in, rows[k]), k), instr.operand[2]}, instr.constant);
+        pieces.insert(Piece{k, partials[k], 0, out.shape.prod()});
+    }
+    const std::map<Piece, bh_base *> fetched = fetch(pieces);
+
+    // The partial results are combined into the output as new parent arrays
+    bh_opcode combine;
+    switch (instr.opcode) {
+        case BH_ADD_REDUCE: combine = BH_ADD; break;
+        case BH_MULTIPLY_REDUCE: combine = BH_MULTIPLY; break;
+        case BH_MINIMUM_REDUCE: combine = BH_MINIMUM; break;
+        case BH_MAXIMUM_REDUCE: combine = BH_MAXIMUM; break;
+        case BH_LOGICAL_AND_REDUCE: combine = BH_LOGICAL_AND; break;
+        case BH_BITWISE_AND_REDUCE: combine = BH_BITWISE_AND; break;
+        case BH_LOGICAL_OR_REDUCE: combine = BH_LOGICAL_OR; break;
+        case BH_BITWISE_OR_REDUCE: combine = BH_BITWISE_OR; break;
+        case BH_LOGICAL_XOR_REDUCE: combine = BH_LOGICAL_XOR; break;
+        case BH_BITWISE_XOR_REDUCE: combine = BH_BITWISE_XOR; break;
+        default: throw runtime_error("CLUSTER - unknown reduction");
+    }
+    bool first = true;
+    for (const Piece &piece: pieces) {
+        emit(piece.shard, BH_FREE, {bh_view(piece.local)});
+        const bh_view partial(fetched.at(piece), 0, out.ndim, out.shape, stride);
+        if (first) {
+            translate(bh_instruction(BH_IDENTITY, {out, partial}));
+            first = false;
+        } else {
+            translate(bh_instruction(combine, {out, out, partial}));
+        }
+        translate(bh_instruction(BH_FREE, {partial}));
+    }
+    return true;
+}
+
+void Impl::translateFallback(const bh_instruction &instr) {
+    ++num_fallback_instrs;
+    const bh_view &out = instr.operand[0];
+
+    // The distributed operands that every shard needs a full copy of. An output is not gathered when the
+    // instruction writes all of its base and doesn't read it.
+    std::set<bh_base *> gathered;
+    bool gather_out = not writesWholeOutput(instr.opcode);
+    for (size_t i = 1; i < instr.operand.size(); ++i) {
+        gather_out |= instr.operand[i].base == out.base;
+    }
+    for (size_t i = 0; i < instr.operand.size(); ++i) {
+        const bh_view &view = instr.operand[i];
+        if (view.isConstant() or dist.at(view.base).layout.replicated()) {
+            continue;
+        }
+        if (i > 0 or gather_out or not viewIsWholeBase(view)) {
+            gathered.insert(view.base);
+        }
+    }
+    std::set<Piece> pieces;
+    for (bh_base *base: gathered) {
+        const DistBase &d = dist.at(base);
+        for (int j = 0; j < nshards(); ++j) {
+            if (d.local[j] != nullptr) {
+                pieces.insert(Piece{j, d.local[j].get(), 0, d.local[j]->nelem()});
+            }
+        }
+    }
+    const std::map<Piece, bh_base *> fetched = fetch(pieces);
+
+    // Every shard uses the same temporary array IDs
+    std::map<bh_base *, bh_base *> full;
+    for (const bh_view &view: instr.operand) {
+        if (not view.isConstant() and not dist.at(view.base).layout.replicated() and not util::exist(full, view.base)) {
+            full[view.base] = newTemp(view.base->nelem(), view.base->dtype());
+        }
+    }
+    for (int k = 0; k < nshards(); ++k) {
+        for (bh_base *base: gathered) {
+            const DistBase &d = dist.at(base);
+            for (int j = 0; j < nshards(); ++j) {
+                if (d.local[j] == nullptr) {
+                    continue;
+                }
+                const bh_view dst(full.at(base), d.layout.lo(j), 1, {d.local[j]->nelem()}, {1});
+                if (j == k) {
+                    emit(k, BH_IDENTITY, {dst, bh_view(d.local[k].get())});
+                } else {
+                    emit(k, BH_IDENTITY, {dst, bh_view(fetched.at(Piece{j, d.local[j].get(), 0, d.local[j]->nelem()}))});
+                }
+            }
+        }
+        bh_instruction local = instr;
+        for (bh_view &view: local.operand) {
+            if (view.isConstant()) {
+                continue;
+            }
+            if (util::exist(full, view.base)) {
+                view.base = full.at(view.base);
+                view.slides = bh_slide();
+            } else {
+                view = localView(view, k);
+            }
+        }
+        shards[k]->pending.push_back(std::move(local));
+
+        // Each shard keeps its block of a distributed output
+        const DistBase &dout = dist.at(out.base);
+        if (util::exist(full, out.base) and dout.local[k] != nullptr) {
+            emit(k, BH_IDENTITY, {bh_view(dout.local[k].get()),
+                                  bh_view(full.at(out.base), dout.layout.lo(k), 1, {dout.local[k]->nelem()}, {1})});
+        }
+        for (const auto &p: full) {
+            emit(k, BH_FREE, {bh_view(p.second)});
+        }
+        for (const auto &p: fetched) {
+            if (p.first.shard != k) {
+                emit(k, BH_FREE, {bh_view(p.second)});
+            }
+        }
+    }
+}
+
+void Impl::endBatch() {
+    for (int k = 0; k < nshards(); ++k) {
+        flush(k);
+    }
+    for (bh_base *base: frees) {
+        bh_data_free(base);
+    }
+    frees.clear();
+    for (auto &temp: temps) {
+        bh_data_free(temp.get());
+    }
+    temps.clear();
+}
+
+void Impl::executeOnce(BhIR *bhir) {
+    for (const bh_instruction &instr: bhir->instr_list) {
+        translate(instr);
+    }
+    endBatch();
+}
+
+void Impl::execute(BhIR *bhir) {
+    handleExtmethod(bhir);
+
+    // The parent runs the iterations of a repeat since the shards fetch halos in between
+    bh_base *cond = bhir->getRepeatCondition();
+    for (uint64_t i = 0; i < bhir->getNRepeats(); ++i) {
+        executeOnce(bhir);
+        if (cond != nullptr and util::exist(dist, cond)) {
+            bh_base value(cond->nelem(), cond->dtype());
+            gather(cond, value, false);
+            const bool stop = value.getDataPtr() != nullptr and not static_cast<bool *>(value.getDataPtr())[0];
+            bh_data_free(&value);
+            if (stop) {
+                break;
+            }
+        }
+        // Change views that slide between iterations
+        for (bh_instruction &instr: bhir->instr_list) {
+            for (bh_view &view: instr.operand) {
+                if (view.hasSlide()) {
+                    view.slide();
+                }
+            }
+        }
+    }
+
+    // Like an engine, we copy the sync'ed arrays into the memory of the parent
+    for (bh_base *base: bhir->getSyncs()) {
+        if (util::exist(dist, base)) {
+            gather(base, *base, false);
+        }
+    }
+}
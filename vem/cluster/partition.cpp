@@ -0,0 +1,122 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include "partition.hpp"
+
+using namespace std;
+
+namespace {
+// Floor and ceil of `a / b` where `b` is positive
+int64_t floorDiv(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+int64_t ceilDiv(int64_t a, int64_t b) {
+    return -floorDiv(-a, b);
+}
+
+// The rows of `rows` where `c + i * s >= bound`
+RowRange atLeast(RowRange rows, int64_t c, int64_t s, int64_t bound) {
+    if (s > 0) {
+        rows.begin = std::max(rows.begin, ceilDiv(bound - c, s));
+    } else if (s < 0) {
+        rows.end = std::min(rows.end, floorDiv(c - bound, -s) + 1);
+    } else if (c < bound) {
+        rows.end = rows.begin;
+    }
+    return rows;
+}
+
+// The rows of `rows` where `c + i * s <= bound`
+RowRange atMost(RowRange rows, int64_t c, int64_t s, int64_t bound) {
+    if (s > 0) {
+        rows.end = std::min(rows.end, floorDiv(bound - c, s) + 1);
+    } else if (s < 0) {
+        rows.begin = std::max(rows.begin, ceilDiv(c - bound, -s));
+    } else if (c > bound) {
+        rows.end = rows.begin;
+    }
+    return rows;
+}
+
+RowRange normalize(RowRange rows) {
+    if (rows.end < rows.begin) {
+        rows.end = rows.begin;
+    }
+    return rows;
+}
+}
+
+ShardLayout::ShardLayout(int64_t nelem, int64_t row_nelem, int nshards, bool replicated) : _replicated(replicated),
+                                                                                           _nelem(nelem) {
+    if (row_nelem <= 0 or nelem % row_nelem != 0) {
+        row_nelem = 1;
+    }
+    const int64_t nrows = nelem / row_nelem;
+    for (int k = 0; k < nshards; ++k) {
+        _bounds.push_back(nrows * k / nshards * row_nelem);
+    }
+    _bounds.push_back(nelem);
+}
+
+ViewRows::ViewRows(const bh_view &view) {
+    if (view.ndim == 0) {
+        nrows = 1;
+        stride = 0;
+        first = last = view.start;
+        return;
+    }
+    nrows = view.shape[0];
+    stride = view.stride[0];
+    first = last = view.start;
+    for (int64_t d = 1; d < view.ndim; ++d) {
+        const int64_t extent = (view.shape[d] - 1) * view.stride[d];
+        if (extent < 0) {
+            first += extent;
+        } else {
+            last += extent;
+        }
+    }
+}
+
+RowRange ViewRows::startingIn(RowRange rows, int64_t lo, int64_t hi) const {
+    return normalize(atMost(atLeast(rows, first, stride, lo), first, stride, hi - 1));
+}
+
+RowRange ViewRows::within(RowRange rows, int64_t lo, int64_t hi) const {
+    return normalize(atMost(atLeast(rows, first, stride, lo), last, stride, hi - 1));
+}
+
+std::pair<int64_t, int64_t> ViewRows::span(RowRange rows) const {
+    if (stride >= 0) {
+        return make_pair(first + rows.begin * stride, last + (rows.end - 1) * stride + 1);
+    }
+    return make_pair(first + (rows.end - 1) * stride, last + rows.begin * stride + 1);
+}
+
+bh_view restrictRows(const bh_view &view, RowRange rows) {
+    bh_view ret = view;
+    if (ret.ndim > 0) {
+        ret.start += rows.begin * ret.stride[0];
+        ret.shape[0] = rows.end - rows.begin;
+    }
+    return ret;
+}
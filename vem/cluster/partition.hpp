@@ -0,0 +1,99 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <bohrium/bh_view.hpp>
+
+/** The partition of a base array across the shards of the cluster. A distributed base array is split into one
+ *  block of consecutive whole rows per shard whereas a replicated base array has a full copy on every shard. */
+class ShardLayout {
+    bool _replicated;
+    // The block of shard `k` is the elements [_bounds[k], _bounds[k+1]) (distributed base arrays only)
+    std::vector<int64_t> _bounds;
+    int64_t _nelem;
+
+public:
+    /** Construct the layout of a base array
+     *
+     * @param nelem      The number of elements of the base array
+     * @param row_nelem  The number of elements of a row, which the blocks never split
+     * @param nshards    The number of shards
+     * @param replicated Whether every shard has a full copy
+     */
+    ShardLayout(int64_t nelem, int64_t row_nelem, int nshards, bool replicated);
+
+    bool replicated() const {
+        return _replicated;
+    }
+
+    /// The first element that shard `k` holds
+    int64_t lo(int k) const {
+        return _replicated ? 0 : _bounds[k];
+    }
+
+    /// One past the last element that shard `k` holds
+    int64_t hi(int k) const {
+        return _replicated ? _nelem : _bounds[k + 1];
+    }
+};
+
+/// A half-open range of rows
+struct RowRange {
+    int64_t begin;
+    int64_t end;
+
+    bool empty() const {
+        return begin >= end;
+    }
+
+    bool operator==(const RowRange &other) const {
+        return begin == other.begin and end == other.end;
+    }
+};
+
+/** The rows of a view, which are the indices of its first dimension. Row `i` accesses elements within
+ *  [first + i * stride, last + i * stride]. A view with no dimensions is a single row. */
+class ViewRows {
+public:
+    int64_t nrows;
+    int64_t stride;
+    int64_t first;
+    int64_t last;
+
+    explicit ViewRows(const bh_view &view);
+
+    /// All the rows
+    RowRange all() const {
+        return RowRange{0, nrows};
+    }
+
+    /// The rows of `rows` that start within the elements [lo, hi)
+    RowRange startingIn(RowRange rows, int64_t lo, int64_t hi) const;
+
+    /// The rows of `rows` that access elements within [lo, hi) only
+    RowRange within(RowRange rows, int64_t lo, int64_t hi) const;
+
+    /// The smallest range of elements [lo, hi) that covers the non-empty `rows`
+    std::pair<int64_t, int64_t> span(RowRange rows) const;
+};
+
+/// Return `view` restricted to `rows`
+bh_view restrictRows(const bh_view &view, RowRange rows);
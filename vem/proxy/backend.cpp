@@ -24,6 +24,8 @@ If not, see <http://www.gnu.org/licenses/>.
 
 #include "comm.hpp"
 #include "compression.hpp"
+#include "batch_cache.hpp"
+#include "cost_report.hpp"
 
 using namespace std;
 using namespace bohrium;
@@ -36,22 +38,64 @@ static void service(const std::string &address, int port) {
     Compression compression;
     string compress_param;
     std::map<const bh_base *, bh_base> remote2local;
+    BhIRViewDict view_dict;
+    BatchCacheBackend batch_cache;
 
     // Some statistics
     std::chrono::duration<double> time_mem_copy_total{0};
     std::chrono::duration<double> time_mem_copy_zip{0};
+    std::chrono::duration<double> time_get_data_zip{0};
+    std::chrono::duration<double> time_data_wait{0};
     uint64_t nbytes_send{0};
+    uint64_t num_early_exec{0};
+
+    // The data wait and execution time of each EXEC message, which the frontend asks for when it writes a
+    // cost report (see cost_report.hpp). The recording starts at the first request.
+    bool record_costs = false;
+    std::vector<std::pair<double, double> > exec_costs;
+
+    // Reply with the elements of `view` (a local view or a constant when there is no data), which are compressed
+    // with `param` unless passed by shared memory. Returns the number of bytes sent through the stream and adds the
+    // compression time to `time_zip`.
+    auto send_view = [&](const bh_view &view, const string &param,
+                         std::chrono::duration<double> &time_zip) -> uint64_t {
+        if (view.base == nullptr or view.base->getDataPtr() == nullptr) {
+            if (comm_backend.sharedMemory()) {
+                comm_backend.send_handle(nullptr, 0);
+            } else {
+                comm_backend.send_data({});
+            }
+            return 0;
+        }
+        // A view that does not cover the whole base is packed into a contiguous temporary array
+        std::vector<char> packed;
+        bh_base packed_base;
+        const bh_base *base = view.base;
+        if (not viewIsWholeBase(view)) {
+            packed.resize(view.shape.prod() * bh_type_size(view.base->dtype()));
+            viewGather(view, packed.data());
+            packed_base = bh_base(view.shape.prod(), view.base->dtype(), packed.data());
+            base = &packed_base;
+        }
+        if (comm_backend.sharedMemory()) {
+            comm_backend.send_handle(base->getDataPtr(), base->nbytes());
+            return 0;
+        }
+        auto t = chrono::steady_clock::now();
+        compression.setLinkBandwidth(comm_backend.bandwidth());
+        auto data = compression.compress(*base, param);
+        time_zip += chrono::steady_clock::now() - t;
+        comm_backend.send_data(data);
+        return data.size();
+    };
 
     while (true) {
-        // Let's read the head of the message
-        vector<char> buf_head(msg::HeaderSize);
-        comm_backend.read(buf_head);
-        msg::Header head(buf_head);
+        // Let's get the next message, which the receiver thread of `comm_backend` has read
+        CommFrame frame = comm_backend.pop();
+        const std::vector<char> &buffer = frame.body;
 
-        switch (head.type) {
+        switch (frame.type) {
             case msg::Type::INIT: {
-                std::vector<char> buffer(head.body_size);
-                comm_backend.read(buffer);
                 msg::Init body(buffer);
                 if (child.get() != nullptr) {
                     throw runtime_error("[VEM-PROXY] Received INIT messages multiple times!");
@@ -67,28 +111,99 @@ static void service(const std::string &address, int port) {
                     cout << "  MemCopy: " << time_mem_copy_total.count() << "s" << endl;
                     cout << "    Zip:   " << time_mem_copy_zip.count() << "s" << endl;
                     cout << "    Send:  " << nbytes_send / 1024.0 / 1024.0 << "MB" << endl;
+                    cout << "  GetData Zip: " << time_get_data_zip.count() << "s" << endl;
+                    cout << "  DataWait: " << time_data_wait.count() << "s" << endl;
+                    cout << "  EarlyExec: " << num_early_exec << endl;
                 }
                 return;
             }
-            case msg::Type::EXEC: {
-                std::vector<char> buffer(head.body_size);
-                comm_backend.read(buffer);
+            case msg::Type::EXEC:
+            case msg::Type::EXEC_CACHE:
+            case msg::Type::EXEC_REF: {
+                const auto wait_start = time_data_wait;
+                std::chrono::duration<double> time_exec{0};
                 vector<bh_base *> data_recv;
                 set<bh_base *> freed;
-                BhIR bhir(buffer, remote2local, data_recv, freed);
-
-                // Receive new base array data
+                BhIR bhir = frame.type == msg::Type::EXEC_REF ?
+                            batch_cache.instantiate(buffer, remote2local, data_recv, freed) :
+                            BhIR(buffer, remote2local, view_dict, data_recv, freed);
+                if (frame.type == msg::Type::EXEC_CACHE) {
+                    batch_cache.insert(buffer, bhir, data_recv);
+                }
                 for (bh_base *base: data_recv) {
                     base->resetDataPtr();
-                    auto data = comm_backend.recv_data();
-                    if (not data.empty()) {
+                }
+
+                // The new base array data follows as DATA messages in the order of `data_recv`
+                size_t nrecv = 0;
+                auto recv_next = [&]() {
+                    auto t = chrono::steady_clock::now();
+                    CommFrame data = comm_backend.pop();
+                    time_data_wait += chrono::steady_clock::now() - t;
+                    bh_base *base = data_recv[nrecv++];
+                    if (data.type == msg::Type::DATA_HANDLE) {
+                        // Notice, we adopt the mapping here since the main memory allocator is not thread-safe
+                        if (data.mapping != nullptr) {
+                            if (data.nbytes != static_cast<uint64_t>(base->nbytes())) {
+                                throw runtime_error("[VEM-PROXY] received shared memory of the wrong size");
+                            }
+                            bh_data_adopt(base, data.mapping);
+                        }
+                    } else if (data.type != msg::Type::DATA) {
+                        throw runtime_error("[VEM-PROXY] the backend expected array data");
+                    } else if (not data.data.empty()) {
                         bh_data_malloc(base);
-                        compression.uncompress(data, *base, compress_param);
+                        compression.uncompress(data.data, *base, compress_param);
+                    }
+                };
+
+                // When the data is still in flight, we execute the instructions that do not depend on it.
+                // A repeated BhIR cannot be split thus it has to wait for all of its data.
+                if (bhir.getNRepeats() == 1 and bhir.getRepeatCondition() == nullptr) {
+                    set<const bh_base *> pending(data_recv.begin(), data_recv.end());
+                    auto first = bhir.instr_list.begin();
+                    while (nrecv < data_recv.size()) {
+                        if (not comm_backend.ready()) {
+                            auto last = first;
+                            while (last != bhir.instr_list.end()) {
+                                bool ready = true;
+                                for (const bh_view &view: last->getViews()) {
+                                    if (util::exist(pending, view.base)) {
+                                        ready = false;
+                                        break;
+                                    }
+                                }
+                                if (not ready) {
+                                    break;
+                                }
+                                ++last;
+                            }
+                            if (last != first) {
+                                BhIR b(vector<bh_instruction>(first, last), bhir.getSyncs());
+                                auto t = chrono::steady_clock::now();
+                                child->execute(&b);
+                                time_exec += chrono::steady_clock::now() - t;
+                                first = last;
+                                ++num_early_exec;
+                            }
+                        }
+                        pending.erase(data_recv[nrecv]);
+                        recv_next();
+                    }
+                    bhir.instr_list.erase(bhir.instr_list.begin(), first);
+                } else {
+                    while (nrecv < data_recv.size()) {
+                        recv_next();
                     }
                 }
 
-                // Send the bhir down to the child
+                // Send the (rest of the) bhir down to the child
+                auto t = chrono::steady_clock::now();
                 child->execute(&bhir);
+                time_exec += chrono::steady_clock::now() - t;
+                if (record_costs) {
+                    exec_costs.emplace_back((time_data_wait - wait_start).count(), time_exec.count());
+                }
 
                 // Let's remove the freed base arrays
                 for (const bh_base *base: freed) {
@@ -98,60 +213,60 @@ static void service(const std::string &address, int port) {
                 break;
             }
             case msg::Type::GET_DATA: {
-                std::vector<char> buffer(head.body_size);
-                comm_backend.read(buffer);
                 msg::GetData body(buffer);
-
-                if (util::exist(remote2local, body.base)) {
-                    bh_base &local_base = remote2local.at(body.base);
-                    child->getMemoryPointer(local_base, true, false, false); // Note, we delay nullify to after comm.
-                    if (local_base.getDataPtr() != nullptr) {
-                        auto data = compression.compress(local_base, compress_param);
-                        comm_backend.send_data(data);
-                    } else {
-                        comm_backend.send_data({});
+                for (const bh_view &remote_view: body.views) {
+                    auto it = remote2local.find(remote_view.base);
+                    if (it == remote2local.end()) {
+                        if (body.reply) {
+                            send_view(bh_view(), compress_param, time_get_data_zip);
+                        }
+                        continue;
                     }
-                    if (body.nullify) {
-                        bh_data_free(&local_base);
-                        local_base.resetDataPtr();
+                    bh_view view = remote_view;
+                    view.base = &it->second;
+                    child->getMemoryPointer(*view.base, true, false, false); // Note, we delay nullify to after comm.
+                    if (body.reply) {
+                        send_view(view, compress_param, time_get_data_zip);
                     }
-                } else {
-                    comm_backend.send_data({});
                 }
                 if (body.nullify) {
-                    remote2local.erase(body.base);
+                    for (const bh_view &remote_view: body.views) {
+                        auto it = remote2local.find(remote_view.base);
+                        if (it != remote2local.end()) {
+                            bh_data_free(&it->second);
+                            remote2local.erase(it);
+                        }
+                    }
                 }
                 break;
             }
             case msg::Type::MEM_COPY: {
                 auto t1 = chrono::steady_clock::now();
-                std::vector<char> buffer(head.body_size);
-                comm_backend.read(buffer);
                 msg::MemCopy body(buffer);
-                if (util::exist(remote2local, body.src.base)) {
+                auto it = remote2local.find(body.src.base);
+                if (it != remote2local.end()) {
                     bh_view src = body.src;
-                    src.base = &remote2local.at(body.src.base);
+                    src.base = &it->second;
                     child->getMemoryPointer(*src.base, true, false, false);
-                    if (src.base->getDataPtr() != nullptr) {
-                        auto t2 = chrono::steady_clock::now();
-                        auto data = compression.compress(src, body.param);
-                        time_mem_copy_zip += chrono::steady_clock::now() - t2;
-                        nbytes_send += data.size();
-                        comm_backend.send_data(data);
-                    } else {
-                        comm_backend.send_data({});
-                    }
+                    nbytes_send += send_view(src, body.param, time_mem_copy_zip);
                 } else {
-                    comm_backend.send_data({});
+                    send_view(bh_view(), body.param, time_mem_copy_zip);
                 }
                 time_mem_copy_total += chrono::steady_clock::now() - t1;
                 break;
             }
             case msg::Type::MSG: {
-                std::vector<char> buffer(head.body_size);
-                comm_backend.read(buffer);
                 msg::Message body(buffer);
                 stringstream ss;
+                if (body.msg == cost_report_msg) {
+                    for (const auto &cost: exec_costs) {
+                        ss << cost.first << " " << cost.second << "\n";
+                    }
+                    exec_costs.clear();
+                    record_costs = true;
+                    comm_backend.write(ss.str());
+                    break;
+                }
                 if (body.msg == "info") {
                     ss << "  Backend: " << "\n";
                     ss << "    Hostname: " << comm_backend.hostname() << "\n";
@@ -0,0 +1,304 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <bohrium/bh_util.hpp>
+
+#include "batch_cache.hpp"
+
+using namespace std;
+
+namespace bohrium {
+
+namespace {
+// Tags that separates the fields of the structure
+constexpr uint64_t TAG_INSTR = UINT64_MAX;
+constexpr uint64_t TAG_CONSTANT = UINT64_MAX - 1;
+constexpr uint64_t TAG_BASE = UINT64_MAX - 2;
+
+/* The body of an EXEC_REF message, which is followed by the base array IDs in the order of first appearance
+ * (uint64_t[nbases]), the sync'ed base arrays (uint64_t[nsyncs]), and the values of the constants in the order
+ * of the instructions (bh_constant_value[nconstants]). Like in a serialized BhIR, base arrays are identified by
+ * their pointer on the frontend. */
+struct RefHeader {
+    uint32_t id;
+    uint32_t nbases;
+    uint32_t nconstants;
+    uint32_t nsyncs;
+    uint64_t repeat_condition; // Zero when there is no repeat condition
+};
+
+size_t ref_size(const RefHeader &head) {
+    return sizeof(RefHeader) + (head.nbases + head.nsyncs) * sizeof(uint64_t) +
+           head.nconstants * sizeof(bh_constant_value);
+}
+
+/* The structure of a view consists of the following fields:
+ * <base index><start><ndim>[<shape><stride>...]<nslide_dims>[<slide dim>...]<nslide_resets>[<slide reset>...]
+ * <iteration_counter>
+ */
+void hash_view(const bh_view &view, uint64_t base_index, jitk::StructuralHasher &hasher) {
+    hasher.add(base_index);
+    hasher.add_signed(view.start);
+    hasher.add_signed(view.ndim);
+    for (int64_t i = 0; i < view.ndim; ++i) {
+        hasher.add_signed(view.shape[i]);
+        hasher.add_signed(view.stride[i]);
+    }
+    hasher.add(view.slides.dims.size());
+    for (const bh_slide_dim &d: view.slides.dims) {
+        hasher.add_signed(d.rank);
+        hasher.add_signed(d.offset_change);
+        hasher.add_signed(d.shape_change);
+        hasher.add_signed(d.stride);
+        hasher.add_signed(d.shape);
+        hasher.add_signed(d.step_delay);
+    }
+    hasher.add(view.slides.resets.size());
+    for (const auto &reset: view.slides.resets) {
+        hasher.add_signed(reset.first);
+        hasher.add_signed(reset.second.first);
+        hasher.add_signed(reset.second.second);
+    }
+    hasher.add_signed(view.slides.iteration_counter);
+}
+} // Anon namespace
+
+msg::Type BatchCacheFrontend::write(BhIR &bhir, set<bh_base *> &known_base_arrays, BhIRViewDict &view_dict,
+                                    vector<bh_base *> &new_data, vector<char> &body) {
+    // Write the structure of `bhir` and find its base arrays and constants
+    vector<bh_base *> bases; // The base arrays in the order of first appearance
+    std::map<const bh_base *, uint64_t> base2index;
+    vector<bh_constant_value> constants;
+    _hasher.clear();
+    _hasher.add(bhir.getNRepeats());
+    for (const bh_instruction &instr: bhir.instr_list) {
+        _hasher.add(TAG_INSTR);
+        _hasher.add(static_cast<uint64_t>(instr.opcode));
+        _hasher.add(instr.operand.size());
+        for (const bh_view &view: instr.operand) {
+            if (view.isConstant()) {
+                _hasher.add(TAG_CONSTANT);
+                _hasher.add(static_cast<uint64_t>(instr.constant.type));
+                continue;
+            }
+            auto it = base2index.find(view.base);
+            if (it == base2index.end()) {
+                it = base2index.emplace(view.base, bases.size()).first;
+                bases.push_back(view.base);
+                // The backend creates the new base arrays thus their metadata is part of the structure
+                _hasher.add(TAG_BASE);
+                if (util::exist(known_base_arrays, view.base)) {
+                    _hasher.add(0);
+                } else {
+                    _hasher.add(1);
+                    _hasher.add_signed(view.base->nelem());
+                    _hasher.add(static_cast<uint64_t>(view.base->dtype()));
+                    _hasher.add(view.base->getDataPtr() != nullptr);
+                }
+            }
+            hash_view(view, it->second, _hasher);
+        }
+        if (instr.has_constant()) {
+            constants.push_back(instr.constant.value);
+        }
+    }
+
+    const jitk::Hash128 hash = _hasher.digest();
+    auto lookup = _cache.find(hash);
+    // NB: a hash collision is detected by comparing the fields and is handled as a cache miss
+    if (lookup != _cache.end() and lookup->second.fields == _hasher.fields()) { // Cache hit!
+        ++stat_hits;
+        for (bh_base *base: bases) {
+            if (not util::exist(known_base_arrays, base)) {
+                known_base_arrays.insert(base);
+                if (base->getDataPtr() != nullptr) {
+                    new_data.push_back(base);
+                }
+            }
+        }
+        const set<bh_base *> syncs = bhir.getSyncs();
+        RefHeader head{};
+        head.id = lookup->second.id;
+        head.nbases = static_cast<uint32_t>(bases.size());
+        head.nconstants = static_cast<uint32_t>(constants.size());
+        head.nsyncs = static_cast<uint32_t>(syncs.size());
+        bh_base *repeat_condition = bhir.getRepeatCondition();
+        if (repeat_condition != nullptr and util::exist(known_base_arrays, repeat_condition)) {
+            head.repeat_condition = reinterpret_cast<uint64_t>(repeat_condition);
+        }
+        body.resize(ref_size(head));
+        char *out = body.data();
+        memcpy(out, &head, sizeof(head));
+        out += sizeof(head);
+        for (const bh_base *base: bases) {
+            const auto id = reinterpret_cast<uint64_t>(base);
+            memcpy(out, &id, sizeof(id));
+            out += sizeof(id);
+        }
+        for (const bh_base *base: syncs) {
+            const auto id = reinterpret_cast<uint64_t>(base);
+            memcpy(out, &id, sizeof(id));
+            out += sizeof(id);
+        }
+        if (not constants.empty()) {
+            memcpy(out, constants.data(), constants.size() * sizeof(bh_constant_value));
+        }
+        stat_nbytes_ref += body.size();
+        if (lookup->second.nbytes > body.size()) {
+            stat_nbytes_saved += lookup->second.nbytes - body.size();
+        }
+        return msg::Type::EXEC_REF;
+    }
+
+    // Cache miss!
+    ++stat_misses;
+    body = bhir.writeSerialized(known_base_arrays, view_dict, new_data);
+    if (_next_id == batch_cache_max_size) {
+        _cache.clear();
+        _next_id = 0;
+    }
+    const uint32_t id = _next_id++;
+    // NB: on a hash collision, we replace the existing entry
+    _cache[hash] = Entry{_hasher.release(), id, body.size()};
+
+    // The ID of the new entry follows the serialized BhIR
+    body.resize(body.size() + sizeof(id));
+    memcpy(body.data() + body.size() - sizeof(id), &id, sizeof(id));
+    return msg::Type::EXEC_CACHE;
+}
+
+string BatchCacheFrontend::pprintStats() const {
+    stringstream ss;
+    ss << "BatchCache:\n";
+    ss << "  Hits:   " << stat_hits << "\n";
+    ss << "  Misses: " << stat_misses << "\n";
+    ss << "  Refs:   " << stat_nbytes_ref / 1024.0 << "KB\n";
+    ss << "  Saved:  " << stat_nbytes_saved / 1024.0 << "KB";
+    if (stat_hits > 0) {
+        ss << " (" << stat_nbytes_saved / stat_hits << "B per hit)";
+    }
+    ss << "\n";
+    return ss.str();
+}
+
+void BatchCacheBackend::insert(const vector<char> &body, const BhIR &bhir, const vector<bh_base *> &data_recv) {
+    uint32_t id;
+    if (body.size() < sizeof(id)) {
+        throw runtime_error("[VEM-PROXY] the EXEC_CACHE message is truncated");
+    }
+    memcpy(&id, body.data() + body.size() - sizeof(id), sizeof(id));
+    if (id >= batch_cache_max_size) {
+        throw runtime_error("[VEM-PROXY] the EXEC_CACHE message has an invalid ID");
+    }
+
+    const set<const bh_base *> has_data(data_recv.begin(), data_recv.end());
+    std::map<const bh_base *, uint64_t> base2index;
+    Entry entry;
+    entry.instr_list = bhir.instr_list;
+    entry.nconstants = 0;
+    entry.nrepeats = bhir.getNRepeats();
+    for (bh_instruction &instr: entry.instr_list) {
+        for (bh_view &view: instr.getViews()) {
+            auto it = base2index.find(view.base);
+            if (it == base2index.end()) {
+                it = base2index.emplace(view.base, entry.bases.size()).first;
+                entry.bases.push_back(BaseInfo{view.base->nelem(), view.base->dtype(),
+                                               util::exist(has_data, view.base)});
+            }
+            view.base = reinterpret_cast<bh_base *>(it->second + 1);
+        }
+        if (instr.has_constant()) {
+            ++entry.nconstants;
+        }
+    }
+    if (_cache.size() <= id) {
+        _cache.resize(id + 1);
+    }
+    _cache[id] = std::move(entry);
+}
+
+BhIR BatchCacheBackend::instantiate(const vector<char> &body, std::map<const bh_base *, bh_base> &remote2local,
+                                    vector<bh_base *> &data_recv, set<bh_base *> &frees) {
+    RefHeader head;
+    if (body.size() < sizeof(head)) {
+        throw runtime_error("[VEM-PROXY] the EXEC_REF message is truncated");
+    }
+    memcpy(&head, body.data(), sizeof(head));
+    if (head.id >= _cache.size() or body.size() != ref_size(head) or
+        head.nbases != _cache[head.id].bases.size() or head.nconstants != _cache[head.id].nconstants) {
+        throw runtime_error("[VEM-PROXY] the EXEC_REF message does not match the batch cache");
+    }
+    const Entry &entry = _cache[head.id];
+    const char *in = body.data() + sizeof(head);
+
+    // Translate the base array IDs into local base arrays, which are created when new
+    vector<bh_base *> remote(head.nbases);
+    vector<bh_base *> local(head.nbases);
+    for (uint32_t i = 0; i < head.nbases; ++i) {
+        uint64_t id;
+        memcpy(&id, in, sizeof(id));
+        in += sizeof(id);
+        remote[i] = reinterpret_cast<bh_base *>(id);
+        auto it = remote2local.find(remote[i]);
+        if (it == remote2local.end()) {
+            const BaseInfo &info = entry.bases[i];
+            it = remote2local.emplace(remote[i], bh_base(info.nelem, info.type)).first;
+            if (info.data) {
+                data_recv.push_back(&it->second);
+            }
+        }
+        local[i] = &it->second;
+    }
+    set<bh_base *> syncs;
+    for (uint32_t i = 0; i < head.nsyncs; ++i) {
+        uint64_t id;
+        memcpy(&id, in, sizeof(id));
+        in += sizeof(id);
+        auto it = remote2local.find(reinterpret_cast<const bh_base *>(id));
+        if (it != remote2local.end()) {
+            syncs.insert(&it->second);
+        }
+    }
+
+    // Copy the cached instructions and update their base arrays and constants
+    vector<bh_instruction> instr_list = entry.instr_list;
+    for (bh_instruction &instr: instr_list) {
+        if (instr.opcode == BH_FREE) {
+            frees.insert(remote[reinterpret_cast<uint64_t>(instr.operand[0].base) - 1]);
+        }
+        for (bh_view &view: instr.getViews()) {
+            view.base = local[reinterpret_cast<uint64_t>(view.base) - 1];
+        }
+        if (instr.has_constant()) {
+            memcpy(&instr.constant.value, in, sizeof(bh_constant_value));
+            in += sizeof(bh_constant_value);
+        }
+    }
+    bh_base *repeat_condition = nullptr;
+    if (head.repeat_condition != 0) {
+        repeat_condition = &remote2local.at(reinterpret_cast<const bh_base *>(head.repeat_condition));
+    }
+    return BhIR(std::move(instr_list), std::move(syncs), entry.nrepeats, repeat_condition);
+}
+
+} // Namespace bohrium
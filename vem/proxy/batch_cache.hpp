@@ -0,0 +1,107 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <vector>
+#include <map>
+#include <set>
+#include <bohrium/bh_ir.hpp>
+#include <bohrium/jitk/structural_hash.hpp>
+
+#include "serialize.hpp"
+
+namespace bohrium {
+
+/* The proxy frontend and backend keep identical caches of the BhIRs that the frontend has sent. A BhIR is cached
+ * as its structure, which is the instruction list without the constant values and with the base arrays replaced by
+ * their order of first appearance (as in the fuse cache). A repeated BhIR is sent as an EXEC_REF message: a
+ * reference to the cache entry plus the delta, which is the base array IDs, the constant values, the sync'ed arrays,
+ * and the repeat condition.
+ *
+ * The caches hold at most `max_size` entries. When the frontend runs out of IDs, it starts over from ID zero and the
+ * backend overwrites the old entries as they are re-used.
+ */
+constexpr uint32_t batch_cache_max_size = 1024;
+
+/** The cache of the serializing end (the proxy frontend) */
+class BatchCacheFrontend {
+    struct Entry {
+        std::vector<uint64_t> fields; // The structure, which verifies a cache hit
+        uint32_t id;
+        uint64_t nbytes; // The size of the serialized BhIR that created the entry
+    };
+    std::map<jitk::Hash128, Entry> _cache;
+    jitk::StructuralHasher _hasher;
+    uint32_t _next_id = 0;
+
+public:
+    // Some statistics
+    uint64_t stat_hits = 0;
+    uint64_t stat_misses = 0;
+    uint64_t stat_nbytes_ref = 0;   // Bytes sent as references
+    uint64_t stat_nbytes_saved = 0; // Bytes the references saved compared to the BhIRs that created the entries
+
+    /** Write `bhir` as the body of an EXEC_REF message when the cache has its structure. Otherwise, write `bhir`
+     *  through `BhIR::writeSerialized()` as the body of an EXEC_CACHE message and insert it into the cache.
+     *  The arguments are the arguments of `BhIR::writeSerialized()`, which are updated the same way.
+     *
+     * @return The message type of the written body
+     */
+    msg::Type write(BhIR &bhir, std::set<bh_base *> &known_base_arrays, BhIRViewDict &view_dict,
+                    std::vector<bh_base *> &new_data, std::vector<char> &body);
+
+    /** Pretty print the statistics */
+    std::string pprintStats() const;
+};
+
+/** The cache of the de-serializing end (the proxy backend) */
+class BatchCacheBackend {
+    struct BaseInfo {
+        int64_t nelem;
+        bh_type type;
+        bool data; // True when the base array is new and has data
+    };
+    struct Entry {
+        // The instructions where the base pointers are the index into `bases` plus one (null is a constant)
+        std::vector<bh_instruction> instr_list;
+        std::vector<BaseInfo> bases;
+        uint32_t nconstants;
+        uint64_t nrepeats;
+    };
+    std::vector<Entry> _cache;
+
+public:
+    /** Insert the de-serialized BhIR of an EXEC_CACHE message into the cache. Call this before `bhir` is executed
+     *  since the execution might change it.
+     *
+     * @param body      The EXEC_CACHE message body that `bhir` was de-serialized from
+     * @param bhir      The de-serialized BhIR
+     * @param data_recv The new base arrays with data, which the de-serialization returned
+     */
+    void insert(const std::vector<char> &body, const BhIR &bhir, const std::vector<bh_base *> &data_recv);
+
+    /** Returns the BhIR of the body of an EXEC_REF message. The arguments are the arguments of the de-serializing
+     *  constructor of BhIR (except for the view dictionary, which a reference does not use) and are updated the
+     *  same way. */
+    BhIR instantiate(const std::vector<char> &body, std::map<const bh_base *, bh_base> &remote2local,
+                     std::vector<bh_base *> &data_recv, std::set<bh_base *> &frees);
+};
+
+} // Namespace bohrium
@@ -0,0 +1,427 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <zlib.h>
+#ifdef BH_PROXY_LZ4
+#include <lz4.h>
+#endif
+#ifdef BH_PROXY_ZSTD
+#include <zstd.h>
+#endif
+
+#include "chunked.hpp"
+
+using namespace std;
+
+namespace bohrium {
+namespace chunked {
+
+namespace {
+constexpr uint32_t magic = 0x5a434842; // "BHCZ"
+constexpr uint8_t version = 1;
+
+struct Head {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t codec;
+    uint8_t filter;
+    uint8_t padding;
+    uint64_t elem_size;
+    uint64_t nbytes;
+    uint64_t chunk_size;
+    uint64_t nchunks;
+};
+
+// Byte-shuffle `n` bytes of elements of `elem_size` bytes. The trailing bytes of an incomplete element are copied.
+void shuffle(const unsigned char *src, unsigned char *dst, uint64_t n, uint64_t elem_size) {
+    const uint64_t nelem = n / elem_size;
+    for (uint64_t b = 0; b < elem_size; ++b) {
+        for (uint64_t i = 0; i < nelem; ++i) {
+            dst[b * nelem + i] = src[i * elem_size + b];
+        }
+    }
+    memcpy(dst + nelem * elem_size, src + nelem * elem_size, n - nelem * elem_size);
+}
+
+void unshuffle(const unsigned char *src, unsigned char *dst, uint64_t n, uint64_t elem_size) {
+    const uint64_t nelem = n / elem_size;
+    for (uint64_t b = 0; b < elem_size; ++b) {
+        for (uint64_t i = 0; i < nelem; ++i) {
+            dst[i * elem_size + b] = src[b * nelem + i];
+        }
+    }
+    memcpy(dst + nelem * elem_size, src + nelem * elem_size, n - nelem * elem_size);
+}
+
+// Transpose the 8x8 bit-matrix of each 8-byte block in-place. The transpose is its own inverse.
+void bitTranspose(unsigned char *buf, uint64_t n) {
+    for (uint64_t i = 0; i + 8 <= n; i += 8) {
+        uint64_t x, t;
+        memcpy(&x, buf + i, 8);
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+        x = x ^ t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+        x = x ^ t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+        x = x ^ t ^ (t << 28);
+        memcpy(buf + i, &x, 8);
+    }
+}
+
+// Compress `n` bytes of `src` into `dst`, which has room for `capacity` bytes.
+// Returns the compressed size or zero when the result does not fit.
+uint64_t codecCompress(Codec codec, int level, const unsigned char *src, uint64_t n,
+                       unsigned char *dst, uint64_t capacity) {
+    switch (codec) {
+        case Codec::NONE:
+            return 0;
+        case Codec::ZLIB: {
+            uLongf size = capacity;
+            const int err = ::compress2(dst, &size, src, n, level == 0 ? Z_DEFAULT_COMPRESSION : level);
+            return err == Z_OK ? size : 0;
+        }
+#ifdef BH_PROXY_LZ4
+        case Codec::LZ4: {
+            // The level is the LZ4 acceleration factor
+            const int size = LZ4_compress_fast(reinterpret_cast<const char *>(src), reinterpret_cast<char *>(dst),
+                                               static_cast<int>(n), static_cast<int>(capacity),
+                                               level == 0 ? 1 : level);
+            return size > 0 ? static_cast<uint64_t>(size) : 0;
+        }
+#endif
+#ifdef BH_PROXY_ZSTD
+        case Codec::ZSTD: {
+            const size_t size = ZSTD_compress(dst, capacity, src, n, level == 0 ? 1 : level);
+            return ZSTD_isError(size) ? 0 : size;
+        }
+#endif
+        default:
+            throw runtime_error("chunked compress(): the codec is not supported by this build");
+    }
+}
+
+void codecUncompress(Codec codec, const unsigned char *src, uint64_t n, unsigned char *dst, uint64_t dst_nbytes) {
+    switch (codec) {
+        case Codec::ZLIB: {
+            uLongf size = dst_nbytes;
+            if (::uncompress(dst, &size, src, n) != Z_OK or size != dst_nbytes) {
+                throw runtime_error("chunked uncompress(): zlib failed");
+            }
+            return;
+        }
+#ifdef BH_PROXY_LZ4
+        case Codec::LZ4: {
+            const int size = LZ4_decompress_safe(reinterpret_cast<const char *>(src), reinterpret_cast<char *>(dst),
+                                                 static_cast<int>(n), static_cast<int>(dst_nbytes));
+            if (size < 0 or static_cast<uint64_t>(size) != dst_nbytes) {
+                throw runtime_error("chunked uncompress(): lz4 failed");
+            }
+            return;
+        }
+#endif
+#ifdef BH_PROXY_ZSTD
+        case Codec::ZSTD: {
+            const size_t size = ZSTD_decompress(dst, dst_nbytes, src, n);
+            if (ZSTD_isError(size) or size != dst_nbytes) {
+                throw runtime_error("chunked uncompress(): zstd failed");
+            }
+            return;
+        }
+#endif
+        default:
+            throw runtime_error("chunked uncompress(): the codec is not supported by this build");
+    }
+}
+
+// Filter and compress one chunk into `out`, which is resized to the stored size of the chunk.
+// `scratch` must have room for `n` bytes.
+void compressChunk(const unsigned char *src, uint64_t n, uint64_t elem_size, const Options &opt,
+                   unsigned char *scratch, vector<unsigned char> &out) {
+    const unsigned char *in = src;
+    if (opt.filter != Filter::NONE and opt.codec != Codec::NONE) {
+        shuffle(src, scratch, n, elem_size);
+        if (opt.filter == Filter::BITSHUFFLE) {
+            bitTranspose(scratch, n);
+        }
+        in = scratch;
+    }
+    out.resize(n);
+    // We only keep the compressed chunk when it is smaller than the raw chunk
+    const uint64_t size = n > 1 ? codecCompress(opt.codec, opt.level, in, n, out.data(), n - 1) : 0;
+    if (size == 0) {
+        memcpy(out.data(), src, n);
+    } else {
+        out.resize(size);
+    }
+}
+
+// Run `body(i)` for i in [0, n) using `pool` when there is more than one iteration.
+// The pool does not handle exceptions thus we pass the first one on to the caller.
+void forEach(uint64_t n, jitk::ThreadPool *pool, const std::function<void(uint64_t)> &body) {
+    if (pool == nullptr or n < 2) {
+        for (uint64_t i = 0; i < n; ++i) {
+            body(i);
+        }
+        return;
+    }
+    std::mutex mutex;
+    std::exception_ptr error;
+    pool->parallelFor(n, 1, 0, [&](uint64_t begin, uint64_t end) {
+        try {
+            for (uint64_t i = begin; i < end; ++i) {
+                body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (not error) {
+                error = std::current_exception();
+            }
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+} // Anonymous namespace
+
+std::string Options::str() const {
+    string ret;
+    switch (codec) {
+        case Codec::NONE: ret = "none"; break;
+        case Codec::ZLIB: ret = "zlib"; break;
+        case Codec::LZ4:  ret = "lz4"; break;
+        case Codec::ZSTD: ret = "zstd"; break;
+    }
+    if (level != 0) {
+        ret += "," + to_string(level);
+    }
+    if (filter == Filter::SHUFFLE) {
+        ret += ",shuffle";
+    } else if (filter == Filter::BITSHUFFLE) {
+        ret += ",bitshuffle";
+    }
+    return ret;
+}
+
+bool available(Codec codec) {
+    switch (codec) {
+        case Codec::NONE:
+        case Codec::ZLIB:
+            return true;
+#ifdef BH_PROXY_LZ4
+        case Codec::LZ4:
+            return true;
+#endif
+#ifdef BH_PROXY_ZSTD
+        case Codec::ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool isCodec(const std::string &name) {
+    return name == "zlib" or name == "lz4" or name == "zstd";
+}
+
+Options parse(const std::vector<std::string> &param_list) {
+    Options ret;
+    if (param_list[0] == "lz4") {
+        ret.codec = Codec::LZ4;
+    } else if (param_list[0] == "zstd") {
+        ret.codec = Codec::ZSTD;
+    } else if (param_list[0] != "zlib") {
+        throw runtime_error("compress(): unknown codec '" + param_list[0] + "'");
+    }
+    if (not available(ret.codec)) {
+        throw runtime_error("compress(): the codec '" + param_list[0] + "' is not supported by this build");
+    }
+    for (size_t i = 1; i < param_list.size(); ++i) {
+        const string &p = param_list[i];
+        if (p == "shuffle") {
+            ret.filter = Filter::SHUFFLE;
+        } else if (p == "bitshuffle") {
+            ret.filter = Filter::BITSHUFFLE;
+        } else if (p.compare(0, 6, "chunk=") == 0) {
+            ret.chunk_size = std::stoull(p.substr(6)) * 1024;
+            if (ret.chunk_size == 0 or ret.chunk_size > (1u << 30)) {
+                throw runtime_error("compress(): the chunk size must be between 1 KiB and 1 GiB");
+            }
+        } else {
+            ret.level = std::stoi(p);
+        }
+    }
+    return ret;
+}
+
+std::vector<unsigned char> compress(const void *data, uint64_t nbytes, uint64_t elem_size, const Options &opt,
+                                    jitk::ThreadPool *pool) {
+    // The chunks must consist of whole elements for the filters to line up
+    const uint64_t chunk_size = std::max(elem_size, opt.chunk_size / elem_size * elem_size);
+    const uint64_t nchunks = (nbytes + chunk_size - 1) / chunk_size;
+    const auto *src = static_cast<const unsigned char *>(data);
+
+    vector<vector<unsigned char> > chunks(nchunks);
+    forEach(nchunks, pool, [&](uint64_t i) {
+        const uint64_t offset = i * chunk_size;
+        const uint64_t n = std::min(chunk_size, nbytes - offset);
+        vector<unsigned char> scratch(opt.filter == Filter::NONE ? 0 : n);
+        compressChunk(src + offset, n, elem_size, opt, scratch.data(), chunks[i]);
+    });
+
+    Head head{};
+    head.magic = magic;
+    head.version = version;
+    head.codec = static_cast<uint8_t>(opt.codec);
+    head.filter = static_cast<uint8_t>(opt.filter);
+    head.elem_size = elem_size;
+    head.nbytes = nbytes;
+    head.chunk_size = chunk_size;
+    head.nchunks = nchunks;
+
+    uint64_t total = sizeof(Head) + nchunks * sizeof(uint64_t);
+    for (const auto &c: chunks) {
+        total += c.size();
+    }
+    vector<unsigned char> ret(total);
+    unsigned char *out = ret.data();
+    memcpy(out, &head, sizeof(Head));
+    out += sizeof(Head);
+    for (const auto &c: chunks) {
+        const uint64_t size = c.size();
+        memcpy(out, &size, sizeof(size));
+        out += sizeof(size);
+    }
+    for (const auto &c: chunks) {
+        memcpy(out, c.data(), c.size());
+        out += c.size();
+    }
+    return ret;
+}
+
+void uncompress(const std::vector<unsigned char> &data, void *dest, uint64_t dest_nbytes, jitk::ThreadPool *pool) {
+    Head head;
+    if (data.size() < sizeof(Head)) {
+        throw runtime_error("chunked uncompress(): truncated container");
+    }
+    memcpy(&head, data.data(), sizeof(Head));
+    if (head.magic != magic or head.version != version) {
+        throw runtime_error("chunked uncompress(): not a container of this version");
+    }
+    if (head.nbytes != dest_nbytes or head.elem_size == 0 or head.chunk_size == 0 or
+        head.nchunks != (head.nbytes + head.chunk_size - 1) / head.chunk_size) {
+        throw runtime_error("chunked uncompress(): the container does not match the destination");
+    }
+    const auto codec = static_cast<Codec>(head.codec);
+    const auto filter = static_cast<Filter>(head.filter);
+
+    // Find the offset of each chunk
+    const unsigned char *sizes = data.data() + sizeof(Head);
+    if (data.size() < sizeof(Head) + head.nchunks * sizeof(uint64_t)) {
+        throw runtime_error("chunked uncompress(): truncated container");
+    }
+    vector<uint64_t> offsets(head.nchunks + 1);
+    offsets[0] = sizeof(Head) + head.nchunks * sizeof(uint64_t);
+    for (uint64_t i = 0; i < head.nchunks; ++i) {
+        uint64_t size;
+        memcpy(&size, sizes + i * sizeof(uint64_t), sizeof(size));
+        offsets[i + 1] = offsets[i] + size;
+    }
+    if (offsets.back() != data.size()) {
+        throw runtime_error("chunked uncompress(): truncated container");
+    }
+
+    auto *dst = static_cast<unsigned char *>(dest);
+    forEach(head.nchunks, pool, [&](uint64_t i) {
+        const unsigned char *src = data.data() + offsets[i];
+        const uint64_t size = offsets[i + 1] - offsets[i];
+        const uint64_t offset = i * head.chunk_size;
+        const uint64_t n = std::min(head.chunk_size, head.nbytes - offset);
+        if (size == n) { // Stored as is
+            memcpy(dst + offset, src, n);
+        } else if (filter == Filter::NONE) {
+            codecUncompress(codec, src, size, dst + offset, n);
+        } else {
+            vector<unsigned char> scratch(n);
+            codecUncompress(codec, src, size, scratch.data(), n);
+            if (filter == Filter::BITSHUFFLE) {
+                bitTranspose(scratch.data(), n);
+            }
+            unshuffle(scratch.data(), dst + offset, n, head.elem_size);
+        }
+    });
+}
+
+Options pick(const void *data, uint64_t nbytes, uint64_t elem_size, double link_bandwidth, uint64_t nthreads) {
+    Options ret;
+    ret.codec = Codec::NONE;
+    if (nbytes < 4096) {
+        return ret;
+    }
+
+    // The candidates ordered by increasing compression effort
+    vector<Options> candidates;
+    for (Codec codec: {Codec::LZ4, Codec::ZSTD, Codec::ZLIB}) {
+        if (available(codec)) {
+            Options opt;
+            opt.codec = codec;
+            opt.level = codec == Codec::LZ4 ? 0 : 1;
+            if (elem_size > 1) {
+                opt.filter = Filter::SHUFFLE;
+                candidates.push_back(opt);
+            }
+            opt.filter = Filter::NONE;
+            candidates.push_back(opt);
+        }
+    }
+
+    // A sample from the middle of the data
+    const uint64_t sample_size = std::min(nbytes, uint64_t{256 * 1024}) / elem_size * elem_size;
+    const uint64_t sample_offset = (nbytes - sample_size) / 2 / elem_size * elem_size;
+    const auto *sample = static_cast<const unsigned char *>(data) + sample_offset;
+
+    double best = link_bandwidth; // The throughput of sending the raw data
+    vector<unsigned char> scratch(sample_size), out;
+    for (const Options &opt: candidates) {
+        auto t = chrono::steady_clock::now();
+        compressChunk(sample, sample_size, elem_size, opt, scratch.data(), out);
+        const chrono::duration<double> time = chrono::steady_clock::now() - t;
+        const double speed = time.count() > 0 ? sample_size * nthreads / time.count()
+                                              : numeric_limits<double>::infinity();
+        const double throughput = std::min(speed, link_bandwidth * sample_size / out.size());
+        if (throughput > best) {
+            best = throughput;
+            ret = opt;
+        }
+    }
+    return ret;
+}
+
+} // chunked
+} // bohrium
@@ -0,0 +1,109 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <bohrium/jitk/thread_pool.hpp>
+
+namespace bohrium {
+namespace chunked {
+
+/* The chunked container format splits an array into fixed-size chunks, which are filtered and compressed
+ * independently thus in parallel:
+ *
+ *     Head | uint64 stored size of each chunk | chunk 0 | chunk 1 | ...
+ *
+ * A chunk that does not compress is stored as is, which we recognize by its stored size being its raw size.
+ */
+
+/** The compression library of each chunk */
+enum class Codec : uint8_t {
+    NONE = 0,
+    ZLIB = 1,
+    LZ4  = 2,
+    ZSTD = 3,
+};
+
+/** The pre-filter that reorders the bytes of typed data before compression */
+enum class Filter : uint8_t {
+    NONE       = 0,
+    SHUFFLE    = 1, // Groups the i'th byte of all elements
+    BITSHUFFLE = 2, // Shuffle followed by an 8x8 bit-transpose of each 8-byte block
+};
+
+/** The compression options */
+struct Options {
+    Codec codec = Codec::ZLIB;
+    Filter filter = Filter::NONE;
+    int level = 0; // Codec specific, zero means the codec default
+    uint64_t chunk_size = 1024 * 1024;
+
+    /** Returns the options as a `compress_param` string */
+    std::string str() const;
+};
+
+/** Returns true when this build supports `codec` */
+bool available(Codec codec);
+
+/** Returns true when `name` is the name of a chunked codec: "zlib", "lz4", or "zstd" */
+bool isCodec(const std::string &name);
+
+/** Parse the `compress_param` list "<codec>[,<level>][,shuffle|bitshuffle][,chunk=<KiB>]" */
+Options parse(const std::vector<std::string> &param_list);
+
+/** Compress `nbytes` of `data` using `pool` (if not null) to compress the chunks in parallel
+ *
+ * @param data       The data to compress
+ * @param nbytes     The number of bytes in `data`
+ * @param elem_size  The size of each element in `data`, which the filters need
+ * @param opt        The options
+ * @param pool       The thread pool or null
+ * @return           The container
+ */
+std::vector<unsigned char> compress(const void *data, uint64_t nbytes, uint64_t elem_size, const Options &opt,
+                                    jitk::ThreadPool *pool);
+
+/** Uncompress the container `data` into `dest` using `pool` (if not null) to uncompress the chunks in parallel
+ *
+ * @param data         The container
+ * @param dest         The destination
+ * @param dest_nbytes  The size of the destination, which must match the size of the uncompressed data
+ * @param pool         The thread pool or null
+ */
+void uncompress(const std::vector<unsigned char> &data, void *dest, uint64_t dest_nbytes, jitk::ThreadPool *pool);
+
+/** Pick the codec and filter of the best estimated throughput for `data` when sent over a link of
+ *  `link_bandwidth` bytes per second. The throughput of each candidate is the lesser of its compression
+ *  speed (measured on a sample of `data`) and the link bandwidth times its compression ratio.
+ *
+ * @param data            The data to compress
+ * @param nbytes          The number of bytes in `data`
+ * @param elem_size       The size of each element in `data`
+ * @param link_bandwidth  The bandwidth of the link in bytes per second
+ * @param nthreads        The number of threads that will compress the chunks
+ * @return                The picked options
+ */
+Options pick(const void *data, uint64_t nbytes, uint64_t elem_size, double link_bandwidth, uint64_t nthreads);
+
+} // chunked
+} // bohrium
@@ -19,65 +19,114 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <iostream>
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <thread>         // std::this_thread::sleep_for
 #include <chrono>         // std::chrono::seconds
-#include <zlib.h>
+#include <unistd.h>
 #include <bohrium/bh_main_memory.hpp>
 
 #include "serialize.hpp"
 #include "comm.hpp"
 
 
-using boost::asio::ip::tcp;
 using namespace std;
 
-namespace {
-void comm_send_data(boost::asio::ip::tcp::socket &socket, const std::vector<unsigned char> &data) {
-    if (data.empty()) {
-        const size_t size[] = {0};
-        boost::asio::write(socket, boost::asio::buffer(size));
-    } else {
-        const size_t size[] = {data.size()};
-        boost::asio::write(socket, boost::asio::buffer(size));
-        boost::asio::write(socket, boost::asio::buffer(data, data.size()));
+void CommRecvQueue::start(Transport &transport, uint64_t sim_bandwidth, std::chrono::duration<double> sim_rtt) {
+    receiver = std::thread(&CommRecvQueue::receiver_loop, this, std::ref(transport), sim_bandwidth, sim_rtt);
+}
+
+void CommRecvQueue::join() {
+    if (receiver.joinable()) {
+        receiver.join();
+    }
+}
+
+void CommRecvQueue::receiver_loop(Transport &transport, uint64_t sim_bandwidth,
+                                  std::chrono::duration<double> sim_rtt) {
+    try {
+        while (true) {
+            vector<char> buf_head(msg::HeaderSize);
+            transport.read(buf_head.data(), buf_head.size());
+            msg::Header head(buf_head);
+
+            CommFrame frame;
+            frame.type = head.type;
+            if (head.type == msg::Type::DATA) {
+                auto t = chrono::steady_clock::now();
+                frame.data.resize(head.body_size);
+                transport.read(frame.data.data(), frame.data.size());
+                if (sim_bandwidth > 0) {
+                    std::chrono::duration<double> comm_time = chrono::steady_clock::now() - t;
+                    std::chrono::duration<double> sim_time{frame.data.size() / (double) sim_bandwidth};
+                    if (comm_time < sim_time) {
+                        std::this_thread::sleep_for(sim_time - comm_time);
+                    }
+                }
+            } else if (head.type == msg::Type::DATA_HANDLE) {
+                // The body size is the size of the shared memory, which has no body in the stream
+                frame.nbytes = head.body_size;
+                if (frame.nbytes > 0) {
+                    frame.mapping = shmMap(transport.popHandle(), frame.nbytes);
+                }
+            } else {
+                frame.body.resize(head.body_size);
+                transport.read(frame.body.data(), frame.body.size());
+            }
+            {
+                const auto arrival = chrono::steady_clock::now() +
+                                     chrono::duration_cast<chrono::steady_clock::duration>(sim_rtt);
+                std::unique_lock<std::mutex> lock(mtx);
+                queue.push_back(std::move(frame));
+                arrivals.push_back(arrival);
+            }
+            cond.notify_all();
+            if (head.type == msg::Type::SHUTDOWN) {
+                return;
+            }
+        }
+    } catch (...) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            error = std::current_exception();
+        }
+        cond.notify_all();
     }
 }
 
-std::vector<unsigned char> comm_recv_data(boost::asio::ip::tcp::socket &socket) {
-    size_t size[1];
-    boost::asio::read(socket, boost::asio::buffer(size));
-    std::vector<unsigned char> ret(size[0]);
-    if (not ret.empty()) {
-        boost::asio::read(socket, boost::asio::buffer(ret));
+CommFrame CommRecvQueue::pop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [this] { return error or not queue.empty(); });
+    if (queue.empty()) {
+        std::rethrow_exception(error);
     }
+    CommFrame ret = std::move(queue.front());
+    const auto arrival = arrivals.front();
+    queue.pop_front();
+    arrivals.pop_front();
+    lock.unlock();
+    std::this_thread::sleep_until(arrival);
     return ret;
 }
+
+bool CommRecvQueue::ready() {
+    std::unique_lock<std::mutex> lock(mtx);
+    return not queue.empty() and arrivals.front() <= chrono::steady_clock::now();
 }
 
 CommFrontend::CommFrontend(int stack_level,
                            const std::string &address,
                            int port,
-                           uint64_t sim_bandwidth) : sim_bandwidth(sim_bandwidth), socket(io_service) {
+                           uint64_t sim_bandwidth,
+                           size_t send_queue_limit,
+                           const std::string &transport_kind,
+                           std::chrono::duration<double> sim_rtt) : sim_bandwidth(sim_bandwidth),
+                                                                    send_queue_limit(send_queue_limit) {
     constexpr unsigned int retries = 100;
     for (unsigned int i = 1; i <= retries; ++i) {
         try {
             cout << "[PROXY-VEM] Connecting to " << address << ":" << port << endl;
-            // Get a list of endpoints corresponding to the server name.
-            tcp::resolver resolver(io_service);
-            tcp::resolver::query query(address, to_string(port));
-            tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
-            tcp::resolver::iterator end;
-
-            // Try each endpoint until we successfully establish a connection.
-            boost::system::error_code error = boost::asio::error::host_not_found;
-            while (error && endpoint_iterator != end) {
-                socket.close();
-                socket.connect(*endpoint_iterator++, error);
-            }
-            if (error)
-                throw boost::system::system_error(error);
-            socket.set_option(boost::asio::ip::tcp::no_delay(true));
+            transport = transportConnect(address, port, transport_kind);
             goto connected;
         }
         catch (const boost::system::system_error &e) {
@@ -99,9 +148,11 @@ CommFrontend::CommFrontend(int stack_level,
     msg::Header head(msg::Type::INIT, buf_body.size());
     head.serialize(buf_head);
 
-    //Send serialized message
-    write(buf_head);
-    write(buf_body);
+    // Start the sender and receiver threads and send the serialized message
+    sender = std::thread(&CommFrontend::sender_loop, this);
+    recv_queue.start(*transport, sim_bandwidth, sim_rtt);
+    write(std::move(buf_head));
+    write(std::move(buf_body));
 }
 
 CommFrontend::~CommFrontend() {
@@ -110,68 +161,238 @@ CommFrontend::~CommFrontend() {
     msg::Header head(msg::Type::SHUTDOWN, 0);
     head.serialize(buf_head);
 
-    //Send serialized message
-    boost::asio::write(socket, boost::asio::buffer(buf_head));
-    socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both);
-    socket.close();
+    //Send serialized message and stop the sender thread when the queue is empty
+    try {
+        write(std::move(buf_head));
+        flush();
+    } catch (const std::exception &e) {
+        cerr << "[PROXY-VEM] " << e.what() << endl;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cond.notify_all();
+    sender.join();
+    // The backend closes the connection when it has handled the SHUTDOWN message, which stops the receiver thread
+    recv_queue.join();
+    transport->shutdown();
 }
 
-void CommFrontend::send_data(const std::vector<unsigned char> &data) {
-    auto t = chrono::steady_clock::now();
-    comm_send_data(socket, data);
-    std::chrono::duration<double> comm_time = chrono::steady_clock::now() - t;
-    std::chrono::duration<double> sim_time = std::chrono::duration<double>{data.size() / (double) sim_bandwidth};
-    if (comm_time < sim_time) {
-        sim_time -= comm_time;
+void CommFrontend::sender_loop() {
+    while (true) {
+        SendFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cond.wait(lock, [this] { return stopping or not send_queue.empty(); });
+            if (send_queue.empty()) {
+                return;
+            }
+            frame = std::move(send_queue.front());
+            send_queue.pop_front();
+            sending = true;
+        }
+        // On error, we drop the rest of the queue and let the caller rethrow the error
+        std::chrono::duration<double> comm_time{0};
+        try {
+            auto t = chrono::steady_clock::now();
+            if (frame.data.empty()) {
+                transport->write({boost::asio::buffer(frame.head)}, frame.handle);
+            } else {
+                transport->write({boost::asio::buffer(frame.head), boost::asio::buffer(frame.data)}, frame.handle);
+            }
+            comm_time = chrono::steady_clock::now() - t;
+            if (sim_bandwidth > 0) {
+                const size_t nbytes = frame.head.size() + frame.data.size() + frame.handle_nbytes;
+                std::chrono::duration<double> sim_time{nbytes / (double) sim_bandwidth};
+                if (comm_time < sim_time) {
+                    std::this_thread::sleep_for(sim_time - comm_time);
+                    comm_time = sim_time;
+                }
+            }
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(mtx);
+            send_error = std::current_exception();
+            send_queue_nbytes = 0;
+            for (const SendFrame &f: send_queue) {
+                if (f.handle != -1) {
+                    ::close(f.handle);
+                }
+            }
+            send_queue.clear();
+        }
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            send_queue_nbytes -= std::min(send_queue_nbytes,
+                                          frame.head.size() + frame.data.size() + frame.handle_nbytes);
+            sending = false;
+            if (not frame.data.empty()) {
+                nbytes_sent += frame.data.size();
+                time_sent += comm_time;
+            }
+            if (frame.tag != 0) {
+                time_sent_by_tag[frame.tag] += comm_time;
+            }
+        }
+        cond.notify_all();
     }
-    if (sim_time.count() > 0) {
-        std::this_thread::sleep_for(sim_time);
+}
+
+void CommFrontend::push(std::vector<char> head, std::vector<unsigned char> data, int handle,
+                        uint64_t handle_nbytes) {
+    // Notice, the shared memory of a queued handle counts towards the limit as well
+    const size_t nbytes = head.size() + data.size() + handle_nbytes;
+    std::unique_lock<std::mutex> lock(mtx);
+    if (send_queue_nbytes > 0 and send_queue_nbytes + nbytes > send_queue_limit) {
+        auto t = chrono::steady_clock::now();
+        cond.wait(lock, [&] {
+            return send_error or send_queue_nbytes == 0 or send_queue_nbytes + nbytes <= send_queue_limit;
+        });
+        time_send_wait += chrono::steady_clock::now() - t;
+    }
+    if (send_error) {
+        if (handle != -1) {
+            ::close(handle);
+        }
+        std::rethrow_exception(send_error);
     }
+    send_queue.push_back(SendFrame{std::move(head), std::move(data), handle, handle_nbytes, current_tag});
+    send_queue_nbytes += nbytes;
+    lock.unlock();
+    cond.notify_all();
 }
 
-std::vector<unsigned char> CommFrontend::recv_data() {
-    auto t = chrono::steady_clock::now();
-    std::vector<unsigned char> ret = comm_recv_data(socket);
-    std::chrono::duration<double> comm_time = chrono::steady_clock::now() - t;
-    std::chrono::duration<double> sim_time = std::chrono::duration<double>{ret.size() / (double) sim_bandwidth};
-    if (comm_time < sim_time) {
-        sim_time -= comm_time;
+void CommFrontend::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [this] { return send_error or (send_queue.empty() and not sending); });
+    if (send_error) {
+        std::rethrow_exception(send_error);
     }
-    if (sim_time.count() > 0) {
-        std::this_thread::sleep_for(sim_time);
+}
+
+std::chrono::duration<double> CommFrontend::timeSent(uint64_t tag) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = time_sent_by_tag.find(tag);
+    if (it == time_sent_by_tag.end()) {
+        return std::chrono::duration<double>{0};
     }
+    const std::chrono::duration<double> ret = it->second;
+    time_sent_by_tag.erase(it);
     return ret;
 }
 
+double CommFrontend::bandwidth() {
+    if (sim_bandwidth > 0) {
+        return sim_bandwidth;
+    }
+    // We need a few MB before the measurement means anything
+    std::unique_lock<std::mutex> lock(mtx);
+    return nbytes_sent > 4 * 1024 * 1024 and time_sent.count() > 0 ? nbytes_sent / time_sent.count() : 0;
+}
+
+void CommFrontend::send_data(std::vector<unsigned char> data) {
+    vector<char> buf_head;
+    msg::Header head(msg::Type::DATA, data.size());
+    head.serialize(buf_head);
+    push(std::move(buf_head), std::move(data));
+}
+
+void CommFrontend::send_handle(const void *data, uint64_t nbytes) {
+    vector<char> buf_head;
+    msg::Header head(msg::Type::DATA_HANDLE, nbytes);
+    head.serialize(buf_head);
+    push(std::move(buf_head), {}, nbytes > 0 ? shmCreate(data, nbytes) : -1, nbytes);
+}
+
 std::string CommFrontend::read() {
-    vector<char> str_vec;
-    while(1) {
-        char buf;
-        size_t bytes = boost::asio::read(socket, boost::asio::buffer(&buf, 1));
-        if (bytes != 1 or buf == '\0') {
-            break;
-        }
-        str_vec.push_back(buf);
+    CommFrame frame = pop();
+    if (frame.type != msg::Type::MSG) {
+        throw runtime_error("[PROXY-VEM] the frontend expected a message reply");
     }
-    return std::string(str_vec.begin(), str_vec.end());
+    return std::string(frame.body.begin(), frame.body.end());
 }
 
-CommBackend::CommBackend(const std::string &address, int port) : socket(io_service) {
+CommBackend::CommBackend(const std::string &address, int port) {
     cout << "[PROXY-VEM] Server listen on port " << port << endl;
-    tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
-    acceptor.accept(socket);
-    socket.set_option(boost::asio::ip::tcp::no_delay(true));
+    transport = transportAccept(port);
+    recv_queue.start(*transport);
 }
 
 CommBackend::~CommBackend() {
-    socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both);
-    socket.close();
+    // Notice, the shutdown makes a blocking read in the receiver thread return
+    transport->shutdown();
+    recv_queue.join();
+}
+
+void CommBackend::write(const std::string &str) {
+    vector<char> buf_head;
+    msg::Header head(msg::Type::MSG, str.size());
+    head.serialize(buf_head);
+    transport->write({boost::asio::buffer(buf_head), boost::asio::buffer(str)});
 }
 
 void CommBackend::send_data(const std::vector<unsigned char> &data) {
-    comm_send_data(socket, data);
+    vector<char> buf_head;
+    msg::Header head(msg::Type::DATA, data.size());
+    head.serialize(buf_head);
+    auto t = chrono::steady_clock::now();
+    transport->write({boost::asio::buffer(buf_head), boost::asio::buffer(data)});
+    time_sent += chrono::steady_clock::now() - t;
+    nbytes_sent += data.size();
 }
 
-std::vector<unsigned char> CommBackend::recv_data() {
-    return comm_recv_data(socket);
+void CommBackend::send_handle(const void *data, uint64_t nbytes) {
+    vector<char> buf_head;
+    msg::Header head(msg::Type::DATA_HANDLE, nbytes);
+    head.serialize(buf_head);
+    transport->write({boost::asio::buffer(buf_head)}, nbytes > 0 ? shmCreate(data, nbytes) : -1);
+}
+
+double CommBackend::bandwidth() const {
+    return nbytes_sent > 4 * 1024 * 1024 and time_sent.count() > 0 ? nbytes_sent / time_sent.count() : 0;
+}
+
+void releaseFrame(CommFrame &frame) {
+    if (frame.mapping != nullptr) {
+        shmUnmap(frame.mapping, frame.nbytes);
+        frame.mapping = nullptr;
+    }
+}
+
+uint64_t recvFrame(CommFrame frame, bh_view &view, bohrium::Compression &compressor,
+                   const std::string &param) {
+    const auto nbytes = static_cast<uint64_t>(view.shape.prod() * bh_type_size(view.base->dtype()));
+    if (frame.type == msg::Type::DATA_HANDLE) {
+        if (frame.mapping == nullptr) {
+            return 0;
+        }
+        if (frame.nbytes != nbytes) {
+            releaseFrame(frame);
+            throw runtime_error("[VEM-PROXY] received shared memory of the wrong size");
+        }
+        if (bohrium::viewIsWholeBase(view) and view.base->getDataPtr() == nullptr) {
+            bh_data_adopt(view.base, frame.mapping);
+        } else {
+            bh_data_malloc(view.base);
+            bohrium::viewScatter(frame.mapping, view);
+            releaseFrame(frame);
+        }
+        return 0;
+    }
+    if (frame.type != msg::Type::DATA) {
+        throw runtime_error("[VEM-PROXY] expected array data from the backend");
+    }
+    if (frame.data.empty()) {
+        return 0;
+    }
+    bh_data_malloc(view.base);
+    if (bohrium::viewIsWholeBase(view)) {
+        compressor.uncompress(frame.data, view, param);
+    } else {
+        std::vector<char> packed(nbytes);
+        bh_base packed_base(view.shape.prod(), view.base->dtype(), packed.data());
+        compressor.uncompress(frame.data, packed_base, param);
+        bohrium::viewScatter(packed.data(), view);
+    }
+    return frame.data.size();
 }
@@ -20,78 +20,223 @@ If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <string>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
 #include <boost/asio.hpp>
 
 #include "serialize.hpp"
+#include "transport.hpp"
+#include "compression.hpp"
+
+/** A message frame: a serialized head and body, a DATA frame of array data, or a DATA_HANDLE frame of array data
+ *  passed by shared memory, which the receiver has mapped into `mapping` */
+struct CommFrame {
+    msg::Type type;
+    std::vector<char> body;
+    std::vector<unsigned char> data;
+    void *mapping = nullptr;
+    uint64_t nbytes = 0;
+};
+
+/** The receive queue, which a receiver thread fills with the frames read from a transport */
+class CommRecvQueue {
+    std::thread receiver;
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::deque<CommFrame> queue;
+    // The time each frame of `queue` is delivered, which simulates the round-trip time of the link
+    std::deque<std::chrono::steady_clock::time_point> arrivals;
+    std::exception_ptr error;
+
+    /// The receiver thread
+    void receiver_loop(Transport &transport, uint64_t sim_bandwidth, std::chrono::duration<double> sim_rtt);
 
-class CommFrontend {
-    uint64_t sim_bandwidth = 1000; // bytes per second
 public:
-    boost::asio::io_service io_service;
-    boost::asio::ip::tcp::socket socket;
+    /// Start the receiver thread, which reads frames until a SHUTDOWN frame or an error such as a closed connection.
+    /// When `sim_bandwidth` is not zero, the receive of array data is delayed to simulate the bandwidth and
+    /// when `sim_rtt` is not zero, every frame is delivered `sim_rtt` after it has been read.
+    void start(Transport &transport, uint64_t sim_bandwidth = 0,
+               std::chrono::duration<double> sim_rtt = std::chrono::duration<double>{0});
 
-    CommFrontend(int stack_level, const std::string &address, int port, uint64_t sim_bandwidth);
+    /// Wait for the receiver thread to finish
+    void join();
+
+    /// Pop the next frame, block until it has arrived
+    CommFrame pop();
+
+    /// Return true when the next frame has arrived thus `pop()` will not block
+    bool ready();
+};
+
+class CommFrontend {
+    uint64_t sim_bandwidth = 0;    // bytes per second (zero disables the simulation)
+    size_t send_queue_limit;       // max bytes in the send queue before `write()` and `send_data()` block
+
+    // A queued frame. `handle` is a shared memory handle of `handle_nbytes` bytes to attach or -1
+    struct SendFrame {
+        std::vector<char> head;
+        std::vector<unsigned char> data;
+        int handle;
+        uint64_t handle_nbytes;
+        uint64_t tag;
+    };
+
+    // The send queue, which the sender thread writes to the transport in order
+    std::thread sender;
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::deque<SendFrame> send_queue;
+    size_t send_queue_nbytes = 0;
+    bool sending = false;
+    bool stopping = false;
+    std::exception_ptr send_error;
+    uint64_t nbytes_sent = 0;
+    std::chrono::duration<double> time_sent{0};
+
+    // The tag of the frames that are pushed and the time it took to send the frames of each tag (tag zero is
+    // not timed)
+    uint64_t current_tag = 0;
+    std::map<uint64_t, std::chrono::duration<double> > time_sent_by_tag;
+
+    // The replies from the `CommBackend`
+    CommRecvQueue recv_queue;
+
+    /// The sender thread
+    void sender_loop();
+
+    /// Push a frame to the send queue, block while the queue is full
+    void push(std::vector<char> head, std::vector<unsigned char> data, int handle = -1, uint64_t handle_nbytes = 0);
+
+public:
+    std::unique_ptr<Transport> transport;
+
+    // Time spent waiting on a full send queue
+    std::chrono::duration<double> time_send_wait{0};
+
+    /** Connect to the `CommBackend`
+     *
+     * @param sim_bandwidth    Simulate a link of this many bytes per second (zero disables the simulation)
+     * @param send_queue_limit The max bytes in the send queue
+     * @param transport_kind   The transport: tcp, local, or auto
+     * @param sim_rtt          Simulate a link of this round-trip time, which delays every reply
+     */
+    CommFrontend(int stack_level, const std::string &address, int port, uint64_t sim_bandwidth,
+                 size_t send_queue_limit, const std::string &transport_kind,
+                 std::chrono::duration<double> sim_rtt = std::chrono::duration<double>{0});
 
     ~CommFrontend();
 
-    /// Write to the `CommBackend`
-    void write(const std::vector<char> &buf) {
-        boost::asio::write(socket, boost::asio::buffer(buf));
+    /// Write to the `CommBackend`. The write is queued and returns immediately unless the send queue is full
+    void write(std::vector<char> buf) {
+        push(std::move(buf), {});
     }
 
-    /// Read string from the `CommBackend`
+    /// Wait until everything queued has been written to the socket
+    void flush();
+
+    /// Tag the frames that are written from now on with `tag`, which times the sending of them (see `timeSent()`)
+    void setTag(uint64_t tag) {
+        std::unique_lock<std::mutex> lock(mtx);
+        current_tag = tag;
+    }
+
+    /// Return the time it took to send the frames of `tag` (including the simulated bandwidth) and forget it.
+    /// Call `flush()` first to include all of the frames.
+    std::chrono::duration<double> timeSent(uint64_t tag);
+
+    /// Returns the simulated bandwidth or the measured send bandwidth in bytes per second (zero when unknown)
+    double bandwidth();
+
+    /// Read the string of the next reply (a MSG frame) from the `CommBackend`
     std::string read();
 
-    /// Send data to the `CommBackend`
-    void send_data(const std::vector<unsigned char> &data);
+    /// Send data to the `CommBackend` as a DATA frame. Like `write()`, the send is queued
+    void send_data(std::vector<unsigned char> data);
 
-    /// Receive data from the `CommBackend`
-    std::vector<unsigned char> recv_data();
+    /// Pop the next reply from the `CommBackend`, block until it has arrived. The replies arrive in the order of
+    /// the requests.
+    CommFrame pop() {
+        return recv_queue.pop();
+    }
+
+    /// Returns true when array data can be passed by shared memory (see `send_handle()`)
+    bool sharedMemory() const {
+        return transport->sharedMemory();
+    }
+
+    /// Send `nbytes` of `data` to the `CommBackend` by shared memory as a DATA_HANDLE frame. Like `write()`,
+    /// the send is queued but the copy of `data` into shared memory is not
+    void send_handle(const void *data, uint64_t nbytes);
 
     std::string hostname() const {
         return boost::asio::ip::host_name();
     }
 
     std::string ip() const {
-        std::stringstream ss;
-        ss << socket.local_endpoint().address() << "\n";
-        return ss.str();
+        return transport->ip() + "\n";
     }
 };
 
 class CommBackend {
 private:
-    boost::asio::io_service io_service;
-    boost::asio::ip::tcp::socket socket;
+    std::unique_ptr<Transport> transport;
+
+    // The frames from the `CommFrontend`
+    CommRecvQueue recv_queue;
+    uint64_t nbytes_sent = 0;
+    std::chrono::duration<double> time_sent{0};
+
 public:
     ~CommBackend();
 
     CommBackend(const std::string &address, int port = 4200);
 
-    /// Read from the `CommFrontend`
-    void read(std::vector<char> &buf) {
-        boost::asio::read(socket, boost::asio::buffer(buf));
+    /// Pop the next frame from the `CommFrontend`, block until it has arrived
+    CommFrame pop() {
+        return recv_queue.pop();
     }
 
-    /// Write string to the `CommFrontend`
-    void write(const std::string &str) {
-        // Write the whole string including the `\0` terminator
-        boost::asio::write(socket, boost::asio::buffer(str.c_str(), str.size() + 1));
+    /// Return true when the next frame has arrived thus `pop()` will not block
+    bool ready() {
+        return recv_queue.ready();
     }
 
-    /// Send data to the `CommFrontend`
+    /// Write string to the `CommFrontend` as a MSG frame
+    void write(const std::string &str);
+
+    /// Send data to the `CommFrontend` as a DATA frame
     void send_data(const std::vector<unsigned char> &data);
 
-    /// Receive data from the `CommFrontend`
-    std::vector<unsigned char> recv_data();
+    /// Returns true when array data can be passed by shared memory (see `send_handle()`)
+    bool sharedMemory() const {
+        return transport->sharedMemory();
+    }
+
+    /// Send `nbytes` of `data` to the `CommFrontend` by shared memory as a DATA_HANDLE frame (`data` may be nullptr
+    /// when `nbytes` is zero)
+    void send_handle(const void *data, uint64_t nbytes);
+
+    /// Returns the measured send bandwidth in bytes per second (zero when unknown)
+    double bandwidth() const;
 
     std::string hostname() const {
         return boost::asio::ip::host_name();
     }
 
     std::string ip() const {
-        std::stringstream ss;
-        ss << socket.local_endpoint().address() << "\n";
-        return ss.str();
+        return transport->ip() + "\n";
     }
 };
+
+/// Release the shared memory of a reply frame that is not used
+void releaseFrame(CommFrame &frame);
+
+/// Receive the reply `frame`, which contains the elements of `view` (if any), into `view`. A shared memory mapping
+/// of a whole base without data becomes its data. Returns the number of bytes received through the stream.
+uint64_t recvFrame(CommFrame frame, bh_view &view, bohrium::Compression &compressor,
+                   const std::string &param);
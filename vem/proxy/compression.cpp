@@ -18,13 +18,16 @@ GNU Lesser General Public License along with Bohrium.
 If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <thread>
 #include <bohrium/bh_base.hpp>
 #include <bohrium/bh_main_memory.hpp>
 #include <boost/algorithm/string.hpp>
 #include <opencv2/opencv.hpp>
 #include <bohrium/colors.hpp>
 #include "compression.hpp"
-#include "zlib.hpp"
+#include "chunked.hpp"
+#include "lossy.hpp"
 
 using namespace std;
 
@@ -52,6 +55,38 @@ int bh2cv_dtype(bh_type type) {
             throw std::runtime_error("bh2cv_dtype: unsupported type UINT64");
     }
 }
+
+/// Call `func(offset, n, stride)` for each row (the innermost dimension) of `view`, where `offset` is the element
+/// offset of the first of the `n` elements of the row
+template<typename F>
+void forEachRow(const bh_view &view, F func) {
+    if (view.ndim == 0) {
+        func(view.start, 1, 1);
+        return;
+    }
+    if (view.shape.prod() == 0) {
+        return;
+    }
+    const int64_t last = view.ndim - 1;
+    std::vector<int64_t> coord(static_cast<size_t>(view.ndim), 0);
+    while (true) {
+        int64_t offset = view.start;
+        for (int64_t d = 0; d < last; ++d) {
+            offset += coord[d] * view.stride[d];
+        }
+        func(offset, view.shape[last], view.stride[last]);
+        int64_t d = last - 1;
+        for (; d >= 0; --d) {
+            if (++coord[d] < view.shape[d]) {
+                break;
+            }
+            coord[d] = 0;
+        }
+        if (d < 0) {
+            return;
+        }
+    }
+}
 }
 
 std::vector<unsigned char> Compression::compress(const bh_view &ary, const std::string &param) {
@@ -64,11 +99,23 @@ std::vector<unsigned char> Compression::compress(const bh_view &ary, const std::
     }
     vector<string> param_list;
     boost::split(param_list, param, boost::is_any_of(","));
+    double max_error = -1;
     if (param.empty() or param_list.empty() or param_list[0] == "none") {
         ret.resize(ary.base->nbytes());
         memcpy(&ret[0], ary.base->getDataPtr(), ary.base->nbytes());
-    } else if (param_list[0] == "zlib") {
-        ret = zlib_compress(ary.base->getDataPtr(), ary.base->nbytes());
+    } else if (chunked::isCodec(param_list[0]) or param_list[0] == "auto") {
+        const uint64_t elem_size = static_cast<uint64_t>(bh_type_size(ary.base->dtype()));
+        chunked::Options opt;
+        if (param_list[0] == "auto") {
+            opt = chunked::pick(ary.base->getDataPtr(), ary.base->nbytes(), elem_size, link_bandwidth,
+                                std::max(1u, std::thread::hardware_concurrency()));
+        } else {
+            opt = chunked::parse(param_list);
+        }
+        ret = chunked::compress(ary.base->getDataPtr(), ary.base->nbytes(), elem_size, opt, &threadPool());
+    } else if (param_list[0] == "sz") {
+        ret = lossy::compress(ary.base->getDataPtr(), static_cast<uint64_t>(ary.base->nelem()), ary.base->dtype(),
+                              lossy::parse(param_list), &threadPool(), max_error);
     } else if (param_list[0] == "jpg" or param_list[0] == "png" or param_list[0] == "jp2") {
         const int cv_type = bh2cv_dtype(ary.base->dtype());
         if (ary.base->dtype() != bh_type::UINT8) {
@@ -96,7 +143,8 @@ std::vector<unsigned char> Compression::compress(const bh_view &ary, const std::
     } else {
         throw std::runtime_error("compress(): unknown param");
     }
-    stat_per_codex[param].push_back(Stat{static_cast<uint64_t>(ary.base->nbytes()), ret.size()});
+    // NB: the statistics are per `param` as given, which is also what `uncompress()` gets
+    stat_per_codex[param].push_back(Stat{static_cast<uint64_t>(ary.base->nbytes()), ret.size(), max_error});
     return ret;
 }
 
@@ -120,8 +168,11 @@ void Compression::uncompress(const std::vector<unsigned char> &data, bh_view &ar
     if (param.empty() or param_list.empty() or param_list[0] == "none") {
         assert(static_cast<int64_t>(data.size()) == ary.base->nbytes());
         memcpy(ary.base->getDataPtr(), &data[0], ary.base->nbytes());
-    } else if (param_list[0] == "zlib") {
-        zlib_uncompress(data, ary.base->getDataPtr(), ary.base->nbytes());
+    } else if (chunked::isCodec(param_list[0]) or param_list[0] == "auto") {
+        chunked::uncompress(data, ary.base->getDataPtr(), ary.base->nbytes(), &threadPool());
+    } else if (param_list[0] == "sz") {
+        lossy::uncompress(data, ary.base->getDataPtr(), static_cast<uint64_t>(ary.base->nelem()), ary.base->dtype(),
+                          &threadPool());
     } else if (param_list[0] == "jpg" or param_list[0] == "png" or param_list[0] == "jp2") {
         if (ary.base->dtype() != bh_type::UINT8) {
             throw std::runtime_error("uncompress(): jpg and png only support uint8 arrays");
@@ -138,6 +189,13 @@ void Compression::uncompress(const std::vector<unsigned char> &data, bh_view &ar
     stat_per_codex[param].push_back(Stat{static_cast<uint64_t >(ary.base->nbytes()), data.size()});
 }
 
+jitk::ThreadPool &Compression::threadPool() {
+    if (_pool == nullptr) {
+        _pool.reset(new jitk::ThreadPool(std::max(1u, std::thread::hardware_concurrency()) - 1));
+    }
+    return *_pool;
+}
+
 void Compression::uncompress(const std::vector<unsigned char> &data, bh_base &ary, const std::string &param) {
     bh_view view{&ary}; // View of the whole base
     uncompress(data, view, param);
@@ -149,14 +207,19 @@ std::string Compression::pprintStats() const {
     for (auto &param: stat_per_codex) {
         uint64_t total_raw = 0;
         uint64_t total_compressed = 0;
+        double max_error = -1;
         for (const Stat &stat: param.second) {
             total_raw += stat.total_raw;
             total_compressed += stat.total_compressed;
+            max_error = std::max(max_error, stat.max_error);
         }
         ss << "Codex \"" << param.first << "\":\n";
         ss << "  Raw data: " << total_raw << "\n";
         ss << "  Zip data: " << total_compressed << "\n";
         ss << "  Ratio: " << total_raw / (double) total_compressed << "\n";
+        if (max_error >= 0) {
+            ss << "  Max error: " << max_error << "\n";
+        }
     }
     return ss.str();
 }
@@ -180,8 +243,47 @@ std::string Compression::pprintStatsDetail() const {
             ss << stat.total_raw / (double) stat.total_compressed << ", ";
         }
         ss << "\n";
+        if (std::any_of(param.second.begin(), param.second.end(), [](const Stat &s) { return s.max_error >= 0; })) {
+            ss << "  Max error: ";
+            for (const Stat &stat: param.second) {
+                ss << stat.max_error << ", ";
+            }
+            ss << "\n";
+        }
     }
     return ss.str();
 }
 
+void viewGather(const bh_view &view, void *dest) {
+    const auto elem_size = static_cast<size_t>(bh_type_size(view.base->dtype()));
+    const auto *src = static_cast<const char *>(view.base->getDataPtr());
+    auto *out = static_cast<char *>(dest);
+    forEachRow(view, [&](int64_t offset, int64_t n, int64_t stride) {
+        if (stride == 1) {
+            memcpy(out, src + offset * elem_size, n * elem_size);
+            out += n * elem_size;
+        } else {
+            for (int64_t i = 0; i < n; ++i, out += elem_size) {
+                memcpy(out, src + (offset + i * stride) * elem_size, elem_size);
+            }
+        }
+    });
+}
+
+void viewScatter(const void *src, const bh_view &view) {
+    const auto elem_size = static_cast<size_t>(bh_type_size(view.base->dtype()));
+    const auto *in = static_cast<const char *>(src);
+    auto *dst = static_cast<char *>(view.base->getDataPtr());
+    forEachRow(view, [&](int64_t offset, int64_t n, int64_t stride) {
+        if (stride == 1) {
+            memcpy(dst + offset * elem_size, in, n * elem_size);
+            in += n * elem_size;
+        } else {
+            for (int64_t i = 0; i < n; ++i, in += elem_size) {
+                memcpy(dst + (offset + i * stride) * elem_size, in, elem_size);
+            }
+        }
+    });
+}
+
 }
@@ -20,24 +20,47 @@ If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <memory>
 #include <bohrium/bh_view.hpp>
+#include <bohrium/jitk/thread_pool.hpp>
 
 namespace bohrium {
 class Compression {
     struct Stat {
         uint64_t total_raw;
         uint64_t total_compressed;
+        double max_error; // The max absolute error of a lossy codec or negative when unknown
 
-        Stat(uint64_t total_raw, uint64_t total_compressed) : total_raw(total_raw),
-                                                              total_compressed(total_compressed) {}
+        Stat(uint64_t total_raw, uint64_t total_compressed, double max_error = -1) : total_raw(total_raw),
+                                                                                    total_compressed(total_compressed),
+                                                                                    max_error(max_error) {}
     };
 
     std::map<std::string, std::vector<Stat> > stat_per_codex;
 
+    // The link bandwidth (bytes per second) that the `auto` codec compares the compression speed against
+    double link_bandwidth = 1.25e9;
+
+    // The pool that compresses the chunks of the chunked codecs in parallel (created on first use)
+    std::unique_ptr<jitk::ThreadPool> _pool;
+    jitk::ThreadPool &threadPool();
+
 public:
     Compression() = default;
 
+    /** Set the link bandwidth in bytes per second, which the `auto` codec uses to pick a codec */
+    void setLinkBandwidth(double bytes_per_sec) {
+        if (bytes_per_sec > 0) {
+            link_bandwidth = bytes_per_sec;
+        }
+    }
+
     /** Compress `ary`
+     *
+     * The codecs `zlib`, `lz4`, and `zstd` compress chunks of the array in parallel and take the parameters
+     * "<codec>[,<level>][,shuffle|bitshuffle][,chunk=<KiB>]". The codec `auto` picks one of them, or none,
+     * by sampling the array. The lossy codec `sz` compresses float32 and float64 arrays within the error bound
+     * of "sz,abs=<bound>" or "sz,rel=<bound>" (relative to the value range of the array).
      *
      * @param ary    The array view to compress, the view MUST represent the whole base array and be contiguous
      * @param param  A string of parameters to parsed through to the compress library
@@ -81,4 +104,15 @@ public:
      */
     std::string pprintStatsDetail() const;
 };
+
+/** Returns true when `view` is contiguous and represents the whole of its base */
+inline bool viewIsWholeBase(const bh_view &view) {
+    return view.isContiguous() and view.shape.prod() == view.base->nelem();
+}
+
+/** Copy the elements of `view` into the contiguous `dest`, which must have room for `view.shape.prod()` elements */
+void viewGather(const bh_view &view, void *dest);
+
+/** Copy the contiguous `src` into the elements of `view`, which must have data */
+void viewScatter(const void *src, const bh_view &view);
 }
\ No newline at end of file
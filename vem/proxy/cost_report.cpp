@@ -0,0 +1,98 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <stdexcept>
+#include "cost_report.hpp"
+
+using namespace std;
+
+namespace bohrium {
+
+void CostReport::setBackendTimes(const std::string &reply) {
+    stringstream ss(reply);
+    auto it = rows.begin();
+    double wait, exec;
+    while (ss >> wait >> exec) {
+        while (it != rows.end() and it->type.compare(0, 4, "EXEC") != 0) {
+            ++it;
+        }
+        if (it == rows.end()) {
+            throw runtime_error("[PROXY-VEM] the backend reported more EXEC messages than were sent");
+        }
+        it->backend_wait = wait;
+        it->backend_exec = exec;
+        ++it;
+    }
+}
+
+void CostReport::write(const std::string &path) const {
+    ofstream out(path);
+    if (not out) {
+        throw runtime_error("[PROXY-VEM] cannot write the cost report `" + path + "`");
+    }
+    out << "msg,type,instrs,body_bytes,arrays,raw_bytes,link_bytes,"
+        << "serialize_s,compress_s,transfer_s,backend_wait_s,backend_exec_s\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Row &r = rows[i];
+        out << i << "," << r.type << "," << r.ninstr << "," << r.nbytes_body << "," << r.narrays << ","
+            << r.nbytes_raw << "," << r.nbytes_link << "," << r.serialize << "," << r.compress << ","
+            << r.transfer << "," << r.backend_wait << "," << r.backend_exec << "\n";
+    }
+}
+
+std::string CostReport::pprintSummary() const {
+    std::map<std::string, Row> totals;
+    std::map<std::string, uint64_t> counts;
+    for (const Row &r: rows) {
+        Row &t = totals[r.type];
+        t.ninstr += r.ninstr;
+        t.nbytes_body += r.nbytes_body;
+        t.narrays += r.narrays;
+        t.nbytes_raw += r.nbytes_raw;
+        t.nbytes_link += r.nbytes_link;
+        t.serialize += r.serialize;
+        t.compress += r.compress;
+        t.transfer += r.transfer;
+        t.backend_wait += r.backend_wait;
+        t.backend_exec += r.backend_exec;
+        ++counts[r.type];
+    }
+    stringstream ss;
+    ss << "CostReport:\n";
+    for (const auto &p: totals) {
+        const Row &t = p.second;
+        ss << "  " << p.first << " (" << counts[p.first] << " messages):\n";
+        ss << "    Instrs:      " << t.ninstr << "\n";
+        ss << "    Body:        " << t.nbytes_body / 1024.0 << "KB\n";
+        ss << "    Arrays:      " << t.narrays << " (" << t.nbytes_raw / 1024.0 / 1024.0 << "MB raw, "
+           << t.nbytes_link / 1024.0 / 1024.0 << "MB on the link)\n";
+        ss << "    Serialize:   " << t.serialize << "s\n";
+        ss << "    Compress:    " << t.compress << "s\n";
+        ss << "    Transfer:    " << t.transfer << "s\n";
+        ss << "    BackendWait: " << t.backend_wait << "s\n";
+        ss << "    BackendExec: " << t.backend_exec << "s\n";
+    }
+    return ss.str();
+}
+
+}
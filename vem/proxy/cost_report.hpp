@@ -0,0 +1,68 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bohrium {
+
+/** The message that asks the proxy backend for its part of the cost report since the last request, which also
+ *  makes the backend record it from then on (see `CostReport`) */
+constexpr const char *cost_report_msg = "proxy-cost-report";
+
+/* The cost of each message of the proxy, which the frontend writes as a CSV file when `report` is set.
+ * An EXEC row is a BhIR and the array data sent with it. Its backend times come from the backend, which records
+ * the time it waited for the array data and the time it executed the BhIR of each EXEC message.
+ * A GET_DATA or MEM_COPY row is the array data of a reply. All times are in seconds.
+ */
+class CostReport {
+public:
+    struct Row {
+        std::string type;          // The message type
+        uint64_t ninstr = 0;       // The number of instructions of an EXEC message
+        uint64_t nbytes_body = 0;  // The size of the serialized BhIR
+        uint64_t narrays = 0;      // The number of arrays sent or received
+        uint64_t nbytes_raw = 0;   // The size of the array data
+        uint64_t nbytes_link = 0;  // The size of the array data in the stream (zero when by shared memory)
+        double serialize = 0;      // The serialization of the BhIR
+        double compress = 0;       // The compression of the array data sent or the uncompression of the reply
+        double transfer = 0;       // The sending of the message or the wait for the reply
+        double backend_wait = 0;   // The wait of the backend for the array data of an EXEC message
+        double backend_exec = 0;   // The execution of the BhIR of an EXEC message at the backend
+        uint64_t tag = 0;          // The tag of the frames of the message (see `CommFrontend::setTag()`)
+    };
+
+    std::vector<Row> rows;
+
+    /** Set the backend times of the EXEC rows from the reply of the `cost_report_msg` message, which is a line of
+     *  "<wait> <exec>" for each EXEC message in order */
+    void setBackendTimes(const std::string &reply);
+
+    /** Write the rows as CSV to the file `path` */
+    void write(const std::string &path) const;
+
+    /** Pretty print the totals of each message type */
+    std::string pprintSummary() const;
+};
+
+}
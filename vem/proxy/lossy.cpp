@@ -0,0 +1,310 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+#include "lossy.hpp"
+#include "chunked.hpp"
+
+using namespace std;
+
+namespace bohrium {
+namespace lossy {
+
+namespace {
+constexpr uint32_t magic = 0x5a534842; // "BHSZ"
+constexpr uint8_t version = 1;
+constexpr uint64_t chunk_nelem = 256 * 1024; // The chunks are quantized in parallel
+constexpr uint32_t outlier_code = 0xFFFFFFFF; // The code of a value stored exact
+constexpr int64_t max_delta = (int64_t{1} << 31) - 1; // The max difference that has a code
+constexpr double max_k = 4.6e18; // Keeps `k` and the difference of two `k`s within int64
+
+struct Head {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t elem_size;
+    uint16_t padding;
+    double step;
+    uint64_t nelem;
+    uint64_t nchunks;
+};
+
+uint32_t zigzag(int64_t delta) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+}
+
+int64_t unzigzag(uint32_t code) {
+    return static_cast<int64_t>(code >> 1) ^ -static_cast<int64_t>(code & 1);
+}
+
+// The reconstruction of `k`, which must be the same expression on both ends
+template<typename T>
+T reconstruct(int64_t k, double step) {
+    return static_cast<T>(static_cast<double>(k) * step);
+}
+
+template<typename T>
+void quantize(const T *x, uint64_t n, double step, double abs_error, uint32_t *codes, vector<T> &outliers,
+              double &max_error) {
+    int64_t prev = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        const double v = x[i];
+        const double q = std::nearbyint(v / step);
+        if (std::isfinite(v) and std::abs(q) < max_k) {
+            const auto k = static_cast<int64_t>(q);
+            const int64_t delta = k - prev;
+            const double err = std::abs(v - static_cast<double>(reconstruct<T>(k, step)));
+            if (delta >= -max_delta and delta <= max_delta and err <= abs_error) {
+                codes[i] = zigzag(delta);
+                prev = k;
+                max_error = std::max(max_error, err);
+                continue;
+            }
+        }
+        codes[i] = outlier_code;
+        outliers.push_back(x[i]);
+    }
+}
+
+template<typename T>
+void dequantize(const uint32_t *codes, uint64_t n, double step, const T *outliers, T *dst) {
+    int64_t prev = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        if (codes[i] == outlier_code) {
+            dst[i] = *outliers++;
+        } else {
+            prev += unzigzag(codes[i]);
+            dst[i] = reconstruct<T>(prev, step);
+        }
+    }
+}
+
+// Returns the max minus the min of the finite values in `x`
+template<typename T>
+double valueRange(const T *x, uint64_t n) {
+    double lo = INFINITY, hi = -INFINITY;
+    for (uint64_t i = 0; i < n; ++i) {
+        if (std::isfinite(x[i])) {
+            lo = std::min(lo, static_cast<double>(x[i]));
+            hi = std::max(hi, static_cast<double>(x[i]));
+        }
+    }
+    return hi > lo ? hi - lo : 0;
+}
+
+// Run `body(i)` for i in [0, n) using `pool` when there is more than one iteration
+void forEach(uint64_t n, jitk::ThreadPool *pool, const std::function<void(uint64_t)> &body) {
+    if (pool == nullptr or n < 2) {
+        for (uint64_t i = 0; i < n; ++i) {
+            body(i);
+        }
+        return;
+    }
+    pool->parallelFor(n, 1, 0, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i) {
+            body(i);
+        }
+    });
+}
+
+// The lossless codec of the codes: byte-shuffled small integers compress well with any of the codecs
+chunked::Options codesCodec() {
+    chunked::Options ret;
+    ret.filter = chunked::Filter::SHUFFLE;
+    ret.level = 1;
+    if (chunked::available(chunked::Codec::ZSTD)) {
+        ret.codec = chunked::Codec::ZSTD;
+    } else if (chunked::available(chunked::Codec::LZ4)) {
+        ret.codec = chunked::Codec::LZ4;
+        ret.level = 0;
+    } else {
+        ret.codec = chunked::Codec::ZLIB;
+    }
+    return ret;
+}
+
+template<typename T>
+std::vector<unsigned char> compressT(const T *x, uint64_t nelem, const Options &opt, jitk::ThreadPool *pool,
+                                     double &max_error) {
+    double abs_error = opt.abs_error;
+    if (abs_error == 0) {
+        abs_error = opt.rel_error * valueRange(x, nelem);
+        if (abs_error == 0) { // All values are equal, which any positive bound reconstructs
+            abs_error = opt.rel_error;
+        }
+    }
+    if (not(abs_error > 0) or not std::isfinite(abs_error)) {
+        throw runtime_error("compress(): the error bound must be positive");
+    }
+    const double step = 2 * abs_error;
+
+    // Quantize the chunks in parallel
+    const uint64_t nchunks = (nelem + chunk_nelem - 1) / chunk_nelem;
+    vector<uint32_t> codes(nelem);
+    vector<vector<T> > outliers(nchunks);
+    vector<double> errors(nchunks, 0);
+    forEach(nchunks, pool, [&](uint64_t i) {
+        const uint64_t begin = i * chunk_nelem;
+        const uint64_t n = std::min(chunk_nelem, nelem - begin);
+        quantize(x + begin, n, step, abs_error, codes.data() + begin, outliers[i], errors[i]);
+    });
+    max_error = nchunks > 0 ? *std::max_element(errors.begin(), errors.end()) : 0;
+
+    const vector<unsigned char> packed = chunked::compress(codes.data(), nelem * sizeof(uint32_t),
+                                                           sizeof(uint32_t), codesCodec(), pool);
+
+    // Write the head, the number of outliers of each chunk, the outliers, and the packed codes
+    Head head{};
+    head.magic = magic;
+    head.version = version;
+    head.elem_size = sizeof(T);
+    head.step = step;
+    head.nelem = nelem;
+    head.nchunks = nchunks;
+    uint64_t noutliers = 0;
+    for (const auto &o: outliers) {
+        noutliers += o.size();
+    }
+    vector<unsigned char> ret(sizeof(Head) + nchunks * sizeof(uint64_t) + noutliers * sizeof(T) + packed.size());
+    unsigned char *out = ret.data();
+    memcpy(out, &head, sizeof(Head));
+    out += sizeof(Head);
+    for (const auto &o: outliers) {
+        const uint64_t size = o.size();
+        memcpy(out, &size, sizeof(size));
+        out += sizeof(size);
+    }
+    for (const auto &o: outliers) {
+        memcpy(out, o.data(), o.size() * sizeof(T));
+        out += o.size() * sizeof(T);
+    }
+    memcpy(out, packed.data(), packed.size());
+    return ret;
+}
+
+template<typename T>
+void uncompressT(const std::vector<unsigned char> &data, T *dst, uint64_t nelem, jitk::ThreadPool *pool) {
+    Head head;
+    if (data.size() < sizeof(Head)) {
+        throw runtime_error("sz uncompress(): truncated data");
+    }
+    memcpy(&head, data.data(), sizeof(Head));
+    if (head.magic != magic or head.version != version) {
+        throw runtime_error("sz uncompress(): not sz data of this version");
+    }
+    if (head.elem_size != sizeof(T) or head.nelem != nelem or
+        head.nchunks != (nelem + chunk_nelem - 1) / chunk_nelem) {
+        throw runtime_error("sz uncompress(): the data does not match the destination");
+    }
+
+    // Find the outliers of each chunk
+    const uint64_t nchunks = head.nchunks;
+    if (data.size() < sizeof(Head) + nchunks * sizeof(uint64_t)) {
+        throw runtime_error("sz uncompress(): truncated data");
+    }
+    vector<uint64_t> outlier_offsets(nchunks + 1, 0);
+    for (uint64_t i = 0; i < nchunks; ++i) {
+        uint64_t size;
+        memcpy(&size, data.data() + sizeof(Head) + i * sizeof(uint64_t), sizeof(size));
+        outlier_offsets[i + 1] = outlier_offsets[i] + size;
+    }
+    const uint64_t outliers_begin = sizeof(Head) + nchunks * sizeof(uint64_t);
+    const uint64_t packed_begin = outliers_begin + outlier_offsets.back() * sizeof(T);
+    if (outlier_offsets.back() > nelem or data.size() < packed_begin) {
+        throw runtime_error("sz uncompress(): truncated data");
+    }
+    vector<T> outliers(outlier_offsets.back());
+    memcpy(outliers.data(), data.data() + outliers_begin, outliers.size() * sizeof(T));
+
+    vector<uint32_t> codes(nelem);
+    chunked::uncompress(vector<unsigned char>(data.begin() + packed_begin, data.end()), codes.data(),
+                        nelem * sizeof(uint32_t), pool);
+
+    // Dequantize the chunks in parallel
+    std::mutex mutex;
+    std::exception_ptr error;
+    forEach(nchunks, pool, [&](uint64_t i) {
+        const uint64_t begin = i * chunk_nelem;
+        const uint64_t n = std::min(chunk_nelem, nelem - begin);
+        const uint64_t noutliers = static_cast<uint64_t>(std::count(codes.begin() + begin,
+                                                                    codes.begin() + begin + n, outlier_code));
+        if (noutliers != outlier_offsets[i + 1] - outlier_offsets[i]) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::make_exception_ptr(runtime_error("sz uncompress(): corrupted data"));
+            return;
+        }
+        dequantize(codes.data() + begin, n, head.step, outliers.data() + outlier_offsets[i], dst + begin);
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+} // Anonymous namespace
+
+Options parse(const std::vector<std::string> &param_list) {
+    Options ret;
+    for (size_t i = 1; i < param_list.size(); ++i) {
+        const string &p = param_list[i];
+        if (p.compare(0, 4, "abs=") == 0) {
+            ret.abs_error = std::stod(p.substr(4));
+        } else if (p.compare(0, 4, "rel=") == 0) {
+            ret.rel_error = std::stod(p.substr(4));
+        } else {
+            throw runtime_error("compress(): unknown sz parameter '" + p + "'");
+        }
+    }
+    if (not(ret.abs_error > 0 or ret.rel_error > 0)) {
+        throw runtime_error("compress(): sz needs a positive error bound e.g. 'sz,abs=1e-4' or 'sz,rel=1e-6'");
+    }
+    return ret;
+}
+
+std::vector<unsigned char> compress(const void *data, uint64_t nelem, bh_type type, const Options &opt,
+                                    jitk::ThreadPool *pool, double &max_error) {
+    switch (type) {
+        case bh_type::FLOAT32:
+            return compressT(static_cast<const float *>(data), nelem, opt, pool, max_error);
+        case bh_type::FLOAT64:
+            return compressT(static_cast<const double *>(data), nelem, opt, pool, max_error);
+        default:
+            throw runtime_error("compress(): sz only supports float32 and float64 arrays");
+    }
+}
+
+void uncompress(const std::vector<unsigned char> &data, void *dest, uint64_t nelem, bh_type type,
+                jitk::ThreadPool *pool) {
+    switch (type) {
+        case bh_type::FLOAT32:
+            return uncompressT(data, static_cast<float *>(dest), nelem, pool);
+        case bh_type::FLOAT64:
+            return uncompressT(data, static_cast<double *>(dest), nelem, pool);
+        default:
+            throw runtime_error("uncompress(): sz only supports float32 and float64 arrays");
+    }
+}
+
+} // lossy
+} // bohrium
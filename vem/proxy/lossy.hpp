@@ -0,0 +1,75 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <bohrium/bh_type.hpp>
+#include <bohrium/jitk/thread_pool.hpp>
+
+namespace bohrium {
+namespace lossy {
+
+/* Error-bounded lossy compression of float32 and float64 arrays in the style of SZ:
+ * each value `x` is quantized to the integer `k = round(x / step)` where `step = 2 * abs_error`, and we
+ * store the difference to the `k` of the previous value, which is small for smooth data. The differences
+ * are compressed losslessly by a chunked codec. Values that would break the error bound (e.g. NaN, Inf, or
+ * huge values) are stored exact.
+ * Since the prediction is done on the integers, the decompression reconstructs each value with a single
+ * multiplication `k * step`, which is bit-identical on both ends.
+ */
+
+/** The error bound */
+struct Options {
+    double abs_error = 0; // Absolute error bound
+    double rel_error = 0; // Error bound relative to the value range of the array (used when `abs_error` is zero)
+};
+
+/** Parse the `compress_param` list "sz,abs=<bound>" or "sz,rel=<bound>" */
+Options parse(const std::vector<std::string> &param_list);
+
+/** Compress the `nelem` values of `data` of type `type`, which must be FLOAT32 or FLOAT64
+ *
+ * @param data       The data to compress
+ * @param nelem      The number of elements in `data`
+ * @param type       The type of the elements
+ * @param opt        The error bound
+ * @param pool       The thread pool or null
+ * @param max_error  On return, the max absolute error of the compressed values
+ * @return           The compressed data
+ */
+std::vector<unsigned char> compress(const void *data, uint64_t nelem, bh_type type, const Options &opt,
+                                    jitk::ThreadPool *pool, double &max_error);
+
+/** Uncompress `data` into the `nelem` values of `dest` of type `type`
+ *
+ * @param data   The compressed data
+ * @param dest   The destination
+ * @param nelem  The number of elements in `dest`
+ * @param type   The type of the elements, which must match the compressed data
+ * @param pool   The thread pool or null
+ */
+void uncompress(const std::vector<unsigned char> &data, void *dest, uint64_t nelem, bh_type type,
+                jitk::ThreadPool *pool);
+
+} // lossy
+} // bohrium
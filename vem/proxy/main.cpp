@@ -19,6 +19,8 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <iostream>
+#include <algorithm>
+#include <deque>
 #include <bohrium/bh_component.hpp>
 #include <bohrium/bh_main_memory.hpp>
 #include <bohrium/bh_util.hpp>
@@ -26,6 +28,8 @@ If not, see <http://www.gnu.org/licenses/>.
 #include "serialize.hpp"
 #include "comm.hpp"
 #include "compression.hpp"
+#include "batch_cache.hpp"
+#include "cost_report.hpp"
 
 using namespace bohrium;
 using namespace component;
@@ -37,31 +41,103 @@ private:
     Compression compressor;
     CommFrontend comm_front;
     std::set<bh_base *> known_base_arrays;
+    BhIRViewDict view_dict;
+    BatchCacheFrontend batch_cache;
     string compress_param;
+    bool use_batch_cache;
+
+    // The prefetches of sync'ed arrays, which the backend has not replied to yet, in the order they were sent.
+    // A base array is replaced by nullptr when a later BhIR writes it thus the prefetched data is out of date.
+    std::deque<std::vector<bh_base *> > prefetch_pending;
+    // The replies of the prefetches, which have not been used yet
+    std::map<bh_base *, CommFrame> prefetched;
+    bool prefetch_syncs;
+    uint64_t num_prefetch_hits{0};
 
     bool stat_print_on_exit;
     std::chrono::duration<double> time_mem_copy_total{0};
     std::chrono::duration<double> time_mem_copy_unzip{0};
     uint64_t nbytes_recv{0};
 
+    // The cost of each message, which is written to `report_path` on exit (disabled when the path is empty)
+    string report_path;
+    CostReport report;
+
 public:
     Impl(int stack_level) : ComponentVE(stack_level, false),
                             comm_front(stack_level,
                                        config.defaultGet<string>("address", "127.0.0.1"),
                                        config.defaultGet<int>("port", 4200),
-                                       config.defaultGet<uint64_t>("delay", 0)),
+                                       config.defaultGet<uint64_t>("sim_bandwidth", 0),
+                                       config.defaultGet<size_t>("send_queue_size", 64) * 1024 * 1024,
+                                       config.defaultGet<string>("transport", "auto"),
+                                       std::chrono::duration<double>{config.defaultGet<double>("sim_rtt", 0) / 1000}),
                             compress_param(config.defaultGet<string>("compress_param", "zlib")),
-                            stat_print_on_exit(config.defaultGet("prof", false)) {}
+                            use_batch_cache(config.defaultGet("batch_cache", true)),
+                            prefetch_syncs(config.defaultGet("prefetch_syncs", true)),
+                            stat_print_on_exit(config.defaultGet("prof", false)),
+                            report_path(config.defaultGet<string>("report", "")) {
+        // The backend records the cost of the EXEC messages from the first request of its cost report
+        if (not report_path.empty()) {
+            message(cost_report_msg);
+        }
+    }
     ~Impl() override {
+        for (auto &p: prefetched) {
+            releaseFrame(p.second);
+        }
+        if (not report_path.empty()) {
+            writeReport();
+        }
         if (stat_print_on_exit) {
             cout << compressor.pprintStats();
             cout << "Frontend:\n";
             cout << "  MemCopy: " << time_mem_copy_total.count() << "s" << endl;
             cout << "    UnZip: " << time_mem_copy_unzip.count() << "s" << endl;
             cout << "    Recv:  " << nbytes_recv / 1024.0 / 1024.0 << "MB" << endl;
+            cout << "  SendWait: " << comm_front.time_send_wait.count() << "s" << endl;
+            cout << "  PrefetchHits: " << num_prefetch_hits << endl;
+            if (use_batch_cache) {
+                cout << batch_cache.pprintStats();
+            }
+            if (not report_path.empty()) {
+                cout << report.pprintSummary();
+            }
+        }
+    }
+
+    // Complete the cost report with the send times and the backend times, and write it to `report_path`
+    void writeReport() {
+        try {
+            report.setBackendTimes(message(cost_report_msg));
+            comm_front.flush();
+            for (CostReport::Row &row: report.rows) {
+                if (row.tag != 0) {
+                    row.transfer = comm_front.timeSent(row.tag).count();
+                }
+            }
+            report.write(report_path);
+        } catch (const std::exception &e) {
+            cerr << e.what() << endl;
         }
     }
 
+    // Add a row of a reply to the cost report, which took `wait` to arrive and `unzip` to receive
+    void reportReply(const char *type, const bh_view &view, uint64_t nbytes_link,
+                     std::chrono::duration<double> wait, std::chrono::duration<double> unzip) {
+        if (report_path.empty()) {
+            return;
+        }
+        CostReport::Row row;
+        row.type = type;
+        row.narrays = 1;
+        row.nbytes_raw = static_cast<uint64_t>(view.shape.prod() * bh_type_size(view.base->dtype()));
+        row.nbytes_link = nbytes_link;
+        row.compress = unzip.count();
+        row.transfer = wait.count();
+        report.rows.push_back(std::move(row));
+    }
+
     void execute(BhIR *bhir) override;
 
     void extmethod(const string &name, bh_opcode opcode) override {
@@ -83,8 +159,8 @@ public:
         head.serialize(buf_head);
 
         // Send serialized message
-        comm_front.write(buf_head);
-        comm_front.write(buf_body);
+        comm_front.write(std::move(buf_head));
+        comm_front.write(std::move(buf_body));
 
         stringstream ss;
         if (msg == "info") {
@@ -98,6 +174,7 @@ public:
             ss << "Proxy:" << "\n";
             ss << compressor.pprintStatsDetail();
         }
+        drainPrefetches();
         ss << comm_front.read(); // Read the message from the backend
         return ss.str();
     }
@@ -108,26 +185,26 @@ public:
             throw runtime_error("PROXY - getMemoryPointer(): `copy2host` is not True");
         }
 
-        // Serialize message body
-        vector<char> buf_body;
-        msg::GetData body(&base, nullify);
-        body.serialize(buf_body);
-
-        // Serialize message head
-        vector<char> buf_head;
-        msg::Header head(msg::Type::GET_DATA, buf_body.size());
-        head.serialize(buf_head);
-
-        // Send serialized message
-        comm_front.write(buf_head);
-        comm_front.write(buf_body);
-
-        // Receive the array data
-        vector<unsigned char> data = comm_front.recv_data();
-        if (not data.empty()) {
-            bh_data_malloc(&base);
-            compressor.uncompress(data, base, compress_param);
+        // The replies of the prefetches come before the reply of this request
+        auto t1 = chrono::steady_clock::now();
+        drainPrefetches();
+        bh_view view(&base);
+        auto it = prefetched.find(&base);
+        CommFrame frame;
+        if (it != prefetched.end()) {
+            frame = std::move(it->second);
+            prefetched.erase(it);
+            ++num_prefetch_hits;
+            if (nullify) {
+                sendGetData({view}, true, false);
+            }
+        } else {
+            sendGetData({view}, nullify, true);
+            frame = comm_front.pop();
         }
+        auto t2 = chrono::steady_clock::now();
+        const uint64_t nbytes = recvFrame(std::move(frame), view, compressor, compress_param);
+        reportReply("GET_DATA", view, nbytes, t2 - t1, chrono::steady_clock::now() - t2);
 
         if (force_alloc) {
             bh_data_malloc(&base);
@@ -163,6 +240,7 @@ public:
         }
 
         auto t1 = chrono::steady_clock::now();
+        drainPrefetches();
 
         // Serialize message body
         vector<char> buf_body;
@@ -175,19 +253,65 @@ public:
         head.serialize(buf_head);
 
         // Send serialized message
-        comm_front.write(buf_head);
-        comm_front.write(buf_body);
+        comm_front.write(std::move(buf_head));
+        comm_front.write(std::move(buf_body));
+
+        // Receive the elements of `src` into `dst`. By shared memory, the data is never compressed.
+        CommFrame frame = comm_front.pop();
+        auto t2 = chrono::steady_clock::now();
+        const uint64_t nbytes = recvFrame(std::move(frame), dst, compressor, param);
+        nbytes_recv += nbytes;
+        time_mem_copy_unzip += chrono::steady_clock::now() - t2;
+        time_mem_copy_total += chrono::steady_clock::now() - t1;
+        reportReply("MEM_COPY", dst, nbytes, t2 - t1, chrono::steady_clock::now() - t2);
+    }
 
-        // Receive the array data
-        vector<unsigned char> data = comm_front.recv_data();
-        if (not data.empty()) {
-            bh_data_malloc(dst.base);
-            auto t2 = chrono::steady_clock::now();
-            compressor.uncompress(data, dst, param);
-            time_mem_copy_unzip += chrono::steady_clock::now() - t2;
-            nbytes_recv += data.size();
+    // Send a GET_DATA request of `views`
+    void sendGetData(std::vector<bh_view> views, bool nullify, bool reply) {
+        // Serialize message body
+        vector<char> buf_body;
+        msg::GetData body(std::move(views), nullify, reply);
+        body.serialize(buf_body);
+
+        // Serialize message head
+        vector<char> buf_head;
+        msg::Header head(msg::Type::GET_DATA, buf_body.size());
+        head.serialize(buf_head);
+
+        // Send serialized message
+        comm_front.write(std::move(buf_head));
+        comm_front.write(std::move(buf_body));
+    }
+
+    // Receive the replies of all pending prefetches
+    void drainPrefetches() {
+        while (not prefetch_pending.empty()) {
+            for (bh_base *base: prefetch_pending.front()) {
+                CommFrame frame = comm_front.pop();
+                if (base == nullptr) {
+                    releaseFrame(frame);
+                    continue;
+                }
+                auto it = prefetched.find(base);
+                if (it != prefetched.end()) {
+                    releaseFrame(it->second);
+                }
+                prefetched[base] = std::move(frame);
+            }
+            prefetch_pending.pop_front();
+        }
+    }
+
+    // Forget the prefetched data of `base`, which is out of date
+    void invalidatePrefetch(bh_base *base) {
+        auto it = prefetched.find(base);
+        if (it != prefetched.end()) {
+            releaseFrame(it->second);
+            prefetched.erase(it);
+        }
+        for (std::vector<bh_base *> &bases: prefetch_pending) {
+            std::replace(bases.begin(), bases.end(), base, static_cast<bh_base *>(nullptr));
         }
-        time_mem_copy_total += chrono::steady_clock::now() - t1;
     }
 
     // We have no context so returning NULL
@@ -234,24 +358,65 @@ void Impl::execute(BhIR *bhir) {
 
     handleExtmethod(bhir);
 
-    // Serialize the BhIR, which becomes the message body
+    // The frames of this message are tagged, which times the sending of them
+    CostReport::Row row;
+    if (not report_path.empty()) {
+        row.tag = report.rows.size() + 1;
+        comm_front.setTag(row.tag);
+    }
+
+    // Serialize the BhIR, which becomes the message body. A repeated BhIR is sent as a reference to the batch cache.
+    auto t1 = chrono::steady_clock::now();
     vector<bh_base *> new_data; // New data in the order they appear in the instruction list
-    vector<char> buf_body = bhir->writeSerializedArchive(known_base_arrays, new_data);
+    vector<char> buf_body;
+    msg::Type type = msg::Type::EXEC;
+    if (use_batch_cache) {
+        type = batch_cache.write(*bhir, known_base_arrays, view_dict, new_data, buf_body);
+    } else {
+        buf_body = bhir->writeSerialized(known_base_arrays, view_dict, new_data);
+    }
+    row.serialize = std::chrono::duration<double>(chrono::steady_clock::now() - t1).count();
+    row.ninstr = bhir->instr_list.size();
+    row.nbytes_body = buf_body.size();
 
     // Serialize message head
     vector<char> buf_head;
-    msg::Header head(msg::Type::EXEC, buf_body.size());
+    msg::Header head(type, buf_body.size());
     head.serialize(buf_head);
 
-    // Send serialized message (head and body)
-    comm_front.write(buf_head);
-    comm_front.write(buf_body);
+    // Queue the serialized message (head and body)
+    comm_front.write(std::move(buf_head));
+    comm_front.write(std::move(buf_body));
 
-    // Send array data
+    // Queue the array data. The sender thread sends array N while we compress array N+1 and the backend
+    // starts executing when the data of the first instructions has arrived.
+    // By shared memory, the data is passed as is.
+    compressor.setLinkBandwidth(comm_front.bandwidth());
     for (bh_base *base: new_data) {
         assert(base->getDataPtr() != nullptr);
-        auto data = compressor.compress(*base, compress_param);
-        comm_front.send_data(data);
+        row.nbytes_raw += base->nbytes();
+        if (comm_front.sharedMemory()) {
+            comm_front.send_handle(base->getDataPtr(), base->nbytes());
+        } else {
+            auto t2 = chrono::steady_clock::now();
+            vector<unsigned char> data = compressor.compress(*base, compress_param);
+            row.compress += std::chrono::duration<double>(chrono::steady_clock::now() - t2).count();
+            row.nbytes_link += data.size();
+            comm_front.send_data(std::move(data));
+        }
+    }
+    if (not report_path.empty()) {
+        comm_front.setTag(0);
+        row.type = type == msg::Type::EXEC_REF ? "EXEC_REF" : type == msg::Type::EXEC_CACHE ? "EXEC_CACHE" : "EXEC";
+        row.narrays = new_data.size();
+        report.rows.push_back(std::move(row));
+    }
+
+    // The prefetched data of the base arrays that this BhIR writes or frees is out of date
+    for (const bh_instruction &instr: bhir->instr_list) {
+        if (not instr.operand.empty() and not instr.operand[0].isConstant()) {
+            invalidatePrefetch(instr.operand[0].base);
+        }
     }
 
     // Cleanup freed base array and make them unknown.
@@ -261,4 +426,24 @@ void Impl::execute(BhIR *bhir) {
             known_base_arrays.erase(instr.operand[0].base);
         }
     }
+
+    // Request the sync'ed arrays together, which the backend sends as soon as it has executed the BhIR.
+    // Notice, we bound the replies that are not received yet.
+    if (prefetch_syncs) {
+        if (prefetch_pending.size() >= 16) {
+            drainPrefetches();
+        }
+        vector<bh_view> views;
+        vector<bh_base *> bases;
+        for (bh_base *base: bhir->getSyncs()) {
+            if (util::exist(known_base_arrays, base)) {
+                views.emplace_back(base);
+                bases.push_back(base);
+            }
+        }
+        if (not views.empty()) {
+            sendGetData(std::move(views), false, true);
+            prefetch_pending.push_back(std::move(bases));
+        }
+    }
 }
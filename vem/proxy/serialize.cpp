@@ -86,10 +86,17 @@ GetData::GetData(const std::vector<char> &buffer) {
     iostreams::stream<iostreams::basic_array_source<char> > input_stream(source);
     archive::binary_iarchive ia(input_stream);
 
-    size_t b;
-    ia >> b;
-    this->base = reinterpret_cast<bh_base *>(b);
+    size_t n;
+    ia >> n;
+    this->views.resize(n);
+    for (bh_view &view: this->views) {
+        ia >> view;
+        size_t b;
+        ia >> b;
+        view.base = reinterpret_cast<bh_base *>(b);
+    }
     ia >> this->nullify;
+    ia >> this->reply;
 }
 
 void GetData::serialize(std::vector<char> &buffer) {
@@ -97,9 +104,15 @@ void GetData::serialize(std::vector<char> &buffer) {
     iostreams::stream<iostreams::back_insert_device<vector<char> > > output_stream(buffer);
     archive::binary_oarchive oa(output_stream);
 
-    size_t b = reinterpret_cast<size_t>(this->base);
-    oa << b;
+    size_t n = this->views.size();
+    oa << n;
+    for (const bh_view &view: this->views) {
+        oa << view;
+        size_t b = reinterpret_cast<size_t>(view.base);
+        oa << b;
+    }
     oa << this->nullify;
+    oa << this->reply;
 }
 
 MemCopy::MemCopy(const std::vector<char> &buffer) {
@@ -32,14 +32,18 @@ namespace boost { namespace serialization { class access; }}
 
 namespace msg {
 
-/** Message type */
+/** Message type. The replies of the backend are MSG, DATA, and DATA_HANDLE messages. */
 enum class Type {
     INIT,
     SHUTDOWN,
     EXEC,
+    EXEC_CACHE, // Like EXEC but the BhIR is also inserted into the batch cache (see batch_cache.hpp)
+    EXEC_REF,   // A BhIR in the batch cache
     GET_DATA,
     MEM_COPY,
-    MSG
+    MSG,
+    DATA,       // Array data of an EXEC message, sent in the order of first use in the instruction list
+    DATA_HANDLE // Like DATA but passed by shared memory. The body size is the size of the shared memory
 };
 
 /** Message Header */
@@ -73,13 +77,16 @@ struct Init {
     void serialize(std::vector<char> &buffer);
 };
 
-/** RPC: `getMemoryPointer()` */
+/** RPC: `getMemoryPointer()` and the prefetch of sync'ed arrays. Unless `reply` is false, the backend replies with
+ *  a DATA frame (or DATA_HANDLE frame) for each view in order, which contains only the elements of the view. */
 struct GetData {
-    bh_base *base;
-    bool nullify;
+    std::vector<bh_view> views;
+    bool nullify; // Free the base arrays of `views` after the reply
+    bool reply;
 
     /** The regular constructor */
-    GetData(bh_base *base, bool nullify) : base(base), nullify(nullify) {}
+    GetData(std::vector<bh_view> views, bool nullify, bool reply = true) : views(std::move(views)),
+                                                                           nullify(nullify), reply(reply) {}
 
     /** The de-serializing constructor */
     explicit GetData(const std::vector<char> &buffer);
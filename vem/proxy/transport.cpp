@@ -0,0 +1,340 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <cstring>
+#include <sstream>
+#include <boost/asio.hpp>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "transport.hpp"
+
+using boost::asio::ip::tcp;
+using namespace std;
+
+namespace {
+
+class TcpTransport : public Transport {
+    std::shared_ptr<boost::asio::io_service> io_service;
+    tcp::socket socket;
+public:
+    TcpTransport(std::shared_ptr<boost::asio::io_service> io_service, tcp::socket socket) :
+            io_service(std::move(io_service)), socket(std::move(socket)) {
+        this->socket.set_option(tcp::no_delay(true));
+    }
+
+    void write(const std::vector<boost::asio::const_buffer> &bufs, int handle) override {
+        if (handle != -1) {
+            throw runtime_error("[PROXY-VEM] the TCP transport does not pass shared memory handles");
+        }
+        boost::asio::write(socket, bufs);
+    }
+
+    void read(void *buf, size_t size) override {
+        boost::asio::read(socket, boost::asio::buffer(buf, size));
+    }
+
+    void shutdown() override {
+        boost::system::error_code error;
+        socket.shutdown(tcp::socket::shutdown_both, error);
+    }
+
+    std::string ip() const override {
+        std::stringstream ss;
+        ss << socket.local_endpoint().address();
+        return ss.str();
+    }
+};
+
+#ifdef __linux__
+using boost::asio::local::stream_protocol;
+
+class LocalTransport : public Transport {
+    std::shared_ptr<boost::asio::io_service> io_service;
+    stream_protocol::socket socket;
+    std::deque<int> handles; // Received handles not yet popped
+public:
+    LocalTransport(std::shared_ptr<boost::asio::io_service> io_service, stream_protocol::socket socket) :
+            io_service(std::move(io_service)), socket(std::move(socket)) {}
+
+    ~LocalTransport() override {
+        for (int handle: handles) {
+            ::close(handle);
+        }
+    }
+
+    void write(const std::vector<boost::asio::const_buffer> &bufs, int handle) override {
+        if (handle == -1) {
+            boost::asio::write(socket, bufs);
+            return;
+        }
+        // The handle goes with the first byte of `bufs`, which `sendmsg()` might not send in full
+        std::vector<iovec> iov;
+        size_t total = 0;
+        for (const auto &buf: bufs) {
+            iov.push_back(iovec{const_cast<void *>(boost::asio::buffer_cast<const void *>(buf)),
+                                boost::asio::buffer_size(buf)});
+            total += iov.back().iov_len;
+        }
+        char control[CMSG_SPACE(sizeof(int))] = {};
+        msghdr msg{};
+        msg.msg_iov = iov.data();
+        msg.msg_iovlen = iov.size();
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &handle, sizeof(int));
+        ssize_t n;
+        do {
+            n = ::sendmsg(socket.native_handle(), &msg, MSG_NOSIGNAL);
+        } while (n < 0 and errno == EINTR);
+        ::close(handle); // The handle in flight keeps the shared memory alive
+        if (n < 0) {
+            throw runtime_error(string("[PROXY-VEM] sendmsg(): ") + strerror(errno));
+        }
+        // Write the rest without the handle
+        std::vector<boost::asio::const_buffer> rest;
+        size_t skip = static_cast<size_t>(n);
+        for (const auto &buf: bufs) {
+            const size_t size = boost::asio::buffer_size(buf);
+            if (skip >= size) {
+                skip -= size;
+            } else {
+                rest.push_back(buf + skip);
+                skip = 0;
+            }
+        }
+        if (static_cast<size_t>(n) < total) {
+            boost::asio::write(socket, rest);
+        }
+    }
+
+    void read(void *buf, size_t size) override {
+        auto *out = static_cast<char *>(buf);
+        while (size > 0) {
+            iovec iov{out, size};
+            char control[CMSG_SPACE(sizeof(int) * 8)];
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            const ssize_t n = ::recvmsg(socket.native_handle(), &msg, MSG_CMSG_CLOEXEC);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw runtime_error(string("[PROXY-VEM] recvmsg(): ") + strerror(errno));
+            }
+            if (n == 0) {
+                throw runtime_error("[PROXY-VEM] the connection was closed");
+            }
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level == SOL_SOCKET and cmsg->cmsg_type == SCM_RIGHTS) {
+                    const size_t num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    for (size_t i = 0; i < num; ++i) {
+                        int handle;
+                        memcpy(&handle, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                        handles.push_back(handle);
+                    }
+                }
+            }
+            if (msg.msg_flags & MSG_CTRUNC) {
+                throw runtime_error("[PROXY-VEM] recvmsg(): lost shared memory handles");
+            }
+            out += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    int popHandle() override {
+        if (handles.empty()) {
+            throw runtime_error("[PROXY-VEM] expected a shared memory handle");
+        }
+        const int ret = handles.front();
+        handles.pop_front();
+        return ret;
+    }
+
+    bool sharedMemory() const override {
+        return true;
+    }
+
+    void shutdown() override {
+        boost::system::error_code error;
+        socket.shutdown(stream_protocol::socket::shutdown_both, error);
+    }
+
+    std::string ip() const override {
+        return "local";
+    }
+};
+
+// The local transport listens on an abstract Unix socket, which is only reachable from this host
+stream_protocol::endpoint localEndpoint(int port) {
+    return stream_protocol::endpoint(std::string(1, '\0') + "bohrium-proxy-" + std::to_string(port));
+}
+#endif
+
+bool isThisHost(const std::string &address) {
+    if (address == "localhost" or address == boost::asio::ip::host_name()) {
+        return true;
+    }
+    boost::system::error_code error;
+    const auto ip = boost::asio::ip::address::from_string(address, error);
+    return not error and ip.is_loopback();
+}
+} // Anonymous namespace
+
+std::unique_ptr<Transport> transportConnect(const std::string &address, int port, const std::string &kind) {
+    if (kind != "tcp" and kind != "local" and kind != "auto") {
+        throw runtime_error("config: the proxy `transport` must be tcp, local, or auto");
+    }
+    auto io_service = std::make_shared<boost::asio::io_service>();
+    boost::system::error_code error;
+#ifdef __linux__
+    if (kind == "local" or (kind == "auto" and isThisHost(address))) {
+        stream_protocol::socket socket(*io_service);
+        socket.connect(localEndpoint(port), error);
+        if (not error) {
+            return std::unique_ptr<Transport>(new LocalTransport(io_service, std::move(socket)));
+        }
+        if (kind == "local") {
+            throw boost::system::system_error(error);
+        }
+    }
+#else
+    if (kind == "local") {
+        throw runtime_error("[PROXY-VEM] the local transport is only supported on Linux");
+    }
+#endif
+    // Get a list of endpoints corresponding to the server name.
+    tcp::resolver resolver(*io_service);
+    tcp::resolver::query query(address, to_string(port));
+    tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
+    tcp::resolver::iterator end;
+
+    // Try each endpoint until we successfully establish a connection.
+    tcp::socket socket(*io_service);
+    error = boost::asio::error::host_not_found;
+    while (error && endpoint_iterator != end) {
+        socket.close();
+        socket.connect(*endpoint_iterator++, error);
+    }
+    if (error) {
+        throw boost::system::system_error(error);
+    }
+    return std::unique_ptr<Transport>(new TcpTransport(io_service, std::move(socket)));
+}
+
+std::unique_ptr<Transport> transportAccept(int port) {
+    auto io_service = std::make_shared<boost::asio::io_service>();
+    std::unique_ptr<Transport> ret;
+
+    // We accept the first connection through either transport
+    tcp::acceptor tcp_acceptor(*io_service, tcp::endpoint(tcp::v4(), port));
+    tcp::socket tcp_socket(*io_service);
+#ifdef __linux__
+    stream_protocol::acceptor local_acceptor(*io_service);
+    stream_protocol::socket local_socket(*io_service);
+    boost::system::error_code error;
+    local_acceptor.open(stream_protocol(), error);
+    if (not error) {
+        local_acceptor.bind(localEndpoint(port), error);
+    }
+    if (not error) {
+        local_acceptor.listen(boost::asio::socket_base::max_connections, error);
+    }
+    if (error) {
+        cerr << "[PROXY-VEM] the local transport is not available: " << error.message() << endl;
+    } else {
+        local_acceptor.async_accept(local_socket, [&](const boost::system::error_code &e) {
+            if (not e and ret == nullptr) {
+                ret.reset(new LocalTransport(io_service, std::move(local_socket)));
+                boost::system::error_code ignored;
+                tcp_acceptor.cancel(ignored);
+            }
+        });
+    }
+#endif
+    tcp_acceptor.async_accept(tcp_socket, [&](const boost::system::error_code &e) {
+        if (not e and ret == nullptr) {
+            ret.reset(new TcpTransport(io_service, std::move(tcp_socket)));
+#ifdef __linux__
+            boost::system::error_code ignored;
+            local_acceptor.cancel(ignored);
+#endif
+        }
+    });
+    io_service->run();
+    if (ret == nullptr) {
+        throw runtime_error("[PROXY-VEM] failed to accept a connection");
+    }
+    return ret;
+}
+
+int shmCreate(const void *data, size_t nbytes) {
+#ifdef __linux__
+    const int handle = memfd_create("bohrium-proxy", MFD_CLOEXEC);
+    if (handle < 0) {
+        throw runtime_error(string("[PROXY-VEM] memfd_create(): ") + strerror(errno));
+    }
+    void *mem = MAP_FAILED;
+    if (ftruncate(handle, static_cast<off_t>(nbytes)) == 0) {
+        mem = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    }
+    if (mem == MAP_FAILED) {
+        const int err = errno;
+        ::close(handle);
+        throw runtime_error(string("[PROXY-VEM] shmCreate(): ") + strerror(err));
+    }
+    memcpy(mem, data, nbytes);
+    munmap(mem, nbytes);
+    return handle;
+#else
+    throw runtime_error("[PROXY-VEM] shared memory is only supported on Linux");
+#endif
+}
+
+void *shmMap(int handle, size_t nbytes) {
+#ifdef __linux__
+    void *ret = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    ::close(handle);
+    if (ret == MAP_FAILED) {
+        throw runtime_error(string("[PROXY-VEM] shmMap(): ") + strerror(errno));
+    }
+    return ret;
+#else
+    throw runtime_error("[PROXY-VEM] shared memory is only supported on Linux");
+#endif
+}
+
+void shmUnmap(void *mem, size_t nbytes) {
+#ifdef __linux__
+    munmap(mem, nbytes);
+#endif
+}
@@ -0,0 +1,81 @@
+/*
+This file is part of Bohrium and copyright (c) 2012 the Bohrium
+team <http://www.bh107.org>.
+
+Bohrium is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as
+published by the Free Software Foundation, either version 3
+of the License, or (at your option) any later version.
+
+Bohrium is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the
+GNU Lesser General Public License along with Bohrium.
+
+If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <boost/asio.hpp>
+
+/** The byte stream between the proxy frontend and backend.
+ *
+ * The TCP transport works everywhere. The local transport is a Unix domain socket, which is only available when
+ * the frontend and backend share a host. Beside the byte stream, it passes shared memory handles (memfd file
+ * descriptors), which the proxy uses to pass array data by handle instead of through the stream.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    /// Write all of `bufs`. When `handle` is not -1, the shared memory handle is attached and closed.
+    virtual void write(const std::vector<boost::asio::const_buffer> &bufs, int handle = -1) = 0;
+
+    /// Read exactly `size` bytes into `buf`
+    virtual void read(void *buf, size_t size) = 0;
+
+    /// Returns the next shared memory handle that arrived with the data read so far
+    virtual int popHandle() {
+        throw std::runtime_error("[PROXY-VEM] the transport does not pass shared memory handles");
+    }
+
+    /// Returns true when the transport passes shared memory handles
+    virtual bool sharedMemory() const {
+        return false;
+    }
+
+    /// Shutdown both directions, which makes a blocking read in another thread return
+    virtual void shutdown() = 0;
+
+    /// Returns the address of this end
+    virtual std::string ip() const = 0;
+};
+
+/** Connect to the backend at `address` and `port`.
+ *
+ * @param kind  "tcp", "local", or "auto", which uses the local transport when `address` is this host
+ * @return      The transport. Throws `boost::system::system_error` when the connection failed
+ */
+std::unique_ptr<Transport> transportConnect(const std::string &address, int port, const std::string &kind);
+
+/** Wait for a frontend to connect through either transport at `port` */
+std::unique_ptr<Transport> transportAccept(int port);
+
+/** Returns a shared memory handle that holds a copy of the `nbytes` of `data` */
+int shmCreate(const void *data, size_t nbytes);
+
+/** Map the shared memory handle of `nbytes` bytes and close the handle.
+ *  The returned memory mapping can be handed over to `bh_data_adopt()` or released with `shmUnmap()`. */
+void *shmMap(int handle, size_t nbytes);
+
+/** Release a memory mapping returned by `shmMap()` */
+void shmUnmap(void *mem, size_t nbytes);